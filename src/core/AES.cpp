@@ -2,6 +2,20 @@
 #include <cstring>
 #include <algorithm>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AES_HAVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AES_NI_TARGET
+#else
+#include <cpuid.h>
+// 只给用到指令集的函数单独开启目标特性，整个程序仍按基线架构编译
+#define AES_NI_TARGET __attribute__((target("aes,pclmul,sse4.1")))
+#endif
+#endif
+
+
 // S-Box, Inverse S-Box, Rcon... (Standard AES lookup tables)
 static const uint8_t sbox[256] = {
   0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
@@ -45,15 +59,298 @@ static const uint8_t Rcon[11] = {
   0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
 };
 
+static uint8_t gmul(uint8_t a, uint8_t b) {
+    uint8_t p = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (b & 1) p ^= a;
+        bool hi_bit_set = (a & 0x80);
+        a <<= 1;
+        if (hi_bit_set) a ^= 0x1b;
+        b >>= 1;
+    }
+    return p;
+}
+
+
+namespace {
+
+inline uint32_t load32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+inline void store32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    return (uint64_t(load32(p)) << 32) | load32(p + 4);
+}
+
+inline void store64(uint8_t* p, uint64_t v) {
+    store32(p, uint32_t(v >> 32)); store32(p + 4, uint32_t(v));
+}
+
+inline uint32_t ror32(uint32_t v, int bits) {
+    return bits == 0 ? v : (v >> bits) | (v << (32 - bits));
+}
+
+// T 表：把 SubBytes + ShiftRows + MixColumns 合并为每列 4 次查表
+struct TTables {
+    uint32_t te[4][256];
+    uint32_t td[4][256];
+    TTables() {
+        for (int x = 0; x < 256; ++x) {
+            const uint8_t s = sbox[x];
+            const uint32_t e = (uint32_t(gmul(s, 2)) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | gmul(s, 3);
+            const uint8_t r = rsbox[x];
+            const uint32_t d = (uint32_t(gmul(r, 14)) << 24) | (uint32_t(gmul(r, 9)) << 16)
+                             | (uint32_t(gmul(r, 13)) << 8) | gmul(r, 11);
+            for (int k = 0; k < 4; ++k) {
+                te[k][x] = ror32(e, 8 * k);
+                td[k][x] = ror32(d, 8 * k);
+            }
+        }
+    }
+};
+const TTables kTables;
+
+void ttEncrypt(const uint32_t* rk, int nr, const uint8_t in[16], uint8_t out[16]) {
+    const auto& T = kTables.te;
+    uint32_t s0 = load32(in) ^ rk[0], s1 = load32(in + 4) ^ rk[1];
+    uint32_t s2 = load32(in + 8) ^ rk[2], s3 = load32(in + 12) ^ rk[3];
+    for (int round = 1; round < nr; ++round) {
+        rk += 4;
+        const uint32_t t0 = T[0][s0 >> 24] ^ T[1][(s1 >> 16) & 0xff] ^ T[2][(s2 >> 8) & 0xff] ^ T[3][s3 & 0xff] ^ rk[0];
+        const uint32_t t1 = T[0][s1 >> 24] ^ T[1][(s2 >> 16) & 0xff] ^ T[2][(s3 >> 8) & 0xff] ^ T[3][s0 & 0xff] ^ rk[1];
+        const uint32_t t2 = T[0][s2 >> 24] ^ T[1][(s3 >> 16) & 0xff] ^ T[2][(s0 >> 8) & 0xff] ^ T[3][s1 & 0xff] ^ rk[2];
+        const uint32_t t3 = T[0][s3 >> 24] ^ T[1][(s0 >> 16) & 0xff] ^ T[2][(s1 >> 8) & 0xff] ^ T[3][s2 & 0xff] ^ rk[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    rk += 4;
+    auto last = [](uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        return (uint32_t(sbox[a >> 24]) << 24) | (uint32_t(sbox[(b >> 16) & 0xff]) << 16)
+             | (uint32_t(sbox[(c >> 8) & 0xff]) << 8) | sbox[d & 0xff];
+    };
+    store32(out, last(s0, s1, s2, s3) ^ rk[0]);
+    store32(out + 4, last(s1, s2, s3, s0) ^ rk[1]);
+    store32(out + 8, last(s2, s3, s0, s1) ^ rk[2]);
+    store32(out + 12, last(s3, s0, s1, s2) ^ rk[3]);
+}
+
+void ttDecrypt(const uint32_t* rk, int nr, const uint8_t in[16], uint8_t out[16]) {
+    const auto& T = kTables.td;
+    uint32_t s0 = load32(in) ^ rk[0], s1 = load32(in + 4) ^ rk[1];
+    uint32_t s2 = load32(in + 8) ^ rk[2], s3 = load32(in + 12) ^ rk[3];
+    for (int round = 1; round < nr; ++round) {
+        rk += 4;
+        const uint32_t t0 = T[0][s0 >> 24] ^ T[1][(s3 >> 16) & 0xff] ^ T[2][(s2 >> 8) & 0xff] ^ T[3][s1 & 0xff] ^ rk[0];
+        const uint32_t t1 = T[0][s1 >> 24] ^ T[1][(s0 >> 16) & 0xff] ^ T[2][(s3 >> 8) & 0xff] ^ T[3][s2 & 0xff] ^ rk[1];
+        const uint32_t t2 = T[0][s2 >> 24] ^ T[1][(s1 >> 16) & 0xff] ^ T[2][(s0 >> 8) & 0xff] ^ T[3][s3 & 0xff] ^ rk[2];
+        const uint32_t t3 = T[0][s3 >> 24] ^ T[1][(s2 >> 16) & 0xff] ^ T[2][(s1 >> 8) & 0xff] ^ T[3][s0 & 0xff] ^ rk[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    rk += 4;
+    auto last = [](uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        return (uint32_t(rsbox[a >> 24]) << 24) | (uint32_t(rsbox[(b >> 16) & 0xff]) << 16)
+             | (uint32_t(rsbox[(c >> 8) & 0xff]) << 8) | rsbox[d & 0xff];
+    };
+    store32(out, last(s0, s3, s2, s1) ^ rk[0]);
+    store32(out + 4, last(s1, s0, s3, s2) ^ rk[1]);
+    store32(out + 8, last(s2, s1, s0, s3) ^ rk[2]);
+    store32(out + 12, last(s3, s2, s1, s0) ^ rk[3]);
+}
+
+struct CpuFeatures {
+    bool aesni = false;
+    bool pclmul = false;
+    bool sse41 = false;
+};
+
+CpuFeatures detectCpu() {
+    CpuFeatures f;
+#ifdef AES_HAVE_X86
+    unsigned int ecx = 0;
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4] = {0};
+    __cpuid(regs, 1);
+    ecx = static_cast<unsigned int>(regs[2]);
+#else
+    unsigned int eax = 0, ebx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) ecx = 0;
+#endif
+    f.pclmul = (ecx >> 1) & 1;
+    f.sse41 = (ecx >> 19) & 1;
+    f.aesni = (ecx >> 25) & 1;
+#endif
+    return f;
+}
+const CpuFeatures kCpu = detectCpu();
+
+#ifdef AES_HAVE_X86
+AES_NI_TARGET void niInvertKeys(const uint8_t* w, uint8_t* dw, int nr) {
+    // 等价逆密码：轮密钥逆序，中间各轮做 InvMixColumns
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dw), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 16 * nr)));
+    for (int r = 1; r < nr; ++r) {
+        const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 16 * (nr - r)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dw + 16 * r), _mm_aesimc_si128(k));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dw + 16 * nr), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w)));
+}
+
+template <bool decrypt>
+AES_NI_TARGET inline __m128i niRound(__m128i b, __m128i key) {
+    return decrypt ? _mm_aesdec_si128(b, key) : _mm_aesenc_si128(b, key);
+}
+
+template <bool decrypt>
+AES_NI_TARGET inline __m128i niLastRound(__m128i b, __m128i key) {
+    return decrypt ? _mm_aesdeclast_si128(b, key) : _mm_aesenclast_si128(b, key);
+}
+
+// decrypt 为 true 时使用 aesdec 系列，rk 须为 niInvertKeys 的结果
+template <bool decrypt>
+AES_NI_TARGET void niCryptBlocks(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out, size_t n) {
+    __m128i k[15];
+    for (int r = 0; r <= nr; ++r) k[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rk + 16 * r));
+
+    const __m128i* src = reinterpret_cast<const __m128i*>(in);
+    __m128i* dst = reinterpret_cast<__m128i*>(out);
+    size_t i = 0;
+    // 4 块交错：aesenc 延迟数个周期但吞吐为每周期一条，独立的块可以填满流水线
+    for (; i + 4 <= n; i += 4) {
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(src + i), k[0]);
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(src + i + 1), k[0]);
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(src + i + 2), k[0]);
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(src + i + 3), k[0]);
+        for (int r = 1; r < nr; ++r) {
+            b0 = niRound<decrypt>(b0, k[r]);
+            b1 = niRound<decrypt>(b1, k[r]);
+            b2 = niRound<decrypt>(b2, k[r]);
+            b3 = niRound<decrypt>(b3, k[r]);
+        }
+        _mm_storeu_si128(dst + i, niLastRound<decrypt>(b0, k[nr]));
+        _mm_storeu_si128(dst + i + 1, niLastRound<decrypt>(b1, k[nr]));
+        _mm_storeu_si128(dst + i + 2, niLastRound<decrypt>(b2, k[nr]));
+        _mm_storeu_si128(dst + i + 3, niLastRound<decrypt>(b3, k[nr]));
+    }
+    for (; i < n; ++i) {
+        __m128i b = _mm_xor_si128(_mm_loadu_si128(src + i), k[0]);
+        for (int r = 1; r < nr; ++r) b = niRound<decrypt>(b, k[r]);
+        _mm_storeu_si128(dst + i, niLastRound<decrypt>(b, k[nr]));
+    }
+}
+
+// GF(2^128) 乘法 (Intel 白皮书《Carry-Less Multiplication and Its Usage for Computing the GCM Mode》算法 5)，
+// 操作数为字节反序后的值
+AES_NI_TARGET inline __m128i clmulGfmul(__m128i a, __m128i b) {
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t4 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t5 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t6 = _mm_clmulepi64_si128(a, b, 0x11);
+    t4 = _mm_xor_si128(t4, t5);
+    t5 = _mm_slli_si128(t4, 8);
+    t4 = _mm_srli_si128(t4, 8);
+    t3 = _mm_xor_si128(t3, t5);
+    t6 = _mm_xor_si128(t6, t4);
+
+    // 256 位乘积整体左移 1 位 (GCM 的位反序约定)
+    __m128i t7 = _mm_srli_epi32(t3, 31);
+    __m128i t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    __m128i t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+
+    // 模 x^128 + x^7 + x^2 + x + 1 约简
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+    __m128i t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+    return _mm_xor_si128(t6, t3);
+}
+
+AES_NI_TARGET void clmulGhash(uint8_t y[16], const uint8_t h[16], const uint8_t* data, size_t nblocks) {
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i H = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), bswap);
+    __m128i Y = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y)), bswap);
+    const __m128i* src = reinterpret_cast<const __m128i*>(data);
+    for (size_t i = 0; i < nblocks; ++i) {
+        const __m128i X = _mm_shuffle_epi8(_mm_loadu_si128(src + i), bswap);
+        Y = clmulGfmul(_mm_xor_si128(Y, X), H);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_shuffle_epi8(Y, bswap));
+}
+#endif // AES_HAVE_X86
+
+// Shoup 4 位查表法的约简常量
+const uint64_t kGhashLast4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+} // namespace
+
 AES::AES(KeyLength keyLength) {
     m_nk = keyLength / 4;
     m_nb = 4;
     if (keyLength == AES_128) m_nr = 10;
     else if (keyLength == AES_192) m_nr = 12;
     else m_nr = 14;
+    m_backend = bestBackend();
+    memset(m_w, 0, sizeof(m_w));
+    memset(m_dw, 0, sizeof(m_dw));
+    memset(m_ek, 0, sizeof(m_ek));
+    memset(m_dk, 0, sizeof(m_dk));
+}
+
+AES::~AES() {
+    // 轮密钥等同于密钥本身，析构时清零
+    volatile uint8_t* p = m_w;
+    for (size_t i = 0; i < sizeof(m_w); ++i) p[i] = 0;
+    p = m_dw;
+    for (size_t i = 0; i < sizeof(m_dw); ++i) p[i] = 0;
+    volatile uint32_t* q = m_ek;
+    for (size_t i = 0; i < 60; ++i) q[i] = 0;
+    q = m_dk;
+    for (size_t i = 0; i < 60; ++i) q[i] = 0;
+}
+
+AES::Backend AES::bestBackend() {
+    return isSupported(Backend::AesNi) ? Backend::AesNi : Backend::TTable;
+}
+
+bool AES::isSupported(Backend backend) {
+    if (backend == Backend::AesNi) return kCpu.aesni && kCpu.pclmul && kCpu.sse41;
+    return true;
 }
 
-AES::~AES() {}
+const char* AES::backendName(Backend backend) {
+    switch (backend) {
+    case Backend::Reference: return "Reference";
+    case Backend::TTable: return "T-Table";
+    case Backend::AesNi: return "AES-NI";
+    }
+    return "Unknown";
+}
+
+void AES::setBackend(Backend backend) {
+    if (isSupported(backend)) m_backend = backend;
+}
 
 void AES::keyExpansion(const uint8_t* key, uint8_t* w) {
     uint8_t temp[4];
@@ -87,19 +384,7 @@ void AES::keyExpansion(const uint8_t* key, uint8_t* w) {
     }
 }
 
-static uint8_t gmul(uint8_t a, uint8_t b) {
-    uint8_t p = 0;
-    for (int i = 0; i < 8; ++i) {
-        if (b & 1) p ^= a;
-        bool hi_bit_set = (a & 0x80);
-        a <<= 1;
-        if (hi_bit_set) a ^= 0x1b;
-        b >>= 1;
-    }
-    return p;
-}
-
-void AES::cipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) {
+void AES::cipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) const {
     uint8_t state[4][4];
     for (int i = 0; i < 4; ++i)
         for (int j = 0; j < 4; ++j)
@@ -146,7 +431,7 @@ void AES::cipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) {
             out[i * 4 + j] = state[j][i] ^ w[m_nr * 16 + i * 4 + j];
 }
 
-void AES::invCipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) {
+void AES::invCipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) const {
     uint8_t state[4][4];
     for (int i = 0; i < 4; ++i)
         for (int j = 0; j < 4; ++j)
@@ -193,43 +478,87 @@ void AES::invCipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) {
             out[i * 4 + j] = state[j][i] ^ w[i * 4 + j];
 }
 
+
+void AES::setKey(const uint8_t* key) {
+    keyExpansion(key, m_w);
+
+    const int words = 4 * (m_nr + 1);
+    for (int i = 0; i < words; ++i) m_ek[i] = load32(m_w + 4 * i);
+    // T 表解密轮密钥：逆序，中间各轮经 Td[sbox[]] 做 InvMixColumns
+    for (int round = 0; round <= m_nr; ++round) {
+        for (int j = 0; j < 4; ++j) {
+            const uint32_t k = m_ek[4 * (m_nr - round) + j];
+            if (round == 0 || round == m_nr) {
+                m_dk[4 * round + j] = k;
+            } else {
+                m_dk[4 * round + j] = kTables.td[0][sbox[k >> 24]] ^ kTables.td[1][sbox[(k >> 16) & 0xff]]
+                                    ^ kTables.td[2][sbox[(k >> 8) & 0xff]] ^ kTables.td[3][sbox[k & 0xff]];
+            }
+        }
+    }
+#ifdef AES_HAVE_X86
+    if (isSupported(Backend::AesNi)) niInvertKeys(m_w, m_dw, m_nr);
+#endif
+}
+
+void AES::encryptBlocks(const uint8_t* in, uint8_t* out, size_t n) const {
+#ifdef AES_HAVE_X86
+    if (m_backend == Backend::AesNi) {
+        niCryptBlocks<false>(m_w, m_nr, in, out, n);
+        return;
+    }
+#endif
+    if (m_backend == Backend::Reference) {
+        for (size_t i = 0; i < n; ++i) cipher(in + 16 * i, out + 16 * i, m_w);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) ttEncrypt(m_ek, m_nr, in + 16 * i, out + 16 * i);
+}
+
+void AES::decryptBlocks(const uint8_t* in, uint8_t* out, size_t n) const {
+#ifdef AES_HAVE_X86
+    if (m_backend == Backend::AesNi) {
+        niCryptBlocks<true>(m_dw, m_nr, in, out, n);
+        return;
+    }
+#endif
+    if (m_backend == Backend::Reference) {
+        for (size_t i = 0; i < n; ++i) invCipher(in + 16 * i, out + 16 * i, m_w);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) ttDecrypt(m_dk, m_nr, in + 16 * i, out + 16 * i);
+}
+
+void AES::encryptBlock(const uint8_t in[16], uint8_t out[16]) const {
+    encryptBlocks(in, out, 1);
+}
+
+void AES::decryptBlock(const uint8_t in[16], uint8_t out[16]) const {
+    decryptBlocks(in, out, 1);
+}
+
 std::vector<uint8_t> AES::encryptCBC(const std::vector<uint8_t>& input, const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv) {
-    std::vector<uint8_t> w(m_nb * (m_nr + 1) * 4);
-    keyExpansion(key.data(), w.data());
+    setKey(key.data());
 
     // PKCS#7 Padding
     size_t paddingLen = 16 - (input.size() % 16);
-    std::vector<uint8_t> paddedInput = input;
-    for (size_t i = 0; i < paddingLen; ++i) paddedInput.push_back((uint8_t)paddingLen);
-
-    std::vector<uint8_t> output(paddedInput.size());
-    uint8_t prevBlock[16];
-    memcpy(prevBlock, iv.data(), 16);
+    std::vector<uint8_t> output = input;
+    output.insert(output.end(), paddingLen, static_cast<uint8_t>(paddingLen));
 
-    for (size_t i = 0; i < paddedInput.size(); i += 16) {
-        uint8_t block[16];
-        for (int j = 0; j < 16; ++j) block[j] = paddedInput[i + j] ^ prevBlock[j];
-        cipher(block, &output[i], w.data());
-        memcpy(prevBlock, &output[i], 16);
-    }
+    uint8_t chain[16];
+    memcpy(chain, iv.data(), 16);
+    encryptCBCBlocks(output.data(), output.data(), output.size(), chain);
     return output;
 }
 
 std::vector<uint8_t> AES::decryptCBC(const std::vector<uint8_t>& input, const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv) {
     if (input.empty() || input.size() % 16 != 0) return {};
-    std::vector<uint8_t> w(m_nb * (m_nr + 1) * 4);
-    keyExpansion(key.data(), w.data());
+    setKey(key.data());
 
     std::vector<uint8_t> output(input.size());
-    uint8_t prevBlock[16];
-    memcpy(prevBlock, iv.data(), 16);
-
-    for (size_t i = 0; i < input.size(); i += 16) {
-        uint8_t block[16];
-        invCipher(&input[i], block, w.data());
-        for (int j = 0; j < 16; ++j) output[i + j] = block[j] ^ prevBlock[j];
-        memcpy(prevBlock, &input[i], 16);
-    }
+    uint8_t chain[16];
+    memcpy(chain, iv.data(), 16);
+    decryptCBCBlocks(input.data(), output.data(), input.size(), chain);
 
     // PKCS#7 Unpadding
     uint8_t paddingLen = output.back();
@@ -242,3 +571,294 @@ std::vector<uint8_t> AES::decryptCBC(const std::vector<uint8_t>& input, const st
     }
     return output;
 }
+
+void AES::encryptCBCBlocks(const uint8_t* in, uint8_t* out, size_t len, uint8_t iv[16]) {
+    // 每块依赖上一块的密文，只能逐块串行
+    for (size_t i = 0; i + 16 <= len; i += 16) {
+        uint8_t block[16];
+        for (int j = 0; j < 16; ++j) block[j] = in[i + j] ^ iv[j];
+        encryptBlocks(block, &out[i], 1);
+        memcpy(iv, &out[i], 16);
+    }
+}
+
+void AES::decryptCBCBlocks(const uint8_t* in, uint8_t* out, size_t len, uint8_t iv[16]) {
+    // 解密各块互相独立：每次取 8 块批量解密，再与前一块密文异或
+    constexpr size_t kBatch = 8;
+    uint8_t saved[kBatch * 16];     // 原地解密时 in 会被覆盖，先保存密文
+    uint8_t plain[kBatch * 16];
+    const size_t blocks = len / 16;
+    for (size_t i = 0; i < blocks; i += kBatch) {
+        const size_t n = std::min(kBatch, blocks - i);
+        memcpy(saved, in + 16 * i, 16 * n);
+        decryptBlocks(saved, plain, n);
+        for (size_t b = 0; b < n; ++b) {
+            const uint8_t* prev = (b == 0) ? iv : saved + 16 * (b - 1);
+            uint8_t* dst = out + 16 * (i + b);
+            for (int j = 0; j < 16; ++j) dst[j] = plain[16 * b + j] ^ prev[j];
+        }
+        memcpy(iv, saved + 16 * (n - 1), 16);
+    }
+}
+
+void AES::ctrXor(const uint8_t* in, uint8_t* out, size_t len, const uint8_t counter0[16], uint64_t blockOffset) const {
+    constexpr size_t kBatch = 8;
+    uint8_t counters[kBatch * 16];
+    uint8_t stream[kBatch * 16];
+    uint32_t next = load32(counter0 + 12) + static_cast<uint32_t>(blockOffset);
+    size_t done = 0;
+    while (done < len) {
+        const size_t bytes = std::min(len - done, sizeof(stream));
+        const size_t n = (bytes + 15) / 16;
+        for (size_t b = 0; b < n; ++b) {
+            memcpy(counters + 16 * b, counter0, 12);
+            store32(counters + 16 * b + 12, next++);
+        }
+        encryptBlocks(counters, stream, n);
+        for (size_t i = 0; i < bytes; ++i) out[done + i] = in[done + i] ^ stream[i];
+        done += bytes;
+    }
+}
+
+// ---------------------------------------------------------------- GCM
+
+AesGcm::AesGcm(const AES& aes, const uint8_t iv[12]) : m_aes(aes) {
+#ifdef AES_HAVE_X86
+    m_clmul = (aes.backend() == AES::Backend::AesNi);
+#endif
+    memcpy(m_j0, iv, 12);
+    store32(m_j0 + 12, 1);
+    memcpy(m_counter1, m_j0, 16);
+    store32(m_counter1 + 12, 2);
+    memset(m_y, 0, 16);
+
+    const uint8_t zero[16] = {0};
+    m_aes.encryptBlock(zero, m_h);
+
+    // 预计算 H 的 16 个倍数 (mbedTLS 同款 4 位表)
+    uint64_t vh = load64(m_h);
+    uint64_t vl = load64(m_h + 8);
+    m_hl[8] = vl; m_hh[8] = vh;
+    m_hl[0] = 0; m_hh[0] = 0;
+    for (int i = 4; i > 0; i >>= 1) {
+        const uint64_t t = (vl & 1) * 0xe1000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (t << 32);
+        m_hl[i] = vl; m_hh[i] = vh;
+    }
+    for (int i = 2; i <= 8; i *= 2) {
+        for (int j = 1; j < i; ++j) {
+            m_hh[i + j] = m_hh[i] ^ m_hh[j];
+            m_hl[i + j] = m_hl[i] ^ m_hl[j];
+        }
+    }
+}
+
+void AesGcm::ghash(const uint8_t* data, size_t nblocks) {
+#ifdef AES_HAVE_X86
+    if (m_clmul) {
+        clmulGhash(m_y, m_h, data, nblocks);
+        return;
+    }
+#endif
+    for (size_t b = 0; b < nblocks; ++b) {
+        uint8_t x[16];
+        for (int j = 0; j < 16; ++j) x[j] = m_y[j] ^ data[16 * b + j];
+
+        int lo = x[15] & 0xf;
+        uint64_t zh = m_hh[lo];
+        uint64_t zl = m_hl[lo];
+        for (int i = 15; i >= 0; --i) {
+            lo = x[i] & 0xf;
+            const int hi = (x[i] >> 4) & 0xf;
+            if (i != 15) {
+                const int rem = zl & 0xf;
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ (kGhashLast4[rem] << 48);
+                zh ^= m_hh[lo];
+                zl ^= m_hl[lo];
+            }
+            const int rem = zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (kGhashLast4[rem] << 48);
+            zh ^= m_hh[hi];
+            zl ^= m_hl[hi];
+        }
+        store64(m_y, zh);
+        store64(m_y + 8, zl);
+    }
+}
+
+void AesGcm::updateAad(const uint8_t* aad, size_t len) {
+    m_aadLen += len;
+    const size_t full = len / 16;
+    ghash(aad, full);
+    if (len % 16) {
+        uint8_t last[16] = {0};
+        memcpy(last, aad + 16 * full, len % 16);
+        ghash(last, 1);
+    }
+}
+
+void AesGcm::crypt(const uint8_t* in, uint8_t* out, size_t len, uint64_t blockOffset) const {
+    m_aes.ctrXor(in, out, len, m_counter1, blockOffset);
+}
+
+void AesGcm::updateGhash(const uint8_t* ciphertext, size_t len) {
+    m_dataLen += len;
+    const size_t full = len / 16;
+    ghash(ciphertext, full);
+    if (len % 16) {
+        uint8_t last[16] = {0};
+        memcpy(last, ciphertext + 16 * full, len % 16);
+        ghash(last, 1);
+    }
+}
+
+void AesGcm::finish(uint8_t tag[16]) {
+    uint8_t lengths[16];
+    store64(lengths, m_aadLen * 8);
+    store64(lengths + 8, m_dataLen * 8);
+    ghash(lengths, 1);
+
+    uint8_t ekj0[16];
+    m_aes.encryptBlock(m_j0, ekj0);
+    for (int i = 0; i < 16; ++i) tag[i] = ekj0[i] ^ m_y[i];
+}
+
+void AesGcm::encrypt(const uint8_t* in, uint8_t* out, size_t len) {
+    crypt(in, out, len, m_dataLen / 16);
+    updateGhash(out, len);
+}
+
+void AesGcm::decrypt(const uint8_t* in, uint8_t* out, size_t len) {
+    updateGhash(in, len);
+    crypt(in, out, len, (m_dataLen - len) / 16);
+}
+
+// ---------------------------------------------------------------- 自检
+
+namespace {
+
+std::vector<uint8_t> fromHex(const char* hex) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+        auto nibble = [](char c) { return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10; };
+        out.push_back(static_cast<uint8_t>((nibble(hex[i]) << 4) | nibble(hex[i + 1])));
+    }
+    return out;
+}
+
+struct GcmVector {
+    const char* key;
+    const char* iv;
+    const char* aad;
+    const char* plain;
+    const char* cipher;
+    const char* tag;
+};
+
+// 《The Galois/Counter Mode of Operation》附录 B，测试用例 13–16 (AES-256)
+const GcmVector kGcmVectors[] = {
+    { "0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000",
+      "", "", "", "530f8afbc74536b9a963b4f1c4cb738b" },
+    { "0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000",
+      "", "00000000000000000000000000000000", "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919" },
+    { "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "",
+      "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+      "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad",
+      "b094dac5d93471bdec1a502270e3cc6c" },
+    { "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+      "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+      "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+      "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+      "76fc6ece0f4e1768cddf8853bb2d551b" },
+};
+
+bool selfTestBackend(AES::Backend backend) {
+    // FIPS-197 附录 C.1 / C.3
+    const std::vector<uint8_t> plain = fromHex("00112233445566778899aabbccddeeff");
+    struct { AES::KeyLength length; const char* key; const char* cipher; } blockVectors[] = {
+        { AES::AES_128, "000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a" },
+        { AES::AES_256, "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "8ea2b7ca516745bfeafc49904b496089" },
+    };
+    for (const auto& v : blockVectors) {
+        AES aes(v.length);
+        aes.setBackend(backend);
+        aes.setKey(fromHex(v.key).data());
+        uint8_t out[16], back[16];
+        aes.encryptBlock(plain.data(), out);
+        aes.decryptBlock(out, back);
+        if (fromHex(v.cipher) != std::vector<uint8_t>(out, out + 16)) return false;
+        if (memcmp(back, plain.data(), 16) != 0) return false;
+    }
+
+    // SP 800-38A F.5.5 CTR-AES256.Encrypt (前两块)
+    {
+        AES aes(AES::AES_256);
+        aes.setBackend(backend);
+        aes.setKey(fromHex("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4").data());
+        const std::vector<uint8_t> counter = fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+        const std::vector<uint8_t> input = fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51");
+        const std::vector<uint8_t> expected = fromHex("601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c5");
+        std::vector<uint8_t> out(input.size());
+        aes.ctrXor(input.data(), out.data(), out.size(), counter.data(), 0);
+        if (out != expected) return false;
+        // 按块偏移分段处理必须与整段一致
+        std::vector<uint8_t> split(input.size());
+        aes.ctrXor(input.data(), split.data(), 16, counter.data(), 0);
+        aes.ctrXor(input.data() + 16, split.data() + 16, 16, counter.data(), 1);
+        if (split != expected) return false;
+    }
+
+    for (const GcmVector& v : kGcmVectors) {
+        AES aes(AES::AES_256);
+        aes.setBackend(backend);
+        aes.setKey(fromHex(v.key).data());
+        const std::vector<uint8_t> iv = fromHex(v.iv);
+        const std::vector<uint8_t> aad = fromHex(v.aad);
+        const std::vector<uint8_t> input = fromHex(v.plain);
+        std::vector<uint8_t> out(input.size());
+        uint8_t tag[16];
+
+        AesGcm enc(aes, iv.data());
+        enc.updateAad(aad.data(), aad.size());
+        enc.encrypt(input.data(), out.data(), out.size());
+        enc.finish(tag);
+        if (out != fromHex(v.cipher) || fromHex(v.tag) != std::vector<uint8_t>(tag, tag + 16)) return false;
+
+        std::vector<uint8_t> back(out.size());
+        AesGcm dec(aes, iv.data());
+        dec.updateAad(aad.data(), aad.size());
+        dec.decrypt(out.data(), back.data(), back.size());
+        dec.finish(tag);
+        if (back != input || fromHex(v.tag) != std::vector<uint8_t>(tag, tag + 16)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool AES::selfTest() {
+    const Backend all[] = { Backend::Reference, Backend::TTable, Backend::AesNi };
+    for (Backend backend : all) {
+        if (isSupported(backend) && !selfTestBackend(backend)) return false;
+    }
+
+    // 多块批量路径 (流水线、CBC 批量解密) 与参考实现交叉比对
+    std::vector<uint8_t> key(32), iv(16), data(16 * 37 + 5);
+    for (size_t i = 0; i < key.size(); ++i) key[i] = static_cast<uint8_t>(i * 7 + 3);
+    for (size_t i = 0; i < iv.size(); ++i) iv[i] = static_cast<uint8_t>(0xf0 + i);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(i * 131 + 17);
+
+    AES reference(AES_256);
+    reference.setBackend(Backend::Reference);
+    const std::vector<uint8_t> expected = reference.encryptCBC(data, key, iv);
+    for (Backend backend : all) {
+        if (!isSupported(backend)) continue;
+        AES aes(AES_256);
+        aes.setBackend(backend);
+        if (aes.encryptCBC(data, key, iv) != expected || aes.decryptCBC(expected, key, iv) != data) return false;
+    }
+    return true;
+}
@@ -3,27 +3,106 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
+/**
+ * @brief AES 分组密码
+ *
+ * 三种后端，构造时自动选择当前 CPU 上最快的一个：
+ *  - AesNi：x86 AES-NI 指令 (GHASH 同时使用 PCLMULQDQ)，运行时通过 CPUID 检测
+ *  - TTable：32 位查表实现，可移植的默认后端
+ *  - Reference：逐字节的教科书实现，只用于自检交叉比对与基准对照
+ * CBC 加密天然串行；CBC 解密、CTR、GCM 的各块互相独立，可以按块偏移分段交给多个线程。
+ */
 class AES {
 public:
     enum KeyLength { AES_128 = 16, AES_192 = 24, AES_256 = 32 };
+    enum class Backend { Reference, TTable, AesNi };
 
     explicit AES(KeyLength keyLength);
     ~AES();
 
+    static Backend bestBackend();
+    static bool isSupported(Backend backend);
+    static const char* backendName(Backend backend);
+    void setBackend(Backend backend);   // 不支持的后端会被忽略
+    Backend backend() const { return m_backend; }
+
     // CBC 加密
     std::vector<uint8_t> encryptCBC(const std::vector<uint8_t>& input, const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv);
     // CBC 解密
     std::vector<uint8_t> decryptCBC(const std::vector<uint8_t>& input, const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv);
 
+    // 流式 CBC：setKey 只展开一次密钥，之后按段处理 16 字节整数倍的数据 (不含填充)。
+    // iv 在调用之间延续 (返回时为最后一个密文块)，in 与 out 可以是同一块内存
+    void setKey(const uint8_t* key);
+    void encryptCBCBlocks(const uint8_t* in, uint8_t* out, size_t len, uint8_t iv[16]);
+    void decryptCBCBlocks(const uint8_t* in, uint8_t* out, size_t len, uint8_t iv[16]);
+
+    void encryptBlock(const uint8_t in[16], uint8_t out[16]) const;
+    void decryptBlock(const uint8_t in[16], uint8_t out[16]) const;
+
+    // CTR：计数块低 32 位按大端递增 (与 GCM 的 inc32 一致)。blockOffset 为 in 相对数据起点的块序号，
+    // 因此不同线程可以无状态地各自处理一段；len 不必是 16 的倍数 (仅限最后一段)
+    void ctrXor(const uint8_t* in, uint8_t* out, size_t len, const uint8_t counter0[16], uint64_t blockOffset) const;
+
+    // 已知答案测试 (FIPS-197、SP 800-38A CTR、GCM 规范测试向量)，覆盖当前 CPU 支持的全部后端
+    static bool selfTest();
+
 private:
-    void cipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w);
-    void invCipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w);
+    friend class AesGcm;
+
+    void cipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) const;
+    void invCipher(const uint8_t in[16], uint8_t out[16], const uint8_t* w) const;
     void keyExpansion(const uint8_t* key, uint8_t* w);
-    
+    // 按当前后端批量处理 n 个互相独立的块 (ECB)，AES-NI 下 4 块交错流水
+    void encryptBlocks(const uint8_t* in, uint8_t* out, size_t n) const;
+    void decryptBlocks(const uint8_t* in, uint8_t* out, size_t n) const;
+
     int m_nb;
     int m_nk;
     int m_nr;
+    Backend m_backend;
+    alignas(16) uint8_t m_w[240];   // 展开后的轮密钥 (AES-256 最多 15 轮 × 16 字节)
+    alignas(16) uint8_t m_dw[240];  // AES-NI 解密轮密钥 (逆序并做 InvMixColumns)
+    uint32_t m_ek[60];              // T 表加密轮密钥 (大端字)
+    uint32_t m_dk[60];              // T 表解密轮密钥 (等价逆密码)
+};
+
+/**
+ * @brief AES-GCM 认证加密 (96 位 IV)
+ *
+ * crypt() 是无状态的 CTR 部分，可按块偏移多线程分段执行；updateGhash() 必须按数据顺序串行喂入密文。
+ * 单线程场景直接使用 encrypt()/decrypt()。
+ */
+class AesGcm {
+public:
+    AesGcm(const AES& aes, const uint8_t iv[12]);
+
+    // 附加认证数据，须在任何数据之前一次性传入
+    void updateAad(const uint8_t* aad, size_t len);
+
+    void crypt(const uint8_t* in, uint8_t* out, size_t len, uint64_t blockOffset) const;
+    // 除最后一次外 len 须为 16 的倍数
+    void updateGhash(const uint8_t* ciphertext, size_t len);
+    void finish(uint8_t tag[16]);
+
+    void encrypt(const uint8_t* in, uint8_t* out, size_t len);
+    void decrypt(const uint8_t* in, uint8_t* out, size_t len);
+
+private:
+    void ghash(const uint8_t* data, size_t nblocks);
+
+    const AES& m_aes;
+    uint8_t m_j0[16];
+    uint8_t m_counter1[16];     // inc32(J0)，数据的第一个计数块
+    uint8_t m_h[16];
+    uint8_t m_y[16];
+    uint64_t m_hl[16];          // 4 位查表 (Shoup) 的 H 倍数表
+    uint64_t m_hh[16];
+    uint64_t m_aadLen = 0;
+    uint64_t m_dataLen = 0;
+    bool m_clmul = false;
 };
 
 #endif // AES_H
@@ -0,0 +1,128 @@
+#include "BlobStore.h"
+#include "FileCopyEngine.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+QString BlobStore::storageRoot() {
+    QString path = QCoreApplication::applicationDirPath() + "/attachments";
+    QDir dir(path);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+    return path;
+}
+
+QString BlobStore::blobPath(const QString& hash) {
+    // 按哈希前两位分桶，避免单个目录下文件过多
+    return storageRoot() + "/.blobs/" + hash.left(2) + "/" + hash;
+}
+
+QString BlobStore::toRelativePath(const QString& absolutePath) {
+    return "attachments/" + QDir(storageRoot()).relativeFilePath(absolutePath);
+}
+
+bool BlobStore::isSupported() {
+    static const bool supported = [] {
+        const QString probe = storageRoot() + "/.reflink_probe" + QString::number(QRandomGenerator::global()->generate64(), 16);
+        {
+            QFile file(probe);
+            if (!file.open(QIODevice::WriteOnly) || file.write("probe") != 5) return false;
+        }
+        const bool ok = FileCopyEngine::reflinkFile(probe, probe + ".clone");
+        QFile::remove(probe + ".clone");
+        QFile::remove(probe);
+        qDebug() << "[BlobStore] 存储目录" << (ok ? "支持" : "不支持") << "reflink，块存储" << (ok ? "开启" : "关闭");
+        return ok;
+    }();
+    return supported;
+}
+
+QString BlobStore::hashFile(const QString& filePath, const std::atomic<bool>* cancel, std::atomic<qint64>* bytesRead) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray chunk(qBound<qint64>(4096, file.size(), kHashChunkSize), Qt::Uninitialized);
+    for (;;) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return QString();
+        const qint64 got = file.read(chunk.data(), chunk.size());
+        if (got < 0) return QString();
+        if (got == 0) break;
+        hash.addData(QByteArrayView(chunk.constData(), got));
+        if (bytesRead) *bytesRead += got;
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool BlobStore::store(const QString& source, const QString& hash, const QString& destination,
+                      bool* deduplicated, const std::atomic<bool>* cancel, std::atomic<qint64>* bytesCopied) {
+    const QString blob = blobPath(hash);
+    const bool exists = QFileInfo::exists(blob);
+    if (deduplicated) *deduplicated = exists;
+
+    if (!exists) {
+        if (!QDir().mkpath(QFileInfo(blob).absolutePath())) return false;
+        // 先写临时名再改名：同一批次里内容相同的文件可能被并行入库，只有第一个改名成功
+        const QString temp = blob + ".part" + QString::number(QRandomGenerator::global()->generate64(), 16);
+        if (!FileCopyEngine::copyFile(source, temp, cancel, bytesCopied)) return false;
+        if (!QFile::rename(temp, blob)) {
+            QFile::remove(temp);
+            if (!QFileInfo::exists(blob)) return false;
+        }
+    }
+    return materialize(blob, destination);
+}
+
+bool BlobStore::materialize(const QString& blobFile, const QString& destination) {
+    // 物化副本会被用户直接打开编辑，必须与块互不影响：reflink (写时复制)；
+    // 不支持时才真正复制 (块存储只在 isSupported 时开启，这里只兜底同一目录跨设备等个别情况)
+    if (FileCopyEngine::reflinkFile(blobFile, destination)) return true;
+    return FileCopyEngine::copyFile(blobFile, destination);
+}
+
+bool BlobStore::ensureBlob(const QString& hash, const QString& relativePath) {
+    const QString blob = blobPath(hash);
+    if (QFileInfo::exists(blob)) return true;
+    const QString source = QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(relativePath);
+    if (!QFileInfo(source).isFile() || hashFile(source) != hash) return false;
+    if (!QDir().mkpath(QFileInfo(blob).absolutePath())) return false;
+    const QString temp = blob + ".part" + QString::number(QRandomGenerator::global()->generate64(), 16);
+    if (!FileCopyEngine::copyFile(source, temp)) return false;
+    if (!QFile::rename(temp, blob)) {
+        QFile::remove(temp);
+        return QFileInfo::exists(blob);
+    }
+    return true;
+}
+
+void BlobStore::removeBlobs(const QStringList& hashes) {
+    for (const QString& hash : hashes) {
+        if (hash.isEmpty()) continue;
+        if (!QFile::remove(blobPath(hash))) {
+            qWarning() << "[BlobStore] 删除块失败:" << hash;
+        }
+    }
+}
+
+void BlobStore::removeMaterialized(const QStringList& relativePaths) {
+    const QString root = QDir(storageRoot()).absolutePath();
+    const QDir appDir(QCoreApplication::applicationDirPath());
+    for (const QString& rel : relativePaths) {
+        if (!rel.startsWith("attachments/")) continue;
+        const QString path = QDir::cleanPath(appDir.absoluteFilePath(rel));
+        // 只处理存储根目录之内、且不是块目录本身的路径
+        if (!path.startsWith(root + "/") || path.startsWith(root + "/.blobs")) continue;
+
+        QFileInfo info(path);
+        if (info.isDir() && !info.isSymLink()) {
+            QDir(path).removeRecursively();
+        } else if (info.exists() || info.isSymLink()) {
+            QFile::remove(path);
+        }
+    }
+}
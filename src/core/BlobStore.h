@@ -0,0 +1,49 @@
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+/**
+ * @brief 内容寻址的附件块存储
+ *
+ * 每个文件按整个文件内容的 SHA-256 (流式读取，不分块去重) 存放一份到 attachments/.blobs/<前两位>/<哈希>，
+ * 笔记引用的可见路径 (attachments/xxx) 是它的 reflink (写时复制) 副本，不占额外空间。
+ * 不使用硬链接：用户编辑某条笔记的附件时不能改动块本身及其他笔记的副本。
+ * 文件系统不支持 reflink 时 (Windows、ext4 等) 每个文件要写两份，反而比直接复制更占空间，
+ * 此时调用方应关闭块存储 (见 isSupported)，按旧方式只复制一份。
+ * 引用关系与计数由 DatabaseManager 的 note_blobs / blobs 表维护，清空回收站时回收无引用的块。
+ */
+class BlobStore {
+public:
+    static constexpr qint64 kHashChunkSize = 1024 * 1024;
+
+    static QString storageRoot();                       // <程序目录>/attachments
+    static QString blobPath(const QString& hash);       // 块文件的绝对路径
+    static QString toRelativePath(const QString& absolutePath); // 转为笔记中保存的 "attachments/..." 形式
+    // 存储目录所在文件系统是否支持 reflink；首次调用时实测一次，结果缓存
+    static bool isSupported();
+
+    // 按 kHashChunkSize 分段读取、计算整个文件的 SHA-256 (十六进制)，失败或取消返回空串
+    static QString hashFile(const QString& filePath, const std::atomic<bool>* cancel = nullptr,
+                            std::atomic<qint64>* bytesRead = nullptr);
+
+    // 确保块存在 (不存在时从 source 复制入库)，再物化到 destination。
+    // deduplicated 返回块是否早已存在 (本次没有写入任何数据)
+    static bool store(const QString& source, const QString& hash, const QString& destination,
+                      bool* deduplicated = nullptr, const std::atomic<bool>* cancel = nullptr,
+                      std::atomic<qint64>* bytesCopied = nullptr);
+
+    // 块文件缺失 (被并发的回收删掉) 时用笔记的物化副本重建，relativePath 为 "attachments/..." 形式
+    static bool ensureBlob(const QString& hash, const QString& relativePath);
+
+    // 删除块与笔记的物化副本 (仅限存储根目录之内)；块是否仍被引用由调用方 (DatabaseManager) 在数据库锁内确认
+    static void removeBlobs(const QStringList& hashes);
+    static void removeMaterialized(const QStringList& relativePaths);
+
+private:
+    static bool materialize(const QString& blobFile, const QString& destination);
+};
+
+#endif // BLOBSTORE_H
@@ -1,4 +1,5 @@
 #include "ClipboardMonitor.h"
+#include "DatabaseManager.h"
 #include <QMimeData>
 #include <QDebug>
 
@@ -14,9 +15,15 @@ ClipboardMonitor::ClipboardMonitor(QObject* parent) : QObject(parent) {
 
 #include <QApplication>
 #include <QImage>
+#include <QImageWriter>
 #include <QBuffer>
 #include <QUrl>
 #include <QFileInfo>
+#include <QSettings>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -70,20 +77,18 @@ void ClipboardMonitor::onClipboardChanged() {
 
     QString type = "text";
     QString content;
-    QByteArray dataBlob;
 
-    if (mimeData->hasText() && !mimeData->text().trimmed().isEmpty()) {
-        content = mimeData->text();
+    // text() 每次调用都会完整转换一遍，只取一次；判空不做 trimmed() 拷贝
+    QString text = mimeData->hasText() ? mimeData->text() : QString();
+    const bool blank = std::all_of(text.cbegin(), text.cend(), [](QChar c) { return c.isSpace(); });
+
+    if (!blank) {
+        content = std::move(text);
         type = "text";
     } else if (mimeData->hasImage()) {
         QImage img = qvariant_cast<QImage>(mimeData->imageData());
-        if (!img.isNull()) {
-            type = "image";
-            content = "[图片]";
-            QBuffer buffer(&dataBlob);
-            buffer.open(QIODevice::WriteOnly);
-            img.save(&buffer, "PNG");
-        }
+        if (!img.isNull()) captureImage(img, sourceApp, sourceTitle);
+        return;
     } else if (mimeData->hasUrls()) {
         QStringList paths;
         for (const QUrl& url : mimeData->urls()) {
@@ -97,13 +102,104 @@ void ClipboardMonitor::onClipboardChanged() {
         return;
     }
 
-    // SHA256 去重
-    QByteArray hashData = dataBlob.isEmpty() ? content.toUtf8() : dataBlob;
-    QString currentHash = QCryptographicHash::hash(hashData, QCryptographicHash::Sha256).toHex();
-    
+    // 与上一次相同则忽略；同一个键随信号传给入库流程
+    QByteArray contentKey;
+    Xxh3::Hash128 currentHash;
+    if (type == "text" && content.size() > DatabaseManager::largeTextThreshold()) {
+        // 超大文本：直接对 UTF-16 内存做连续去重，不在界面线程转码；去重键由入库时在线程池中计算
+        currentHash = Xxh3::hash128(content.constData(), static_cast<size_t>(content.size()) * sizeof(QChar));
+    } else {
+        contentKey = DatabaseManager::computeContentKey(content.toUtf8());
+        currentHash = Xxh3::Hash128::fromBytes(reinterpret_cast<const uint8_t*>(contentKey.constData()));
+    }
     if (currentHash == m_lastHash) return;
     m_lastHash = currentHash;
 
     qDebug() << "[ClipboardMonitor] 捕获新内容 (来自:" << sourceApp << "):" << type << content.left(30);
-    emit newContentDetected(content, type, dataBlob, sourceApp, sourceTitle);
-}
\ No newline at end of file
+    emit newContentDetected(content, type, QByteArray(), sourceApp, sourceTitle, contentKey);
+}
+
+Xxh3::Hash128 ClipboardMonitor::hashPixels(const QImage& image) {
+    const size_t rowBytes = (static_cast<size_t>(image.width()) * image.depth() + 7) / 8;
+    // 头部带上尺寸与像素格式，避免内容相同而形状不同的图片撞键
+    QVector<quint64> digest = { quint64(image.width()), quint64(image.height()), quint64(image.format()) };
+    if (static_cast<size_t>(image.bytesPerLine()) == rowBytes) {
+        // 行间无填充 (32 位格式的常见情况)：整块一次哈希
+        const Xxh3::Hash128 h = Xxh3::hash128(image.constBits(), rowBytes * image.height());
+        digest << h.low64 << h.high64;
+    } else {
+        for (int y = 0; y < image.height(); ++y) {
+            const Xxh3::Hash128 h = Xxh3::hash128(image.constScanLine(y), rowBytes);
+            digest << h.low64 << h.high64;
+        }
+    }
+    return Xxh3::hash128(digest.constData(), digest.size() * sizeof(quint64));
+}
+
+void ClipboardMonitor::captureImage(const QImage& image, const QString& sourceApp, const QString& sourceTitle) {
+    QElapsedTimer hashTimer;
+    hashTimer.start();
+    const Xxh3::Hash128 currentHash = hashPixels(image);
+    const qint64 hashMs = hashTimer.elapsed();
+    if (currentHash == m_lastHash) return;   // 像素相同，不必编码
+    m_lastHash = currentHash;
+
+    // 像素哈希直接作为入库的去重键：与编码格式无关，编码后不再对数据重新求键。
+    // 库中已有同样的图片时只刷新那条笔记，不做编码
+    QByteArray contentKey(DatabaseManager::kContentKeySize, Qt::Uninitialized);
+    currentHash.toBytes(reinterpret_cast<uint8_t*>(contentKey.data()));
+    if (DatabaseManager::instance().touchDuplicate(contentKey, sourceApp, sourceTitle)) {
+        qDebug().noquote() << QString("[ClipboardMonitor] 图片 %1x%2 已在库中，跳过编码 (哈希 %3 ms)")
+                                  .arg(image.width()).arg(image.height()).arg(hashMs);
+        return;
+    }
+
+    const QString format = QSettings("RapidNotes", "Clipboard").value("imageFormat", "png-fast").toString();
+    const qint64 rawBytes = image.sizeInBytes();
+    (void)QtConcurrent::run([this, image, format, rawBytes, hashMs, currentHash, contentKey, sourceApp, sourceTitle]() {
+        QElapsedTimer encodeTimer;
+        encodeTimer.start();
+        const QByteArray data = encodeImage(image, format);
+        const qint64 encodeMs = encodeTimer.elapsed();
+
+        QMetaObject::invokeMethod(this, [=, this]() {
+            if (data.isEmpty()) {
+                qWarning() << "[ClipboardMonitor] 图片编码失败:" << format;
+                if (m_lastHash == currentHash) m_lastHash = Xxh3::Hash128();
+                return;
+            }
+            m_encodedCount++;
+            m_encodeMsTotal += encodeMs;
+            m_rawBytesTotal += rawBytes;
+            m_encodedBytesTotal += data.size();
+            qDebug().noquote() << QString("[ClipboardMonitor] 图片 %1x%2 %3: 原始 %4 KB -> %5 KB，哈希 %6 ms，编码 %7 ms "
+                                          "(累计 %8 张，平均编码 %9 ms，平均压缩率 %10%)")
+                                      .arg(image.width()).arg(image.height()).arg(format)
+                                      .arg(rawBytes / 1024).arg(data.size() / 1024).arg(hashMs).arg(encodeMs)
+                                      .arg(m_encodedCount).arg(m_encodeMsTotal / m_encodedCount)
+                                      .arg(m_encodedBytesTotal * 100.0 / qMax<qint64>(1, m_rawBytesTotal), 0, 'f', 1);
+            emit newContentDetected("[图片]", "image", data, sourceApp, sourceTitle, contentKey);
+        });
+    });
+}
+
+QByteArray ClipboardMonitor::encodeImage(const QImage& image, const QString& format) {
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    if (format == "webp" && QImageWriter::supportedImageFormats().contains("webp")) {
+        // quality 100 即无损 WebP
+        QImageWriter writer(&buffer, "webp");
+        writer.setQuality(100);
+        if (writer.write(image)) return data;
+        buffer.seek(0);
+        data.clear();
+    }
+
+    QImageWriter writer(&buffer, "png");
+    // PNG 的 quality 映射为 zlib 压缩级别：80 对应级别 1，比默认级别快数倍，体积只大一点
+    if (format != "png") writer.setQuality(80);
+    if (!writer.write(image)) return QByteArray();
+    return data;
+}
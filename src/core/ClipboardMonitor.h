@@ -4,18 +4,33 @@
 #include <QObject>
 #include <QClipboard>
 #include <QGuiApplication>
-#include <QCryptographicHash>
 #include <QStringList>
+#include <QImage>
+#include "Xxh3.h"
 
+/**
+ * @brief 剪贴板监听
+ *
+ * 图片只对原始像素做一次快速哈希 (XXH3-128)，它同时是入库的去重键：与上一张相同、或库中已有同键的笔记
+ * (只刷新该笔记) 时都不再编码；新图片在线程池中按设置的格式编码 (QSettings "Clipboard/imageFormat"：
+ * png-fast 默认、png、webp)，编码完成后才发出 newContentDetected。键与编码格式无关，切换格式不影响去重。
+ * 每次编码输出原始/编码大小与哈希、编码耗时，并累计平均值。
+ * 文本的去重键 (XXH3-128，见 DatabaseManager::computeContentKey) 同样在这里算好随信号传出，入库时不再重复计算。
+ * 超过 DatabaseManager::largeTextThreshold() 的文本不在这里转码求键，交给入库流程在线程池中处理。
+ */
 class ClipboardMonitor : public QObject {
     Q_OBJECT
 public:
     static ClipboardMonitor& instance();
     void skipNext() { m_skipNext = true; }
 
+    // 按格式编码图片，webp 不可用时退回 png-fast；可在任意线程调用
+    static QByteArray encodeImage(const QImage& image, const QString& format);
+
 signals:
     void newContentDetected(const QString& content, const QString& type, const QByteArray& data = QByteArray(),
-                            const QString& sourceApp = "", const QString& sourceTitle = "");
+                            const QString& sourceApp = "", const QString& sourceTitle = "",
+                            const QByteArray& contentKey = QByteArray());
     void clipboardChanged();
 
 private slots:
@@ -23,8 +38,18 @@ private slots:
 
 private:
     ClipboardMonitor(QObject* parent = nullptr);
-    QString m_lastHash;
+    // 对可见像素哈希 (不含行尾填充)，与图片编码无关
+    static Xxh3::Hash128 hashPixels(const QImage& image);
+    void captureImage(const QImage& image, const QString& sourceApp, const QString& sourceTitle);
+
+    Xxh3::Hash128 m_lastHash;
     bool m_skipNext = false;
+
+    // 图片编码统计
+    int m_encodedCount = 0;
+    qint64 m_encodeMsTotal = 0;
+    qint64 m_rawBytesTotal = 0;
+    qint64 m_encodedBytesTotal = 0;
 };
 
 #endif // CLIPBOARDMONITOR_H
\ No newline at end of file
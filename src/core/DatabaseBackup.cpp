@@ -0,0 +1,312 @@
+#include "DatabaseBackup.h"
+#include "DatabaseManager.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 在当前线程池线程上临时降低 CPU 与磁盘优先级，析构时恢复 (线程会被其他任务复用)
+class BackgroundPriority {
+public:
+    BackgroundPriority() {
+        m_threadPriority = QThread::currentThread()->priority();
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+#ifdef Q_OS_WIN
+        m_background = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(Q_OS_LINUX)
+        // ioprio 按线程生效：IOPRIO_WHO_PROCESS + 0 即调用线程，IDLE 类只在磁盘空闲时得到服务
+        constexpr int kWhoProcess = 1;
+        constexpr int kClassIdle = 3;
+        constexpr int kClassShift = 13;
+        m_ioPriority = static_cast<int>(syscall(SYS_ioprio_get, kWhoProcess, 0));
+        syscall(SYS_ioprio_set, kWhoProcess, 0, kClassIdle << kClassShift);
+#endif
+    }
+    ~BackgroundPriority() {
+#ifdef Q_OS_WIN
+        if (m_background) SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+#elif defined(Q_OS_LINUX)
+        if (m_ioPriority >= 0) syscall(SYS_ioprio_set, 1, 0, m_ioPriority);
+#endif
+        QThread::currentThread()->setPriority(m_threadPriority);
+    }
+
+private:
+    QThread::Priority m_threadPriority;
+#ifdef Q_OS_WIN
+    bool m_background = false;
+#elif defined(Q_OS_LINUX)
+    int m_ioPriority = -1;
+#endif
+};
+
+// SQLite 文件头偏移 24 处的修改计数：回滚日志模式下每次提交事务都会递增
+quint32 sqliteChangeCounter(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    const QByteArray head = file.read(28);
+    return head.size() == 28 ? qFromBigEndian<quint32>(head.constData() + 24) : 0;
+}
+
+QString chunkPath(const QString& hash) {
+    return DatabaseBackup::backupRoot() + "/chunks/" + hash.left(2) + "/" + hash;
+}
+
+QJsonObject readSnapshot(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+} // namespace
+
+DatabaseBackup& DatabaseBackup::instance() {
+    static DatabaseBackup inst;
+    return inst;
+}
+
+DatabaseBackup::DatabaseBackup(QObject* parent) : QObject(parent) {
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &DatabaseBackup::cancel);
+}
+
+DatabaseBackup::~DatabaseBackup() {
+    cancel();
+}
+
+QString DatabaseBackup::backupRoot() {
+    return QCoreApplication::applicationDirPath() + "/backups";
+}
+
+QStringList DatabaseBackup::snapshots() {
+    // 文件名带时间戳，按名称倒序即新的在前
+    QDir dir(backupRoot() + "/snapshots");
+    QStringList result;
+    const QStringList names = dir.entryList(QStringList() << "snapshot_*.json", QDir::Files, QDir::Name | QDir::Reversed);
+    for (const QString& name : names) result << dir.absoluteFilePath(name);
+    return result;
+}
+
+void DatabaseBackup::schedule(const QString& dbPath, int delayMs) {
+    QTimer::singleShot(delayMs, this, [this, dbPath]() {
+        if (m_future.isRunning()) return;
+        m_cancel = false;
+        m_future = QtConcurrent::run([this, dbPath]() {
+            Stats stats;
+            const bool ok = run(dbPath, stats);
+            emit finished(ok, stats.chunksWritten, stats.bytesWritten);
+        });
+    });
+}
+
+void DatabaseBackup::cancel() {
+    m_cancel = true;
+    m_future.waitForFinished();
+}
+
+bool DatabaseBackup::run(const QString& dbPath, Stats& stats) {
+    BackgroundPriority priority;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+        bool raced = false;
+        // 只有第一遍限速：重读时文件多半还在页缓存中，尽快读完才更可能赶在下一次提交之前
+        if (snapshotOnce(dbPath, attempt == 0, &raced, stats)) {
+            pruneSnapshots();
+            qDebug().noquote() << QString("[DatabaseBackup] 备份完成: 新写入 %1 块 (%2 KB)，耗时 %3 ms")
+                                      .arg(stats.chunksWritten).arg(stats.bytesWritten / 1024).arg(timer.elapsed());
+            return true;
+        }
+        if (!raced || m_cancel) break;
+        qDebug() << "[DatabaseBackup] 读取期间数据库有写入，重新生成快照";
+    }
+    // 作废快照写入的块由下一次成功备份后的清理回收
+    qWarning() << "[DatabaseBackup] 本次备份未完成";
+    return false;
+}
+
+bool DatabaseBackup::snapshotOnce(const QString& dbPath, bool throttle, bool* raced, Stats& stats) {
+    *raced = false;
+    quint32 counter = 0;
+    qint64 size = 0;
+    DatabaseManager::instance().runExclusive([&] {
+        counter = sqliteChangeCounter(dbPath);
+        size = QFileInfo(dbPath).size();
+    });
+
+    const QStringList existing = snapshots();
+    if (!existing.isEmpty()) {
+        const QJsonObject last = readSnapshot(existing.first());
+        if (last.value("changeCounter").toInteger() == counter && last.value("size").toInteger() == size) {
+            qDebug() << "[DatabaseBackup] 数据库自上次备份以来没有变化，跳过";
+            return true;
+        }
+    }
+
+    QFile file(dbPath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QJsonArray chunks;
+    QByteArray buffer(kChunkSize, Qt::Uninitialized);
+    QElapsedTimer throttleTimer;
+    throttleTimer.start();
+    qint64 readTotal = 0;
+    for (;;) {
+        if (m_cancel) return false;
+        const qint64 got = file.read(buffer.data(), kChunkSize);
+        if (got < 0) return false;
+        if (got == 0) break;
+        const QByteArray data = QByteArray::fromRawData(buffer.constData(), got);
+        const QString hash = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+        if (!storeChunk(hash, data, stats)) return false;
+        chunks.append(hash);
+
+        readTotal += got;
+        if (throttle) {
+            const qint64 due = readTotal * 1000 / kReadBytesPerSecond;
+            if (due > throttleTimer.elapsed()) QThread::msleep(static_cast<unsigned long>(due - throttleTimer.elapsed()));
+        }
+    }
+
+    quint32 counterAfter = 0;
+    qint64 sizeAfter = 0;
+    DatabaseManager::instance().runExclusive([&] {
+        counterAfter = sqliteChangeCounter(dbPath);
+        sizeAfter = QFileInfo(dbPath).size();
+    });
+    if (counterAfter != counter || sizeAfter != size || readTotal != size) {
+        *raced = true;
+        return false;
+    }
+
+    QJsonObject snapshot;
+    snapshot["version"] = 1;
+    snapshot["created"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    snapshot["size"] = size;
+    snapshot["chunkSize"] = kChunkSize;
+    snapshot["changeCounter"] = static_cast<qint64>(counter);
+    snapshot["chunks"] = chunks;
+
+    const QString dir = backupRoot() + "/snapshots";
+    QDir().mkpath(dir);
+    QSaveFile out(dir + "/snapshot_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".json");
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(QJsonDocument(snapshot).toJson(QJsonDocument::Compact));
+    return out.commit();
+}
+
+bool DatabaseBackup::storeChunk(const QString& hash, const QByteArray& data, Stats& stats) {
+    const QString path = chunkPath(hash);
+    if (QFileInfo::exists(path)) return true;   // 其他快照已有相同内容
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    const QByteArray compressed = qCompress(data, 6);
+    if (out.write(compressed) != compressed.size() || !out.commit()) return false;
+    stats.chunksWritten++;
+    stats.bytesWritten += compressed.size();
+    return true;
+}
+
+void DatabaseBackup::pruneSnapshots() {
+    QStringList list = snapshots();
+    while (list.size() > kMaxSnapshots) {
+        QFile::remove(list.takeLast());
+    }
+
+    // 回收不再被任何快照引用的块
+    QSet<QString> referenced;
+    for (const QString& path : std::as_const(list)) {
+        const QJsonArray chunks = readSnapshot(path).value("chunks").toArray();
+        for (const QJsonValue& v : chunks) referenced.insert(v.toString());
+    }
+    QDir chunkRoot(backupRoot() + "/chunks");
+    const QStringList buckets = chunkRoot.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& bucket : buckets) {
+        QDir dir(chunkRoot.absoluteFilePath(bucket));
+        const QStringList files = dir.entryList(QDir::Files);
+        for (const QString& name : files) {
+            if (!referenced.contains(name)) QFile::remove(dir.absoluteFilePath(name));
+        }
+    }
+
+    // 旧版每次启动整库复制的 backup_*.db：最新的快照能还原出通过完整性检查的数据库之后才只保留最新一份，
+    // 在此之前仍按旧版的数量上限保留
+    QDir root(backupRoot());
+    QFileInfoList legacy = root.entryInfoList(QStringList() << "backup_*.db", QDir::Files, QDir::Time);
+    if (legacy.size() <= 1) return;
+    const int keep = (!list.isEmpty() && verifySnapshot(list.first())) ? 1 : kMaxLegacyBackups;
+    while (legacy.size() > keep) {
+        QFile::remove(legacy.takeLast().absoluteFilePath());
+    }
+}
+
+bool DatabaseBackup::verifySnapshot(const QString& snapshotPath) {
+    QTemporaryDir dir;
+    if (!dir.isValid()) return false;
+    const QString path = dir.filePath("verify.db");
+    if (!restore(snapshotPath, path)) return false;
+
+    bool ok = false;
+    const QString connName = "backup_verify";
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
+        db.setDatabaseName(path);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (db.open()) {
+            QSqlQuery q(db);
+            ok = q.exec("PRAGMA integrity_check") && q.next() && q.value(0).toString() == "ok";
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connName);
+    if (!ok) qWarning() << "[DatabaseBackup] 快照未通过完整性检查:" << snapshotPath;
+    return ok;
+}
+
+bool DatabaseBackup::restore(const QString& snapshotPath, const QString& destPath) {
+    const QJsonObject snapshot = readSnapshot(snapshotPath);
+    if (snapshot.value("version").toInt() != 1) return false;
+
+    QSaveFile out(destPath);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    const QJsonArray chunks = snapshot.value("chunks").toArray();
+    for (const QJsonValue& v : chunks) {
+        const QString hash = v.toString();
+        QFile file(chunkPath(hash));
+        if (!file.open(QIODevice::ReadOnly)) return false;
+        const QByteArray data = qUncompress(file.readAll());
+        if (QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex() != hash.toLatin1()) {
+            qWarning() << "[DatabaseBackup] 备份块已损坏:" << hash;
+            return false;
+        }
+        if (out.write(data) != data.size()) return false;
+    }
+    return out.size() == snapshot.value("size").toInteger() && out.commit();
+}
@@ -0,0 +1,66 @@
+#ifndef DATABASEBACKUP_H
+#define DATABASEBACKUP_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFuture>
+#include <atomic>
+
+/**
+ * @brief 后台增量数据库备份
+ *
+ * 启动后延迟一段时间，在线程池中以最低 CPU / IO 优先级读取数据库文件并限速。文件按 kChunkSize 切块，
+ * 每块按 SHA-256 压缩存放到 backups/chunks/<前两位>/<哈希>，快照只是一份记录块哈希序列的清单
+ * (backups/snapshots/*.json)。未变化的块在各快照之间共享，一次备份只写入新出现的块。
+ *
+ * 读取期间不持有数据库锁：开始与结束时在锁内各读一次 SQLite 文件头的修改计数，
+ * 两次不一致说明中途有事务提交，快照作废并重读 (此时数据多半已在页缓存中，重读不再限速)。
+ * 修改计数与上一份快照相同时直接跳过。
+ */
+class DatabaseBackup : public QObject {
+    Q_OBJECT
+public:
+    static constexpr qint64 kChunkSize = 256 * 1024;            // SQLite 页大小的整数倍
+    static constexpr int kMaxSnapshots = 20;
+    static constexpr int kMaxLegacyBackups = 20;                // 旧版 backup_*.db 的保留数量
+    static constexpr int kStartupDelayMs = 30 * 1000;
+    static constexpr qint64 kReadBytesPerSecond = 32 * 1024 * 1024;
+    static constexpr int kMaxAttempts = 3;
+
+    static DatabaseBackup& instance();
+
+    static QString backupRoot();                // <程序目录>/backups
+    static QStringList snapshots();             // 快照清单路径，新的在前
+    // 由快照清单还原出完整的数据库文件
+    static bool restore(const QString& snapshotPath, const QString& destPath);
+
+    // 延迟 delayMs 后在后台备份 dbPath，程序退出时自动取消
+    void schedule(const QString& dbPath, int delayMs = kStartupDelayMs);
+    void cancel();
+
+signals:
+    void finished(bool ok, int chunksWritten, qint64 bytesWritten);
+
+private:
+    DatabaseBackup(QObject* parent = nullptr);
+    ~DatabaseBackup();
+    DatabaseBackup(const DatabaseBackup&) = delete;
+    DatabaseBackup& operator=(const DatabaseBackup&) = delete;
+
+    struct Stats {
+        int chunksWritten = 0;
+        qint64 bytesWritten = 0;
+    };
+    bool run(const QString& dbPath, Stats& stats);
+    bool snapshotOnce(const QString& dbPath, bool throttle, bool* raced, Stats& stats);
+    static bool storeChunk(const QString& hash, const QByteArray& data, Stats& stats);
+    static void pruneSnapshots();
+    // 把快照还原到临时文件并做 PRAGMA integrity_check
+    static bool verifySnapshot(const QString& snapshotPath);
+
+    QFuture<void> m_future;
+    std::atomic<bool> m_cancel{false};
+};
+
+#endif // DATABASEBACKUP_H
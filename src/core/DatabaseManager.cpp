@@ -1,14 +1,19 @@
 #include "DatabaseManager.h"
+#include "BlobStore.h"
+#include "DatabaseBackup.h"
 #include <QDebug>
 #include <QSqlRecord>
 #include <QtConcurrent>
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QTimer>
 #include <QFile>
 #include <QDir>
 #include <QCryptographicHash>
 #include <QRandomGenerator>
 #include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QSettings>
 
 DatabaseManager& DatabaseManager::instance() {
     static DatabaseManager inst;
@@ -36,23 +41,13 @@ DatabaseManager::~DatabaseManager() {
     }
 }
 
-bool DatabaseManager::init(const QString& dbPath) {
+bool DatabaseManager::init(const QString& dbPath, bool backup) {
     QMutexLocker locker(&m_mutex);
     m_dbPath = dbPath;
     
-    // 自动备份
-    if (QFile::exists(dbPath)) {
-        QString backupDir = QCoreApplication::applicationDirPath() + "/backups";
-        QDir().mkpath(backupDir);
-        QString backupPath = backupDir + "/backup_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".db";
-        if (QFile::copy(dbPath, backupPath)) {
-            // 清理旧备份 (保留 20 份)
-            QDir dir(backupDir);
-            QFileInfoList list = dir.entryInfoList(QStringList() << "*.db", QDir::Files, QDir::Time);
-            while (list.size() > 20) {
-                QFile::remove(list.takeLast().absoluteFilePath());
-            }
-        }
+    // 自动备份：启动完成后在后台做增量快照，不再阻塞启动
+    if (backup && QFile::exists(dbPath)) {
+        DatabaseBackup::instance().schedule(dbPath);
     }
 
     if (m_db.isOpen()) m_db.close();
@@ -65,11 +60,32 @@ bool DatabaseManager::init(const QString& dbPath) {
         return false;
     }
 
+    // 读取 (尤其是图片块) 走内存映射，省去逐页拷贝到页缓存
+    QSqlQuery(m_db).exec(QString("PRAGMA mmap_size = %1").arg(kMmapSize));
+
     if (!createTables()) return false;
+    loadContentKeys();
+    // 旧库的图片搬迁与内容键补算可能要几秒：等界面显示后在事件循环中分批进行，不拖慢启动
+    if (!m_migrationRunning) {
+        m_migrationRunning = true;
+        m_migratedImages = m_migratedKeys = 0;
+        m_migrationTimer.start();
+        scheduleMigration(kMigrationDelayMs);
+    }
 
     return true;
 }
 
+void DatabaseManager::close() {
+    QMutexLocker locker(&m_mutex);
+    if (m_db.isOpen()) m_db.close();
+}
+
+void DatabaseManager::runExclusive(const std::function<void()>& fn) {
+    QMutexLocker locker(&m_mutex);
+    fn();
+}
+
 bool DatabaseManager::createTables() {
     QSqlQuery query(m_db);
     
@@ -93,7 +109,14 @@ bool DatabaseManager::createTables() {
             is_favorite INTEGER DEFAULT 0,
             is_deleted INTEGER DEFAULT 0,
             source_app TEXT,
-            source_title TEXT
+            source_title TEXT,
+            image_hash TEXT,
+            content_key BLOB,
+            large_size INTEGER DEFAULT 0,
+            ocr_text TEXT,
+            ocr_state INTEGER DEFAULT 0,
+            ocr_failures INTEGER DEFAULT 0,
+            ocr_retry_at INTEGER
         )
     )";
     
@@ -108,7 +131,14 @@ bool DatabaseManager::createTables() {
         "ALTER TABLE notes ADD COLUMN content_hash TEXT",
         "ALTER TABLE notes ADD COLUMN rating INTEGER DEFAULT 0",
         "ALTER TABLE notes ADD COLUMN source_app TEXT",
-        "ALTER TABLE notes ADD COLUMN source_title TEXT"
+        "ALTER TABLE notes ADD COLUMN source_title TEXT",
+        "ALTER TABLE notes ADD COLUMN image_hash TEXT",
+        "ALTER TABLE notes ADD COLUMN content_key BLOB",
+        "ALTER TABLE notes ADD COLUMN large_size INTEGER DEFAULT 0",
+        "ALTER TABLE notes ADD COLUMN ocr_text TEXT",
+        "ALTER TABLE notes ADD COLUMN ocr_state INTEGER DEFAULT 0",
+        "ALTER TABLE notes ADD COLUMN ocr_failures INTEGER DEFAULT 0",
+        "ALTER TABLE notes ADD COLUMN ocr_retry_at INTEGER"
     };
     for (const QString& sql : columnsToAdd) {
         query.exec(sql); // 忽略已存在的错误
@@ -139,14 +169,47 @@ bool DatabaseManager::createTables() {
     
     // 索引
     query.exec("CREATE INDEX IF NOT EXISTS idx_notes_content_hash ON notes(content_hash)");
-
-    // 4. FTS5 全文搜索
+    query.exec("CREATE INDEX IF NOT EXISTS idx_notes_image_hash ON notes(image_hash)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_notes_content_key ON notes(content_key)");
+    // 后台 OCR 待处理的图片笔记 (部分索引，只含未识别的行)
+    query.exec("CREATE INDEX IF NOT EXISTS idx_notes_ocr_pending ON notes(id) WHERE ocr_state = 0 AND item_type = 'image'");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_notes_ocr_failed ON notes(ocr_retry_at) WHERE ocr_state = 3 AND item_type = 'image'");
+
+    // 图片内容单独存放，hash 为该图片 notes.content_key (XXH3-128) 的十六进制，不是 SHA-256；
+    // notes 表只保留引用，列表扫描不再拖着整张 PNG 的溢出页
+    query.exec("CREATE TABLE IF NOT EXISTS image_blobs (hash TEXT PRIMARY KEY, size INTEGER, data BLOB)");
+
+    // 超大文本的正文分块 (qCompress 后的 UTF-8)，notes 表只留预览
+    query.exec("CREATE TABLE IF NOT EXISTS note_texts (note_id INTEGER, seq INTEGER, data BLOB, PRIMARY KEY (note_id, seq))");
+
+    // OCR 识别结果缓存，同一张图再次识别时直接取用
+    query.exec("CREATE TABLE IF NOT EXISTS ocr_cache (key BLOB PRIMARY KEY, language TEXT, text TEXT, "
+               "hits INTEGER DEFAULT 0, created_at DATETIME DEFAULT CURRENT_TIMESTAMP, last_used DATETIME DEFAULT CURRENT_TIMESTAMP)");
+    query.exec("ALTER TABLE ocr_cache ADD COLUMN blocks BLOB");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_ocr_cache_last_used ON ocr_cache(last_used)");
+
+    // 附件内容块 (BlobStore) 及笔记引用关系，ref_count 供清空回收站时回收
+    query.exec("CREATE TABLE IF NOT EXISTS blobs (hash TEXT PRIMARY KEY, size INTEGER, ref_count INTEGER DEFAULT 0)");
+    query.exec("CREATE TABLE IF NOT EXISTS note_blobs (note_id INTEGER, blob_hash TEXT, rel_path TEXT)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_note_blobs_note ON note_blobs(note_id)");
+
+    // 4. FTS5 全文搜索 (ocr_text 为图片笔记的识别文字)
+    bool ftsHasOcr = false;
+    query.exec("PRAGMA table_info(notes_fts)");
+    while (query.next()) {
+        if (query.value(1).toString() == "ocr_text") ftsHasOcr = true;
+    }
+    if (!ftsHasOcr) {
+        // 旧版索引只有 title、content 两列：删除后按三列重建
+        query.exec("DROP TABLE IF EXISTS notes_fts");
+    }
     QString createFtsTable = R"(
         CREATE VIRTUAL TABLE IF NOT EXISTS notes_fts USING fts5(
-            title, content, content='notes', content_rowid='id'
+            title, content, ocr_text, content='notes', content_rowid='id'
         )
     )";
     query.exec(createFtsTable);
+    if (!ftsHasOcr) rebuildFts();
 
     // 移除旧的 FTS 触发器，改为在 C++ 层手动管理，以支持 HTML 剥离
     query.exec("DROP TRIGGER IF EXISTS notes_ai");
@@ -160,100 +223,222 @@ bool DatabaseManager::createTables() {
 bool DatabaseManager::addNote(const QString& title, const QString& content, const QStringList& tags,
                              const QString& color, int categoryId,
                              const QString& itemType, const QByteArray& dataBlob,
-                             const QString& sourceApp, const QString& sourceTitle) {
+                             const QString& sourceApp, const QString& sourceTitle,
+                             const QByteArray& contentKey) {
+    QByteArray key = contentKey;
+    LargeText large;
+    prepareContent(content, itemType, dataBlob, key, large);
+    return addPreparedNote(title, content, tags, color, categoryId, itemType, dataBlob, sourceApp, sourceTitle,
+                           key, large);
+}
+
+void DatabaseManager::prepareContent(const QString& content, const QString& itemType, const QByteArray& dataBlob,
+                                     QByteArray& key, LargeText& large) {
+    // 调用方 (剪贴板捕获) 已算好的键直接沿用，否则在此计算一次
+    const bool needKey = key.size() != kContentKeySize;
+    if (isLargeText(itemType, content)) {
+        const QByteArray utf8 = content.toUtf8();
+        if (needKey) key = computeContentKey(utf8);
+        large = compressLargeText(content, utf8);
+    } else if (needKey) {
+        key = computeContentKey(dataBlob.isEmpty() ? content.toUtf8() : dataBlob);
+    }
+}
+
+bool DatabaseManager::addPreparedNote(const QString& title, const QString& content, const QStringList& tags,
+                                      const QString& color, int categoryId, const QString& itemType,
+                                      const QByteArray& dataBlob, const QString& sourceApp, const QString& sourceTitle,
+                                      const QByteArray& key, const LargeText& large) {
     QVariantMap newNoteMap;
     bool success = false;
-    QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
-
-    // 计算 SHA256 哈希值
-    QByteArray hashData = dataBlob.isEmpty() ? content.toUtf8() : dataBlob;
-    QString contentHash = QCryptographicHash::hash(hashData, QCryptographicHash::Sha256).toHex();
+    // 超大文本的 notes.content 与全文索引都只用预览
+    const QString storedContent = large.isNull() ? content : large.preview;
 
     {   // === 锁的作用域开始 ===
         QMutexLocker locker(&m_mutex);
         if (!m_db.isOpen()) return false;
 
-        QSqlQuery checkQuery(m_db);
-        // 首先检查哈希是否存在（且未删除）
-        checkQuery.prepare("SELECT id FROM notes WHERE content_hash = :hash AND is_deleted = 0 LIMIT 1");
-        checkQuery.bindValue(":hash", contentHash);
-        
-        if (checkQuery.exec() && checkQuery.next()) {
-            // --- 命中重复：更新时间戳和来源（即置顶逻辑） ---
-            int existingId = checkQuery.value(0).toInt();
-            QSqlQuery updateQuery(m_db);
-            updateQuery.prepare("UPDATE notes SET updated_at = :now, source_app = :app, source_title = :stitle "
-                                "WHERE id = :id");
-            updateQuery.bindValue(":now", currentTime);
-            updateQuery.bindValue(":app", sourceApp);
-            updateQuery.bindValue(":stitle", sourceTitle);
-            updateQuery.bindValue(":id", existingId);
-            
-            if (updateQuery.exec()) {
-                success = true; // 复用外部 success 变量
-            }
+        // --- 命中重复：更新时间戳和来源（即置顶逻辑） ---
+        if (touchDuplicateLocked(key, sourceApp, sourceTitle)) {
+            locker.unlock(); // 提前释放锁
+            emit noteUpdated();
+            return true;
+        }
 
-            if (success) {
-                locker.unlock(); // 提前释放锁
-                emit noteUpdated();
-                return true;
-            }
+        // --- 未命中：插入新记录 (超大文本连同分块在同一事务中写入) ---
+        if (!large.isNull()) m_db.transaction();
+        const int noteId = insertNoteLocked(title, storedContent, tags, color, categoryId, itemType, dataBlob, key,
+                                            large.size, sourceApp, sourceTitle, newNoteMap);
+        success = noteId > 0 && (large.isNull() || storeLargeTextLocked(noteId, large));
+        if (!large.isNull()) {
+            if (success) success = m_db.commit();
+            else m_db.rollback();
         }
+    }
 
-        // --- 未命中：插入新记录 ---
-        QString finalColor = color.isEmpty() ? "#2d2d2d" : color;
-        QStringList finalTags = tags;
+    if (success && !newNoteMap.isEmpty()) {
+        syncFts(newNoteMap["id"].toInt(), title, storedContent);
+        emit noteAdded(newNoteMap);
+    }
+    
+    return success;
+}
 
-        // 获取分类预设标签和颜色 (如果指定了分类且未指定颜色)
-        if (categoryId != -1) {
-            QSqlQuery catQuery(m_db);
-            catQuery.prepare("SELECT color, preset_tags FROM categories WHERE id = :id");
-            catQuery.bindValue(":id", categoryId);
-            if (catQuery.exec() && catQuery.next()) {
-                if (color.isEmpty()) finalColor = catQuery.value(0).toString();
-                QString preset = catQuery.value(1).toString();
-                if (!preset.isEmpty()) {
-                    QStringList pTags = preset.split(",", Qt::SkipEmptyParts);
-                    for (const QString& t : pTags) {
-                        QString trimmed = t.trimmed();
-                        if (!finalTags.contains(trimmed)) finalTags << trimmed;
-                    }
+int DatabaseManager::insertNoteLocked(const QString& title, const QString& content, const QStringList& tags,
+                                      const QString& color, int categoryId, const QString& itemType,
+                                      const QByteArray& dataBlob, const QByteArray& contentKey, qint64 largeSize,
+                                      const QString& sourceApp, const QString& sourceTitle, QVariantMap& noteMap) {
+    QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    QString finalColor = color.isEmpty() ? "#2d2d2d" : color;
+    QStringList finalTags = tags;
+
+    // 获取分类预设标签和颜色 (如果指定了分类且未指定颜色)
+    if (categoryId != -1) {
+        QSqlQuery catQuery(m_db);
+        catQuery.prepare("SELECT color, preset_tags FROM categories WHERE id = :id");
+        catQuery.bindValue(":id", categoryId);
+        if (catQuery.exec() && catQuery.next()) {
+            if (color.isEmpty()) finalColor = catQuery.value(0).toString();
+            QString preset = catQuery.value(1).toString();
+            if (!preset.isEmpty()) {
+                QStringList pTags = preset.split(",", Qt::SkipEmptyParts);
+                for (const QString& t : pTags) {
+                    QString trimmed = t.trimmed();
+                    if (!finalTags.contains(trimmed)) finalTags << trimmed;
                 }
             }
         }
+    }
+
+    QString imageHash;
+    if (!dataBlob.isEmpty()) {
+        imageHash = storeImageLocked(dataBlob, QString::fromLatin1(contentKey.toHex()));
+        if (imageHash.isEmpty()) return 0;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare("INSERT INTO notes (title, content, tags, color, category_id, item_type, image_hash, "
+                  "content_key, large_size, created_at, updated_at, source_app, source_title) "
+                  "VALUES (:title, :content, :tags, :color, :category_id, :item_type, :image_hash, "
+                  ":key, :large_size, :created_at, :updated_at, :source_app, :source_title)");
+    query.bindValue(":title", title);
+    query.bindValue(":content", content);
+    query.bindValue(":tags", finalTags.join(","));
+    query.bindValue(":color", finalColor);
+    query.bindValue(":category_id", categoryId == -1 ? QVariant(QMetaType::fromType<int>()) : categoryId);
+    query.bindValue(":item_type", itemType);
+    query.bindValue(":image_hash", imageHash.isEmpty() ? QVariant(QMetaType::fromType<QString>()) : imageHash);
+    query.bindValue(":key", contentKey);
+    query.bindValue(":large_size", largeSize);
+    query.bindValue(":created_at", currentTime);
+    query.bindValue(":updated_at", currentTime);
+    query.bindValue(":source_app", sourceApp);
+    query.bindValue(":source_title", sourceTitle);
+
+    if (!query.exec()) {
+        qCritical() << "添加笔记失败:" << query.lastError().text();
+        return 0;
+    }
+
+    QVariant lastId = query.lastInsertId();
+    m_contentKeys.insert(toHash128(contentKey));
+    QSqlQuery fetch(m_db);
+    fetch.prepare("SELECT * FROM notes WHERE id = :id");
+    fetch.bindValue(":id", lastId);
+    if (fetch.exec() && fetch.next()) {
+        QSqlRecord rec = fetch.record();
+        for (int i = 0; i < rec.count(); ++i) {
+            noteMap[rec.fieldName(i)] = fetch.value(i);
+        }
+    }
+    return lastId.toInt();
+}
 
+int DatabaseManager::addPendingImageNote(const QString& title, const QString& content, const QStringList& tags) {
+    // 占位键随机生成，图片就绪后换成图片内容的键
+    QByteArray key(kContentKeySize, Qt::Uninitialized);
+    QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(key.data()), kContentKeySize / sizeof(quint32));
+    QVariantMap newNoteMap;
+    int noteId = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen()) return 0;
+        noteId = insertNoteLocked(title, content, tags, "", -1, "image", QByteArray(), key, 0, "", "", newNoteMap);
+    }
+    if (noteId > 0 && !newNoteMap.isEmpty()) {
+        syncFts(noteId, title, content);
+        emit noteAdded(newNoteMap);
+    }
+    return noteId;
+}
+
+bool DatabaseManager::attachNoteImage(int id, const QByteArray& imageData, const QByteArray& contentKey) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen()) return false;
+        m_db.transaction();
+        const QString imageHash = storeImageLocked(imageData, QString::fromLatin1(contentKey.toHex()));
         QSqlQuery query(m_db);
-        query.prepare("INSERT INTO notes (title, content, tags, color, category_id, item_type, data_blob, "
-                      "content_hash, created_at, updated_at, source_app, source_title) "
-                      "VALUES (:title, :content, :tags, :color, :category_id, :item_type, :data_blob, "
-                      ":hash, :created_at, :updated_at, :source_app, :source_title)");
-        query.bindValue(":title", title);
-        query.bindValue(":content", content);
-        query.bindValue(":tags", finalTags.join(","));
-        query.bindValue(":color", finalColor);
-        query.bindValue(":category_id", categoryId == -1 ? QVariant(QMetaType::fromType<int>()) : categoryId);
-        query.bindValue(":item_type", itemType);
-        query.bindValue(":data_blob", dataBlob);
-        query.bindValue(":hash", contentHash);
-        query.bindValue(":created_at", currentTime);
-        query.bindValue(":updated_at", currentTime);
-        query.bindValue(":source_app", sourceApp);
-        query.bindValue(":source_title", sourceTitle);
-        
-        if (query.exec()) {
-            success = true;
-            QVariant lastId = query.lastInsertId();
-            QSqlQuery fetch(m_db);
-            fetch.prepare("SELECT * FROM notes WHERE id = :id");
-            fetch.bindValue(":id", lastId);
-            if (fetch.exec() && fetch.next()) {
-                QSqlRecord rec = fetch.record();
-                for (int i = 0; i < rec.count(); ++i) {
-                    newNoteMap[rec.fieldName(i)] = fetch.value(i);
-                }
+        query.prepare("UPDATE notes SET image_hash = :hash, content_key = :key WHERE id = :id");
+        query.bindValue(":hash", imageHash);
+        query.bindValue(":key", contentKey);
+        query.bindValue(":id", id);
+        if (imageHash.isEmpty() || !query.exec() || !m_db.commit()) {
+            qCritical() << "写入截屏图片失败:" << query.lastError().text();
+            m_db.rollback();
+            return false;
+        }
+        m_contentKeys.insert(toHash128(contentKey));
+    }
+    emit noteUpdated();
+    return true;
+}
+
+bool DatabaseManager::addStoredFileNote(const QString& title, const QString& content, const QStringList& tags,
+                                        const QString& color, int categoryId, const QString& itemType,
+                                        const QString& sourceApp, const QString& sourceTitle,
+                                        const QList<QVariantMap>& blobs) {
+    QVariantMap newNoteMap;
+    bool success = false;
+    const QByteArray contentKey = computeContentKey(content.toUtf8());
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen()) return false;
+
+        // 笔记、引用关系与块计数在同一事务中写入，任何一步失败都整体回滚
+        m_db.transaction();
+        const int noteId = insertNoteLocked(title, content, tags, color, categoryId, itemType, QByteArray(),
+                                            contentKey, 0, sourceApp, sourceTitle, newNoteMap);
+        success = noteId > 0;
+
+        QSqlQuery blobQuery(m_db);
+        blobQuery.prepare("INSERT INTO blobs (hash, size, ref_count) VALUES (?, ?, 1) "
+                          "ON CONFLICT(hash) DO UPDATE SET ref_count = ref_count + 1");
+        QSqlQuery refQuery(m_db);
+        refQuery.prepare("INSERT INTO note_blobs (note_id, blob_hash, rel_path) VALUES (?, ?, ?)");
+
+        for (const QVariantMap& blob : blobs) {
+            if (!success) break;
+            // 复制期间块可能刚被清空回收站回收 (入库时判断为已存在)，在锁内确认块文件仍在，否则从物化副本重建
+            if (!BlobStore::ensureBlob(blob.value("hash").toString(), blob.value("path").toString())) {
+                qCritical() << "归档文件的块已丢失且无法重建:" << blob.value("hash").toString();
+                success = false;
+                break;
             }
+            blobQuery.addBindValue(blob.value("hash"));
+            blobQuery.addBindValue(blob.value("size"));
+            refQuery.addBindValue(noteId);
+            refQuery.addBindValue(blob.value("hash"));
+            refQuery.addBindValue(blob.value("path"));
+            success = blobQuery.exec() && refQuery.exec();
+        }
+
+        if (success) {
+            success = m_db.commit();
         } else {
-            qCritical() << "添加笔记失败:" << query.lastError().text();
+            qCritical() << "归档文件写入失败:" << blobQuery.lastError().text() << refQuery.lastError().text();
+            m_db.rollback();
         }
     }
 
@@ -261,7 +446,6 @@ bool DatabaseManager::addNote(const QString& title, const QString& content, cons
         syncFts(newNoteMap["id"].toInt(), title, content);
         emit noteAdded(newNoteMap);
     }
-    
     return success;
 }
 
@@ -269,12 +453,17 @@ bool DatabaseManager::updateNote(int id, const QString& title, const QString& co
                                 const QString& color, int categoryId) {
     bool success = false;
     QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    const bool keepBody = content.isNull();
+    const LargeText large = !keepBody && isLargeText("text", content)
+        ? compressLargeText(content, content.toUtf8()) : LargeText();
+    QString ftsContent = large.isNull() ? content : large.preview;
     {
         QMutexLocker locker(&m_mutex);
         if (!m_db.isOpen()) return false;
 
         QSqlQuery query(m_db);
-        QString sql = "UPDATE notes SET title=:title, content=:content, tags=:tags, updated_at=:updated_at";
+        QString sql = "UPDATE notes SET title=:title, tags=:tags, updated_at=:updated_at";
+        if (!keepBody) sql += ", content=:content, large_size=:large_size";
         if (!color.isEmpty()) {
             sql += ", color=:color";
         } else if (categoryId != -1) {
@@ -292,9 +481,12 @@ bool DatabaseManager::updateNote(int id, const QString& title, const QString& co
 
         query.prepare(sql);
         query.bindValue(":title", title);
-        query.bindValue(":content", content);
         query.bindValue(":tags", tags.join(","));
         query.bindValue(":updated_at", currentTime);
+        if (!keepBody) {
+            query.bindValue(":content", ftsContent);
+            query.bindValue(":large_size", large.size);
+        }
         
         if (!color.isEmpty()) {
             query.bindValue(":color", color);
@@ -309,11 +501,29 @@ bool DatabaseManager::updateNote(int id, const QString& title, const QString& co
         if (categoryId != -1) query.bindValue(":category_id", categoryId);
         query.bindValue(":id", id);
         
+        // 正文与分块一起替换：变小的文本清掉旧分块，仍超阈值的写入新分块
+        m_db.transaction();
         success = query.exec();
+        if (success && !keepBody) {
+            QSqlQuery clear(m_db);
+            clear.prepare("DELETE FROM note_texts WHERE note_id = :id");
+            clear.bindValue(":id", id);
+            success = clear.exec() && (large.isNull() || storeLargeTextLocked(id, large));
+        }
+        if (success) success = m_db.commit();
+        else m_db.rollback();
+
+        if (success && keepBody) {
+            // 全文索引仍需随标题更新，正文沿用库中的预览
+            QSqlQuery fetch(m_db);
+            fetch.prepare("SELECT content FROM notes WHERE id = :id");
+            fetch.bindValue(":id", id);
+            if (fetch.exec() && fetch.next()) ftsContent = fetch.value(0).toString();
+        }
     }
 
     if (success) {
-        syncFts(id, title, content);
+        syncFts(id, title, ftsContent);
         emit noteUpdated();
     }
     return success;
@@ -435,6 +645,7 @@ bool DatabaseManager::restoreAllFromTrash() {
 
 // 【修复核心】防止死锁的 updateNoteState
 bool DatabaseManager::updateNoteState(int id, const QString& column, const QVariant& value) {
+    if (column == "content") return updateNoteContent(id, value.toString());
     bool success = false;
     QString title, content;
     bool needsFts = false;
@@ -443,7 +654,7 @@ bool DatabaseManager::updateNoteState(int id, const QString& column, const QVari
         QMutexLocker locker(&m_mutex);
         if (!m_db.isOpen()) return false;
         
-        QStringList allowedColumns = {"is_pinned", "is_locked", "is_favorite", "is_deleted", "tags", "rating", "category_id", "color", "content", "title"};
+        QStringList allowedColumns = {"is_pinned", "is_locked", "is_favorite", "is_deleted", "tags", "rating", "category_id", "color", "title"};
         if (!allowedColumns.contains(column)) return false;
 
         QSqlQuery query(m_db);
@@ -489,7 +700,7 @@ bool DatabaseManager::updateNoteState(int id, const QString& column, const QVari
         
         success = query.exec();
         
-        if (success && (column == "content" || column == "title")) {
+        if (success && column == "title") {
             needsFts = true;
             QSqlQuery fetch(m_db);
             fetch.prepare("SELECT title, content FROM notes WHERE id = ?");
@@ -508,6 +719,47 @@ bool DatabaseManager::updateNoteState(int id, const QString& column, const QVari
     return success;
 }
 
+bool DatabaseManager::updateNoteContent(int id, const QString& content) {
+    const LargeText large = isLargeText("text", content) ? compressLargeText(content, content.toUtf8()) : LargeText();
+    const QString storedContent = large.isNull() ? content : large.preview;
+    QString title;
+    bool success = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen()) return false;
+
+        // 正文与分块在同一事务中替换，不会出现预览与全文不一致
+        m_db.transaction();
+        QSqlQuery query(m_db);
+        query.prepare("UPDATE notes SET content = :content, large_size = :large_size, updated_at = :now WHERE id = :id");
+        query.bindValue(":content", storedContent);
+        query.bindValue(":large_size", large.size);
+        query.bindValue(":now", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+        query.bindValue(":id", id);
+        success = query.exec();
+        if (success) {
+            QSqlQuery clear(m_db);
+            clear.prepare("DELETE FROM note_texts WHERE note_id = :id");
+            clear.bindValue(":id", id);
+            success = clear.exec() && (large.isNull() || storeLargeTextLocked(id, large));
+        }
+        if (success) success = m_db.commit();
+        else m_db.rollback();
+
+        if (success) {
+            QSqlQuery fetch(m_db);
+            fetch.prepare("SELECT title FROM notes WHERE id = :id");
+            fetch.bindValue(":id", id);
+            if (fetch.exec() && fetch.next()) title = fetch.value(0).toString();
+        }
+    }
+    if (success) {
+        syncFts(id, title, storedContent);
+        emit noteUpdated();
+    }
+    return success;
+}
+
 bool DatabaseManager::updateNoteStateBatch(const QList<int>& ids, const QString& column, const QVariant& value) {
     if (ids.isEmpty()) return true;
     bool success = false;
@@ -649,7 +901,11 @@ bool DatabaseManager::deleteNote(int id) {
         query.prepare("DELETE FROM notes WHERE id=:id");
         query.bindValue(":id", id);
         success = query.exec();
-        if (success) removeFts(id);
+        if (success) {
+            removeFts(id);
+            removeOrphanImagesLocked();
+            removeOrphanTextsLocked();
+        }
     } // 自动解锁
 
     if (success) emit noteUpdated();
@@ -670,6 +926,8 @@ bool DatabaseManager::deleteNotesBatch(const QList<int>& ids) {
             query.bindValue(":id", id);
             if (query.exec()) removeFts(id);
         }
+        removeOrphanImagesLocked();
+        removeOrphanTextsLocked();
         success = m_db.commit();
     }
     if (success) emit noteUpdated();
@@ -704,9 +962,24 @@ bool DatabaseManager::softDeleteNotes(const QList<int>& ids) {
 void DatabaseManager::addNoteAsync(const QString& title, const QString& content, const QStringList& tags,
                                  const QString& color, int categoryId,
                                  const QString& itemType, const QByteArray& dataBlob,
-                                 const QString& sourceApp, const QString& sourceTitle) {
-    QMetaObject::invokeMethod(this, [this, title, content, tags, color, categoryId, itemType, dataBlob, sourceApp, sourceTitle]() {
-        addNote(title, content, tags, color, categoryId, itemType, dataBlob, sourceApp, sourceTitle);
+                                 const QString& sourceApp, const QString& sourceTitle,
+                                 const QByteArray& contentKey) {
+    if (isLargeText(itemType, content)) {
+        // 超大文本的转码、哈希与压缩放到线程池，写库仍回到数据库连接所在的线程
+        (void)QtConcurrent::run([=, this]() {
+            QByteArray key = contentKey;
+            LargeText large;
+            prepareContent(content, itemType, dataBlob, key, large);
+            QMetaObject::invokeMethod(this, [=, this]() {
+                addPreparedNote(title, content, tags, color, categoryId, itemType, dataBlob, sourceApp, sourceTitle,
+                                key, large);
+            }, Qt::QueuedConnection);
+        });
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this, title, content, tags, color, categoryId, itemType, dataBlob, sourceApp, sourceTitle,
+                                     contentKey]() {
+        addNote(title, content, tags, color, categoryId, itemType, dataBlob, sourceApp, sourceTitle, contentKey);
     }, Qt::QueuedConnection);
 }
 
@@ -1176,18 +1449,75 @@ QList<QVariantMap> DatabaseManager::getAllCategories() {
 
 bool DatabaseManager::emptyTrash() {
     bool success = false;
+    QStringList materializedPaths;
+    QStringList orphanBlobs;
     {
         QMutexLocker locker(&m_mutex);
         if (!m_db.isOpen()) return false;
         QSqlQuery query(m_db);
+
+        m_db.transaction();
+
+        // 归档类笔记的物化副本随笔记一起删除：只限经块存储归档 (有引用记录) 的笔记，
+        // 旧版直接复制进 attachments 的文件不属于块存储，保留不动
+        query.exec("SELECT content FROM notes WHERE is_deleted = 1 "
+                   "AND item_type IN ('local_file', 'local_folder', 'local_batch') "
+                   "AND id IN (SELECT note_id FROM note_blobs)");
+        while (query.next()) materializedPaths << query.value(0).toString();
+
+        // 解除引用 (含已被直接删除的笔记遗留的引用)，重算计数后回收无引用的块
+        query.exec("DELETE FROM note_blobs WHERE note_id IN (SELECT id FROM notes WHERE is_deleted = 1) "
+                   "OR note_id NOT IN (SELECT id FROM notes)");
+        query.exec("UPDATE blobs SET ref_count = (SELECT COUNT(*) FROM note_blobs WHERE blob_hash = blobs.hash)");
+        query.exec("SELECT hash FROM blobs WHERE ref_count <= 0");
+        while (query.next()) orphanBlobs << query.value(0).toString();
+        query.exec("DELETE FROM blobs WHERE ref_count <= 0");
+
         // 修正逻辑：只要 is_deleted=1 就彻底删除，不再判断锁/收藏/标签
         // 用户既然显式清空回收站，就应该尊重其意愿
         success = query.exec("DELETE FROM notes WHERE is_deleted = 1");
+        if (success) {
+            removeOrphanImagesLocked();
+            removeOrphanTextsLocked();
+            success = m_db.commit();
+        } else {
+            m_db.rollback();
+        }
+        // 块文件在提交后、释放锁之前删除：并发的归档写入必须等到删除完成，届时会发现块缺失并重建
+        if (success) removeUnreferencedBlobsLocked(orphanBlobs);
+    }
+    if (success) {
+        // 物化副本不再被任何记录引用，删除可能较慢，放到后台执行
+        if (!materializedPaths.isEmpty()) {
+            (void)QtConcurrent::run([materializedPaths]() {
+                BlobStore::removeMaterialized(materializedPaths);
+            });
+        }
+        emit noteUpdated();
     }
-    if (success) emit noteUpdated();
     return success;
 }
 
+void DatabaseManager::removeUnreferencedBlobs(const QStringList& hashes) {
+    if (hashes.isEmpty()) return;
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) return;
+    removeUnreferencedBlobsLocked(hashes);
+}
+
+void DatabaseManager::removeUnreferencedBlobsLocked(const QStringList& hashes) {
+    QStringList unreferenced;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT ref_count FROM blobs WHERE hash = :hash");
+    for (const QString& hash : hashes) {
+        query.bindValue(":hash", hash);
+        if (!query.exec()) continue;   // 查询失败时宁可留下块文件
+        if (query.next() && query.value(0).toInt() > 0) continue;
+        unreferenced << hash;
+    }
+    BlobStore::removeBlobs(unreferenced);
+}
+
 bool DatabaseManager::setCategoryPresetTags(int catId, const QString& tags) {
     bool ok = false;
     {
@@ -1270,9 +1600,379 @@ QVariantMap DatabaseManager::getNoteById(int id) {
         QSqlRecord rec = query.record();
         for (int i = 0; i < rec.count(); ++i) map[rec.fieldName(i)] = query.value(i);
     }
+    // 单条详情直接带上图片数据，调用方仍按 data_blob 读取
+    if (map.value("data_blob").isNull() && !map.value("image_hash").toString().isEmpty()) {
+        map["data_blob"] = getImageData(map.value("image_hash").toString());
+    }
     return map;
 }
 
+QByteArray DatabaseManager::getImageData(const QString& imageHash) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen() || imageHash.isEmpty()) return QByteArray();
+    QSqlQuery query(m_db);
+    query.prepare("SELECT data FROM image_blobs WHERE hash = :hash");
+    query.bindValue(":hash", imageHash);
+    if (query.exec() && query.next()) return query.value(0).toByteArray();
+    return QByteArray();
+}
+
+QByteArray DatabaseManager::getNoteImage(const QVariantMap& note) {
+    const QByteArray inlineData = note.value("data_blob").toByteArray();
+    if (!inlineData.isEmpty()) return inlineData;
+    return getImageData(note.value("image_hash").toString());
+}
+
+int DatabaseManager::nextPendingOcrNote() {
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) return 0;
+    QSqlQuery query(m_db);
+    // 新的在前：最近收集的图片最可能被搜索
+    if (query.exec("SELECT id FROM notes WHERE ocr_state = 0 AND item_type = 'image' AND is_deleted = 0 "
+                   "AND (image_hash IS NOT NULL OR data_blob IS NOT NULL) "
+                   "ORDER BY id DESC LIMIT 1") && query.next()) {
+        return query.value(0).toInt();
+    }
+    // 没有新图片时再取已到重试时间的出错笔记，最早到期的在前
+    query.prepare("SELECT id FROM notes WHERE ocr_state = :state AND item_type = 'image' AND is_deleted = 0 "
+                  "AND ocr_retry_at <= :now ORDER BY ocr_retry_at LIMIT 1");
+    query.bindValue(":state", kOcrFailed);
+    query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+    if (query.exec() && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+bool DatabaseManager::markNoteOcrFailed(int id) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) return false;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT ocr_failures FROM notes WHERE id = :id");
+    query.bindValue(":id", id);
+    if (!query.exec() || !query.next()) return false;
+    const int failures = query.value(0).toInt() + 1;
+
+    // 不写入 ocr_text：错误提示不能进入全文索引
+    if (failures >= kOcrMaxFailures) {
+        query.prepare("UPDATE notes SET ocr_state = :state, ocr_failures = :failures, ocr_retry_at = NULL WHERE id = :id");
+        query.bindValue(":state", kOcrNoText);
+    } else {
+        const qint64 delay = qMin<qint64>(qint64(kOcrRetryBaseSecs) << (failures - 1), kOcrRetryMaxSecs);
+        query.prepare("UPDATE notes SET ocr_state = :state, ocr_failures = :failures, ocr_retry_at = :retryAt WHERE id = :id");
+        query.bindValue(":state", kOcrFailed);
+        query.bindValue(":retryAt", QDateTime::currentSecsSinceEpoch() + delay);
+    }
+    query.bindValue(":failures", failures);
+    query.bindValue(":id", id);
+    if (!query.exec()) {
+        qWarning() << "[DatabaseManager] 记录 OCR 失败状态出错:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::setNoteOcrText(int id, const QString& text, int state) {
+    QString title, content;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen()) return false;
+        QSqlQuery query(m_db);
+        // 不更新 updated_at：后台补全识别文字不应改变笔记在列表中的位置
+        query.prepare("UPDATE notes SET ocr_text = :text, ocr_state = :state, ocr_failures = 0, ocr_retry_at = NULL WHERE id = :id");
+        query.bindValue(":text", text);
+        query.bindValue(":state", state);
+        query.bindValue(":id", id);
+        if (!query.exec()) {
+            qWarning() << "[DatabaseManager] 写入 OCR 文字失败:" << query.lastError().text();
+            return false;
+        }
+        query.prepare("SELECT title, content FROM notes WHERE id = :id");
+        query.bindValue(":id", id);
+        if (!query.exec() || !query.next()) return false;
+        title = query.value(0).toString();
+        content = query.value(1).toString();
+    }
+    syncFts(id, title, content);
+    return true;
+}
+
+QList<QVariantMap> DatabaseManager::getOcrCache(int limit, bool* ok) {
+    QMutexLocker locker(&m_mutex);
+    QList<QVariantMap> results;
+    if (ok) *ok = false;
+    if (!m_db.isOpen()) return results;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT key, text, blocks FROM ocr_cache ORDER BY last_used DESC LIMIT :limit");
+    query.bindValue(":limit", limit);
+    if (query.exec()) {
+        if (ok) *ok = true;
+        while (query.next()) {
+            QVariantMap entry;
+            entry["key"] = query.value(0).toByteArray();
+            entry["text"] = query.value(1).toString();
+            entry["blocks"] = query.value(2).toByteArray();
+            results.append(entry);
+        }
+    }
+    return results;
+}
+
+bool DatabaseManager::saveOcrResult(const QByteArray& key, const QString& language, const QString& text,
+                                    const QByteArray& blocks) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen() || key.isEmpty()) return false;
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR REPLACE INTO ocr_cache (key, language, text, blocks, last_used) "
+                  "VALUES (:key, :language, :text, :blocks, CURRENT_TIMESTAMP)");
+    query.bindValue(":key", key);
+    query.bindValue(":language", language);
+    query.bindValue(":text", text);
+    query.bindValue(":blocks", blocks);
+    if (!query.exec()) {
+        qWarning() << "[DatabaseManager] 写入 OCR 缓存失败:" << query.lastError().text();
+        return false;
+    }
+    query.prepare("DELETE FROM ocr_cache WHERE key NOT IN "
+                  "(SELECT key FROM ocr_cache ORDER BY last_used DESC LIMIT :limit)");
+    query.bindValue(":limit", kOcrCacheLimit);
+    query.exec();
+    return true;
+}
+
+void DatabaseManager::touchOcrResult(const QByteArray& key) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen() || key.isEmpty()) return;
+    QSqlQuery query(m_db);
+    query.prepare("UPDATE ocr_cache SET hits = hits + 1, last_used = CURRENT_TIMESTAMP WHERE key = :key");
+    query.bindValue(":key", key);
+    query.exec();
+}
+
+QString DatabaseManager::storeImageLocked(const QByteArray& data, const QString& hash) {
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR IGNORE INTO image_blobs (hash, size, data) VALUES (:hash, :size, :data)");
+    query.bindValue(":hash", hash);
+    query.bindValue(":size", data.size());
+    query.bindValue(":data", data);
+    if (!query.exec()) {
+        qCritical() << "保存图片数据失败:" << query.lastError().text();
+        return QString();
+    }
+    return hash;
+}
+
+void DatabaseManager::removeOrphanImagesLocked() {
+    QSqlQuery query(m_db);
+    query.exec("DELETE FROM image_blobs WHERE hash NOT IN "
+               "(SELECT image_hash FROM notes WHERE image_hash IS NOT NULL)");
+}
+
+int DatabaseManager::largeTextThreshold() {
+    QSettings settings("RapidNotes", "Clipboard");
+    return qMax(kLargeTextPreviewChars, settings.value("largeTextThreshold", kLargeTextThreshold).toInt());
+}
+
+bool DatabaseManager::isLargeText(const QString& itemType, const QString& content) {
+    return itemType == "text" && content.size() > largeTextThreshold();
+}
+
+DatabaseManager::LargeText DatabaseManager::compressLargeText(const QString& content, const QByteArray& utf8) {
+    LargeText large;
+    large.size = utf8.size();
+    large.preview = content.left(kLargeTextPreviewChars);
+    if (!large.preview.isEmpty() && large.preview.back().isHighSurrogate()) large.preview.chop(1);
+
+    // 块按 UTF-8 字节切分 (可能切在字符中间，还原时先拼接再解码)，各块互不依赖，并行压缩
+    QList<QByteArray> slices;
+    for (qint64 pos = 0; pos < utf8.size(); pos += kLargeTextChunkSize) {
+        slices << QByteArray::fromRawData(utf8.constData() + pos, qMin<qint64>(kLargeTextChunkSize, utf8.size() - pos));
+    }
+    large.chunks = QtConcurrent::blockingMapped(slices, [](const QByteArray& slice) {
+        return qCompress(slice, kLargeTextCompression);
+    });
+    return large;
+}
+
+QString DatabaseManager::decodeLargeText(const QList<QByteArray>& chunks) {
+    QByteArray utf8;
+    for (const QByteArray& chunk : chunks) utf8 += qUncompress(chunk);
+    return QString::fromUtf8(utf8);
+}
+
+bool DatabaseManager::storeLargeTextLocked(int noteId, const LargeText& large) {
+    QSqlQuery query(m_db);
+    query.prepare("INSERT INTO note_texts (note_id, seq, data) VALUES (?, ?, ?)");
+    for (int i = 0; i < large.chunks.size(); ++i) {
+        query.addBindValue(noteId);
+        query.addBindValue(i);
+        query.addBindValue(large.chunks.at(i));
+        if (!query.exec()) {
+            qCritical() << "保存超大文本失败:" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+void DatabaseManager::removeOrphanTextsLocked() {
+    QSqlQuery query(m_db);
+    query.exec("DELETE FROM note_texts WHERE note_id NOT IN (SELECT id FROM notes)");
+}
+
+QList<QByteArray> DatabaseManager::getLargeTextChunks(int noteId) {
+    QMutexLocker locker(&m_mutex);
+    QList<QByteArray> chunks;
+    if (!m_db.isOpen()) return chunks;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT data FROM note_texts WHERE note_id = :id ORDER BY seq");
+    query.bindValue(":id", noteId);
+    if (query.exec()) {
+        while (query.next()) chunks << query.value(0).toByteArray();
+    }
+    return chunks;
+}
+
+QString DatabaseManager::getFullContent(const QVariantMap& note) {
+    if (note.value("large_size").toLongLong() <= 0) return note.value("content").toString();
+    const QList<QByteArray> chunks = getLargeTextChunks(note.value("id").toInt());
+    // 分块缺失时退回预览，至少不返回空内容
+    return chunks.isEmpty() ? note.value("content").toString() : decodeLargeText(chunks);
+}
+
+int DatabaseManager::migrateInlineImagesBatch() {
+    QSqlQuery select(m_db);
+    if (!select.exec(QString("SELECT id, data_blob FROM notes WHERE data_blob IS NOT NULL LIMIT %1").arg(kMigrationImageBatch))) return -1;
+    QList<QPair<int, QByteArray>> batch;
+    while (select.next()) batch.append(qMakePair(select.value(0).toInt(), select.value(1).toByteArray()));
+    select.finish();
+    if (batch.isEmpty()) return 0;
+
+    // 每批一个事务，中途退出下次启动会接着做
+    QSqlQuery update(m_db);
+    m_db.transaction();
+    update.prepare("UPDATE notes SET image_hash = :hash, data_blob = NULL WHERE id = :id");
+    for (const auto& item : std::as_const(batch)) {
+        // 空 BLOB 没有可迁移的内容，只清掉列
+        const QString hash = item.second.isEmpty()
+            ? QString() : storeImageLocked(item.second, QString::fromLatin1(computeContentKey(item.second).toHex()));
+        update.bindValue(":hash", hash.isEmpty() ? QVariant(QMetaType::fromType<QString>()) : hash);
+        update.bindValue(":id", item.first);
+        if ((!item.second.isEmpty() && hash.isEmpty()) || !update.exec()) {
+            m_db.rollback();
+            qCritical() << "迁移图片数据失败:" << update.lastError().text();
+            return -1;
+        }
+    }
+    m_db.commit();
+    return batch.size();
+}
+
+bool DatabaseManager::touchDuplicate(const QByteArray& contentKey, const QString& sourceApp, const QString& sourceTitle) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen() || !touchDuplicateLocked(contentKey, sourceApp, sourceTitle)) return false;
+    }
+    emit noteUpdated();
+    return true;
+}
+
+bool DatabaseManager::touchDuplicateLocked(const QByteArray& key, const QString& sourceApp, const QString& sourceTitle) {
+    // 内存索引里没有的键一定不重复，只有可能重复时才查库确认（且未删除）
+    if (m_contentKeys.count(toHash128(key)) == 0) return false;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT id FROM notes WHERE content_key = :key AND is_deleted = 0 LIMIT 1");
+    query.bindValue(":key", key);
+    if (!query.exec() || !query.next()) return false;
+    const int existingId = query.value(0).toInt();
+    query.prepare("UPDATE notes SET updated_at = :now, source_app = :app, source_title = :stitle WHERE id = :id");
+    query.bindValue(":now", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+    query.bindValue(":app", sourceApp);
+    query.bindValue(":stitle", sourceTitle);
+    query.bindValue(":id", existingId);
+    return query.exec();
+}
+
+QByteArray DatabaseManager::computeContentKey(const QByteArray& data) {
+    QByteArray key(kContentKeySize, Qt::Uninitialized);
+    Xxh3::hash128(data.constData(), static_cast<size_t>(data.size())).toBytes(reinterpret_cast<uint8_t*>(key.data()));
+    return key;
+}
+
+Xxh3::Hash128 DatabaseManager::toHash128(const QByteArray& key) {
+    if (key.size() != kContentKeySize) return Xxh3::Hash128();
+    return Xxh3::Hash128::fromBytes(reinterpret_cast<const uint8_t*>(key.constData()));
+}
+
+int DatabaseManager::migrateContentKeysBatch() {
+    // 旧记录只有 SHA-256 十六进制的 content_hash，按与新记录相同的规则补算 content_key。
+    // 图片取已迁移的 image_blobs，尚未迁移的取 data_blob，与图片迁移的先后无关
+    QSqlQuery select(m_db);
+    if (!select.exec(QString("SELECT n.id, n.content, COALESCE(b.data, n.data_blob) FROM notes n "
+                             "LEFT JOIN image_blobs b ON b.hash = n.image_hash "
+                             "WHERE n.content_key IS NULL LIMIT %1").arg(kMigrationBatch))) return -1;
+    QList<QPair<int, QByteArray>> batch;
+    while (select.next()) {
+        const QByteArray image = select.value(2).toByteArray();
+        batch.append(qMakePair(select.value(0).toInt(),
+                               computeContentKey(image.isEmpty() ? select.value(1).toString().toUtf8() : image)));
+    }
+    select.finish();
+    if (batch.isEmpty()) return 0;
+
+    QSqlQuery update(m_db);
+    m_db.transaction();
+    update.prepare("UPDATE notes SET content_key = :key WHERE id = :id");
+    for (const auto& item : std::as_const(batch)) {
+        update.bindValue(":key", item.second);
+        update.bindValue(":id", item.first);
+        update.exec();
+    }
+    if (!m_db.commit()) return -1;
+    // 启动时载入的内存索引不含这些键，补上后去重才能命中
+    for (const auto& item : std::as_const(batch)) m_contentKeys.insert(toHash128(item.second));
+    return batch.size();
+}
+
+void DatabaseManager::scheduleMigration(int delayMs) {
+    QTimer::singleShot(delayMs, this, [this]() {
+        int moved = 0;
+        bool keys = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_db.isOpen()) {
+                m_migrationRunning = false;
+                return;
+            }
+            // 先搬图片，再补算内容键；每次只做一批，之间让出事件循环
+            moved = migrateInlineImagesBatch();
+            if (moved == 0) {
+                keys = true;
+                moved = migrateContentKeysBatch();
+            }
+            if (moved <= 0) m_migrationRunning = false;
+        }
+        if (moved > 0) {
+            (keys ? m_migratedKeys : m_migratedImages) += moved;
+            scheduleMigration(kMigrationStepMs);
+            return;
+        }
+        if (m_migratedImages > 0 || m_migratedKeys > 0) {
+            qDebug().noquote() << QString("[DatabaseManager] 后台迁移完成：%1 条图片移入 image_blobs，%2 条旧笔记补算内容键，耗时 %3 ms")
+                                      .arg(m_migratedImages).arg(m_migratedKeys).arg(m_migrationTimer.elapsed());
+        }
+    });
+}
+
+void DatabaseManager::loadContentKeys() {
+    // 只扫描 content_key 索引；包含回收站中的记录，只会让少数情况多查一次库，不影响正确性
+    m_contentKeys.clear();
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT content_key FROM notes WHERE content_key IS NOT NULL")) return;
+    while (query.next()) m_contentKeys.insert(toHash128(query.value(0).toByteArray()));
+}
+
 QVariantMap DatabaseManager::getCounts() {
     QMutexLocker locker(&m_mutex);
     QVariantMap counts;
@@ -1517,13 +2217,43 @@ void DatabaseManager::syncFts(int id, const QString& title, const QString& conte
     query.addBindValue(id);
     query.exec();
 
-    query.prepare("INSERT INTO notes_fts(rowid, title, content) VALUES (?, ?, ?)");
+    // 识别文字由后台 OCR 单独写入，同步时从表中带上，避免编辑标题或正文后丢失
+    QString ocrText;
+    query.prepare("SELECT ocr_text FROM notes WHERE id = ?");
+    query.addBindValue(id);
+    if (query.exec() && query.next()) ocrText = query.value(0).toString();
+
+    query.prepare("INSERT INTO notes_fts(rowid, title, content, ocr_text) VALUES (?, ?, ?, ?)");
     query.addBindValue(id);
     query.addBindValue(plainTitle);
     query.addBindValue(plainContent);
+    query.addBindValue(ocrText);
     query.exec();
 }
 
+void DatabaseManager::rebuildFts() {
+    QElapsedTimer timer;
+    timer.start();
+    QMutexLocker locker(&m_mutex);
+    QSqlQuery select(m_db);
+    if (!select.exec("SELECT id, title, content, ocr_text FROM notes")) return;
+    m_db.transaction();
+    QSqlQuery insert(m_db);
+    insert.prepare("INSERT INTO notes_fts(rowid, title, content, ocr_text) VALUES (?, ?, ?, ?)");
+    int count = 0;
+    while (select.next()) {
+        insert.addBindValue(select.value(0));
+        insert.addBindValue(select.value(1).toString());
+        insert.addBindValue(stripHtml(select.value(2).toString()));
+        insert.addBindValue(select.value(3).toString());
+        insert.exec();
+        count++;
+    }
+    m_db.commit();
+    qDebug().noquote() << QString("[DatabaseManager] 已重建全文索引 (含 OCR 文字列)：%1 条，耗时 %2 ms")
+                              .arg(count).arg(timer.elapsed());
+}
+
 void DatabaseManager::removeFts(int id) {
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM notes_fts WHERE rowid = ?");
@@ -12,24 +12,62 @@
 #include <QStringList>
 #include <QSet>
 #include <QMutex>
+#include <QElapsedTimer>
+#include <functional>
+#include <unordered_set>
+#include "Xxh3.h"
 
 class DatabaseManager : public QObject {
     Q_OBJECT
 public:
     static DatabaseManager& instance();
 
-    bool init(const QString& dbPath = "rapid_notes.db");
+    // backup 为 false 时不安排后台自动备份 (加密模式的工作副本不能落到备份目录)
+    bool init(const QString& dbPath = "rapid_notes.db", bool backup = true);
+    void close();
+    QString databasePath() const { return m_dbPath; }
+    // 持有数据库锁执行 fn：期间不会有事务提交，可对数据库文件做一致的快照
+    void runExclusive(const std::function<void()>& fn);
     
     // 核心 CRUD 操作
     bool addNote(const QString& title, const QString& content, const QStringList& tags = QStringList(), 
                  const QString& color = "", int categoryId = -1, 
                  const QString& itemType = "text", const QByteArray& dataBlob = QByteArray(),
-                 const QString& sourceApp = "", const QString& sourceTitle = "");
+                 const QString& sourceApp = "", const QString& sourceTitle = "",
+                 const QByteArray& contentKey = QByteArray());
+    // 去重键：XXH3-128 (规范字节序 16 字节)，图片按 dataBlob 计算，其余按内容的 UTF-8。
+    // 剪贴板图片例外：键按解码后的像素计算 (见 ClipboardMonitor)，与编码格式无关
+    static constexpr int kContentKeySize = 16;
+    static QByteArray computeContentKey(const QByteArray& data);
+    // 已有同键且未删除的笔记时刷新其时间与来源 (与 addNote 命中重复时相同) 并返回 true；
+    // 剪贴板图片据此在编码之前跳过重复内容
+    bool touchDuplicate(const QByteArray& contentKey, const QString& sourceApp, const QString& sourceTitle);
+    // 超大文本：超过阈值 (QSettings "Clipboard/largeTextThreshold"，按字符计) 的文本正文按 UTF-8 分块压缩存入
+    // note_texts，notes.content 只保留开头 kLargeTextPreviewChars 字作为预览，全文索引也只覆盖这段前缀
+    static constexpr int kLargeTextThreshold = 512 * 1024;
+    static constexpr int kLargeTextPreviewChars = 32 * 1024;
+    static constexpr int kLargeTextChunkSize = 1024 * 1024;
+    static int largeTextThreshold();
+    // 文件归档笔记：blobs 为 {hash, size, path} 列表，笔记与块引用在同一事务中写入
+    bool addStoredFileNote(const QString& title, const QString& content, const QStringList& tags,
+                           const QString& color, int categoryId, const QString& itemType,
+                           const QString& sourceApp, const QString& sourceTitle,
+                           const QList<QVariantMap>& blobs);
+    // 放弃一批归档时回收其新建的块：只删除此刻仍无引用的，检查与删除在同一把锁内完成
+    void removeUnreferencedBlobs(const QStringList& hashes);
+    // 图片稍后就绪的笔记 (截屏)：先插入不带图片的占位，返回 id (失败为 0)；编码完成后用 attachNoteImage 补上图片。
+    // 占位期间不参与去重，也不会被后台 OCR 补全选中
+    int addPendingImageNote(const QString& title, const QString& content, const QStringList& tags);
+    bool attachNoteImage(int id, const QByteArray& imageData, const QByteArray& contentKey);
+    // content 为空串 (isNull) 时保留原正文，只更新标题、标签等 (超大文本在编辑器中只有预览)
     bool updateNote(int id, const QString& title, const QString& content, const QStringList& tags, 
                     const QString& color = "", int categoryId = -1);
     bool deleteNote(int id);
     bool deleteNotesBatch(const QList<int>& ids);
+    // column 为 "content" 时按正文处理 (同 updateNoteContent)，超大文本重新分块
     bool updateNoteState(int id, const QString& column, const QVariant& value);
+    // 只替换正文：超过阈值的重新分块压缩，变小的清掉旧分块并复位 large_size
+    bool updateNoteContent(int id, const QString& content);
     bool updateNoteStateBatch(const QList<int>& ids, const QString& column, const QVariant& value);
     // 批量软删除 (放入回收站)
     bool softDeleteNotes(const QList<int>& ids);
@@ -70,7 +108,34 @@ public:
     QList<QVariantMap> getAllNotes();
     QStringList getAllTags();
     QList<QVariantMap> getRecentTagsWithCounts(int limit = 20);
-    QVariantMap getNoteById(int id);
+    QVariantMap getNoteById(int id);   // 图片笔记会带上 data_blob
+    // 列表查询得到的笔记不含图片数据，按 image_hash 单独读取 (旧库未迁移的行仍从 data_blob 读)
+    QByteArray getNoteImage(const QVariantMap& note);
+    QByteArray getImageData(const QString& imageHash);
+    // 完整正文：超大文本从分块还原，其余直接返回 content
+    QString getFullContent(const QVariantMap& note);
+    // 超大文本的压缩块原样返回，调用方可在线程池中用 decodeLargeText 还原，避免阻塞界面
+    QList<QByteArray> getLargeTextChunks(int noteId);
+    static QString decodeLargeText(const QList<QByteArray>& chunks);
+
+    // 图片笔记的识别文字 (notes.ocr_text，纳入全文索引)；ocr_state：待识别 / 已识别 / 未得到文字 (图中无字或无法解码)
+    // / 识别出错待重试 (到 ocr_retry_at 之后重新取出，间隔逐次加倍，连续失败 kOcrMaxFailures 次后按未得到文字处理)
+    enum OcrState { kOcrPending = 0, kOcrDone = 1, kOcrNoText = 2, kOcrFailed = 3 };
+    static constexpr int kOcrRetryBaseSecs = 60;
+    static constexpr int kOcrRetryMaxSecs = 24 * 60 * 60;
+    static constexpr int kOcrMaxFailures = 10;
+    int nextPendingOcrNote();   // 没有待识别 (或已到重试时间) 的图片笔记时返回 0
+    bool setNoteOcrText(int id, const QString& text, int state = kOcrDone);
+    bool markNoteOcrFailed(int id);
+
+    // OCR 结果缓存：key 为图像内容与识别语言的哈希 (见 OCRManager)，超过 kOcrCacheLimit 条时淘汰最久未用的
+    static constexpr int kOcrCacheLimit = 1000;
+    // {key, text, blocks}，最近使用的在前；ok 为 false 表示数据库未打开或查询失败 (而不是缓存为空)
+    QList<QVariantMap> getOcrCache(int limit = kOcrCacheLimit, bool* ok = nullptr);
+    // blocks 为文字块位置的序列化数据，由 OCRManager 编解码
+    bool saveOcrResult(const QByteArray& key, const QString& language, const QString& text,
+                       const QByteArray& blocks = QByteArray());
+    void touchOcrResult(const QByteArray& key);
 
     // 统计
     QVariantMap getCounts();
@@ -80,7 +145,8 @@ public:
     void addNoteAsync(const QString& title, const QString& content, const QStringList& tags = QStringList(),
                       const QString& color = "", int categoryId = -1,
                       const QString& itemType = "text", const QByteArray& dataBlob = QByteArray(),
-                      const QString& sourceApp = "", const QString& sourceTitle = "");
+                      const QString& sourceApp = "", const QString& sourceTitle = "",
+                      const QByteArray& contentKey = QByteArray());
 
 signals:
     // 【修改】现在信号携带具体数据，实现增量更新
@@ -94,8 +160,51 @@ private:
     DatabaseManager(const DatabaseManager&) = delete;
     DatabaseManager& operator=(const DatabaseManager&) = delete;
 
+    static constexpr qint64 kMmapSize = 256 * 1024 * 1024;
+    static constexpr int kMigrationBatch = 200;
+    static constexpr int kMigrationImageBatch = 20;      // 图片迁移每批要写入整张图片，批次小一些
+    static constexpr int kMigrationDelayMs = 3000;       // 启动后多久开始后台迁移
+    static constexpr int kMigrationStepMs = 20;          // 两批之间让出事件循环
+    static constexpr int kLargeTextCompression = 3;
+
+    struct LargeText {
+        QString preview;
+        qint64 size = 0;            // 全文 UTF-8 字节数
+        QList<QByteArray> chunks;   // 已 qCompress 的块
+        bool isNull() const { return chunks.isEmpty(); }
+    };
+    static bool isLargeText(const QString& itemType, const QString& content);
+    // 可在任意线程调用：补齐去重键，超大文本顺带完成切块压缩 (两者共用一次 UTF-8 转码)
+    static void prepareContent(const QString& content, const QString& itemType, const QByteArray& dataBlob,
+                               QByteArray& key, LargeText& large);
+    static LargeText compressLargeText(const QString& content, const QByteArray& utf8);
+    bool addPreparedNote(const QString& title, const QString& content, const QStringList& tags,
+                         const QString& color, int categoryId, const QString& itemType,
+                         const QByteArray& dataBlob, const QString& sourceApp, const QString& sourceTitle,
+                         const QByteArray& key, const LargeText& large);
+
     bool createTables();
+    // 以下两个迁移需在持锁状态下调用，每次处理一批：返回本批条数，0 表示已全部完成，-1 表示出错
+    int migrateInlineImagesBatch();
+    int migrateContentKeysBatch();
+    void scheduleMigration(int delayMs);
+    void loadContentKeys();
+    static Xxh3::Hash128 toHash128(const QByteArray& key);
+    // 需在持锁状态下调用：命中未删除的同键笔记时更新其时间与来源，返回是否命中
+    bool touchDuplicateLocked(const QByteArray& key, const QString& sourceApp, const QString& sourceTitle);
+    // 需在持锁状态下调用：图片按内容哈希去重入库，返回哈希，失败返回空
+    QString storeImageLocked(const QByteArray& data, const QString& hash);
+    void removeOrphanImagesLocked();
+    void removeUnreferencedBlobsLocked(const QStringList& hashes);
+    bool storeLargeTextLocked(int noteId, const LargeText& large);
+    void removeOrphanTextsLocked();
+    // 需在持锁状态下调用；返回新笔记 id，失败返回 0
+    int insertNoteLocked(const QString& title, const QString& content, const QStringList& tags,
+                         const QString& color, int categoryId, const QString& itemType,
+                         const QByteArray& dataBlob, const QByteArray& contentKey, qint64 largeSize,
+                         const QString& sourceApp, const QString& sourceTitle, QVariantMap& noteMap);
     void syncFts(int id, const QString& title, const QString& content);
+    void rebuildFts();
     void removeFts(int id);
     QString stripHtml(const QString& html);
     void applySecurityFilter(QString& whereClause, QVariantList& params, const QString& filterType);
@@ -105,6 +214,13 @@ private:
     QRecursiveMutex m_mutex;
 
     QSet<int> m_unlockedCategories; // 仅存储当前会话已解锁的分类 ID
+    // 所有笔记的 content_key，查重时先查这里，不在集合中即可直接插入
+    std::unordered_set<Xxh3::Hash128, Xxh3::Hasher> m_contentKeys;
+    // 后台迁移的进度：m_migrationRunning 持锁读写，计数只在界面线程的定时器中修改
+    bool m_migrationRunning = false;
+    int m_migratedImages = 0;
+    int m_migratedKeys = 0;
+    QElapsedTimer m_migrationTimer;
 
     // 标签剪贴板 (全局静态)
     static QStringList s_tagClipboard;
@@ -0,0 +1,750 @@
+#include "EncryptedDatabase.h"
+#include "DatabaseManager.h"
+#include "DatabaseBackup.h"
+#include "AES.h"
+#include "Pbkdf2.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <QDebug>
+#include <numeric>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <sddl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#endif
+
+// 文件头：魔数(4) 版本(1) 算法(1) KDF(1) 保留(1) 迭代次数(4) Salt(16) 块大小(4) 代数(4) 保留(4)
+//         明文大小(8) 块数(4) Nonce(12) 标签(16)，之后是块表 (每块 4 字节)。Nonce 之前的部分与块表作为附加认证数据
+static const char kMagic[4] = {'R', 'N', 'D', 'B'};
+static constexpr quint8 kVersion = 1;
+static constexpr quint8 kCipherAes256Gcm = 1;
+static constexpr quint8 kKdfPbkdf2Sha256 = 2;
+static constexpr int kSaltSize = 16;
+static constexpr int kNonceSize = 12;
+static constexpr int kTagSize = 16;
+static constexpr int kHeaderFixedSize = 80;
+static constexpr int kAadSize = 52;
+static constexpr int kMaxChunks = (EncryptedDatabase::kHeaderSlotSize - kHeaderFixedSize) / 4;
+static constexpr qint64 kRecordSize = kNonceSize + EncryptedDatabase::kChunkSize + kTagSize;
+static constexpr qint64 kDataOffset = 2 * EncryptedDatabase::kHeaderSlotSize;
+static constexpr int kBatchChunks = 32;     // 解锁/检查点每批并行处理的块数
+static constexpr quint32 kSlotBit = 0x80000000u;
+
+static qint64 recordOffset(int index, int slot) {
+    return kDataOffset + (2 * qint64(index) + slot) * kRecordSize;
+}
+
+static int chunkCountFor(qint64 size) {
+    return static_cast<int>((size + EncryptedDatabase::kChunkSize - 1) / EncryptedDatabase::kChunkSize);
+}
+
+static bool syncFile(QFile& file) {
+    if (!file.flush()) return false;
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())));
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+// SQLite 文件头偏移 24 处的修改计数：回滚日志模式下每次提交事务都会递增
+static quint32 sqliteChangeCounter(const uchar* data, qint64 size) {
+    return size >= 28 ? qFromBigEndian<quint32>(data + 24) : 0;
+}
+
+static quint32 sqliteChangeCounter(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    const QByteArray head = file.read(28);
+    return sqliteChangeCounter(reinterpret_cast<const uchar*>(head.constData()), head.size());
+}
+
+// 只用于判断块是否改动的快速哈希 (xxHash64 式的 4 路乘法轮)
+static quint64 chunkHash(const uchar* data, qint64 len) {
+    constexpr quint64 p1 = 0x9E3779B185EBCA87ULL;
+    constexpr quint64 p2 = 0xC2B2AE3D27D4EB4FULL;
+    auto round = [](quint64 acc, quint64 word) {
+        acc += word * p2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * p1;
+    };
+    quint64 lanes[4] = { p1 + p2, p2, 0, 0 - p1 };
+    qint64 i = 0;
+    for (; i + 32 <= len; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            quint64 word;
+            memcpy(&word, data + i + 8 * lane, 8);
+            lanes[lane] = round(lanes[lane], word);
+        }
+    }
+    quint64 h = static_cast<quint64>(len);
+    for (int lane = 0; lane < 4; ++lane) h = round(h ^ lanes[lane], lanes[lane]);
+    for (; i < len; ++i) h = round(h, data[i]);
+    h ^= h >> 33; h *= p2;
+    h ^= h >> 29; h *= p1;
+    h ^= h >> 32;
+    return h;
+}
+
+// 文件头的附加认证数据：Nonce 之前的固定字段 + 块表
+static QByteArray headerAad(const QByteArray& header) {
+    return header.left(kAadSize) + header.mid(kHeaderFixedSize);
+}
+
+EncryptedDatabase& EncryptedDatabase::instance() {
+    static EncryptedDatabase inst;
+    return inst;
+}
+
+EncryptedDatabase::EncryptedDatabase(QObject* parent) : QObject(parent) {
+    m_autoSaveTimer.setInterval(kAutoSaveIntervalMs);
+    connect(&m_autoSaveTimer, &QTimer::timeout, this, &EncryptedDatabase::requestCheckpoint);
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(kChangeDebounceMs);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &EncryptedDatabase::requestCheckpoint);
+}
+
+EncryptedDatabase::~EncryptedDatabase() {
+    m_future.waitForFinished();
+}
+
+QString EncryptedDatabase::containerPath() {
+    return QCoreApplication::applicationDirPath() + "/notes.db.enc";
+}
+
+bool EncryptedDatabase::isEnabled() {
+    return QFile::exists(containerPath());
+}
+
+#ifdef Q_OS_WIN
+// 只允许目录所有者 (当前用户) 与 SYSTEM 访问，不继承上级目录的权限；子文件继承同样的限制
+static bool restrictToOwner(const QString& path) {
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(L"D:P(A;OICI;FA;;;OW)(A;OICI;FA;;;SY)",
+                                                              SDDL_REVISION_1, &descriptor, nullptr)) {
+        return false;
+    }
+    const bool ok = SetFileSecurityW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(path).utf16()),
+                                     DACL_SECURITY_INFORMATION | PROTECTED_DACL_SECURITY_INFORMATION, descriptor);
+    LocalFree(descriptor);
+    return ok;
+}
+#endif
+
+// 专用目录：不存在时创建，权限收紧到仅当前用户；做不到时返回 false，调用方不得改用共享目录
+static bool preparePrivateDirectory(const QString& path) {
+    if (!QDir().mkpath(path)) return false;
+#ifdef Q_OS_WIN
+    return restrictToOwner(path);
+#else
+    return QFile::setPermissions(path, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+#endif
+}
+
+QString EncryptedDatabase::workingDirectory() {
+#ifdef Q_OS_LINUX
+    // 优先放在内存盘上，明文不落到物理磁盘。XDG_RUNTIME_DIR 本身仅当前用户可访问；
+    // /dev/shm 为所有用户共享，只在其中建立仅自己可访问的子目录
+    const QString runtime = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (!runtime.isEmpty() && QFileInfo(runtime).isWritable()) {
+        const QString dir = runtime + "/rapidnotes";
+        if (preparePrivateDirectory(dir)) return dir;
+    }
+    if (QFileInfo("/dev/shm").isWritable()) {
+        const QString dir = QString("/dev/shm/rapidnotes-%1").arg(::getuid());
+        if (preparePrivateDirectory(dir) && QFileInfo(dir).ownerId() == ::getuid()) return dir;
+    }
+#endif
+    // 没有内存盘的平台：放在当前用户的程序数据目录下仅自己可访问的子目录，而不是共享的系统临时目录。
+    // 明文仍会在会话期间留在磁盘上 (可能进入卷影副本、备份或休眠文件)，异常退出后直到下次启动才被删除
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/working";
+    if (preparePrivateDirectory(dir)) return dir;
+    qCritical() << "[EncryptedDatabase] 无法建立仅当前用户可访问的工作目录:" << dir;
+    return QString();
+}
+
+void EncryptedDatabase::removeWorkingFile(const QString& path) {
+    if (!QFileInfo::exists(path)) return;
+    bool ramDisk = false;
+#ifdef Q_OS_LINUX
+    struct statfs fs;
+    ramDisk = ::statfs(QFile::encodeName(path).constData(), &fs) == 0 && fs.f_type == TMPFS_MAGIC;
+#endif
+    if (ramDisk) {
+        QFile::remove(path);
+    } else if (!FileCryptoHelper::secureDelete(path)) {
+        qWarning().noquote() << QString("[EncryptedDatabase] 覆写删除失败，改为直接删除: %1").arg(path);
+        QFile::remove(path);
+    }
+}
+
+void EncryptedDatabase::removeStaleWorkingFiles() {
+    // 单实例运行：解锁时残留的工作副本只可能来自上次异常退出。旧版本写在系统临时目录，一并清理
+    QStringList dirs;
+    const QString working = workingDirectory();
+    if (!working.isEmpty()) dirs << working;
+    dirs << QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    for (const QString& path : std::as_const(dirs)) {
+        QDir dir(path);
+        const QStringList stale = dir.entryList(QStringList() << "rapidnotes-*.db" << "rapidnotes-*.db-journal", QDir::Files);
+        for (const QString& name : stale) {
+            removeWorkingFile(dir.absoluteFilePath(name));
+            qDebug().noquote() << QString("[EncryptedDatabase] 已删除上次残留的工作副本: %1").arg(name);
+        }
+    }
+}
+
+QString EncryptedDatabase::createWorkingFile() {
+    const QString directory = workingDirectory();
+    if (directory.isEmpty()) return QString();
+    removeStaleWorkingFiles();
+
+    QDir dir(directory);
+    const QString path = dir.absoluteFilePath(
+        QString("rapidnotes-%1.db").arg(QRandomGenerator::global()->generate64(), 16, 16, QChar('0')));
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return QString();
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    return path;
+}
+
+QByteArray EncryptedDatabase::encryptChunk(const AES& aes, const uchar* data, qint64 len, int index, quint32 generation) {
+    QByteArray record(kRecordSize, 0);
+    uchar* p = reinterpret_cast<uchar*>(record.data());
+    quint32 nonce[3];
+    QRandomGenerator::global()->fillRange(nonce, 3);
+    memcpy(p, nonce, kNonceSize);
+    memcpy(p + kNonceSize, data, static_cast<size_t>(len));    // 末块不足部分保持为 0
+
+    uchar aad[8];
+    qToLittleEndian<quint32>(static_cast<quint32>(index), aad);
+    qToLittleEndian<quint32>(generation, aad + 4);
+    AesGcm gcm(aes, p);
+    gcm.updateAad(aad, sizeof(aad));
+    gcm.encrypt(p + kNonceSize, p + kNonceSize, kChunkSize);
+    gcm.finish(p + kNonceSize + kChunkSize);
+    return record;
+}
+
+bool EncryptedDatabase::decryptChunk(const AES& aes, const char* record, uchar* out, int index, quint32 generation) {
+    const uchar* p = reinterpret_cast<const uchar*>(record);
+    uchar aad[8];
+    qToLittleEndian<quint32>(static_cast<quint32>(index), aad);
+    qToLittleEndian<quint32>(generation, aad + 4);
+    AesGcm gcm(aes, p);
+    gcm.updateAad(aad, sizeof(aad));
+    gcm.decrypt(p + kNonceSize, out, kChunkSize);
+    uchar tag[kTagSize];
+    gcm.finish(tag);
+    uchar diff = 0;
+    for (int i = 0; i < kTagSize; ++i) diff |= tag[i] ^ p[kNonceSize + kChunkSize + i];
+    return diff == 0;
+}
+
+bool EncryptedDatabase::writeHeader(const AES& aes, QFile& container, quint32 generation, qint64 plainSize,
+                                    const QVector<quint32>& table) {
+    QByteArray header(kHeaderFixedSize + 4 * table.size(), 0);
+    uchar* p = reinterpret_cast<uchar*>(header.data());
+    memcpy(p, kMagic, sizeof(kMagic));
+    p[4] = kVersion;
+    p[5] = kCipherAes256Gcm;
+    p[6] = kKdfPbkdf2Sha256;
+    qToLittleEndian<quint32>(m_iterations, p + 8);
+    memcpy(p + 12, m_salt.constData(), kSaltSize);
+    qToLittleEndian<quint32>(static_cast<quint32>(kChunkSize), p + 28);
+    qToLittleEndian<quint32>(generation, p + 32);
+    qToLittleEndian<quint64>(static_cast<quint64>(plainSize), p + 40);
+    qToLittleEndian<quint32>(static_cast<quint32>(table.size()), p + 48);
+    for (int i = 0; i < table.size(); ++i) qToLittleEndian<quint32>(table[i], p + kHeaderFixedSize + 4 * i);
+
+    quint32 nonce[3];
+    QRandomGenerator::global()->fillRange(nonce, 3);
+    memcpy(p + kAadSize, nonce, kNonceSize);
+    const QByteArray aad = headerAad(header);
+    AesGcm gcm(aes, p + kAadSize);
+    gcm.updateAad(reinterpret_cast<const uchar*>(aad.constData()), static_cast<size_t>(aad.size()));
+    gcm.finish(p + kAadSize + kNonceSize);
+
+    // 两份文件头轮流写，崩溃时另一份仍是上一代的完整状态
+    const qint64 offset = (generation % 2) * qint64(kHeaderSlotSize);
+    return container.seek(offset) && container.write(header) == header.size() && syncFile(container);
+}
+
+namespace {
+
+struct ParsedHeader {
+    bool valid = false;
+    quint32 iterations = 0;
+    QByteArray salt;
+    quint32 generation = 0;
+    qint64 plainSize = 0;
+    QVector<quint32> table;
+};
+
+// 只解析结构，认证需要密钥，由 verifyHeader 完成
+ParsedHeader parseHeader(const QByteArray& raw) {
+    ParsedHeader h;
+    const uchar* p = reinterpret_cast<const uchar*>(raw.constData());
+    if (raw.size() < kHeaderFixedSize || memcmp(p, kMagic, sizeof(kMagic)) != 0 || p[4] != kVersion
+        || p[5] != kCipherAes256Gcm || p[6] != kKdfPbkdf2Sha256
+        || qFromLittleEndian<quint32>(p + 28) != EncryptedDatabase::kChunkSize) {
+        return h;
+    }
+    h.iterations = qFromLittleEndian<quint32>(p + 8);
+    h.salt = raw.mid(12, kSaltSize);
+    h.generation = qFromLittleEndian<quint32>(p + 32);
+    h.plainSize = static_cast<qint64>(qFromLittleEndian<quint64>(p + 40));
+    const quint32 count = qFromLittleEndian<quint32>(p + 48);
+    if (count > quint32(kMaxChunks) || raw.size() < kHeaderFixedSize + 4 * qint64(count)
+        || chunkCountFor(h.plainSize) != int(count) || h.iterations == 0 || h.iterations > Pbkdf2::kMaxIterations) {
+        return h;
+    }
+    h.table.resize(count);
+    for (quint32 i = 0; i < count; ++i) h.table[i] = qFromLittleEndian<quint32>(p + kHeaderFixedSize + 4 * i);
+    h.valid = true;
+    return h;
+}
+
+bool verifyHeader(const AES& aes, const QByteArray& raw, const ParsedHeader& h) {
+    const uchar* p = reinterpret_cast<const uchar*>(raw.constData());
+    const QByteArray aad = headerAad(raw.left(kHeaderFixedSize + 4 * h.table.size()));
+    AesGcm gcm(aes, p + kAadSize);
+    gcm.updateAad(reinterpret_cast<const uchar*>(aad.constData()), static_cast<size_t>(aad.size()));
+    uchar tag[kTagSize];
+    gcm.finish(tag);
+    uchar diff = 0;
+    for (int i = 0; i < kTagSize; ++i) diff |= tag[i] ^ p[kAadSize + kNonceSize + i];
+    return diff == 0;
+}
+
+} // namespace
+
+bool EncryptedDatabase::unlock(const QString& password, const ProgressCallback& keyProgress,
+                               const ProgressCallback& progress, bool* wrongPassword) {
+    if (wrongPassword) *wrongPassword = false;
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile container(containerPath());
+    if (!container.open(QIODevice::ReadOnly)) return false;
+    const QByteArray raw[2] = { container.read(kHeaderSlotSize), container.read(kHeaderSlotSize) };
+    const ParsedHeader parsed[2] = { parseHeader(raw[0]), parseHeader(raw[1]) };
+    const ParsedHeader& any = parsed[0].valid ? parsed[0] : parsed[1];
+    if (!any.valid) {
+        qWarning() << "[EncryptedDatabase] 容器文件头已损坏";
+        return false;
+    }
+
+    // 1. 派生密钥，用它认证两份文件头并取代数较新的一份
+    const QByteArray key = FileCryptoHelper::deriveKey(password, any.salt, any.iterations, keyProgress);
+    if (key.isEmpty()) return false;
+    const qint64 kdfMs = timer.elapsed();
+    auto aes = std::make_unique<AES>(AES::AES_256);
+    aes->setKey(reinterpret_cast<const uint8_t*>(key.constData()));
+
+    const ParsedHeader* header = nullptr;
+    for (int slot = 0; slot < 2; ++slot) {
+        if (parsed[slot].valid && verifyHeader(*aes, raw[slot], parsed[slot])
+            && (!header || parsed[slot].generation > header->generation)) {
+            header = &parsed[slot];
+        }
+    }
+    if (!header) {
+        if (wrongPassword) *wrongPassword = true;
+        return false;
+    }
+
+    // 2. 按批读取当前槽位，并行解密后顺序写入工作副本，同时记下各块哈希作为检查点的比较基准
+    const QString working = createWorkingFile();
+    QFile out(working);
+    if (working.isEmpty() || !out.open(QIODevice::WriteOnly)) return false;
+
+    const int count = header->table.size();
+    QVector<quint64> hashes(count);
+    QVector<QByteArray> records(kBatchChunks);
+    QByteArray plain(kBatchChunks * kChunkSize, Qt::Uninitialized);
+    QVector<int> positions;
+    std::atomic<bool> corrupt{false};
+    bool ok = true;
+    for (int first = 0; ok && first < count; first += kBatchChunks) {
+        const int n = qMin(kBatchChunks, count - first);
+        positions.resize(n);
+        std::iota(positions.begin(), positions.end(), 0);
+        for (int k = 0; k < n; ++k) {
+            const quint32 entry = header->table[first + k];
+            if (!container.seek(recordOffset(first + k, entry & kSlotBit ? 1 : 0))) ok = false;
+            records[k] = container.read(kRecordSize);
+            if (records[k].size() != kRecordSize) ok = false;
+        }
+        if (!ok) break;
+
+        QtConcurrent::blockingMap(positions, [&](const int& k) {
+            const int index = first + k;
+            uchar* dst = reinterpret_cast<uchar*>(plain.data()) + k * kChunkSize;
+            if (!decryptChunk(*aes, records[k].constData(), dst, index, header->table[index] & ~kSlotBit)) {
+                corrupt = true;
+                return;
+            }
+            hashes[index] = chunkHash(dst, qMin(kChunkSize, header->plainSize - index * kChunkSize));
+        });
+        if (corrupt) {
+            ok = false;
+            break;
+        }
+
+        const qint64 bytes = qMin<qint64>(n * kChunkSize, header->plainSize - first * kChunkSize);
+        const qint64 done = first * kChunkSize + bytes;
+        if (out.write(plain.constData(), bytes) != bytes || (progress && !progress(done, header->plainSize))) ok = false;
+    }
+    plain.fill(0);
+    out.close();
+    if (!ok) {
+        if (corrupt) qWarning() << "[EncryptedDatabase] 数据块认证失败，容器已损坏";
+        QFile::remove(working);
+        return false;
+    }
+
+    QMutexLocker locker(&m_saveMutex);
+    m_aes = std::move(aes);
+    m_salt = header->salt;
+    m_iterations = header->iterations;
+    m_generation = header->generation;
+    m_plainSize = header->plainSize;
+    m_table = header->table;
+    m_chunkHashes = hashes;
+    m_changeCounter = sqliteChangeCounter(working);
+    m_workingPath = working;
+    m_lastUnlockMs = timer.elapsed();
+    qDebug().noquote() << QString("[EncryptedDatabase] 解锁完成: %1 MB，共 %2 ms (密钥派生 %3 ms)，工作副本 %4")
+                              .arg(m_plainSize / (1024.0 * 1024.0), 0, 'f', 1).arg(m_lastUnlockMs).arg(kdfMs).arg(working);
+    return true;
+}
+
+bool EncryptedDatabase::writeContainer(const AES& aes, const QString& plainPath, const ProgressCallback& progress) {
+    QFile src(plainPath);
+    if (!src.open(QIODevice::ReadOnly)) return false;
+    const qint64 size = src.size();
+    const int count = chunkCountFor(size);
+    if (count > kMaxChunks) {
+        qWarning() << "[EncryptedDatabase] 数据库超过容器上限:" << size;
+        return false;
+    }
+
+    // 写到临时名再改名；槽位 1 先留空 (稀疏)，以后的检查点才会用到
+    const QString temp = containerPath() + ".part";
+    QFile container(temp);
+    if (!container.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    QVector<quint32> table(count, 1u);     // 第 1 代，全部位于槽位 0
+    QVector<quint64> hashes(count);
+    QVector<QByteArray> records(kBatchChunks);
+    QByteArray plain(kBatchChunks * kChunkSize, Qt::Uninitialized);
+    QVector<int> positions;
+    bool ok = true;
+    for (int first = 0; ok && first < count; first += kBatchChunks) {
+        const int n = qMin(kBatchChunks, count - first);
+        const qint64 bytes = qMin<qint64>(n * kChunkSize, size - first * kChunkSize);
+        if (src.read(plain.data(), bytes) != bytes) {
+            ok = false;
+            break;
+        }
+        positions.resize(n);
+        std::iota(positions.begin(), positions.end(), 0);
+        QtConcurrent::blockingMap(positions, [&](const int& k) {
+            const int index = first + k;
+            const uchar* data = reinterpret_cast<const uchar*>(plain.constData()) + k * kChunkSize;
+            const qint64 len = qMin(kChunkSize, size - index * kChunkSize);
+            records[k] = encryptChunk(aes, data, len, index, 1);
+            hashes[index] = chunkHash(data, len);
+        });
+        for (int k = 0; ok && k < n; ++k) {
+            ok = container.seek(recordOffset(first + k, 0)) && container.write(records[k]) == kRecordSize;
+        }
+        if (ok && progress && !progress(first * kChunkSize + bytes, size)) ok = false;
+    }
+    plain.fill(0);
+
+    ok = ok && writeHeader(aes, container, 1, size, table);
+    container.close();
+    if (!ok || !QFile::rename(temp, containerPath())) {
+        QFile::remove(temp);
+        return false;
+    }
+
+    QMutexLocker locker(&m_saveMutex);
+    m_generation = 1;
+    m_plainSize = size;
+    m_table = table;
+    m_chunkHashes = hashes;
+    return true;
+}
+
+bool EncryptedDatabase::prepareEnable(const QString& plainPath, const QString& password,
+                                      const ProgressCallback& keyProgress, const ProgressCallback& progress) {
+    if (isEnabled() || isUnlocked()) return false;
+
+    QByteArray salt(kSaltSize, 0);
+    for (int i = 0; i < kSaltSize; ++i) salt[i] = (char)QRandomGenerator::global()->bounded(256);
+    const quint32 iterations = FileCryptoHelper::defaultIterations();
+    const QByteArray key = FileCryptoHelper::deriveKey(password, salt, iterations, keyProgress);
+    if (key.isEmpty()) return false;
+    auto aes = std::make_unique<AES>(AES::AES_256);
+    aes->setKey(reinterpret_cast<const uint8_t*>(key.constData()));
+    m_salt = salt;
+    m_iterations = iterations;
+
+    // 在数据库锁内做快照，记录修改计数供 finishEnable 判断之后是否又有写入
+    const QString working = createWorkingFile();
+    if (working.isEmpty()) return false;
+    bool copied = false;
+    DatabaseManager::instance().runExclusive([&] {
+        QFile::remove(working);
+        copied = QFile::copy(plainPath, working);
+        m_enableSize = QFileInfo(plainPath).size();
+        m_enableCounter = sqliteChangeCounter(plainPath);
+    });
+    QFile::setPermissions(working, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    if (!copied || !writeContainer(*aes, working, progress)) {
+        QFile::remove(working);
+        return false;
+    }
+
+    m_aes = std::move(aes);
+    m_workingPath = working;
+    m_plainSourcePath = plainPath;
+    m_changeCounter = m_enableCounter;
+    return true;
+}
+
+bool EncryptedDatabase::finishEnable() {
+    if (!isUnlocked() || m_plainSourcePath.isEmpty()) return false;
+
+    DatabaseManager& db = DatabaseManager::instance();
+    bool ok = false;
+    db.runExclusive([&] {
+        // 快照之后明文库若又提交过事务，补拷一次；差异由下一次检查点按块写入容器
+        if (QFileInfo(m_plainSourcePath).size() != m_enableSize
+            || sqliteChangeCounter(m_plainSourcePath) != m_enableCounter) {
+            removeWorkingFile(m_workingPath);
+            if (!QFile::copy(m_plainSourcePath, m_workingPath)) return;
+            QFile::setPermissions(m_workingPath, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+        }
+        ok = db.init(m_workingPath, false);
+    });
+
+    if (!ok) {
+        qWarning() << "[EncryptedDatabase] 切换到加密数据库失败，保持明文模式";
+        db.init(m_plainSourcePath);
+        QFile::remove(containerPath());
+        removeWorkingFile(m_workingPath);
+        m_aes.reset();
+        m_workingPath.clear();
+        return false;
+    }
+
+    // 覆盖删除明文库较慢，放到后台；先停掉可能正在读取明文库的自动备份
+    DatabaseBackup::instance().cancel();
+    const QString plain = m_plainSourcePath;
+    m_plainSourcePath.clear();
+    (void)QtConcurrent::run([plain]() {
+        FileCryptoHelper::secureDelete(plain);
+        QFile::remove(plain + "-journal");
+    });
+
+    startAutoSave();
+    requestCheckpoint();
+    return true;
+}
+
+void EncryptedDatabase::discard() {
+    if (!isUnlocked()) return;
+    QMutexLocker locker(&m_saveMutex);
+    if (!m_plainSourcePath.isEmpty()) {
+        QFile::remove(containerPath());
+        m_plainSourcePath.clear();
+    }
+    removeWorkingFile(m_workingPath);
+    m_workingPath.clear();
+    m_aes.reset();
+}
+
+bool EncryptedDatabase::checkpoint() {
+    if (!isUnlocked()) return false;
+    QMutexLocker saveLocker(&m_saveMutex);
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile working(m_workingPath);
+    QFile container(containerPath());
+    if (!working.open(QIODevice::ReadOnly) || !container.open(QIODevice::ReadWrite)) return false;
+
+    struct Pending {
+        int index;
+        int slot;
+        QByteArray record;
+    };
+    QList<Pending> pending;
+    qint64 pendingBytes = 0;
+    auto flush = [&]() {
+        for (const Pending& p : std::as_const(pending)) {
+            if (!container.seek(recordOffset(p.index, p.slot)) || container.write(p.record) != kRecordSize) return false;
+        }
+        pending.clear();
+        pendingBytes = 0;
+        return true;
+    };
+
+    const quint32 generation = m_generation + 1;
+    bool ok = true;
+    bool unchanged = false;
+    int changedCount = 0;
+    qint64 size = 0;
+    quint32 counter = 0;
+    qint64 lockedMs = 0;
+    QVector<quint32> table;
+    QVector<quint64> hashes;
+
+    DatabaseManager::instance().runExclusive([&] {
+        QElapsedTimer lockTimer;
+        lockTimer.start();
+        size = working.size();
+        const int count = chunkCountFor(size);
+        if (count > kMaxChunks) {
+            qWarning() << "[EncryptedDatabase] 数据库超过容器上限:" << size;
+            ok = false;
+            return;
+        }
+        uchar* map = size > 0 ? working.map(0, size) : nullptr;
+        if (size > 0 && !map) {
+            ok = false;
+            return;
+        }
+        counter = sqliteChangeCounter(map, size);
+        if (size == m_plainSize && counter == m_changeCounter) {
+            unchanged = true;
+        } else {
+            // 并行哈希找出变化的块，加密后缓存密文；缓存过大时在锁内先写出一部分
+            hashes.resize(count);
+            QVector<int> indices(count);
+            std::iota(indices.begin(), indices.end(), 0);
+            QtConcurrent::blockingMap(indices, [&](const int& i) {
+                hashes[i] = chunkHash(map + i * kChunkSize, qMin(kChunkSize, size - i * kChunkSize));
+            });
+
+            QVector<int> changed;
+            for (int i = 0; i < count; ++i) {
+                if (i >= m_chunkHashes.size() || hashes[i] != m_chunkHashes[i]) changed.append(i);
+            }
+            changedCount = changed.size();
+            table = m_table;
+            table.resize(count);
+
+            for (int first = 0; ok && first < changed.size(); first += kBatchChunks) {
+                const QVector<int> batch = changed.mid(first, kBatchChunks);
+                QVector<QByteArray> records(batch.size());
+                QVector<int> positions(batch.size());
+                std::iota(positions.begin(), positions.end(), 0);
+                QtConcurrent::blockingMap(positions, [&](const int& k) {
+                    const int i = batch[k];
+                    records[k] = encryptChunk(*m_aes, map + i * kChunkSize, qMin(kChunkSize, size - i * kChunkSize), i, generation);
+                });
+                for (int k = 0; k < batch.size(); ++k) {
+                    const int i = batch[k];
+                    // 写入当前块表未引用的槽位
+                    const int slot = (i < m_table.size() && !(m_table[i] & kSlotBit)) ? 1 : 0;
+                    table[i] = (slot ? kSlotBit : 0u) | generation;
+                    pending.append(Pending{i, slot, records[k]});
+                    pendingBytes += kRecordSize;
+                }
+                if (pendingBytes > kMaxPendingBytes && !flush()) ok = false;
+            }
+        }
+        if (map) working.unmap(map);
+        lockedMs = lockTimer.elapsed();
+    });
+
+    if (!ok) return false;
+    if (unchanged) return true;
+    if (changedCount == 0 && size == m_plainSize) {
+        m_changeCounter = counter;
+        return true;
+    }
+
+    // 新块落盘后再提交新一代文件头，最后截掉数据库缩小后多余的槽位
+    if (!flush() || !syncFile(container) || !writeHeader(*m_aes, container, generation, size, table)) {
+        qWarning() << "[EncryptedDatabase] 检查点写入失败:" << container.errorString();
+        return false;
+    }
+    const qint64 end = recordOffset(table.size(), 0);
+    if (container.size() > end) container.resize(end);
+
+    m_generation = generation;
+    m_plainSize = size;
+    m_table = table;
+    m_chunkHashes = hashes;
+    m_changeCounter = counter;
+    m_lastCheckpointMs = timer.elapsed();
+    qDebug().noquote() << QString("[EncryptedDatabase] 检查点 #%1: 写入 %2/%3 块，共 %4 ms (持锁 %5 ms)")
+                              .arg(generation).arg(changedCount).arg(table.size()).arg(m_lastCheckpointMs).arg(lockedMs);
+    emit checkpointFinished(true, changedCount, m_lastCheckpointMs);
+    return true;
+}
+
+void EncryptedDatabase::startAutoSave() {
+    if (!isUnlocked()) return;
+    DatabaseManager& db = DatabaseManager::instance();
+    auto schedule = [this]() { m_debounceTimer.start(); };
+    // Qt::UniqueConnection 对 lambda 无效，保留连接句柄，重复调用时先断开旧的
+    for (const QMetaObject::Connection& connection : std::as_const(m_changeConnections)) disconnect(connection);
+    m_changeConnections = {
+        connect(&db, &DatabaseManager::noteAdded, this, schedule),
+        connect(&db, &DatabaseManager::noteUpdated, this, schedule),
+        connect(&db, &DatabaseManager::categoriesChanged, this, schedule),
+    };
+    m_autoSaveTimer.start();
+}
+
+void EncryptedDatabase::requestCheckpoint() {
+    if (!isUnlocked()) return;
+    if (m_checkpointRunning.exchange(true)) {
+        // 上一次还在进行，它的快照可能已经错过这次写入，稍后再来
+        m_debounceTimer.start();
+        return;
+    }
+    m_future = QtConcurrent::run([this]() {
+        if (!checkpoint()) emit checkpointFinished(false, 0, 0);
+        m_checkpointRunning = false;
+    });
+}
+
+void EncryptedDatabase::shutdown() {
+    if (!isUnlocked()) return;
+    m_autoSaveTimer.stop();
+    m_debounceTimer.stop();
+    m_future.waitForFinished();
+    if (!checkpoint()) {
+        qCritical() << "[EncryptedDatabase] 退出前的检查点失败，工作副本保留在:" << m_workingPath;
+        return;
+    }
+
+    DatabaseManager::instance().close();
+    removeWorkingFile(m_workingPath);
+    removeWorkingFile(m_workingPath + "-journal");
+    m_aes.reset();
+    m_workingPath.clear();
+}
@@ -0,0 +1,127 @@
+#ifndef ENCRYPTEDDATABASE_H
+#define ENCRYPTEDDATABASE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QTimer>
+#include <QFuture>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include "FileCryptoHelper.h"
+
+class AES;
+
+/**
+ * @brief 数据库静态加密
+ *
+ * 加密模式下磁盘上只有容器文件 notes.db.enc，解锁时把它解密成明文工作副本交给 DatabaseManager 打开，退出时删除。
+ * 工作副本放在仅当前用户可访问的目录：Linux 优先用内存盘 (XDG_RUNTIME_DIR 或 /dev/shm 下的私有子目录)，
+ * 其他平台为程序数据目录 (AppLocalData) 下的 working 子目录 (Windows 上设置仅本人与 SYSTEM 可访问的 ACL)，
+ * 无法建立这样的目录时解锁失败，不退回共享的临时目录。
+ *
+ * 残余风险：没有内存盘的平台上，明文在整个会话期间位于磁盘，可能被卷影副本、备份或休眠文件捕获，
+ * 对能以当前用户身份运行程序的攻击者也不设防；异常退出留下的副本在下次解锁时删除 (removeStaleWorkingFiles)。
+ * 不在内存盘上的副本删除前先覆写 (FileCryptoHelper::secureDelete)。
+ *
+ * 容器按 kChunkSize 切块，每块独立做 AES-256-GCM (随机 Nonce，块序号与代数作为附加认证数据)，
+ * 解锁时各块并行解密。每块有 A/B 两个槽位，文件头同样双份：检查点只把内容变化的块写进当前未被引用的槽位，
+ * 同步落盘后再写入新一代文件头，中途崩溃时旧的文件头仍指向完整的一代数据。
+ *
+ * 检查点先读 SQLite 文件头的修改计数，数据库没有提交过事务时直接跳过；否则在数据库锁内映射工作副本，
+ * 并行计算各块哈希找出变化的块并加密，释放锁后再写盘。1GB 数据库持锁时间约为一次并行哈希的耗时，
+ * 写盘量只与改动的块数成正比。解锁与检查点的耗时都会记录并输出到日志，
+ * 1GB 库上的实测见 RapidNotesBenchmark encrypted (tests/EncryptedDatabaseBenchmark.cpp)。
+ */
+class EncryptedDatabase : public QObject {
+    Q_OBJECT
+public:
+    using ProgressCallback = FileCryptoHelper::ProgressCallback;
+
+    static constexpr qint64 kChunkSize = 1024 * 1024;
+    static constexpr int kHeaderSlotSize = 64 * 1024;           // 每份文件头 (含块表) 的固定大小
+    static constexpr int kAutoSaveIntervalMs = 60 * 1000;       // 周期检查点
+    static constexpr int kChangeDebounceMs = 3000;              // 数据库写入后的防抖检查点
+    static constexpr qint64 kMaxPendingBytes = 64 * 1024 * 1024; // 持锁期间最多缓存的密文，超出则在锁内直接写盘
+
+    static EncryptedDatabase& instance();
+
+    static QString containerPath();     // <程序目录>/notes.db.enc
+    static bool isEnabled();            // 容器存在即为加密模式
+
+    // 以下三个耗时操作可在工作线程中调用 (进度回调也在该线程中触发)
+    // 解锁：派生密钥、校验文件头并解密全部块到工作副本；wrongPassword 区分密码错误与文件损坏
+    bool unlock(const QString& password, const ProgressCallback& keyProgress = nullptr,
+                const ProgressCallback& progress = nullptr, bool* wrongPassword = nullptr);
+    // 开启加密：在数据库锁内对明文库做快照，生成容器与工作副本
+    bool prepareEnable(const QString& plainPath, const QString& password,
+                       const ProgressCallback& keyProgress = nullptr, const ProgressCallback& progress = nullptr);
+    // 把工作副本中变化的块写回容器
+    bool checkpoint();
+
+    // 主线程：prepareEnable 成功后切换 DatabaseManager 到工作副本，并安全删除明文库
+    bool finishEnable();
+
+    // 撤销尚未交给 DatabaseManager 的 unlock / prepareEnable 结果：删除工作副本，开启加密时一并删除容器
+    void discard();
+
+    bool isUnlocked() const { return m_aes != nullptr; }
+    QString workingPath() const { return m_workingPath; }
+
+    // 主线程：开始周期与防抖检查点
+    void startAutoSave();
+    void requestCheckpoint();
+    // 退出时调用：等待后台检查点、做最后一次检查点、关闭数据库并删除工作副本
+    void shutdown();
+
+    qint64 lastUnlockMs() const { return m_lastUnlockMs; }
+    qint64 lastCheckpointMs() const { return m_lastCheckpointMs; }
+
+signals:
+    void checkpointFinished(bool ok, int chunksWritten, qint64 elapsedMs);
+
+private:
+    EncryptedDatabase(QObject* parent = nullptr);
+    ~EncryptedDatabase();
+    EncryptedDatabase(const EncryptedDatabase&) = delete;
+    EncryptedDatabase& operator=(const EncryptedDatabase&) = delete;
+
+    static QString workingDirectory();
+    // 删除上次异常退出留下的明文工作副本 (含旧版本写在系统临时目录中的)；只在加密模式创建工作副本时调用
+    static void removeStaleWorkingFiles();
+    // 明文工作副本的删除：内存盘 (tmpfs) 上直接删除，磁盘上先覆写再删除
+    static void removeWorkingFile(const QString& path);
+    QString createWorkingFile();
+    bool writeContainer(const AES& aes, const QString& plainPath, const ProgressCallback& progress);
+    bool writeHeader(const AES& aes, QFile& container, quint32 generation, qint64 plainSize, const QVector<quint32>& table);
+    static QByteArray encryptChunk(const AES& aes, const uchar* data, qint64 len, int index, quint32 generation);
+    static bool decryptChunk(const AES& aes, const char* record, uchar* out, int index, quint32 generation);
+
+    std::unique_ptr<AES> m_aes;
+    QByteArray m_salt;
+    quint32 m_iterations = 0;
+
+    QString m_workingPath;
+    QString m_plainSourcePath;          // prepareEnable 的明文来源
+    quint32 m_enableCounter = 0;
+    qint64 m_enableSize = -1;
+
+    // 已提交的状态，仅在 m_saveMutex 内修改
+    QMutex m_saveMutex;
+    quint32 m_generation = 0;
+    qint64 m_plainSize = 0;
+    QVector<quint32> m_table;           // 每块：最高位为槽位，低 31 位为写入时的代数
+    QVector<quint64> m_chunkHashes;
+    quint32 m_changeCounter = 0;
+
+    QTimer m_autoSaveTimer;
+    QTimer m_debounceTimer;
+    QList<QMetaObject::Connection> m_changeConnections;   // startAutoSave 建立的数据变化监听，重复调用时先断开
+    QFuture<void> m_future;
+    std::atomic<bool> m_checkpointRunning{false};
+    qint64 m_lastUnlockMs = 0;
+    qint64 m_lastCheckpointMs = 0;
+};
+
+#endif // ENCRYPTEDDATABASE_H
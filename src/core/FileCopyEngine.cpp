@@ -0,0 +1,257 @@
+#include "FileCopyEngine.h"
+#include "BlobStore.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QMutex>
+#include <QtConcurrent>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+FileCopyEngine::FileCopyEngine(QObject* parent) : QObject(parent) {
+    m_progressTimer.setInterval(kProgressIntervalMs);
+    connect(&m_progressTimer, &QTimer::timeout, this, &FileCopyEngine::emitProgress);
+}
+
+FileCopyEngine::~FileCopyEngine() {
+    // 工作线程持有 this，析构前必须等它退出 (取消后每个块都会检查标志，退出很快)
+    m_cancel = true;
+    m_future.waitForFinished();
+}
+
+bool FileCopyEngine::start(const QList<Task>& tasks) {
+    if (m_running) return false;
+    m_running = true;
+    m_cancel = false;
+    m_bytesDone = 0;
+    m_bytesTotal = 0;
+    m_filesDone = 0;
+    m_filesTotal = 0;
+    m_dedupBytes = 0;
+    m_storedBlobs.clear();
+    m_progressTimer.start();
+
+    m_future = QtConcurrent::run([this, tasks]() {
+        QList<bool> taskOk = runTasks(tasks);
+        const bool cancelled = m_cancel;
+        QMetaObject::invokeMethod(this, [this, taskOk, cancelled]() {
+            m_progressTimer.stop();
+            m_running = false;
+            emitProgress();
+            emit finished(taskOk, cancelled);
+        });
+    });
+    return true;
+}
+
+void FileCopyEngine::cancel() {
+    m_cancel = true;
+}
+
+void FileCopyEngine::emitProgress() {
+    emit progress(m_bytesDone, m_bytesTotal, m_filesDone, m_filesTotal);
+}
+
+QList<bool> FileCopyEngine::runTasks(const QList<Task>& tasks) {
+    struct Job {
+        QString source;
+        QString destination;
+        qint64 size;
+        int task;
+    };
+    QList<Job> smallJobs;
+    QList<Job> largeJobs;
+    QList<bool> taskOk(tasks.size(), true);
+
+    auto addJob = [&](const QFileInfo& info, const QString& destination, int task) {
+        Job job{info.absoluteFilePath(), destination, info.size(), task};
+        (job.size < kSmallFileLimit ? smallJobs : largeJobs) << job;
+        // 块存储模式下每个文件先读一遍算哈希，进度按两遍计
+        m_bytesTotal += m_useBlobStore ? job.size * 2 : job.size;
+        m_filesTotal++;
+    };
+
+    // 1. 建立清单并预建目录，复制阶段不再有目录竞争
+    for (int i = 0; i < tasks.size() && !m_cancel; ++i) {
+        const Task& task = tasks.at(i);
+        QFileInfo info(task.source);
+        if (info.isDir()) {
+            if (!QDir().mkpath(task.destination)) {
+                taskOk[i] = false;
+                continue;
+            }
+            QDir srcRoot(info.absoluteFilePath());
+            QDirIterator it(srcRoot.absolutePath(), QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden,
+                            QDirIterator::Subdirectories);
+            while (it.hasNext() && !m_cancel) {
+                it.next();
+                const QFileInfo entry = it.fileInfo();
+                const QString destination = task.destination + "/" + srcRoot.relativeFilePath(entry.absoluteFilePath());
+                if (entry.isDir()) {
+                    if (!QDir().mkpath(destination)) taskOk[i] = false;
+                } else {
+                    addJob(entry, destination, i);
+                }
+            }
+        } else if (info.isFile()) {
+            addJob(info, task.destination, i);
+        } else {
+            taskOk[i] = false;
+        }
+    }
+
+    QMutex failMutex;
+    auto copyJob = [&](const Job& job) {
+        if (!m_useBlobStore) return copyFile(job.source, job.destination, &m_cancel, &m_bytesDone);
+
+        const QString hash = BlobStore::hashFile(job.source, &m_cancel, &m_bytesDone);
+        bool deduplicated = false;
+        if (hash.isEmpty() || !BlobStore::store(job.source, hash, job.destination, &deduplicated, &m_cancel, &m_bytesDone)) {
+            return false;
+        }
+        if (deduplicated) {
+            m_bytesDone += job.size; // 已存在的块无需写入
+            m_dedupBytes += job.size;
+        }
+        QMutexLocker locker(&m_blobMutex);
+        m_storedBlobs.append(QVariantMap{{"hash", hash}, {"size", job.size}, {"created", !deduplicated},
+                                         {"path", BlobStore::toRelativePath(job.destination)}});
+        return true;
+    };
+
+    auto runJob = [&](const Job& job) {
+        if (m_cancel) return;
+        if (copyJob(job)) {
+            m_filesDone++;
+        } else if (!m_cancel) {
+            qWarning() << "[FileCopyEngine] 复制失败:" << job.source;
+            QMutexLocker locker(&failMutex);
+            taskOk[job.task] = false;
+        }
+    };
+
+    // 2. 小文件并行：单个文件的开销主要在打开/创建 (块存储模式下还有哈希计算)，而非带宽
+    QtConcurrent::blockingMap(smallJobs, runJob);
+    // 3. 大文件顺序：带宽已被单个文件吃满，并行只会互相抢占
+    for (const Job& job : std::as_const(largeJobs)) {
+        if (m_cancel) break;
+        runJob(job);
+    }
+    return taskOk;
+}
+
+#ifdef Q_OS_WIN
+namespace {
+struct CopyProgressContext {
+    const std::atomic<bool>* cancel;
+    std::atomic<qint64>* bytesCopied;
+    qint64 reported;
+};
+
+DWORD CALLBACK copyProgressRoutine(LARGE_INTEGER, LARGE_INTEGER transferred, LARGE_INTEGER, LARGE_INTEGER,
+                                   DWORD, DWORD, HANDLE, HANDLE, LPVOID data) {
+    auto* ctx = static_cast<CopyProgressContext*>(data);
+    if (ctx->bytesCopied) *ctx->bytesCopied += transferred.QuadPart - ctx->reported;
+    ctx->reported = transferred.QuadPart;
+    return (ctx->cancel && ctx->cancel->load(std::memory_order_relaxed)) ? PROGRESS_CANCEL : PROGRESS_CONTINUE;
+}
+}
+#endif
+
+bool FileCopyEngine::reflinkFile(const QString& source, const QString& destination) {
+#ifdef Q_OS_LINUX
+    QFile in(source);
+    QFile out(destination);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    if (!out.open(QIODevice::WriteOnly | QIODevice::NewOnly)) return false;
+    if (::ioctl(out.handle(), FICLONE, in.handle()) == 0) {
+        out.setPermissions(in.permissions());
+        return true;
+    }
+    out.remove();
+    return false;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(destination);
+    return false;
+#endif
+}
+
+bool FileCopyEngine::copyFile(const QString& source, const QString& destination,
+                              const std::atomic<bool>* cancel, std::atomic<qint64>* bytesCopied) {
+#ifdef Q_OS_WIN
+    // 系统复制：保留属性，走缓存管理器的大块异步 I/O；取消时系统会删除半成品
+    CopyProgressContext ctx{cancel, bytesCopied, 0};
+    const std::wstring src = QDir::toNativeSeparators(source).toStdWString();
+    const std::wstring dst = QDir::toNativeSeparators(destination).toStdWString();
+    return CopyFileExW(src.c_str(), dst.c_str(), copyProgressRoutine, &ctx, nullptr, COPY_FILE_FAIL_IF_EXISTS) != 0;
+#else
+    auto cancelled = [cancel]() { return cancel && cancel->load(std::memory_order_relaxed); };
+    auto advance = [bytesCopied](qint64 n) {
+        if (bytesCopied) *bytesCopied += n;
+    };
+
+    QFile in(source);
+    QFile out(destination);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    if (!out.open(QIODevice::WriteOnly | QIODevice::NewOnly)) return false;
+
+    const qint64 size = in.size();
+    qint64 copied = 0;
+    bool ok = true;
+
+#ifdef Q_OS_LINUX
+    const int inFd = in.handle();
+    const int outFd = out.handle();
+    if (::ioctl(outFd, FICLONE, inFd) == 0) {
+        // reflink (btrfs/xfs)：写时复制，不产生数据拷贝
+        copied = size;
+        advance(size);
+    } else {
+        // 内核内拷贝，避免数据在用户态来回搬运；跨文件系统或内核不支持时退回缓冲区复制
+        while (copied < size && !cancelled()) {
+            const ssize_t n = ::copy_file_range(inFd, nullptr, outFd, nullptr,
+                                                static_cast<size_t>(qMin(size - copied, kBufferSize)), 0);
+            if (n <= 0) break;
+            copied += n;
+            advance(n);
+        }
+        if (copied < size && !cancelled()) ok = in.seek(copied) && out.seek(copied);
+    }
+#endif
+
+    if (ok && copied < size && !cancelled()) {
+        QByteArray buffer(qBound<qint64>(64 * 1024, size - copied, kBufferSize), Qt::Uninitialized);
+        while (!cancelled()) {
+            const qint64 got = in.read(buffer.data(), buffer.size());
+            if (got < 0) {
+                ok = false;
+                break;
+            }
+            if (got == 0) break;
+            if (out.write(buffer.constData(), got) != got) {
+                ok = false;
+                break;
+            }
+            advance(got);
+        }
+    }
+
+    if (!ok || cancelled()) {
+        out.remove();
+        return false;
+    }
+    out.setPermissions(in.permissions());
+    return out.flush();
+#endif
+}
@@ -1,88 +1,313 @@
 #include "FileCryptoHelper.h"
 #include "AES.h"
+#include "Pbkdf2.h"
 #include <QDebug>
 #include <QFileInfo>
 #include <QCryptographicHash>
 #include <QRandomGenerator>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <cstring>
 
 #define SALT_SIZE 16
 #define IV_SIZE 16
+#define NONCE_SIZE 12
+#define TAG_SIZE 16
 #define KEY_SIZE 32
-#define PBKDF2_ITERATIONS 5000 // 减少迭代次数以适应内置实现性能
+#define LEGACY_KDF_ITERATIONS 5000 // 旧版哈希链的固定轮数
 
-// 简单的 PBKDF2 替代方案：利用 Qt 自带哈希链式派生密钥
-static QByteArray deriveKeyInternal(const QString& password, const QByteArray& salt) {
+// v2 文件头：魔数(4) + 版本(1) + 算法(1) + KDF(1) + 保留(1) + 迭代次数(4, 小端) + Salt + Nonce
+static const char kMagic[4] = {'R', 'N', 'C', 'F'};
+static constexpr quint8 kFormatVersion = 2;
+static constexpr quint8 kCipherAes256Gcm = 1;
+static constexpr quint8 kKdfSha256Chain = 1;     // 旧版哈希链，仅用于解密
+static constexpr quint8 kKdfPbkdf2Sha256 = 2;
+static constexpr int kHeaderSize = 12 + SALT_SIZE + NONCE_SIZE;
+// GCM 单条消息最多 2^32 - 2 个块
+static constexpr qint64 kMaxGcmBytes = (Q_INT64_C(1) << 36) - 32;
+
+// 旧版密钥派生：SHA-256 哈希链，仅为解密早期文件保留
+static QByteArray deriveLegacyKey(const QString& password, const QByteArray& salt, int iterations = LEGACY_KDF_ITERATIONS) {
     QByteArray key = password.toUtf8();
-    for (int i = 0; i < PBKDF2_ITERATIONS; ++i) {
+    for (int i = 0; i < iterations; ++i) {
         key = QCryptographicHash::hash(key + salt, QCryptographicHash::Sha256);
     }
     return key;
 }
 
-bool FileCryptoHelper::encryptFile(const QString& sourcePath, const QString& destPath, const QString& password) {
+// 读满 len 字节或到达文件末尾
+static qint64 readFully(QFile& file, char* data, qint64 len) {
+    qint64 total = 0;
+    while (total < len) {
+        const qint64 got = file.read(data + total, len - total);
+        if (got < 0) return -1;
+        if (got == 0) break;
+        total += got;
+    }
+    return total;
+}
+
+static QByteArray randomBytes(int size) {
+    QByteArray bytes(size, 0);
+    for (int i = 0; i < size; ++i) bytes[i] = (char)QRandomGenerator::global()->bounded(256);
+    return bytes;
+}
+
+// 首次使用前跑一遍已知答案测试，实现有误时宁可拒绝工作也不产出错误的密文
+static bool selfTestPassed() {
+    static const bool passed = [] {
+        const bool ok = AES::selfTest() && Pbkdf2::selfTest();
+        if (!ok) qCritical() << "[FileCryptoHelper] AES/PBKDF2 自检失败，已禁用加解密";
+        return ok;
+    }();
+    return passed;
+}
+
+// 按 kSegmentSize 切段，各段以块偏移独立计算 CTR 密钥流，交给线程池并行
+static void parallelCrypt(const AesGcm& gcm, uint8_t* data, qint64 len, quint64 blockBase) {
+    const qint64 segment = FileCryptoHelper::kSegmentSize;
+    if (len <= segment) {
+        gcm.crypt(data, data, static_cast<size_t>(len), blockBase);
+        return;
+    }
+    QList<qint64> offsets;
+    for (qint64 offset = 0; offset < len; offset += segment) offsets.append(offset);
+    QtConcurrent::blockingMap(offsets, [&](const qint64& offset) {
+        gcm.crypt(data + offset, data + offset, static_cast<size_t>(qMin(segment, len - offset)),
+                  blockBase + static_cast<quint64>(offset / 16));
+    });
+}
+
+static bool constantTimeEquals(const uint8_t* a, const uint8_t* b, int len) {
+    uint8_t diff = 0;
+    for (int i = 0; i < len; ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+QByteArray FileCryptoHelper::deriveKey(const QString& password, const QByteArray& salt, quint32 iterations,
+                                       const ProgressCallback& progress) {
+    QByteArray pwd = password.toUtf8();
+    QByteArray key(KEY_SIZE, Qt::Uninitialized);
+    Pbkdf2::ProgressCallback callback;
+    if (progress) {
+        callback = [&progress](uint64_t done, uint64_t total) {
+            return progress(static_cast<qint64>(done), static_cast<qint64>(total));
+        };
+    }
+    const bool ok = Pbkdf2::deriveHmacSha256(reinterpret_cast<const uint8_t*>(pwd.constData()), static_cast<size_t>(pwd.size()),
+                                             reinterpret_cast<const uint8_t*>(salt.constData()), static_cast<size_t>(salt.size()),
+                                             iterations, reinterpret_cast<uint8_t*>(key.data()), KEY_SIZE, callback);
+    pwd.fill(0);
+    if (!ok) {
+        key.fill(0);
+        return QByteArray();
+    }
+    return key;
+}
+
+quint32 FileCryptoHelper::defaultIterations() {
+    static const quint32 iterations = [] {
+        const quint32 n = Pbkdf2::calibrate(kKdfTargetMs);
+        qDebug() << "[FileCryptoHelper] PBKDF2 迭代次数校准为" << n;
+        return n;
+    }();
+    return iterations;
+}
+
+QFuture<bool> FileCryptoHelper::encryptFileAsync(const QString& sourcePath, const QString& destPath, const QString& password,
+                                                 const ProgressCallback& progress, const ProgressCallback& keyProgress) {
+    return QtConcurrent::run([=]() { return encryptFile(sourcePath, destPath, password, progress, keyProgress); });
+}
+
+QFuture<bool> FileCryptoHelper::decryptFileAsync(const QString& sourcePath, const QString& destPath, const QString& password,
+                                                 const ProgressCallback& progress, const ProgressCallback& keyProgress) {
+    return QtConcurrent::run([=]() { return decryptFile(sourcePath, destPath, password, progress, keyProgress); });
+}
+
+bool FileCryptoHelper::encryptFile(const QString& sourcePath, const QString& destPath, const QString& password,
+                                   const ProgressCallback& progress, const ProgressCallback& keyProgress) {
+    if (!selfTestPassed()) return false;
+
     QFile src(sourcePath);
     if (!src.open(QIODevice::ReadOnly)) return false;
-    QByteArray srcData = src.readAll();
-    src.close();
+    const qint64 total = src.size();
+    if (total > kMaxGcmBytes) {
+        qWarning() << "[FileCryptoHelper] 文件超过 AES-GCM 单次加密上限:" << sourcePath;
+        return false;
+    }
 
-    // 1. 生成随机盐和 IV
-    QByteArray salt(SALT_SIZE, 0);
-    QByteArray iv(IV_SIZE, 0);
-    for(int i=0; i<SALT_SIZE; ++i) salt[i] = (char)QRandomGenerator::global()->bounded(256);
-    for(int i=0; i<IV_SIZE; ++i) iv[i] = (char)QRandomGenerator::global()->bounded(256);
+    // 1. 生成随机盐和 Nonce，派生密钥
+    const QByteArray salt = randomBytes(SALT_SIZE);
+    const QByteArray nonce = randomBytes(NONCE_SIZE);
+    const quint32 iterations = defaultIterations();
+    const QByteArray key = deriveKey(password, salt, iterations, keyProgress);
+    if (key.isEmpty()) return false;
 
-    // 2. 派生密钥
-    QByteArray key = deriveKeyInternal(password, salt);
+    QByteArray header(kMagic, sizeof(kMagic));
+    header.append(char(kFormatVersion)).append(char(kCipherAes256Gcm)).append(char(kKdfPbkdf2Sha256)).append('\0');
+    char iterationBytes[4];
+    qToLittleEndian<quint32>(iterations, iterationBytes);
+    header.append(iterationBytes, 4).append(salt).append(nonce);
 
-    // 3. 执行加密
     AES aes(AES::AES_256);
-    std::vector<uint8_t> input(srcData.begin(), srcData.end());
-    std::vector<uint8_t> keyVec(key.begin(), key.end());
-    std::vector<uint8_t> ivVec(iv.begin(), iv.end());
-    
-    std::vector<uint8_t> encrypted = aes.encryptCBC(input, keyVec, ivVec);
+    aes.setKey(reinterpret_cast<const uint8_t*>(key.constData()));
+    AesGcm gcm(aes, reinterpret_cast<const uint8_t*>(nonce.constData()));
+    gcm.updateAad(reinterpret_cast<const uint8_t*>(header.constData()), static_cast<size_t>(header.size()));
 
-    // 4. 写入文件：Salt + IV + EncryptedData
-    QFile dest(destPath);
+    // 2. 写入文件：文件头 + 密文 + 认证标签
+    QSaveFile dest(destPath);
     if (!dest.open(QIODevice::WriteOnly)) return false;
-    dest.write(salt);
-    dest.write(iv);
-    dest.write((const char*)encrypted.data(), encrypted.size());
-    dest.close();
+    dest.write(header);
 
-    return true;
-}
+    QByteArray buffer(kChunkSize, Qt::Uninitialized);
+    uint8_t* data = reinterpret_cast<uint8_t*>(buffer.data());
+    qint64 processed = 0;
+    for (;;) {
+        const qint64 got = readFully(src, buffer.data(), kChunkSize);
+        if (got < 0) {
+            dest.cancelWriting();
+            return false;
+        }
+        parallelCrypt(gcm, data, got, static_cast<quint64>(processed / 16));
+        gcm.updateGhash(data, static_cast<size_t>(got));
+        processed += got;
 
-bool FileCryptoHelper::decryptFile(const QString& sourcePath, const QString& destPath, const QString& password) {
-    QFile src(sourcePath);
-    if (!src.open(QIODevice::ReadOnly)) return false;
+        if (dest.write(buffer.constData(), got) != got || (progress && !progress(processed, total))) {
+            dest.cancelWriting();
+            return false;
+        }
+        if (got < kChunkSize) break;
+    }
+
+    uint8_t tag[TAG_SIZE];
+    gcm.finish(tag);
+    if (dest.write(reinterpret_cast<const char*>(tag), TAG_SIZE) != TAG_SIZE) {
+        dest.cancelWriting();
+        return false;
+    }
+    return dest.commit();
+}
 
+// 旧版格式：Salt + IV + AES-256-CBC 密文 (PKCS#7)
+static bool decryptLegacyFile(QFile& src, const QString& destPath, const QString& password,
+                              const FileCryptoHelper::ProgressCallback& progress) {
+    src.seek(0);
     QByteArray salt = src.read(SALT_SIZE);
     QByteArray iv = src.read(IV_SIZE);
-    QByteArray encryptedData = src.readAll();
-    src.close();
-
     if (salt.size() != SALT_SIZE || iv.size() != IV_SIZE) return false;
 
+    const qint64 total = src.size() - SALT_SIZE - IV_SIZE;
+    if (total <= 0 || total % 16 != 0) return false;
+
     // 1. 派生密钥
-    QByteArray key = deriveKeyInternal(password, salt);
+    QByteArray key = deriveLegacyKey(password, salt);
 
-    // 2. 执行解密
     AES aes(AES::AES_256);
-    std::vector<uint8_t> input(encryptedData.begin(), encryptedData.end());
-    std::vector<uint8_t> keyVec(key.begin(), key.end());
-    std::vector<uint8_t> ivVec(iv.begin(), iv.end());
+    aes.setKey(reinterpret_cast<const uint8_t*>(key.constData()));
+    uint8_t chain[IV_SIZE];
+    memcpy(chain, iv.constData(), IV_SIZE);
+
+    // 2. 逐块解密；末块去掉填充，填充不合法说明密码错误或文件损坏
+    QSaveFile dest(destPath);
+    if (!dest.open(QIODevice::WriteOnly)) return false;
+
+    QByteArray buffer(FileCryptoHelper::kChunkSize, Qt::Uninitialized);
+    uint8_t* data = reinterpret_cast<uint8_t*>(buffer.data());
+    qint64 processed = 0;
+    while (processed < total) {
+        qint64 got = readFully(src, buffer.data(), qMin(FileCryptoHelper::kChunkSize, total - processed));
+        if (got <= 0 || got % 16 != 0) {
+            dest.cancelWriting();
+            return false;
+        }
+        processed += got;
+        aes.decryptCBCBlocks(data, data, static_cast<size_t>(got), chain);
+
+        if (processed == total) {
+            const uint8_t paddingLen = data[got - 1];
+            bool valid = paddingLen > 0 && paddingLen <= 16;
+            for (int i = 0; valid && i < paddingLen; ++i) valid = (data[got - 1 - i] == paddingLen);
+            if (!valid) {
+                dest.cancelWriting();
+                return false;
+            }
+            got -= paddingLen;
+        }
+
+        if (dest.write(buffer.constData(), got) != got || (progress && !progress(processed, total))) {
+            dest.cancelWriting();
+            return false;
+        }
+    }
+    return dest.commit();
+}
 
-    std::vector<uint8_t> decrypted = aes.decryptCBC(input, keyVec, ivVec);
-    if (decrypted.empty()) return false;
+bool FileCryptoHelper::decryptFile(const QString& sourcePath, const QString& destPath, const QString& password,
+                                   const ProgressCallback& progress, const ProgressCallback& keyProgress) {
+    if (!selfTestPassed()) return false;
 
-    // 3. 验证并保存
-    QFile dest(destPath);
+    QFile src(sourcePath);
+    if (!src.open(QIODevice::ReadOnly)) return false;
+
+    const QByteArray header = src.read(kHeaderSize);
+    const quint8 kdf = header.size() == kHeaderSize ? quint8(header[6]) : 0;
+    const bool isV2 = header.size() == kHeaderSize && memcmp(header.constData(), kMagic, sizeof(kMagic)) == 0
+                   && quint8(header[4]) == kFormatVersion && quint8(header[5]) == kCipherAes256Gcm
+                   && (kdf == kKdfSha256Chain || kdf == kKdfPbkdf2Sha256);
+    if (!isV2) return decryptLegacyFile(src, destPath, password, progress);
+
+    const quint32 iterations = qFromLittleEndian<quint32>(header.constData() + 8);
+    const QByteArray salt = header.mid(12, SALT_SIZE);
+    const QByteArray nonce = header.mid(12 + SALT_SIZE, NONCE_SIZE);
+    const qint64 total = src.size() - kHeaderSize - TAG_SIZE;
+    if (total < 0 || iterations == 0 || iterations > Pbkdf2::kMaxIterations) return false;
+
+    uint8_t expectedTag[TAG_SIZE];
+    if (!src.seek(kHeaderSize + total) || src.read(reinterpret_cast<char*>(expectedTag), TAG_SIZE) != TAG_SIZE
+        || !src.seek(kHeaderSize)) {
+        return false;
+    }
+
+    // 1. 派生密钥 (迭代次数以文件头记录为准)
+    const QByteArray key = kdf == kKdfPbkdf2Sha256 ? deriveKey(password, salt, iterations, keyProgress)
+                                                   : deriveLegacyKey(password, salt, static_cast<int>(iterations));
+    if (key.isEmpty()) return false;
+    AES aes(AES::AES_256);
+    aes.setKey(reinterpret_cast<const uint8_t*>(key.constData()));
+    AesGcm gcm(aes, reinterpret_cast<const uint8_t*>(nonce.constData()));
+    gcm.updateAad(reinterpret_cast<const uint8_t*>(header.constData()), static_cast<size_t>(header.size()));
+
+    // 2. 先对密文累加 GHASH 再并行解密；标签校验通过才提交，密码错误或文件被篡改都不会产出结果
+    QSaveFile dest(destPath);
     if (!dest.open(QIODevice::WriteOnly)) return false;
-    dest.write((const char*)decrypted.data(), decrypted.size());
-    dest.close();
 
-    return true;
+    QByteArray buffer(kChunkSize, Qt::Uninitialized);
+    uint8_t* data = reinterpret_cast<uint8_t*>(buffer.data());
+    qint64 processed = 0;
+    while (processed < total) {
+        const qint64 got = readFully(src, buffer.data(), qMin(kChunkSize, total - processed));
+        if (got <= 0) {
+            dest.cancelWriting();
+            return false;
+        }
+        gcm.updateGhash(data, static_cast<size_t>(got));
+        parallelCrypt(gcm, data, got, static_cast<quint64>(processed / 16));
+        processed += got;
+
+        if (dest.write(buffer.constData(), got) != got || (progress && !progress(processed, total))) {
+            dest.cancelWriting();
+            return false;
+        }
+    }
+
+    uint8_t tag[TAG_SIZE];
+    gcm.finish(tag);
+    if (!constantTimeEquals(tag, expectedTag, TAG_SIZE)) {
+        dest.cancelWriting();
+        return false;
+    }
+    return dest.commit();
 }
 
 bool FileCryptoHelper::secureDelete(const QString& filePath) {
@@ -4,17 +4,50 @@
 #include <QString>
 #include <QByteArray>
 #include <QFile>
+#include <QFuture>
+#include <functional>
 
+/**
+ * @brief 文件加解密
+ *
+ * 当前格式 (v2，AES-256-GCM)：魔数 "RNCF" + 版本/算法/KDF + 迭代次数 + Salt + Nonce + 密文 + 16 字节认证标签，
+ * 文件头作为附加认证数据，篡改任何字节都会导致解密失败。旧版无文件头的 Salt + IV + CBC 密文仍可解密。
+ * 密钥由 PBKDF2-HMAC-SHA256 派生，迭代次数按本机速度校准 (约 kKdfTargetMs 毫秒) 并记录在文件头中，
+ * 以后换到更快的机器上加密的新文件自动使用更高的强度，旧文件仍按各自记录的次数解密。
+ * 以固定大小的块流式读写，块内再切段交给线程池并行做 CTR，GHASH 按顺序串行累加；
+ * 输出经 QSaveFile 原子落盘，失败、取消或认证不通过时不会留下半个文件。
+ */
 class FileCryptoHelper {
 public:
-    static bool encryptFile(const QString& sourcePath, const QString& destPath, const QString& password);
-    static bool decryptFile(const QString& sourcePath, const QString& destPath, const QString& password);
-    
+    // 进度回调：返回 false 取消
+    using ProgressCallback = std::function<bool(qint64 processed, qint64 total)>;
+
+    static constexpr qint64 kChunkSize = 4 * 1024 * 1024;   // 必须是 16 的整数倍
+    static constexpr qint64 kSegmentSize = 256 * 1024;      // 并行 CTR 的分段大小
+    static constexpr int kKdfTargetMs = 500;                // 单次密钥派生的目标耗时
+
+    // keyProgress 报告密钥派生的迭代进度，progress 报告数据加解密进度
+    static bool encryptFile(const QString& sourcePath, const QString& destPath, const QString& password,
+                            const ProgressCallback& progress = nullptr, const ProgressCallback& keyProgress = nullptr);
+    static bool decryptFile(const QString& sourcePath, const QString& destPath, const QString& password,
+                            const ProgressCallback& progress = nullptr, const ProgressCallback& keyProgress = nullptr);
+
+    // 在线程池中执行，避免强密钥派生阻塞界面；回调在工作线程中调用，更新界面须转回主线程
+    static QFuture<bool> encryptFileAsync(const QString& sourcePath, const QString& destPath, const QString& password,
+                                          const ProgressCallback& progress = nullptr,
+                                          const ProgressCallback& keyProgress = nullptr);
+    static QFuture<bool> decryptFileAsync(const QString& sourcePath, const QString& destPath, const QString& password,
+                                          const ProgressCallback& progress = nullptr,
+                                          const ProgressCallback& keyProgress = nullptr);
+
+    // PBKDF2-HMAC-SHA256 派生 32 字节密钥，取消时返回空
+    static QByteArray deriveKey(const QString& password, const QByteArray& salt, quint32 iterations,
+                                const ProgressCallback& progress = nullptr);
+    // 本机校准后的迭代次数，首次调用时测定并缓存
+    static quint32 defaultIterations();
+
     // 安全删除文件（覆盖后再删除）
     static bool secureDelete(const QString& filePath);
-
-private:
-    static QByteArray deriveKey(const QString& password, const QByteArray& salt);
 };
 
 #endif // FILECRYPTOHELPER_H
@@ -0,0 +1,518 @@
+#include "FileReplaceEngine.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QStringEncoder>
+#include <QStringDecoder>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+#include <filesystem>
+#include <system_error>
+#include <cstring>
+
+static QByteArray encodeGbk(const QString& text) {
+    // GB18030 向下兼容 GBK；Qt 未带 ICU 时退回系统 ANSI 代码页 (简体中文 Windows 下即 CP936)
+    QStringEncoder gb18030("GB18030");
+    if (gb18030.isValid()) return gb18030.encode(text);
+    QStringEncoder system(QStringConverter::System);
+    return system.encode(text);
+}
+
+// 按文件编码逐块解码/编码，BOM 作为 U+FEFF 字符保留在文本中，写回时原样还原
+static QStringDecoder decoderFor(TextFileClassifier::Kind kind) {
+    using Kind = TextFileClassifier::Kind;
+    const auto flags = QStringConverter::Flag::ConvertInitialBom;
+    switch (kind) {
+    case Kind::Utf16LE: return QStringDecoder(QStringConverter::Utf16LE, flags);
+    case Kind::Utf16BE: return QStringDecoder(QStringConverter::Utf16BE, flags);
+    case Kind::Gbk: {
+        QStringDecoder gb18030("GB18030", flags);
+        return gb18030.isValid() ? std::move(gb18030) : QStringDecoder(QStringConverter::System, flags);
+    }
+    case Kind::Legacy: return QStringDecoder(QStringConverter::System, flags);
+    default: return QStringDecoder(QStringConverter::Utf8, flags);
+    }
+}
+
+static QStringEncoder encoderFor(TextFileClassifier::Kind kind) {
+    using Kind = TextFileClassifier::Kind;
+    switch (kind) {
+    case Kind::Utf16LE: return QStringEncoder(QStringConverter::Utf16LE);
+    case Kind::Utf16BE: return QStringEncoder(QStringConverter::Utf16BE);
+    case Kind::Gbk: {
+        QStringEncoder gb18030("GB18030");
+        return gb18030.isValid() ? std::move(gb18030) : QStringEncoder(QStringConverter::System);
+    }
+    case Kind::Legacy: return QStringEncoder(QStringConverter::System);
+    default: return QStringEncoder(QStringConverter::Utf8);
+    }
+}
+
+// 系统本地编码本身就是 UTF-8 (Linux/macOS 常见) 时，Legacy 文件没有可用的还原编码
+static bool systemCodecIsUtf8() {
+    static const bool utf8 = [] {
+        QStringDecoder decoder(QStringConverter::System);
+        const QString text = decoder.decode(QByteArrayView("\xC3\xA4"));
+        return !decoder.hasError() && text == QString(QChar(0xE4));
+    }();
+    return utf8;
+}
+
+// 解码路径下不能写回的原因，空串表示可以无损写回
+static QString unreplaceableReason(TextFileClassifier::Kind kind, bool lossless) {
+    if (kind == TextFileClassifier::Kind::Legacy && systemCodecIsUtf8()) {
+        return "文件不是 UTF-8，系统本地编码也是 UTF-8，无法确定原编码，未修改";
+    }
+    if (!lossless) return "文件编码无法无损还原，未修改";
+    return QString();
+}
+
+bool FileReplaceEngine::needsUnicodeFolding(const QString& keyword, bool caseSensitive) {
+    if (caseSensitive) return false;
+    for (const QChar ch : keyword) {
+        if (ch.unicode() >= 0x80 && ch.toLower() != ch.toUpper()) return true;
+    }
+    return false;
+}
+
+qint64 FileReplaceEngine::decodedScan(QIODevice* in, const QString& keyword, const QString& replaceText,
+                                      Qt::CaseSensitivity cs, TextFileClassifier::Kind kind,
+                                      QIODevice* out, bool* lossless) {
+    const qsizetype n = keyword.size();
+    if (n == 0) return 0;
+
+    // 解码器与编码器都是有状态的：跨块切开的多字节序列、代理对在下一块接上
+    QStringDecoder decoder = decoderFor(kind);
+    QStringEncoder encoder = encoderFor(kind);
+
+    // 只读扫描时把解码结果重新编码，与原始字节逐段比对，判断写回是否会改变未命中的部分
+    QStringEncoder verifier = encoderFor(kind);
+    QByteArray rawPending;
+    QByteArray encodedPending;
+    bool same = true;
+
+    auto emitText = [&](QStringView text) {
+        if (!out || text.isEmpty()) return true;
+        const QByteArray bytes = encoder.encode(text);
+        return out->write(bytes) == bytes.size();
+    };
+
+    QByteArray chunk(kChunkSize, Qt::Uninitialized);
+    QString buf;
+    qint64 count = 0;
+
+    for (;;) {
+        const qint64 got = in->read(chunk.data(), chunk.size());
+        if (got < 0) return -1;
+        const bool eof = (got == 0);
+        const QByteArrayView raw(chunk.constData(), got);
+        const QString piece = decoder.decode(raw);
+
+        if (lossless && same) {
+            rawPending.append(raw);
+            const QByteArray reencoded = verifier.encode(piece);
+            encodedPending.append(reencoded);
+            const qsizetype common = qMin(rawPending.size(), encodedPending.size());
+            same = std::memcmp(rawPending.constData(), encodedPending.constData(), common) == 0;
+            rawPending.remove(0, common);
+            encodedPending.remove(0, common);
+        }
+        buf += piece;
+
+        // 与字节匹配路径一致：不重叠地逐个查找
+        qsizetype emitted = 0;
+        for (qsizetype hit = buf.indexOf(keyword, 0, cs); hit >= 0; hit = buf.indexOf(keyword, emitted, cs)) {
+            ++count;
+            if (!emitText(QStringView(buf).mid(emitted, hit - emitted)) || !emitText(replaceText)) return -1;
+            emitted = hit + n;
+        }
+
+        if (eof) {
+            if (!emitText(QStringView(buf).mid(emitted))) return -1;
+            break;
+        }
+
+        // 保留末尾 n-1 个字符，让跨块边界的匹配在下一轮被完整看到
+        const qsizetype keep = qMax(emitted, buf.size() - (n - 1));
+        if (!emitText(QStringView(buf).mid(emitted, keep - emitted))) return -1;
+        buf.remove(0, keep);
+    }
+
+    // 末尾残留未解码完的字节、或有替换字符时，写回会破坏文件，只允许查找
+    if (lossless) *lossless = same && !decoder.hasError() && rawPending.isEmpty() && encodedPending.isEmpty();
+    return count;
+}
+
+FileReplaceEngine::FileResult FileReplaceEngine::decodedReplace(QFile& src, const QString& keyword,
+                                                                const QString& replaceText, bool caseSensitive,
+                                                                TextFileClassifier::Kind kind, const QString& backupFile) {
+    FileResult result;
+    const Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+    // 1. 只读扫描：计数并确认能否无损写回
+    bool lossless = false;
+    const qint64 count = decodedScan(&src, keyword, QString(), cs, kind, nullptr, &lossless);
+    if (count <= 0) {
+        result.ok = (count == 0);
+        if (!result.ok) result.error = "读取失败";
+        return result;
+    }
+    const QString reason = unreplaceableReason(kind, lossless);
+    if (!reason.isEmpty()) {
+        result.ok = false;
+        result.error = reason;
+        return result;
+    }
+
+    if (!backupFile.isEmpty() && !QFileInfo::exists(backupFile) && !createBackup(src.fileName(), backupFile)) {
+        result.ok = false;
+        result.error = "备份失败";
+        return result;
+    }
+
+    // 2. 再次逐块解码，替换后按原编码流式写入临时文件
+    QSaveFile dest(src.fileName());
+    if (!src.seek(0) || !dest.open(QIODevice::WriteOnly)) {
+        result.ok = false;
+        result.error = "无法写入: " + dest.errorString();
+        return result;
+    }
+    const qint64 replaced = decodedScan(&src, keyword, replaceText, cs, kind, &dest, nullptr);
+    src.close(); // Windows 下原文件仍被打开时无法被替换
+    if (replaced != count) {
+        dest.cancelWriting();
+        result.ok = false;
+        result.error = "写入失败";
+        return result;
+    }
+    if (!dest.commit()) {
+        result.ok = false;
+        result.error = "替换失败: " + dest.errorString();
+        return result;
+    }
+    result.replacements = static_cast<int>(count);
+    return result;
+}
+
+FileReplaceEngine::Needle FileReplaceEngine::makeNeedle(const QString& keyword, const QString& replaceText,
+                                                        TextFileClassifier::Kind kind, bool caseSensitive) {
+    using Kind = TextFileClassifier::Kind;
+
+    Needle needle;
+    if (kind == Kind::Gbk) {
+        needle.exact = encodeGbk(keyword);
+        needle.replacement = encodeGbk(replaceText);
+        needle.gbk = true;
+    } else {
+        QStringConverter::Encoding codec = QStringConverter::Utf8;
+        if (kind == Kind::Utf16LE) codec = QStringConverter::Utf16LE;
+        else if (kind == Kind::Utf16BE) codec = QStringConverter::Utf16BE;
+
+        QStringEncoder encoder(codec);
+        QByteArray exact = encoder.encode(keyword);
+        QByteArray replacement = encoder.encode(replaceText);
+        needle.exact = exact;
+        needle.replacement = replacement;
+        needle.unitSize = (codec == QStringConverter::Utf8) ? 1 : 2;
+        needle.bigEndian = (kind == Kind::Utf16BE);
+        needle.validateUtf8 = (codec == QStringConverter::Utf8);
+    }
+    needle.caseSensitive = caseSensitive;
+    // 忽略大小写只折叠 ASCII 字母：UTF-8 多字节字符的字节值都 >= 0x80，不会被误折叠
+    needle.pattern = caseSensitive ? needle.exact : needle.exact.toLower();
+    return needle;
+}
+
+// GBK/GB18030 字符长度：单字节 ASCII、双字节、或 "lead 0x30-0x39 lead 0x30-0x39" 的四字节序列
+static inline qsizetype gbkCharLength(const QByteArray& buf, qsizetype pos) {
+    const uchar c = uchar(buf.at(pos));
+    if (c < 0x81 || c == 0xFF) return 1;
+    if (pos + 1 < buf.size()) {
+        const uchar c2 = uchar(buf.at(pos + 1));
+        if (c2 >= 0x30 && c2 <= 0x39) return 4;
+    }
+    return 2;
+}
+
+static inline char16_t readUnit(const char* p, bool bigEndian) {
+    const uchar b0 = uchar(p[0]), b1 = uchar(p[1]);
+    return bigEndian ? char16_t((b0 << 8) | b1) : char16_t((b1 << 8) | b0);
+}
+
+static inline char16_t foldUnit(char16_t u) {
+    return (u >= 'A' && u <= 'Z') ? char16_t(u + 32) : u;
+}
+
+qint64 FileReplaceEngine::streamReplace(QIODevice* in, QIODevice* out, const Needle& needle, bool stopAtFirst) {
+    const qsizetype n = needle.pattern.size();
+    if (n == 0) return 0;
+
+    // UTF-16 下字节折叠可能误伤非 ASCII 单元的某个字节，命中后需按单元复核
+    const bool verifyUnits = !needle.caseSensitive && needle.unitSize == 2;
+
+    QByteArray chunk(kChunkSize, Qt::Uninitialized);
+    QByteArray buf;
+    buf.reserve(kChunkSize + n);
+    qint64 base = 0;        // buf[0] 在文件中的偏移
+    qsizetype boundary = 0; // GBK 模式下 buf 中已知的字符边界位置
+    qint64 count = 0;
+
+    auto emitBytes = [out](const char* data, qsizetype len) {
+        return !out || len == 0 || out->write(data, len) == len;
+    };
+
+    TextFileClassifier::Utf8Validator validator;
+
+    for (;;) {
+        const qint64 got = in->read(chunk.data(), chunk.size());
+        if (got < 0) return -1;
+        const bool eof = (got == 0);
+        // 嗅探只看了头部：后面出现非法 UTF-8 时交给调用方改走解码路径
+        if (needle.validateUtf8 && (!validator.feed(chunk.constData(), got) || (eof && !validator.finish()))) {
+            return kNotUtf8;
+        }
+        buf.append(chunk.constData(), got);
+
+        const QByteArray folded = needle.caseSensitive ? QByteArray() : buf.toLower();
+        const QByteArray& hay = needle.caseSensitive ? buf : folded;
+
+        qsizetype pos = 0;
+        qsizetype emitted = 0;
+        for (;;) {
+            const qsizetype hit = hay.indexOf(needle.pattern, pos);
+            if (hit < 0) break;
+
+            bool valid = ((base + hit) % needle.unitSize) == 0;
+            if (valid && needle.gbk) {
+                while (boundary < hit) boundary += gbkCharLength(buf, boundary);
+                valid = (boundary == hit);
+                // 折叠会把尾字节落在 A-Z 的不同汉字折成一样，多字节字符需精确比较
+                for (qsizetype i = 0; valid && !needle.caseSensitive && i < n;) {
+                    const qsizetype len = gbkCharLength(needle.exact, i);
+                    if (len > 1) valid = std::memcmp(buf.constData() + hit + i, needle.exact.constData() + i, len) == 0;
+                    i += len;
+                }
+            }
+            if (valid && verifyUnits) {
+                for (qsizetype i = 0; i < n; i += 2) {
+                    if (foldUnit(readUnit(buf.constData() + hit + i, needle.bigEndian)) !=
+                        foldUnit(readUnit(needle.exact.constData() + i, needle.bigEndian))) {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+            if (!valid) {
+                pos = hit + 1;
+                continue;
+            }
+
+            ++count;
+            if (stopAtFirst) return count;
+            if (!emitBytes(buf.constData() + emitted, hit - emitted) ||
+                !emitBytes(needle.replacement.constData(), needle.replacement.size())) {
+                return -1;
+            }
+            emitted = pos = boundary = hit + n;
+        }
+
+        if (eof) {
+            if (!emitBytes(buf.constData() + emitted, buf.size() - emitted)) return -1;
+            break;
+        }
+
+        // 保留末尾 n-1 字节，让跨块边界的匹配在下一轮被完整看到
+        const qsizetype keep = qMax(emitted, buf.size() - (n - 1));
+        if (!emitBytes(buf.constData() + emitted, keep - emitted)) return -1;
+        if (needle.gbk) {
+            while (boundary < keep) boundary += gbkCharLength(buf, boundary);
+            boundary -= keep;
+        }
+        buf.remove(0, keep);
+        base += keep;
+    }
+    return count;
+}
+
+int FileReplaceEngine::countMatches(const QString& filePath, const QString& keyword, bool caseSensitive, bool* isText,
+                                    QString* notReplaceable) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return -1;
+
+    // 嗅探只看头部一个块 (peek 不移动读指针)，随后从头流式扫描
+    TextFileClassifier::Kind kind = TextFileClassifier::classifyHead(file.peek(TextFileClassifier::kSniffSize));
+    if (isText) *isText = TextFileClassifier::isText(kind);
+    if (!TextFileClassifier::isText(kind)) return 0;
+
+    const Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    auto countDecoded = [&](TextFileClassifier::Kind decodeKind) {
+        bool lossless = false;
+        const qint64 count = decodedScan(&file, keyword, QString(), cs, decodeKind, nullptr, &lossless);
+        if (notReplaceable && count > 0) *notReplaceable = unreplaceableReason(decodeKind, lossless);
+        return static_cast<int>(count);
+    };
+    if (kind == TextFileClassifier::Kind::Legacy || needsUnicodeFolding(keyword, caseSensitive)) {
+        return countDecoded(kind);
+    }
+
+    Needle needle = makeNeedle(keyword, QString(), kind, caseSensitive);
+    const qint64 count = streamReplace(&file, nullptr, needle, false);
+    if (count == kNotUtf8) {
+        if (!file.seek(0)) return -1;
+        return countDecoded(TextFileClassifier::Kind::Legacy);
+    }
+    return static_cast<int>(count);
+}
+
+bool FileReplaceEngine::createBackup(const QString& filePath, const QString& backupFile) {
+    if (!QDir().mkpath(QFileInfo(backupFile).absolutePath())) return false;
+
+    // 原文件随后会被临时文件整体替换 (改名)，旧内容只需一个硬链接即可保住，省去一次完整拷贝；
+    // 跨卷或文件系统不支持时退回普通复制
+    std::error_code ec;
+    std::filesystem::create_hard_link(QFileInfo(filePath).filesystemAbsoluteFilePath(),
+                                      QFileInfo(backupFile).filesystemAbsoluteFilePath(), ec);
+    if (!ec) return true;
+    return QFile::copy(filePath, backupFile);
+}
+
+FileReplaceEngine::FileResult FileReplaceEngine::replaceInFile(const QString& filePath, const QString& keyword,
+                                                               const QString& replaceText, bool caseSensitive,
+                                                               const QString& backupFile) {
+    FileResult result;
+    QFile src(filePath);
+    if (!src.open(QIODevice::ReadOnly)) {
+        result.ok = false;
+        result.error = "无法读取: " + src.errorString();
+        return result;
+    }
+
+    TextFileClassifier::Kind kind = TextFileClassifier::classifyHead(src.peek(TextFileClassifier::kSniffSize));
+    if (!TextFileClassifier::isText(kind)) return result;
+
+    if (kind == TextFileClassifier::Kind::Legacy || needsUnicodeFolding(keyword, caseSensitive)) {
+        return decodedReplace(src, keyword, replaceText, caseSensitive, kind, backupFile);
+    }
+
+    Needle needle = makeNeedle(keyword, replaceText, kind, caseSensitive);
+
+    // 1. 只读探测：绝大多数文件不含关键字，命中第一处即停，无需任何写入
+    const qint64 probe = streamReplace(&src, nullptr, needle, true);
+    if (probe == kNotUtf8) {
+        if (!src.seek(0)) return {0, false, "读取失败"};
+        return decodedReplace(src, keyword, replaceText, caseSensitive, TextFileClassifier::Kind::Legacy, backupFile);
+    }
+    if (probe <= 0) {
+        result.ok = (probe == 0);
+        if (!result.ok) result.error = "读取失败";
+        return result;
+    }
+
+    // 2. 备份原文件
+    if (!backupFile.isEmpty() && !createBackup(filePath, backupFile)) {
+        result.ok = false;
+        result.error = "备份失败";
+        return result;
+    }
+
+    // 3. 流式写入临时文件，全部成功后原子替换
+    QSaveFile dest(filePath);
+    if (!src.seek(0) || !dest.open(QIODevice::WriteOnly)) {
+        result.ok = false;
+        result.error = "无法写入: " + dest.errorString();
+        return result;
+    }
+
+    const qint64 replaced = streamReplace(&src, &dest, needle, false);
+    if (replaced == kNotUtf8) {
+        // 探测命中之后才遇到非法 UTF-8：丢弃已写的临时文件，整体解码重做 (备份已存在，不再重复)
+        dest.cancelWriting();
+        if (!src.seek(0)) return {0, false, "读取失败"};
+        return decodedReplace(src, keyword, replaceText, caseSensitive, TextFileClassifier::Kind::Legacy, backupFile);
+    }
+    src.close(); // Windows 下原文件仍被打开时无法被替换
+    if (replaced <= 0) {
+        dest.cancelWriting();
+        result.ok = (replaced == 0);
+        if (!result.ok) result.error = "写入失败";
+        return result;
+    }
+    if (!dest.commit()) {
+        result.ok = false;
+        result.error = "替换失败: " + dest.errorString();
+        return result;
+    }
+
+    result.replacements = static_cast<int>(replaced);
+    return result;
+}
+
+bool FileReplaceEngine::writeManifest(const QString& backupDir, const QString& rootDir, const QList<ManifestEntry>& entries) {
+    QJsonArray array;
+    for (const ManifestEntry& e : entries) {
+        QJsonObject obj;
+        obj["path"] = e.originalPath;
+        obj["backup"] = e.backupFile;
+        obj["count"] = e.replacements;
+        array.append(obj);
+    }
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["root"] = rootDir;
+    root["created"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["entries"] = array;
+
+    QSaveFile file(QDir(backupDir).filePath("manifest.json"));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
+
+QList<FileReplaceEngine::ManifestEntry> FileReplaceEngine::readManifest(const QString& backupDir) {
+    QList<ManifestEntry> entries;
+    QFile file(QDir(backupDir).filePath("manifest.json"));
+    if (!file.open(QIODevice::ReadOnly)) return entries;
+
+    const QJsonArray array = QJsonDocument::fromJson(file.readAll()).object().value("entries").toArray();
+    for (const QJsonValue& v : array) {
+        QJsonObject obj = v.toObject();
+        entries.append({obj.value("path").toString(), obj.value("backup").toString(), obj.value("count").toInt()});
+    }
+    return entries;
+}
+
+int FileReplaceEngine::restoreFromManifest(const QString& backupDir, QStringList* failedPaths) {
+    int restored = 0;
+    const QList<ManifestEntry> entries = readManifest(backupDir);
+    QDir dir(backupDir);
+
+    for (const ManifestEntry& e : entries) {
+        QFile src(dir.filePath(e.backupFile));
+        QSaveFile dest(e.originalPath);
+        bool ok = src.open(QIODevice::ReadOnly) && dest.open(QIODevice::WriteOnly);
+        if (ok) {
+            QByteArray chunk(kChunkSize, Qt::Uninitialized);
+            qint64 got;
+            while (ok && (got = src.read(chunk.data(), chunk.size())) > 0) {
+                ok = (dest.write(chunk.constData(), got) == got);
+            }
+            ok = ok && src.error() == QFileDevice::NoError;
+            src.close();
+            if (!ok) dest.cancelWriting();
+            ok = dest.commit() && ok;
+        }
+
+        if (ok) {
+            restored++;
+        } else {
+            qWarning() << "[FileReplaceEngine] 恢复失败:" << e.originalPath;
+            if (failedPaths) failedPaths->append(e.originalPath);
+        }
+    }
+    return restored;
+}
@@ -0,0 +1,83 @@
+#ifndef FILEREPLACEENGINE_H
+#define FILEREPLACEENGINE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QIODevice>
+#include <QFile>
+#include "TextFileClassifier.h"
+
+/**
+ * @brief 流式查找/替换引擎
+ *
+ * 按固定大小的块扫描文件原始字节，不整体读入内存，也不做 QString 往返转换：
+ * 关键字按 TextFileClassifier 嗅探出的编码 (UTF-8 / UTF-16 / GBK) 编码后直接做字节匹配，
+ * 因此文件的编码、BOM 与换行符 (\r\n / \n) 保持原样。
+ * 字节匹配的忽略大小写只折叠 ASCII 字母；关键字含非 ASCII 字母 (Ä/ä、西里尔、希腊字母等) 时，
+ * 文件按其编码逐块解码 (有状态解码器，文本只保留关键字长度减一的尾部用于跨块匹配) 后用 Qt::CaseInsensitive 查找，
+ * 替换后按原编码逐块写回 (无法无损还原的文件不修改)。
+ * 嗅探为 Legacy 的文件、以及流式读取中途才发现不是合法 UTF-8 的文件，同样走解码路径，按系统本地编码解码；
+ * 系统本地编码本身是 UTF-8 时这类文件只能计数，替换时报告原因并跳过。
+ * 写入通过 QSaveFile 先落到同目录临时文件再原子改名，中途失败不会留下半截文件。
+ * 备份按相对路径镜像存放，并生成以完整路径为键的清单 (manifest.json)，撤销时逐条精确还原。
+ */
+class FileReplaceEngine {
+public:
+    struct FileResult {
+        int replacements = 0;   // 0 表示未命中，文件未被改动
+        bool ok = true;
+        QString error;
+    };
+
+    struct ManifestEntry {
+        QString originalPath;   // 被修改文件的绝对路径
+        QString backupFile;     // 备份文件相对备份目录的路径
+        int replacements = 0;
+    };
+
+    static constexpr qint64 kChunkSize = 1024 * 1024;
+
+    // 流式统计关键字出现次数，-1 表示读取失败；二进制文件返回 0 并把 isText 置为 false。
+    // 命中但替换时会被跳过 (编码无法无损还原) 的文件，通过 notReplaceable 返回原因
+    static int countMatches(const QString& filePath, const QString& keyword, bool caseSensitive, bool* isText = nullptr,
+                            QString* notReplaceable = nullptr);
+
+    // 替换单个文件 (二进制文件直接跳过)。命中时先把原文件保存为 backupFile (为空则不备份)，再原子写回
+    static FileResult replaceInFile(const QString& filePath, const QString& keyword, const QString& replaceText,
+                                    bool caseSensitive, const QString& backupFile);
+
+    // 备份清单读写
+    static bool writeManifest(const QString& backupDir, const QString& rootDir, const QList<ManifestEntry>& entries);
+    static QList<ManifestEntry> readManifest(const QString& backupDir);
+
+    // 按清单把备份原子地还原到原始完整路径，返回成功恢复的文件数
+    static int restoreFromManifest(const QString& backupDir, QStringList* failedPaths = nullptr);
+
+private:
+    struct Needle {
+        QByteArray pattern;     // 已按文件编码编码的关键字
+        QByteArray exact;       // 未做大小写折叠的原始编码，UTF-16 忽略大小写时逐单元校验
+        QByteArray replacement; // 已按文件编码编码的替换内容
+        int unitSize = 1;       // 编码单元字节数，UTF-16 为 2，用于对齐校验
+        bool bigEndian = false;
+        bool gbk = false;       // GBK 双字节字符的尾字节可能落在 ASCII 区，命中需校验字符边界
+        bool validateUtf8 = false;  // 边读边校验，遇到非法序列时返回 kNotUtf8
+        bool caseSensitive = true;
+    };
+
+    // 忽略大小写且关键字含非 ASCII 的大小写字母时，只能走解码路径
+    static bool needsUnicodeFolding(const QString& keyword, bool caseSensitive);
+    // 解码路径的流式查找：out 为空时只计数 (lossless 返回能否无损写回)，否则把替换结果按原编码写入 out
+    static qint64 decodedScan(QIODevice* in, const QString& keyword, const QString& replaceText, Qt::CaseSensitivity cs,
+                              TextFileClassifier::Kind kind, QIODevice* out, bool* lossless);
+    static FileResult decodedReplace(QFile& src, const QString& keyword, const QString& replaceText, bool caseSensitive,
+                                     TextFileClassifier::Kind kind, const QString& backupFile);
+
+    static Needle makeNeedle(const QString& keyword, const QString& replaceText, TextFileClassifier::Kind kind, bool caseSensitive);
+    static constexpr qint64 kNotUtf8 = -2;   // streamReplace：文件后部不是合法 UTF-8
+    static qint64 streamReplace(QIODevice* in, QIODevice* out, const Needle& needle, bool stopAtFirst);
+    static bool createBackup(const QString& filePath, const QString& backupFile);
+};
+
+#endif // FILEREPLACEENGINE_H
@@ -0,0 +1,188 @@
+#include "IgnoreMatcher.h"
+#include <QFile>
+#include <QDir>
+#include <QDirIterator>
+#include <utility>
+
+#ifdef Q_OS_WIN
+static constexpr Qt::CaseSensitivity kPathCase = Qt::CaseInsensitive;
+#else
+static constexpr Qt::CaseSensitivity kPathCase = Qt::CaseSensitive;
+#endif
+
+IgnoreMatcher::IgnoreMatcher(bool useDefaultRules) {
+    if (useDefaultRules) {
+        QStringList lines;
+        for (const QString& name : defaultIgnoredDirs()) lines << name + "/";
+        addRules(QString(), lines);
+    }
+}
+
+QStringList IgnoreMatcher::defaultIgnoredDirs() {
+    return {".git", ".svn", ".hg", ".idea", ".vscode", "__pycache__", "node_modules", "dist", "build", "venv",
+            "$RECYCLE.BIN", "System Volume Information"};
+}
+
+QString IgnoreMatcher::globToRegex(const QString& glob) {
+    QString rx = "^";
+    const qsizetype n = glob.size();
+    for (qsizetype i = 0; i < n; ++i) {
+        const QChar c = glob.at(i);
+        if (c == '*') {
+            if (i + 1 < n && glob.at(i + 1) == '*') {
+                // "**/" 匹配零到多层目录，其余位置的 "**" 匹配任意字符
+                if (i + 2 < n && glob.at(i + 2) == '/') {
+                    rx += "(?:.*/)?";
+                    i += 2;
+                } else {
+                    rx += ".*";
+                    i += 1;
+                }
+            } else {
+                rx += "[^/]*";
+            }
+        } else if (c == '?') {
+            rx += "[^/]";
+        } else if (c == '[') {
+            const qsizetype close = glob.indexOf(']', i + 2);
+            if (close < 0) {
+                rx += "\\[";
+                continue;
+            }
+            QString cls = glob.mid(i + 1, close - i - 1);
+            if (cls.startsWith('!')) cls[0] = '^';
+            cls.replace("\\", "\\\\");
+            rx += "[" + cls + "]";
+            i = close;
+        } else if (c == '\\' && i + 1 < n) {
+            rx += QRegularExpression::escape(QString(glob.at(++i)));
+        } else {
+            rx += QRegularExpression::escape(QString(c));
+        }
+    }
+    return rx + "$";
+}
+
+void IgnoreMatcher::addRules(const QString& baseDir, const QStringList& lines) {
+    static const QRegularExpression wildcard("[*?\\[\\\\]");
+    const QString base = baseDir.isEmpty() ? QString() : QDir::fromNativeSeparators(baseDir);
+
+    for (QString line : lines) {
+        if (line.endsWith('\r')) line.chop(1);
+        while (line.endsWith(' ') && !line.endsWith("\\ ")) line.chop(1);
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        Rule rule;
+        rule.baseDir = base;
+        if (line.startsWith('!')) {
+            rule.negate = true;
+            line.remove(0, 1);
+        } else if (line.startsWith("\\!") || line.startsWith("\\#")) {
+            line.remove(0, 1);
+        }
+        if (line.endsWith('/')) {
+            rule.dirOnly = true;
+            line.chop(1);
+        }
+        if (line.startsWith('/')) {
+            rule.anchored = true;
+            line.remove(0, 1);
+        } else if (line.startsWith("**/") && !line.mid(3).contains('/')) {
+            line.remove(0, 3); // "**/name" 等价于任意层级的 name
+        } else if (line.contains('/')) {
+            rule.anchored = true;
+        }
+        if (line.isEmpty()) continue;
+
+        if (line.contains(wildcard)) {
+            rule.regex = QRegularExpression(globToRegex(line), kPathCase == Qt::CaseInsensitive
+                                                                   ? QRegularExpression::CaseInsensitiveOption
+                                                                   : QRegularExpression::NoPatternOption);
+            if (!rule.regex.isValid()) continue;
+        } else {
+            rule.literal = line;
+        }
+        m_rules.append(rule);
+    }
+}
+
+void IgnoreMatcher::loadDirectory(const QString& dirPath) {
+    for (const char* name : {".gitignore", ".ignore"}) {
+        QFile file(dirPath + "/" + QLatin1String(name));
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        addRules(dirPath, QString::fromUtf8(file.readAll()).split('\n'));
+    }
+}
+
+bool IgnoreMatcher::isIgnored(const QString& absolutePath, bool isDir) const {
+    const QString path = QDir::fromNativeSeparators(absolutePath);
+    const QString name = path.mid(path.lastIndexOf('/') + 1);
+
+    // 后加载 (更深层目录) 的规则优先，与 git 一致：最后一条命中的规则说了算
+    for (qsizetype i = m_rules.size() - 1; i >= 0; --i) {
+        const Rule& rule = m_rules.at(i);
+        if (rule.dirOnly && !isDir) continue;
+
+        QString rel;
+        if (!rule.baseDir.isEmpty()) {
+            if (path.size() <= rule.baseDir.size() || path.at(rule.baseDir.size()) != '/' ||
+                !path.startsWith(rule.baseDir, kPathCase)) {
+                continue;
+            }
+            if (rule.anchored) rel = path.mid(rule.baseDir.size() + 1);
+        } else if (rule.anchored) {
+            rel = path;
+        }
+
+        const QString& subject = rule.anchored ? rel : name;
+        const bool hit = rule.literal.isEmpty() ? rule.regex.match(subject).hasMatch()
+                                                : subject.compare(rule.literal, kPathCase) == 0;
+        if (hit) return !rule.negate;
+    }
+    return false;
+}
+
+bool IgnoreMatcher::walk(const QString& rootPath, const Visitor& visit, WalkFlags flags, int maxDepth) {
+    QFileInfo root(rootPath);
+    if (!root.isDir()) return true;
+    return walkDir(QDir::fromNativeSeparators(root.absoluteFilePath()), visit, flags, 1, maxDepth);
+}
+
+bool IgnoreMatcher::walkDir(const QString& dirPath, const Visitor& visit, WalkFlags flags, int depth, int maxDepth) {
+    const qsizetype mark = m_rules.size();
+    loadDirectory(dirPath);
+
+    QDir::Filters filters = QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot;
+    if (flags & Hidden) filters |= QDir::Hidden;
+
+    bool completed = true;
+    QStringList subDirs;
+    QDirIterator it(dirPath, filters);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        const bool isDir = info.isDir();
+        // 在进入之前判定，被忽略的目录整棵子树都不会被枚举
+        if (isIgnored(info.absoluteFilePath(), isDir)) continue;
+
+        if (isDir) {
+            if ((flags & Dirs) && !visit(info)) {
+                completed = false;
+                break;
+            }
+            if (!info.isSymLink() && (maxDepth <= 0 || depth < maxDepth)) subDirs << info.absoluteFilePath();
+        } else if ((flags & Files) && !visit(info)) {
+            completed = false;
+            break;
+        }
+    }
+
+    for (const QString& sub : std::as_const(subDirs)) {
+        if (!completed) break;
+        completed = walkDir(sub, visit, flags, depth + 1, maxDepth);
+    }
+
+    // 离开目录时弹出它的规则，兄弟目录互不影响
+    m_rules.resize(mark);
+    return completed;
+}
@@ -0,0 +1,63 @@
+#ifndef IGNOREMATCHER_H
+#define IGNOREMATCHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <functional>
+
+/**
+ * @brief 目录遍历忽略规则 (兼容 .gitignore / .ignore 语法)
+ *
+ * 内置一组常见的依赖/构建/系统目录；遍历时每进入一个目录就编译该目录下的 .gitignore 与 .ignore，
+ * 离开时弹出。被忽略的目录在进入之前就被剪掉，node_modules 之类的大目录完全不会被枚举。
+ * 支持注释、! 取反、结尾 / (仅目录)、以 / 锚定、* ? [] 以及 ** 通配。
+ */
+class IgnoreMatcher {
+public:
+    enum WalkFlag {
+        Files  = 0x1,
+        Dirs   = 0x2,
+        Hidden = 0x4    // 包含隐藏文件/目录 (忽略规则仍然生效)
+    };
+    Q_DECLARE_FLAGS(WalkFlags, WalkFlag)
+
+    // 返回 false 终止遍历
+    using Visitor = std::function<bool(const QFileInfo& info)>;
+
+    explicit IgnoreMatcher(bool useDefaultRules = true);
+
+    static QStringList defaultIgnoredDirs();
+
+    // 追加规则；baseDir 为规则文件所在目录，为空表示对任意层级生效
+    void addRules(const QString& baseDir, const QStringList& lines);
+    // 读取目录下的 .gitignore / .ignore
+    void loadDirectory(const QString& dirPath);
+
+    bool isIgnored(const QString& absolutePath, bool isDir) const;
+
+    // 带剪枝的深度优先遍历：被忽略的目录不会进入。遍历完整结束返回 true
+    // maxDepth 为 1 时只列出根目录的直接子项，<= 0 表示不限深度
+    bool walk(const QString& rootPath, const Visitor& visit, WalkFlags flags = Files, int maxDepth = 0);
+
+private:
+    struct Rule {
+        QString baseDir;            // 规则生效的目录 (以 / 分隔，不带结尾 /)
+        QString literal;            // 无通配符时直接比较
+        QRegularExpression regex;   // 含通配符时编译为正则
+        bool negate = false;
+        bool dirOnly = false;
+        bool anchored = false;      // 含 / 时相对 baseDir 匹配整条路径，否则只匹配文件名
+    };
+
+    static QString globToRegex(const QString& glob);
+    bool walkDir(const QString& dirPath, const Visitor& visit, WalkFlags flags, int depth, int maxDepth);
+
+    QList<Rule> m_rules;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(IgnoreMatcher::WalkFlags)
+
+#endif // IGNOREMATCHER_H
@@ -0,0 +1,277 @@
+#include "ImagePreprocessor.h"
+#include <QtConcurrent>
+#include <QTransform>
+#include <QtMath>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IPP_HAVE_SSE2 1
+#endif
+
+namespace {
+
+// 按行带执行 fn(bandIndex)，像素数较少时直接在当前线程执行，省去调度开销
+void forEachBand(int bandCount, bool parallel, const std::function<void(int)>& fn) {
+    if (!parallel || bandCount < 2) {
+        for (int i = 0; i < bandCount; ++i) fn(i);
+        return;
+    }
+    QList<int> bands(bandCount);
+    for (int i = 0; i < bandCount; ++i) bands[i] = i;
+    QtConcurrent::blockingMap(bands, [&fn](int& band) { fn(band); });
+}
+
+// 四份子直方图交替累加，避免相邻相同灰度值造成的写后读依赖
+void histogramRows(const uchar* bits, qsizetype bpl, int w, int y0, int y1, quint32* hist) {
+    std::array<std::array<quint32, 256>, 4> sub{};
+    for (int y = y0; y < y1; ++y) {
+        const uchar* line = bits + y * bpl;
+        int x = 0;
+        for (; x + 4 <= w; x += 4) {
+            sub[0][line[x]]++;
+            sub[1][line[x + 1]]++;
+            sub[2][line[x + 2]]++;
+            sub[3][line[x + 3]]++;
+        }
+        for (; x < w; ++x) sub[0][line[x]]++;
+    }
+    for (int i = 0; i < 256; ++i) hist[i] = sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+}
+
+// out[x] = clamp(5*cur[x] - up[x] - down[x] - cur[x-1] - cur[x+1])，x ∈ [1, w-2]
+void sharpenRow(const uchar* up, const uchar* cur, const uchar* down, uchar* out, int w) {
+    int x = 1;
+#ifdef IPP_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    auto load = [](const uchar* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+    auto kernel = [](__m128i c, __m128i u, __m128i d, __m128i l, __m128i r) {
+        // 16 位中间值范围 [-1020, 1275]，不会溢出；packus 饱和到 [0, 255] 与 qBound 一致
+        const __m128i c5 = _mm_add_epi16(_mm_slli_epi16(c, 2), c);
+        return _mm_sub_epi16(_mm_sub_epi16(c5, _mm_add_epi16(u, d)), _mm_add_epi16(l, r));
+    };
+    for (; x + 16 <= w - 1; x += 16) {
+        const __m128i c = load(cur + x), u = load(up + x), d = load(down + x);
+        const __m128i l = load(cur + x - 1), r = load(cur + x + 1);
+        const __m128i lo = kernel(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(d, zero),
+                                  _mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(r, zero));
+        const __m128i hi = kernel(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(d, zero),
+                                  _mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(r, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < w - 1; ++x) {
+        const int sum = 5 * cur[x] - up[x] - down[x] - cur[x - 1] - cur[x + 1];
+        out[x] = static_cast<uchar>(qBound(0, sum, 255));
+    }
+}
+
+// 对 [y0, y1) 行做查表 (反色 + 拉伸) 与锐化；只保留三行查表结果轮换使用
+void stretchSharpenRows(const uchar* src, qsizetype srcBpl, uchar* dst, qsizetype dstBpl,
+                        int w, int h, int y0, int y1, const uchar* lut) {
+    std::vector<uchar> rows(static_cast<size_t>(w) * 3);
+    uchar* up = rows.data();
+    uchar* cur = up + w;
+    uchar* down = cur + w;
+    auto mapRow = [&](int y, uchar* out) {
+        const uchar* line = src + y * srcBpl;
+        for (int x = 0; x < w; ++x) out[x] = lut[line[x]];
+    };
+
+    int mapped = -2;   // cur 当前对应的行号
+    for (int y = y0; y < y1; ++y) {
+        uchar* out = dst + y * dstBpl;
+        // 首尾两行不参与卷积
+        if (y == 0 || y == h - 1) {
+            mapRow(y, out);
+            continue;
+        }
+        if (mapped == y - 1) {
+            std::swap(up, cur);
+            std::swap(cur, down);
+            mapRow(y + 1, down);
+        } else {
+            mapRow(y - 1, up);
+            mapRow(y, cur);
+            mapRow(y + 1, down);
+        }
+        mapped = y;
+
+        out[0] = cur[0];
+        out[w - 1] = cur[w - 1];
+        sharpenRow(up, cur, down, out, w);
+    }
+}
+
+} // namespace
+
+QImage ImagePreprocessor::prepareForOcr(const QImage& original, const Options& options) {
+    if (original.isNull()) {
+        return original;
+    }
+
+    // 1. 灰度化 (保留 8 位深度的灰度细节，这对 Tesseract 4+ 至关重要)
+    QImage gray = original.convertToFormat(QImage::Format_Grayscale8);
+
+    // 2. 动态缩放：使文字像素高度接近 Tesseract 偏好的 30-35 像素，大图不再放大
+    int scale = 3;
+    if (gray.width() > 2000 || gray.height() > 2000) {
+        scale = 1;
+    } else if (gray.width() > 1000 || gray.height() > 1000) {
+        scale = 2;
+    }
+    if (scale > 1) {
+        gray = gray.scaled(gray.width() * scale, gray.height() * scale, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const int w = gray.width();
+    const int h = gray.height();
+    const uchar* src = gray.constBits();
+    const qsizetype srcBpl = gray.bytesPerLine();
+    const int bandCount = (h + kBandRows - 1) / kBandRows;
+    const bool parallel = qint64(w) * h >= kParallelMinPixels;
+
+    // 3. 四角偏暗视为深色背景，反色并入查找表
+    const int cornerSum = src[0] + src[w - 1] + src[(h - 1) * srcBpl] + src[(h - 1) * srcBpl + w - 1];
+    const bool invert = cornerSum / 4 < 128;
+
+    // 4. 直方图 (各行带独立统计后合并)，两端各忽略 0.5% 决定拉伸区间
+    std::vector<std::array<quint32, 256>> partial(bandCount);
+    forEachBand(bandCount, parallel, [&](int band) {
+        histogramRows(src, srcBpl, w, band * kBandRows, qMin(h, (band + 1) * kBandRows), partial[band].data());
+    });
+    qint64 histogram[256] = {0};
+    for (const auto& part : partial) {
+        for (int i = 0; i < 256; ++i) histogram[invert ? 255 - i : i] += part[i];
+    }
+
+    const int totalPixels = w * h;
+    int minGray = 0, maxGray = 255;
+    qint64 count = 0;
+    for (int i = 0; i < 256; ++i) {
+        count += histogram[i];
+        if (count > totalPixels * 0.005) { minGray = i; break; }
+    }
+    count = 0;
+    for (int i = 255; i >= 0; --i) {
+        count += histogram[i];
+        if (count > totalPixels * 0.005) { maxGray = i; break; }
+    }
+
+    uchar lut[256];
+    for (int v = 0; v < 256; ++v) {
+        const int u = invert ? 255 - v : v;
+        lut[v] = maxGray > minGray ? static_cast<uchar>(qBound(0, (u - minGray) * 255 / (maxGray - minGray), 255))
+                                   : static_cast<uchar>(u);
+    }
+
+    // 5. 查表与十字形锐化合为一遍，直接写入输出
+    QImage processed(w, h, QImage::Format_Grayscale8);
+    uchar* dst = processed.bits();
+    const qsizetype dstBpl = processed.bytesPerLine();
+    forEachBand(bandCount, parallel, [&](int band) {
+        stretchSharpenRows(src, srcBpl, dst, dstBpl, w, h, band * kBandRows, qMin(h, (band + 1) * kBandRows), lut);
+    });
+
+    if (options.deskew) processed = deskew(processed);
+    if (options.binarize) processed = adaptiveBinarize(processed);
+    return processed;
+}
+
+QImage ImagePreprocessor::adaptiveBinarize(const QImage& gray, int windowSize, int thresholdPercent) {
+    if (gray.isNull()) return gray;
+    const QImage input = gray.convertToFormat(QImage::Format_Grayscale8);
+    const int w = input.width();
+    const int h = input.height();
+    const int half = (windowSize > 0 ? windowSize : qMax(15, qMin(w, h) / 16)) / 2;
+
+    // 积分图按 32 位无符号累加：总和可能回绕，但窗口内的差值仍然正确
+    const size_t stride = static_cast<size_t>(w) + 1;
+    std::vector<quint32> integral(stride * (static_cast<size_t>(h) + 1), 0);
+    for (int y = 0; y < h; ++y) {
+        const uchar* line = input.constScanLine(y);
+        quint32 rowSum = 0;
+        quint32* above = integral.data() + static_cast<size_t>(y) * stride;
+        quint32* row = above + stride;
+        for (int x = 0; x < w; ++x) {
+            rowSum += line[x];
+            row[x + 1] = above[x + 1] + rowSum;
+        }
+    }
+
+    QImage result(w, h, QImage::Format_Grayscale8);
+    const int bandCount = (h + kBandRows - 1) / kBandRows;
+    forEachBand(bandCount, qint64(w) * h >= kParallelMinPixels, [&](int band) {
+        const int yEnd = qMin(h, (band + 1) * kBandRows);
+        for (int y = band * kBandRows; y < yEnd; ++y) {
+            const int y1 = qMax(0, y - half);
+            const int y2 = qMin(h - 1, y + half);
+            const quint32* top = integral.data() + static_cast<size_t>(y1) * stride;
+            const quint32* bottom = integral.data() + static_cast<size_t>(y2 + 1) * stride;
+            const uchar* line = input.constScanLine(y);
+            uchar* out = result.scanLine(y);
+            for (int x = 0; x < w; ++x) {
+                const int x1 = qMax(0, x - half);
+                const int x2 = qMin(w - 1, x + half);
+                const quint32 sum = bottom[x2 + 1] - top[x2 + 1] - bottom[x1] + top[x1];
+                const qint64 area = qint64(x2 - x1 + 1) * (y2 - y1 + 1);
+                // 比局部均值暗 thresholdPercent% 以上判为前景
+                out[x] = qint64(line[x]) * area * 100 <= qint64(sum) * (100 - thresholdPercent) ? 0 : 255;
+            }
+        }
+    });
+    return result;
+}
+
+QImage ImagePreprocessor::deskew(const QImage& gray, double* angleOut) {
+    if (angleOut) *angleOut = 0.0;
+    if (gray.isNull()) return gray;
+
+    // 在缩小的副本上收集深色像素，按候选角度投影，行方向投影最集中 (平方和最大) 的角度即倾斜角
+    const QImage sample = gray.width() > 1000 || gray.height() > 1000
+        ? gray.scaled(1000, 1000, Qt::KeepAspectRatio, Qt::FastTransformation).convertToFormat(QImage::Format_Grayscale8)
+        : gray.convertToFormat(QImage::Format_Grayscale8);
+    std::vector<std::pair<int, int>> dark;
+    for (int y = 0; y < sample.height(); ++y) {
+        const uchar* line = sample.constScanLine(y);
+        for (int x = 0; x < sample.width(); ++x) {
+            if (line[x] < 128) dark.emplace_back(x, y);
+        }
+    }
+    if (dark.size() < 100) return gray;
+
+    const int diagonal = static_cast<int>(std::ceil(std::hypot(sample.width(), sample.height())));
+    const int steps = static_cast<int>(std::lround(kMaxSkewDegrees / kSkewStepDegrees));
+    QList<int> candidates;
+    for (int i = -steps; i <= steps; ++i) candidates << i;
+    const QList<qint64> scores = QtConcurrent::blockingMapped(candidates, [&](int step) {
+        const double radians = qDegreesToRadians(step * kSkewStepDegrees);
+        const double s = std::sin(radians);
+        const double c = std::cos(radians);
+        std::vector<int> bins(static_cast<size_t>(diagonal) * 2 + 1, 0);
+        for (const auto& p : dark) bins[static_cast<size_t>(std::lround(p.second * c - p.first * s) + diagonal)]++;
+        qint64 score = 0;
+        for (int n : bins) score += qint64(n) * n;
+        return score;
+    });
+
+    int best = 0;
+    for (int i = 1; i < candidates.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    const double angle = candidates[best] * kSkewStepDegrees;
+    if (angleOut) *angleOut = angle;
+    if (std::abs(angle) < kMinSkewDegrees) return gray;
+
+    // 旋转露出的角落为透明 (转灰度后为 0)，先反色再转回，使其成为白色背景
+    QImage inverted = gray.convertToFormat(QImage::Format_Grayscale8);
+    inverted.invertPixels();
+    QImage rotated = inverted.transformed(QTransform().rotate(-angle), Qt::SmoothTransformation)
+                         .convertToFormat(QImage::Format_Grayscale8);
+    rotated.invertPixels();
+    return rotated;
+}
@@ -0,0 +1,38 @@
+#ifndef IMAGEPREPROCESSOR_H
+#define IMAGEPREPROCESSOR_H
+
+#include <QImage>
+
+/**
+ * @brief OCR 前的图像预处理
+ *
+ * 灰度化、按尺寸放大、深色背景反色、0.5% 截断的线性对比度拉伸与十字形 3x3 锐化。
+ * 反色与拉伸合并为一张 256 项查找表，锐化时逐行现场查表，不再生成拉伸后的整图副本；
+ * 直方图与拉伸锐化都按行带分给线程池，锐化内核使用 SSE2 每次处理 16 个像素。
+ * 输出与逐像素的原始实现逐字节一致 (见 tests/ImagePreprocessorBenchmark.cpp)。
+ *
+ * 可选的自适应二值化 (Bradley 局部均值) 与倾斜校正 (投影方差搜索 ±5°) 默认关闭：
+ * Tesseract 4+ 对抗锯齿的灰度图自行二值化效果更好，只在扫描件等场景按需开启。
+ */
+class ImagePreprocessor {
+public:
+    struct Options {
+        bool deskew = false;
+        bool binarize = false;
+    };
+
+    static QImage prepareForOcr(const QImage& original, const Options& options = Options());
+
+    // 输入输出均为 Format_Grayscale8
+    static QImage adaptiveBinarize(const QImage& gray, int windowSize = 0, int thresholdPercent = 15);
+    static QImage deskew(const QImage& gray, double* angleOut = nullptr);
+
+private:
+    static constexpr int kBandRows = 32;                 // 每个并行任务处理的行数
+    static constexpr qint64 kParallelMinPixels = 256 * 1024;
+    static constexpr double kMaxSkewDegrees = 5.0;
+    static constexpr double kSkewStepDegrees = 0.2;
+    static constexpr double kMinSkewDegrees = 0.3;       // 小于该角度不旋转，避免无谓的重采样
+};
+
+#endif // IMAGEPREPROCESSOR_H
@@ -0,0 +1,69 @@
+#include "OCRBatch.h"
+#include "OCRManager.h"
+#include <QFuture>
+#include <QDebug>
+#include <utility>
+
+OCRBatch::OCRBatch(QObject* parent) : QObject(parent) {}
+
+int OCRBatch::add(const QImage& image, const QVariant& tag) {
+    return enqueue(Task{image, QString(), tag});
+}
+
+int OCRBatch::addFile(const QString& path, const QVariant& tag) {
+    return enqueue(Task{QImage(), path, tag});
+}
+
+int OCRBatch::enqueue(Task task) {
+    const int index = m_tasks.size();
+    m_tasks.append(std::move(task));
+    m_results.append(OCRResult());
+    m_pending.enqueue(index);
+    emit progress(m_finished, m_tasks.size());
+    pump();
+    return index;
+}
+
+void OCRBatch::cancel() {
+    if (isRunning()) qDebug() << "[OCRBatch] 取消: 丢弃排队任务" << m_pending.size() << "个，进行中" << m_running << "个";
+    m_generation++;
+    m_pending.clear();
+    m_tasks.clear();
+    m_results.clear();
+    m_running = 0;
+    m_finished = 0;
+}
+
+void OCRBatch::pump() {
+    const int limit = OCRManager::instance().maxConcurrency();
+    while (m_running < limit && !m_pending.isEmpty()) {
+        const int index = m_pending.dequeue();
+        Task& task = m_tasks[index];
+        // 提交后即释放本地引用，长队列不必同时持有所有已处理图片
+        QFuture<OCRResult> future = task.path.isEmpty()
+            ? OCRManager::instance().recognizeLayout(std::exchange(task.image, QImage()))
+            : OCRManager::instance().recognizeFile(task.path);
+        m_running++;
+        emit itemStarted(index, task.tag);
+
+        const int generation = m_generation;
+        future.then(this, [this, index, generation](const OCRResult& result) {
+            onTaskDone(index, generation, result);
+        });
+    }
+}
+
+void OCRBatch::onTaskDone(int index, int generation, const OCRResult& result) {
+    if (generation != m_generation) return;   // 已取消的批次
+
+    m_running--;
+    m_finished++;
+    m_results[index] = result;
+    const QVariant tag = m_tasks.at(index).tag;
+    emit itemFinished(index, result, tag);
+    if (generation != m_generation) return;   // 槽函数中取消了本批
+    emit progress(m_finished, m_tasks.size());
+
+    pump();
+    if (!isRunning()) emit finished();
+}
@@ -0,0 +1,63 @@
+#ifndef OCRBATCH_H
+#define OCRBATCH_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QQueue>
+#include <QList>
+#include "OCRManager.h"
+
+/**
+ * @brief 有界并行的 OCR 批量调度
+ *
+ * 任务按加入顺序编号，同时进行的识别数不超过 OCRManager::maxConcurrency() (与识别线程数一致)，
+ * 其余任务在本对象内排队，一个完成后立即补上下一个。每完成一项发出 itemFinished (完成顺序不定，
+ * 通过序号与 tag 对应)，结果为完整的 OCRResult：调用方可区分识别出错 (transient) 与图中无字，
+ * 也能拿到文字块位置。results() 始终按加入顺序排列。cancel() 丢弃排队中的任务，进行中的结果到达后忽略。
+ * 所有信号都在本对象所在线程发出。
+ */
+class OCRBatch : public QObject {
+    Q_OBJECT
+public:
+    explicit OCRBatch(QObject* parent = nullptr);
+
+    // 追加任务，返回序号 (从 0 开始)；tag 随结果原样带回
+    int add(const QImage& image, const QVariant& tag = QVariant());
+    // 图片文件在识别线程中解码
+    int addFile(const QString& path, const QVariant& tag = QVariant());
+    // 取消全部任务并清空，之后可继续 add 开始新的一批
+    void cancel();
+
+    int total() const { return m_tasks.size(); }
+    int finishedCount() const { return m_finished; }
+    bool isRunning() const { return m_running > 0 || !m_pending.isEmpty(); }
+    QList<OCRResult> results() const { return m_results; }   // 未完成的项为默认值 (text 为空)
+
+signals:
+    void itemStarted(int index, const QVariant& tag);
+    void itemFinished(int index, const OCRResult& result, const QVariant& tag);
+    void progress(int finished, int total);
+    void finished();
+
+private:
+    struct Task {
+        QImage image;
+        QString path;
+        QVariant tag;
+    };
+    int enqueue(Task task);
+    void pump();
+    void onTaskDone(int index, int generation, const OCRResult& result);
+
+    QList<Task> m_tasks;
+    QList<OCRResult> m_results;
+    QQueue<int> m_pending;
+    int m_running = 0;
+    int m_finished = 0;
+    int m_generation = 0;   // cancel() 后递增，丢弃上一批迟到的结果
+};
+
+#endif // OCRBATCH_H
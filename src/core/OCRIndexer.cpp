@@ -0,0 +1,116 @@
+#include "OCRIndexer.h"
+#include "OCRManager.h"
+#include "DatabaseManager.h"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QSettings>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+OCRIndexer::OCRIndexer(QObject* parent) : QObject(parent) {
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &OCRIndexer::tick);
+    m_lastInput.start();
+
+    // 新收集的图片不必等到下一轮空闲轮询
+    connect(&DatabaseManager::instance(), &DatabaseManager::noteAdded, this, [this](const QVariantMap& note) {
+        if (!m_running || m_busy || note.value("item_type").toString() != "image") return;
+        if (!m_timer.isActive() || m_timer.remainingTime() > kRetryMs) schedule(kRetryMs);
+    });
+}
+
+void OCRIndexer::start() {
+    if (m_running) return;
+    if (!QSettings("RapidNotes", "OCR").value("backgroundIndex", true).toBool()) {
+        qDebug() << "[OCRIndexer] 后台识别已在设置中关闭";
+        return;
+    }
+    m_running = true;
+    qApp->installEventFilter(this);
+    schedule(kStartDelayMs);
+}
+
+void OCRIndexer::stop() {
+    if (!m_running) return;
+    m_running = false;
+    m_timer.stop();
+    qApp->removeEventFilter(this);
+}
+
+bool OCRIndexer::eventFilter(QObject* watched, QEvent* event) {
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::Wheel:
+        m_lastInput.restart();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void OCRIndexer::schedule(int delayMs) {
+    if (m_running) m_timer.start(delayMs);
+}
+
+qint64 OCRIndexer::idleMs() const {
+#ifdef Q_OS_WIN
+    // 本程序大多在后台运行，以系统级的最后输入时间为准
+    LASTINPUTINFO info;
+    info.cbSize = sizeof(info);
+    if (GetLastInputInfo(&info)) return static_cast<qint64>(GetTickCount() - info.dwTime);
+#endif
+    return m_lastInput.elapsed();
+}
+
+void OCRIndexer::tick() {
+    if (!m_running || m_busy) return;
+    // 用户正在操作或前台正在识别：稍后再看
+    if (idleMs() < kIdleMs || OCRManager::instance().activeCount() > 0) {
+        schedule(kRetryMs);
+        return;
+    }
+    if (!OCRManager::isAvailable()) {
+        qDebug() << "[OCRIndexer] 未找到 OCR 引擎，后台识别停止";
+        stop();
+        return;
+    }
+
+    DatabaseManager& db = DatabaseManager::instance();
+    const int noteId = db.nextPendingOcrNote();
+    if (noteId <= 0) {
+        schedule(kEmptyPollMs);
+        return;
+    }
+    const QByteArray data = db.getNoteImage(db.getNoteById(noteId));
+    if (data.isEmpty()) {
+        db.setNoteOcrText(noteId, QString(), DatabaseManager::kOcrNoText);
+        schedule(kIntervalMs);
+        return;
+    }
+
+    m_busy = true;
+    QElapsedTimer timer;
+    timer.start();
+    OCRManager::instance().recognizeInBackground(data).then(this, [this, noteId, timer](const OCRResult& result) {
+        m_busy = false;
+        if (result.transient) {
+            // 引擎出错不等于图中无字：按退避时间稍后重试
+            DatabaseManager::instance().markNoteOcrFailed(noteId);
+            qDebug().noquote() << QString("[OCRIndexer] 笔记 %1 识别出错，稍后重试：%2").arg(noteId).arg(result.text);
+            schedule(kIntervalMs);
+            return;
+        }
+        DatabaseManager::instance().setNoteOcrText(noteId, result.success ? result.text : QString(),
+                                                   result.success ? DatabaseManager::kOcrDone : DatabaseManager::kOcrNoText);
+        m_indexed++;
+        qDebug().noquote() << QString("[OCRIndexer] 笔记 %1 识别完成：%2 字，耗时 %3 ms (本次运行已补全 %4 条)")
+                                  .arg(noteId).arg(result.success ? result.text.size() : 0)
+                                  .arg(timer.elapsed()).arg(m_indexed);
+        schedule(kIntervalMs);
+    });
+}
@@ -0,0 +1,46 @@
+#ifndef OCRINDEXER_H
+#define OCRINDEXER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief 空闲时为图片笔记补全 OCR 文字
+ *
+ * 逐条取出尚未识别的图片笔记 (notes.ocr_state = 0，新的在前)，识别结果写入 notes.ocr_text 并纳入全文索引。
+ * 进度即数据库中的 ocr_state，退出后下次启动从剩余的笔记继续。引擎出错 (超时、启动失败等) 的笔记标记为
+ * 待重试，按逐次加倍的间隔重新识别；只有确实没有文字或图片无法解码时才不再处理。
+ *
+ * 节流：用户最近 kIdleMs 内有键鼠操作、或前台正在识别时不启动新任务；同一时刻只识别一张，
+ * 识别线程降为最低优先级，两张之间至少间隔 kIntervalMs。可通过 QSettings "OCR/backgroundIndex" 关闭。
+ */
+class OCRIndexer : public QObject {
+    Q_OBJECT
+public:
+    explicit OCRIndexer(QObject* parent = nullptr);
+    void start();
+    void stop();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    void tick();
+    void schedule(int delayMs);
+    qint64 idleMs() const;
+
+    static constexpr int kStartDelayMs = 30 * 1000;   // 启动后先让出时间给界面与剪贴板监听
+    static constexpr int kIdleMs = 5 * 1000;
+    static constexpr int kIntervalMs = 2 * 1000;
+    static constexpr int kRetryMs = 10 * 1000;       // 用户忙碌或前台识别时的复查间隔
+    static constexpr int kEmptyPollMs = 5 * 60 * 1000;
+
+    QTimer m_timer;
+    QElapsedTimer m_lastInput;
+    bool m_running = false;
+    bool m_busy = false;       // 有一张正在识别
+    int m_indexed = 0;
+};
+
+#endif // OCRINDEXER_H
@@ -1,21 +1,40 @@
 #include "OCRManager.h"
+#include "DatabaseManager.h"
+#include "TextRegionDetector.h"
 #include <QtConcurrent>
 #include <QThreadPool>
 #include <QStringList>
 #include <QTemporaryFile>
 #include <QProcess>
 #include <QDir>
+#include <QFileInfo>
 #include <QDebug>
 #include <QLocale>
 #include <QCoreApplication>
+#include <QStandardPaths>
+#include <QSettings>
+#include <QDataStream>
+#include <QRectF>
 #include <utility>
+#include <memory>
+#include <algorithm>
+
+#ifdef RAPIDNOTES_HAVE_TESSERACT
+#include <tesseract/baseapi.h>
+#include <tesseract/resultiterator.h>
+#endif
 
 OCRManager& OCRManager::instance() {
     static OCRManager inst;
     return inst;
 }
 
-OCRManager::OCRManager(QObject* parent) : QObject(parent) {}
+OCRManager::OCRManager(QObject* parent) : QObject(parent) {
+    // 线程永不过期：线程上缓存的识别引擎随线程一直保留，避免空闲后重新加载模型
+    m_pool.setExpiryTimeout(-1);
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), kMaxEngines));
+    m_cache.setMaxCost(DatabaseManager::kOcrCacheLimit);
+}
 
 void OCRManager::setLanguage(const QString& lang) {
     m_language = lang;
@@ -29,7 +48,8 @@ void OCRManager::recognizeAsync(const QImage& image, int contextId) {
     qDebug() << "[OCRManager] recognizeAsync: 接收任务 ID:" << contextId 
              << "图片大小:" << image.width() << "x" << image.height() 
              << "主线程:" << QThread::currentThread();
-    (void)QtConcurrent::run(QThreadPool::globalInstance(), [this, image, contextId]() {
+    ensureCacheLoaded();
+    (void)QtConcurrent::run(&m_pool, [this, image, contextId]() {
         qDebug() << "[OCRManager] 工作线程开始执行 ID:" << contextId 
                  << "线程:" << QThread::currentThread();
         this->recognizeSync(image, contextId);
@@ -37,222 +57,190 @@ void OCRManager::recognizeAsync(const QImage& image, int contextId) {
     });
 }
 
-// 图像预处理函数：提高 OCR 识别准确度
-QImage OCRManager::preprocessImage(const QImage& original) {
-    if (original.isNull()) {
-        return original;
-    }
-    
-    // 1. 转换为灰度图 (保留 8 位深度的灰度细节，这对 Tesseract 4+ 至关重要)
-    QImage processed = original.convertToFormat(QImage::Format_Grayscale8);
-    
-    // 2. 动态缩放策略
-    // 目标：使文字像素高度达到 Tesseract 偏好的 30-35 像素。
-    // 如果原图已经很大（宽度 > 2000），则不需要放大 3 倍，否则会导致内存占用过高且识别变慢
-    int scale = 3;
-    if (processed.width() > 2000 || processed.height() > 2000) {
-        scale = 1;
-    } else if (processed.width() > 1000 || processed.height() > 1000) {
-        scale = 2;
-    }
-    
-    if (scale > 1) {
-        processed = processed.scaled(
-            processed.width() * scale, 
-            processed.height() * scale, 
-            Qt::KeepAspectRatio, 
-            Qt::SmoothTransformation
-        );
-    }
-    
-    // 3. 自动反色处理：Tesseract 在白底黑字下表现最好
-    // 简单判断：如果四个角的像素平均值较暗，则认为可能是深色背景
-    int cornerSum = 0;
-    cornerSum += qGray(processed.pixel(0, 0));
-    cornerSum += qGray(processed.pixel(processed.width()-1, 0));
-    cornerSum += qGray(processed.pixel(0, processed.height()-1));
-    cornerSum += qGray(processed.pixel(processed.width()-1, processed.height()-1));
-    if (cornerSum / 4 < 128) {
-        processed.invertPixels();
-    }
+QFuture<QString> OCRManager::recognize(const QImage& image) {
+    ensureCacheLoaded();
+    return QtConcurrent::run(&m_pool, [this, image]() { return recognizeText(image); });
+}
 
-    // 4. 增强对比度（线性拉伸）
-    // 泰语等细笔画文字对二值化和过度的对比度拉伸很敏感，因此我们收窄忽略范围（从 1% 降至 0.5%）
-    int histogram[256] = {0};
-    for (int y = 0; y < processed.height(); ++y) {
-        const uchar* line = processed.constScanLine(y);
-        for (int x = 0; x < processed.width(); ++x) {
-            histogram[line[x]]++;
-        }
-    }
-    
-    int totalPixels = processed.width() * processed.height();
-    int minGray = 0, maxGray = 255;
-    int count = 0;
-    
-    for (int i = 0; i < 256; ++i) {
-        count += histogram[i];
-        if (count > totalPixels * 0.005) {
-            minGray = i;
-            break;
-        }
-    }
-    
-    count = 0;
-    for (int i = 255; i >= 0; --i) {
-        count += histogram[i];
-        if (count > totalPixels * 0.005) {
-            maxGray = i;
-            break;
+QFuture<OCRResult> OCRManager::recognizeLayout(const QImage& image) {
+    ensureCacheLoaded();
+    return QtConcurrent::run(&m_pool, [this, image]() { return recognizeResult(image); });
+}
+
+QFuture<OCRResult> OCRManager::recognizeInBackground(const QByteArray& encoded) {
+    ensureCacheLoaded();
+    return QtConcurrent::run(&m_pool, [this, encoded]() {
+        const QImage image = QImage::fromData(encoded);
+        if (image.isNull()) return OCRResult{"图片数据无法解码", false, {}};
+        QThread* thread = QThread::currentThread();
+        const QThread::Priority priority = thread->priority();
+        thread->setPriority(QThread::LowestPriority);
+        OCRResult result = recognizeResult(image);
+        thread->setPriority(priority);
+        return result;
+    });
+}
+
+QFuture<OCRResult> OCRManager::recognizeFile(const QString& path) {
+    ensureCacheLoaded();
+    return QtConcurrent::run(&m_pool, [this, path]() {
+        const QImage image(path);
+        return image.isNull() ? OCRResult{QString("无法读取图片: %1").arg(QFileInfo(path).fileName()), false, {}}
+                              : recognizeResult(image);
+    });
+}
+
+// 二值化与倾斜校正默认关闭：Tesseract 4.0+ 内部的二值化器在抗锯齿灰度图上表现更好
+ImagePreprocessor::Options OCRManager::preprocessOptions() {
+    QSettings settings("RapidNotes", "OCR");
+    ImagePreprocessor::Options options;
+    options.deskew = settings.value("deskew", false).toBool();
+    options.binarize = settings.value("binarize", false).toBool();
+    return options;
+}
+
+QByteArray OCRManager::cacheKey(const QImage& gray, const QString& lang, const ImagePreprocessor::Options& options) {
+    // 尺寸、预处理选项与语言一并参与哈希，任何一项不同都不会命中
+    QByteArray digest;
+    QDataStream stream(&digest, QIODevice::WriteOnly);
+    stream << kCacheVersion << gray.width() << gray.height() << options.deskew << options.binarize << lang;
+    const Xxh3::Hash128 pixels = [&gray]() {
+        if (gray.bytesPerLine() == gray.width()) {
+            return Xxh3::hash128(gray.constBits(), static_cast<size_t>(gray.width()) * gray.height());
         }
-    }
-    
-    if (maxGray > minGray) {
-        for (int y = 0; y < processed.height(); ++y) {
-            uchar* line = processed.scanLine(y);
-            for (int x = 0; x < processed.width(); ++x) {
-                int val = line[x];
-                val = (val - minGray) * 255 / (maxGray - minGray);
-                val = qBound(0, val, 255);
-                line[x] = static_cast<uchar>(val);
-            }
+        QVector<quint64> rows;
+        rows.reserve(gray.height() * 2);
+        for (int y = 0; y < gray.height(); ++y) {
+            const Xxh3::Hash128 h = Xxh3::hash128(gray.constScanLine(y), static_cast<size_t>(gray.width()));
+            rows << h.low64 << h.high64;
         }
-    }
+        return Xxh3::hash128(rows.constData(), rows.size() * sizeof(quint64));
+    }();
+    stream << quint64(pixels.low64) << quint64(pixels.high64);
+    return DatabaseManager::computeContentKey(digest);
+}
 
-    // 5. 简单锐化处理 (卷积)
-    // 增加文字边缘对比度，有助于 Tesseract 识别彩色变灰度后的细微笔画
-    QImage sharpened = processed;
-    int kernel[3][3] = {
-        {0, -1, 0},
-        {-1, 5, -1},
-        {0, -1, 0}
-    };
-    for (int y = 1; y < processed.height() - 1; ++y) {
-        const uchar* prevLine = processed.constScanLine(y - 1);
-        const uchar* currLine = processed.constScanLine(y);
-        const uchar* nextLine = processed.constScanLine(y + 1);
-        uchar* destLine = sharpened.scanLine(y);
-        for (int x = 1; x < processed.width() - 1; ++x) {
-            int sum = currLine[x] * kernel[1][1]
-                    + prevLine[x] * kernel[0][1] + nextLine[x] * kernel[2][1]
-                    + currLine[x-1] * kernel[1][0] + currLine[x+1] * kernel[1][2];
-            destLine[x] = static_cast<uchar>(qBound(0, sum, 255));
-        }
+void OCRManager::ensureCacheLoaded() {
+    // 数据库连接只能在界面线程使用，由各识别入口 (均在界面线程调用) 首次进入时加载
+    if (m_cacheLoaded) return;
+    // 数据库尚未打开 (如加密库还未解锁) 时不标记为已加载，下次识别时再试
+    bool ok = false;
+    const QList<QVariantMap> entries = DatabaseManager::instance().getOcrCache(DatabaseManager::kOcrCacheLimit, &ok);
+    if (!ok) return;
+    m_cacheLoaded = true;
+    QMutexLocker locker(&m_cacheMutex);
+    // 最近使用的排在前面：倒序插入，使其在 LRU 中最新；加载之前已识别出的结果保留不动
+    for (auto it = entries.crbegin(); it != entries.crend(); ++it) {
+        if (m_cache.contains(it->value("key").toByteArray())) continue;
+        const QString text = it->value("text").toString();
+        m_cache.insert(it->value("key").toByteArray(),
+                       new OCRResult{text, !text.isEmpty(), decodeBlocks(it->value("blocks").toByteArray())});
     }
-    processed = sharpened;
-    
-    // 注意：不再手动调用 Otsu 二值化。
-    // Tesseract 4.0+ 内部的二值化器（基于 Leptonica）在处理具有抗锯齿边缘的灰度图像时表现更好。
-    
-    return processed;
+    qDebug() << "[OCRManager] 已载入 OCR 缓存" << entries.size() << "条";
 }
 
-void OCRManager::recognizeSync(const QImage& image, int contextId) {
-    qDebug() << "[OCRManager] recognizeSync: 开始识别 ID:" << contextId 
-             << "线程:" << QThread::currentThread();
-    QString result;
+QByteArray OCRManager::encodeBlocks(const QList<OCRBlock>& blocks) {
+    if (blocks.isEmpty()) return QByteArray();
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << qint32(blocks.size());
+    for (const OCRBlock& block : blocks) stream << block.rect << block.text;
+    return data;
+}
 
-#ifdef Q_OS_WIN
-    // 预处理图像以提高识别准确度
-    QImage processedImage = preprocessImage(image);
-    
-    if (processedImage.isNull()) {
-        result = "图像无效";
-        emit recognitionFinished(result, contextId);
-        return;
-    }
-    
-    // 使用 BMP 格式存储临时文件，因为其写入速度最快且不涉及复杂的压缩计算，能缩短毫秒级开销
-    QTemporaryFile tempFile(QDir::tempPath() + "/ocr_XXXXXX.bmp");
-    tempFile.setAutoRemove(true);
-    
-    if (!tempFile.open()) {
-        result = "无法创建临时图像文件";
-        emit recognitionFinished(result, contextId);
-        return;
-    }
-    
-    QString filePath = QDir::toNativeSeparators(tempFile.fileName());
-    
-    // 保存预处理后的灰度图
-    if (!processedImage.save(filePath, "BMP")) {
-        result = "无法保存临时图像文件";
-        emit recognitionFinished(result, contextId);
-        return;
+QList<OCRBlock> OCRManager::decodeBlocks(const QByteArray& data) {
+    QList<OCRBlock> blocks;
+    if (data.isEmpty()) return blocks;
+    QDataStream stream(data);
+    qint32 count = 0;
+    stream >> count;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        OCRBlock block;
+        stream >> block.rect >> block.text;
+        blocks.append(block);
     }
-    
-    tempFile.close();
+    return stream.status() == QDataStream::Ok ? blocks : QList<OCRBlock>();
+}
+
+#ifdef RAPIDNOTES_HAVE_TESSERACT
+// 某个线程的引擎初始化失败 (模型缺失等) 后，各线程都会回退到可执行文件
+static std::atomic<bool> s_engineInitFailed{false};
+#endif
+
+bool OCRManager::hasInProcessEngine() {
+#ifdef RAPIDNOTES_HAVE_TESSERACT
+    return !s_engineInitFailed.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
 
-    // 路径探测逻辑：增强鲁棒性，支持从 bin 或 build 目录运行
-    QString appPath = QCoreApplication::applicationDirPath();
-    QString tessDataPath;
-    QString tesseractPath;
-
-    // 尝试在多个层级寻找 resources 目录
-    QStringList basePaths;
-    basePaths << appPath;
-    basePaths << QDir(appPath).absolutePath() + "/..";
-    basePaths << QDir(appPath).absolutePath() + "/../..";
-
-    for (const QString& base : std::as_const(basePaths)) {
-        // 搜索数据目录 (支持资源目录、根目录及标准安装路径)
-        if (tessDataPath.isEmpty()) {
-            QStringList dataPotentials;
+bool OCRManager::isAvailable() {
+#ifdef RAPIDNOTES_HAVE_TESSERACT
+    return true;
+#else
+    return !environment().executable.isEmpty();
+#endif
+}
+
+const OCRManager::TessEnvironment& OCRManager::environment() {
+    // 局部静态变量的初始化是线程安全的：并发的首批任务只会探测一次
+    static const TessEnvironment env = []() {
+        TessEnvironment e;
+
+        // 路径探测逻辑：增强鲁棒性，支持从 bin 或 build 目录运行
+        QString appPath = QCoreApplication::applicationDirPath();
+        QStringList basePaths;
+        basePaths << appPath;
+        basePaths << QDir(appPath).absolutePath() + "/..";
+        basePaths << QDir(appPath).absolutePath() + "/../..";
+
+        QStringList dataPotentials;
+        QStringList exePotentials;
+        for (const QString& base : std::as_const(basePaths)) {
             dataPotentials << base + "/resources/Tesseract-OCR/tessdata"
                            << base + "/Tesseract-OCR/tessdata"
-                           << base + "/tessdata"
-                           << "C:/Program Files/Tesseract-OCR/tessdata";
-            for (const QString& p : std::as_const(dataPotentials)) {
-                if (QDir(p).exists()) {
-                    tessDataPath = QDir(p).absolutePath();
-                    break;
-                }
+                           << base + "/tessdata";
+#ifdef Q_OS_WIN
+            exePotentials << base + "/resources/Tesseract-OCR/tesseract.exe"
+                          << base + "/Tesseract-OCR/tesseract.exe"
+                          << base + "/resources/tesseract.exe"
+                          << base + "/tesseract.exe";
+#endif
+        }
+        // 系统安装位置
+        const QString envPrefix = qEnvironmentVariable("TESSDATA_PREFIX");
+        if (!envPrefix.isEmpty()) dataPotentials << envPrefix + "/tessdata" << envPrefix;
+#ifdef Q_OS_WIN
+        dataPotentials << "C:/Program Files/Tesseract-OCR/tessdata";
+        exePotentials << "C:/Program Files/Tesseract-OCR/tesseract.exe";
+#else
+        dataPotentials << "/usr/share/tesseract-ocr/5/tessdata"
+                       << "/usr/share/tesseract-ocr/4.00/tessdata"
+                       << "/usr/share/tessdata"
+                       << "/usr/local/share/tessdata"
+                       << "/opt/homebrew/share/tessdata";
+#endif
+
+        for (const QString& p : std::as_const(dataPotentials)) {
+            if (QDir(p).exists() && !QDir(p).entryList(QStringList() << "*.traineddata", QDir::Files).isEmpty()) {
+                e.dataPath = QDir(p).absolutePath();
+                break;
             }
         }
-        
-        // 搜索执行文件
-        if (tesseractPath.isEmpty()) {
-            QStringList exePotentials;
-            exePotentials << base + "/resources/Tesseract-OCR/tesseract.exe"
-                           << base + "/Tesseract-OCR/tesseract.exe"
-                           << base + "/resources/tesseract.exe"
-                           << base + "/tesseract.exe"
-                           << "C:/Program Files/Tesseract-OCR/tesseract.exe";
-            for (const QString& p : std::as_const(exePotentials)) {
-                if (QFile::exists(p)) {
-                    tesseractPath = QDir::toNativeSeparators(p);
-                    break;
-                }
+        for (const QString& p : std::as_const(exePotentials)) {
+            if (QFile::exists(p)) {
+                e.executable = QDir::toNativeSeparators(p);
+                break;
             }
         }
-        
-        if (!tessDataPath.isEmpty() && !tesseractPath.isEmpty()) break;
-    }
+        // 系统 PATH 兜底
+        if (e.executable.isEmpty()) e.executable = QStandardPaths::findExecutable("tesseract");
 
-    // 系统 PATH 兜底
-    if (tesseractPath.isEmpty()) tesseractPath = "tesseract";
-
-    if (!tesseractPath.isEmpty()) {
-        QProcess tesseract;
-        
-        // 设置 TESSDATA_PREFIX 环境变量（Tesseract 主程序所在的父目录或 tessdata 所在目录）
-        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-        if (!tessDataPath.isEmpty() && QDir(tessDataPath).exists()) {
-            // TESSDATA_PREFIX 通常应该是包含 tessdata 文件夹的目录
-            QDir prefixDir(tessDataPath);
-            prefixDir.cdUp();
-            env.insert("TESSDATA_PREFIX", QDir::toNativeSeparators(prefixDir.absolutePath()));
-        }
-        tesseract.setProcessEnvironment(env);
-        
         // 智能语言探测：自动扫描 tessdata 目录下所有可用的训练数据
-        QStringList foundLangs;
-        if (!tessDataPath.isEmpty()) {
-            QDir dir(tessDataPath);
-            if (dir.exists()) {
-            QStringList filters; filters << "*.traineddata";
-            QStringList files = dir.entryList(filters, QDir::Files);
-            
+        if (!e.dataPath.isEmpty()) {
+            QStringList files = QDir(e.dataPath).entryList(QStringList() << "*.traineddata", QDir::Files);
+
             // 定义优先级：优先加载中文简体和泰语，防止误识别为英文字符 (如 星号 -> BE)
             QStringList priority;
             if (QLocale::system().language() == QLocale::Chinese && 
@@ -264,66 +252,287 @@ void OCRManager::recognizeSync(const QImage& image, int contextId) {
 
             for (const QString& pLang : std::as_const(priority)) {
                 if (files.contains(pLang + ".traineddata")) {
-                    foundLangs << pLang;
+                    e.languages << pLang;
                     files.removeAll(pLang + ".traineddata");
                 }
             }
             // 其余语言按字母顺序追加，但限制总数。
             // 速度优化的关键：加载的语言模型（LSTM）越多，Tesseract 初始化越慢。
-            // 将上限从 10 降至 3，可使初始化速度提升数倍。
             for (const QString& file : std::as_const(files)) {
-                if (foundLangs.size() >= 3) break;
+                if (e.languages.size() >= 3) break;
                 QString name = file.left(file.lastIndexOf('.'));
-                if (name != "osd" && !foundLangs.contains(name)) foundLangs << name;
-            }
+                if (name != "osd" && !e.languages.contains(name)) e.languages << name;
             }
         }
 
-        QString currentLang = foundLangs.isEmpty() ? m_language : foundLangs.join('+');
-        qDebug() << "OCR: Used tessdata path:" << tessDataPath;
-        qDebug() << "OCR: Detected languages:" << foundLangs.size() << ":" << currentLang;
+        qDebug() << "OCR: Used tessdata path:" << e.dataPath;
+        qDebug() << "OCR: Detected languages:" << e.languages.size() << ":" << e.languages.join('+');
+        qDebug() << "OCR: Fallback executable:" << e.executable;
+        return e;
+    }();
+    return env;
+}
+
+QString OCRManager::runEngine(const QImage& processed, const QString& lang, int psm, QString* error,
+                              QList<OCRBlock>* lines) {
+#ifdef RAPIDNOTES_HAVE_TESSERACT
+    // 每个工作线程一个引擎：TessBaseAPI 不可跨线程并发使用，模型加载后在本线程内反复复用
+    struct ThreadEngine {
+        std::unique_ptr<tesseract::TessBaseAPI> api;
+        QString lang;
+        QString dataPath;
+    };
+    thread_local ThreadEngine engine;
 
-        QStringList args;
-        // 明确指定数据目录
-        if (QFile::exists(tessDataPath)) {
-            args << "--tessdata-dir" << QDir::toNativeSeparators(tessDataPath);
+    const TessEnvironment& env = environment();
+    if (!engine.api || engine.lang != lang || engine.dataPath != env.dataPath) {
+        engine.api = std::make_unique<tesseract::TessBaseAPI>();
+        const QByteArray dataPath = QDir::toNativeSeparators(env.dataPath).toLocal8Bit();
+        const QByteArray language = lang.toUtf8();
+        if (engine.api->Init(dataPath.isEmpty() ? nullptr : dataPath.constData(), language.constData(),
+                             tesseract::OEM_LSTM_ONLY) != 0) {
+            engine.api.reset();
+            s_engineInitFailed = true;
+            qWarning() << "[OCRManager] Tesseract 引擎初始化失败，改用可执行文件:" << lang;
+            return runProcess(processed, lang, psm, error);
         }
-        
-        args << filePath << "stdout" << "-l" << currentLang << "--oem" << "1" << "--psm" << "3";
-        tesseract.start(tesseractPath, args);
-        
-        if (!tesseract.waitForStarted()) {
-            result = "无法启动 Tesseract 引擎。路径: " + tesseractPath;
-        } else if (tesseract.waitForFinished(20000)) {
-            QByteArray output = tesseract.readAllStandardOutput();
-            QByteArray errorOutput = tesseract.readAllStandardError();
-            result = QString::fromUtf8(output).trimmed();
-            
-            if (!result.isEmpty()) {
-                qDebug() << "Tesseract OCR succeeded using:" << tesseractPath << "with lang:" << currentLang;
-                emit recognitionFinished(result, contextId);
-                return;
-            }
-            
-            if (!errorOutput.isEmpty()) {
-                result = "Tesseract 错误: " + QString::fromUtf8(errorOutput).left(100);
-            } else {
-                result = "未识别到任何内容。请检查数据包及语言。";
-            }
-        } else {
-            tesseract.kill();
-            result = "OCR 识别超时 (20s)。语言包过量或图片过大。";
+        engine.lang = lang;
+        engine.dataPath = env.dataPath;
+        qDebug() << "[OCRManager] 线程" << QThread::currentThread() << "已加载识别引擎:" << lang;
+    }
+
+    // 预处理结果是 8 位灰度，直接交给引擎，不再落盘
+    engine.api->SetPageSegMode(static_cast<tesseract::PageSegMode>(psm));
+    engine.api->SetImage(processed.constBits(), processed.width(), processed.height(), 1,
+                         static_cast<int>(processed.bytesPerLine()));
+    engine.api->SetSourceResolution(300);
+    std::unique_ptr<char[]> text(engine.api->GetUTF8Text());
+    if (text && lines) {
+        // 整页识别时按文本行给出位置
+        std::unique_ptr<tesseract::ResultIterator> it(engine.api->GetIterator());
+        if (it) {
+            do {
+                int left = 0, top = 0, right = 0, bottom = 0;
+                if (!it->BoundingBox(tesseract::RIL_TEXTLINE, &left, &top, &right, &bottom)) continue;
+                std::unique_ptr<char[]> line(it->GetUTF8Text(tesseract::RIL_TEXTLINE));
+                const QString lineText = line ? QString::fromUtf8(line.get()).trimmed() : QString();
+                if (!lineText.isEmpty()) lines->append(OCRBlock{QRect(QPoint(left, top), QPoint(right - 1, bottom - 1)), lineText});
+            } while (it->Next(tesseract::RIL_TEXTLINE));
         }
-    } else {
-        result = "未找到 Tesseract 引擎组件。搜索路径包括 resources/Tesseract-OCR。";
     }
+    engine.api->Clear();
+    if (!text) {
+        *error = "Tesseract 识别失败";
+        return QString();
+    }
+    return QString::fromUtf8(text.get()).trimmed();
 #else
-    result = "当前平台不支持 OCR 功能";
+    Q_UNUSED(lines);
+    return runProcess(processed, lang, psm, error);
 #endif
+}
+
+QString OCRManager::runProcess(const QImage& processed, const QString& lang, int psm, QString* error) {
+    const TessEnvironment& env = environment();
+    if (env.executable.isEmpty()) {
+        *error = "未找到 Tesseract 引擎组件。搜索路径包括 resources/Tesseract-OCR。";
+        return QString();
+    }
+
+    // 使用 BMP 格式存储临时文件，因为其写入速度最快且不涉及复杂的压缩计算，能缩短毫秒级开销
+    QTemporaryFile tempFile(QDir::tempPath() + "/ocr_XXXXXX.bmp");
+    tempFile.setAutoRemove(true);
+    if (!tempFile.open()) {
+        *error = "无法创建临时图像文件";
+        return QString();
+    }
+    QString filePath = QDir::toNativeSeparators(tempFile.fileName());
+    if (!processed.save(filePath, "BMP")) {
+        *error = "无法保存临时图像文件";
+        return QString();
+    }
+    tempFile.close();
+
+    QProcess tesseract;
+    // 设置 TESSDATA_PREFIX 环境变量（tessdata 所在目录的父目录）
+    QProcessEnvironment procEnv = QProcessEnvironment::systemEnvironment();
+    if (!env.dataPath.isEmpty()) {
+        QDir prefixDir(env.dataPath);
+        prefixDir.cdUp();
+        procEnv.insert("TESSDATA_PREFIX", QDir::toNativeSeparators(prefixDir.absolutePath()));
+    }
+    tesseract.setProcessEnvironment(procEnv);
+
+    QStringList args;
+    // 明确指定数据目录
+    if (!env.dataPath.isEmpty()) {
+        args << "--tessdata-dir" << QDir::toNativeSeparators(env.dataPath);
+    }
+    args << filePath << "stdout" << "-l" << lang << "--oem" << "1" << "--psm" << QString::number(psm);
+    tesseract.start(env.executable, args);
+
+    if (!tesseract.waitForStarted()) {
+        *error = "无法启动 Tesseract 引擎。路径: " + env.executable;
+        return QString();
+    }
+    if (!tesseract.waitForFinished(kProcessTimeoutMs)) {
+        tesseract.kill();
+        *error = "OCR 识别超时 (20s)。语言包过量或图片过大。";
+        return QString();
+    }
 
-    if (result.isEmpty()) {
-        result = "未能从图片中识别出任何文字";
+    // 只有进程异常退出才算出错；正常结束而输出为空即图中没有文字 (stderr 里通常只有 "Estimating resolution" 之类的提示)
+    if (tesseract.exitStatus() != QProcess::NormalExit || tesseract.exitCode() != 0) {
+        const QByteArray errorOutput = tesseract.readAllStandardError();
+        *error = errorOutput.isEmpty() ? QString("Tesseract 异常退出 (代码 %1)").arg(tesseract.exitCode())
+                                       : "Tesseract 错误: " + QString::fromUtf8(errorOutput).left(100);
+        return QString();
     }
+    return QString::fromUtf8(tesseract.readAllStandardOutput()).trimmed();
+}
+
+QString OCRManager::recognizeText(const QImage& image) {
+    return recognizeResult(image).text;
+}
+
+OCRResult OCRManager::recognizeResult(const QImage& image) {
+    if (image.isNull()) return OCRResult{"图像无效", false, {}};
+
+    const TessEnvironment& env = environment();
+    const QString currentLang = env.languages.isEmpty() ? m_language : env.languages.join('+');
+    const ImagePreprocessor::Options options = preprocessOptions();
+    const QString noText = "未能从图片中识别出任何文字";
+
+    // 缓存键按灰度像素计算 (预处理的第一步)：截屏、PNG 文件、数据库中的图片无论解码成何种像素格式都能命中
+    const QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    const QByteArray key = cacheKey(gray, currentLang, options);
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        if (const OCRResult* cached = m_cache.object(key)) {
+            const OCRResult result = *cached;
+            locker.unlock();
+            const int hits = ++m_cacheHits;
+            qDebug() << "[OCRManager] 缓存命中 (命中" << hits << "/ 未命中" << m_cacheMisses.load() << ")";
+            QMetaObject::invokeMethod(&DatabaseManager::instance(), [key]() {
+                DatabaseManager::instance().touchOcrResult(key);
+            });
+            return result.text.isEmpty() ? OCRResult{noText, false, {}} : result;
+        }
+    }
+    const int misses = ++m_cacheMisses;
+    qDebug() << "[OCRManager] 缓存未命中 (命中" << m_cacheHits.load() << "/ 未命中" << misses << ")";
+
+    // 预处理图像以提高识别准确度
+    const QImage processedImage = ImagePreprocessor::prepareForOcr(gray, options);
+    if (processedImage.isNull()) return OCRResult{"图像无效", false, {}};
+
+    QString error;
+    // 倾斜校正旋转后的坐标与原图不再对应，此时按整页识别且不给出位置
+    OCRResult result = recognizeRegions(processedImage, currentLang, options.deskew, &error);
+    result.success = !result.text.isEmpty();
+    // 文字块坐标从预处理图 (已放大) 换算回原图
+    const double sx = double(image.width()) / processedImage.width();
+    const double sy = double(image.height()) / processedImage.height();
+    for (OCRBlock& block : result.blocks) {
+        block.rect = QRectF(block.rect.x() * sx, block.rect.y() * sy, block.rect.width() * sx, block.rect.height() * sy)
+                         .toAlignedRect().intersected(image.rect());
+    }
+
+    // 识别出错 (引擎不可用、超时等) 不缓存，下次仍重新识别
+    if (!result.text.isEmpty() || error.isEmpty()) {
+        {
+            QMutexLocker locker(&m_cacheMutex);
+            m_cache.insert(key, new OCRResult(result));
+        }
+        const QString text = result.text;
+        const QByteArray blocks = encodeBlocks(result.blocks);
+        QMetaObject::invokeMethod(&DatabaseManager::instance(), [key, currentLang, text, blocks]() {
+            DatabaseManager::instance().saveOcrResult(key, currentLang, text, blocks);
+        });
+    }
+    if (!result.text.isEmpty()) return result;
+    return OCRResult{error.isEmpty() ? noText : error, false, {}, !error.isEmpty()};
+}
+
+OCRResult OCRManager::recognizeRegions(const QImage& processed, const QString& lang, bool wholePage, QString* error) {
+    OCRResult result;
+    const QList<QRect> regions = wholePage ? QList<QRect>{ processed.rect() } : TextRegionDetector::detect(processed);
+    if (regions.isEmpty()) return result;   // 没有墨迹，不必调用引擎
+
+    // 分块只对进程内引擎有利：回退到可执行文件时每块都要启动一次进程并重新加载模型，
+    // 此时整张图按版面分析 (psm 3) 只识别一次
+    if (!hasInProcessEngine() || (regions.size() == 1 && regions.first() == processed.rect())) {
+        result.text = runEngine(processed, lang, kPsmAuto, error, wholePage ? nullptr : &result.blocks);
+        return result;
+    }
+
+    // 各块在识别线程池中并行；blockingMapped 的调用线程自身也会处理任务，池中线程全部占满时也不会死锁
+    struct Piece {
+        QString text;
+        QString error;
+    };
+    // 池中其他线程按调用方的优先级处理各块：后台补全降低了调用线程的优先级，分出去的块也不能以正常优先级运行
+    const QThread::Priority priority = QThread::currentThread()->priority();
+    const QList<Piece> pieces = QtConcurrent::blockingMapped(&m_pool, regions, [&processed, &lang, priority](const QRect& rect) {
+        QThread* thread = QThread::currentThread();
+        const QThread::Priority previous = thread->priority();
+        if (previous != priority) thread->setPriority(priority);
+        Piece piece;
+        piece.text = runEngine(processed.copy(rect), lang, kPsmSingleBlock, &piece.error);
+        if (previous != priority) thread->setPriority(previous);
+        return piece;
+    });
+    for (int i = 0; i < regions.size(); ++i) {
+        if (!pieces[i].text.isEmpty()) {
+            result.blocks.append(OCRBlock{regions[i], pieces[i].text});
+        } else if (error->isEmpty()) {
+            *error = pieces[i].error;
+        }
+    }
+    qDebug() << "[OCRManager] 分块识别:" << regions.size() << "个候选块，" << result.blocks.size() << "个有文字";
+    result.text = joinInReadingOrder(result.blocks);
+    return result;
+}
+
+QString OCRManager::joinInReadingOrder(QList<OCRBlock>& blocks) {
+    // 按上边缘排序后分行：竖直中心落在当前行范围内的块归入同一行，行内自左向右
+    std::sort(blocks.begin(), blocks.end(), [](const OCRBlock& a, const OCRBlock& b) {
+        return a.rect.top() < b.rect.top();
+    });
+    QList<QList<OCRBlock>> rows;
+    int rowTop = 0, rowBottom = -1;
+    for (const OCRBlock& block : std::as_const(blocks)) {
+        const int center = block.rect.center().y();
+        if (rows.isEmpty() || center < rowTop || center > rowBottom) {
+            rows.append(QList<OCRBlock>());
+            rowTop = block.rect.top();
+            rowBottom = block.rect.bottom();
+        } else {
+            rowBottom = qMax(rowBottom, block.rect.bottom());
+        }
+        rows.last().append(block);
+    }
+
+    blocks.clear();
+    QStringList lines;
+    for (QList<OCRBlock>& row : rows) {
+        std::sort(row.begin(), row.end(), [](const OCRBlock& a, const OCRBlock& b) {
+            return a.rect.left() < b.rect.left();
+        });
+        QStringList parts;
+        for (const OCRBlock& block : std::as_const(row)) {
+            parts << block.text;
+            blocks.append(block);
+        }
+        lines << parts.join("    ");
+    }
+    return lines.join('\n');
+}
+
+void OCRManager::recognizeSync(const QImage& image, int contextId) {
+    qDebug() << "[OCRManager] recognizeSync: 开始识别 ID:" << contextId 
+             << "线程:" << QThread::currentThread();
+    const QString result = recognizeText(image);
     
     qDebug() << "[OCRManager] recognizeSync: 识别完成 ID:" << contextId 
              << "结果长度:" << result.length() << "线程:" << QThread::currentThread();
@@ -337,4 +546,4 @@ void OCRManager::recognizeSync(const QImage& image, int contextId) {
     } catch (...) {
         qDebug() << "[OCRManager] 异常: 发送信号时出现未知错误 ID:" << contextId;
     }
-}
\ No newline at end of file
+}
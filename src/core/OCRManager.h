@@ -3,12 +3,69 @@
 #include <QObject>
 #include <QImage>
 #include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QFuture>
+#include <QMutex>
+#include <QCache>
+#include <QRect>
+#include <QList>
+#include <atomic>
+#include "ImagePreprocessor.h"
 
+// 一个文字块及其在原图中的位置
+struct OCRBlock {
+    QRect rect;
+    QString text;
+};
+
+struct OCRResult {
+    QString text;              // 按阅读顺序拼接的全文 (出错时为错误信息)
+    bool success = false;      // false 时 text 为错误或"未识别出文字"的提示
+    QList<OCRBlock> blocks;    // 可能为空：出错、开启倾斜校正或回退到可执行文件识别整页时没有位置
+    bool transient = false;    // 引擎出错 (启动失败、超时等)，与图中无字不同，稍后重试可能成功
+};
+
+/**
+ * @brief Tesseract 文字识别
+ *
+ * 构建时找到 libtesseract (定义 RAPIDNOTES_HAVE_TESSERACT) 则在进程内识别：专用线程池的每个线程各持有
+ * 一个已加载模型的 TessBaseAPI，线程不过期，模型只在首次使用或语言变化时加载。否则回退到调用 tesseract
+ * 可执行文件。可执行文件与 tessdata 的探测结果全程缓存，Windows 与 Linux 均可用。
+ * 随附 tesseract.exe 的 Windows 构建通常不链接 libtesseract：那里没有常驻引擎，每张图仍要写一个临时 BMP、
+ * 启动一次进程并加载一次模型。
+ *
+ * 识别结果按 (灰度像素、识别语言、预处理选项) 的哈希缓存：内存中保留最近使用的条目，同时写入数据库
+ * ocr_cache 表，下次启动后同一张图仍可命中。查缓存在识别线程中、预处理之前进行，命中时不再预处理和识别。
+ *
+ * 预处理后先用 TextRegionDetector 找出文字块：使用进程内引擎且块数有限时，各块裁剪后按单块模式 (psm 6)
+ * 并行识别，再按阅读顺序 (自上而下分行、行内自左向右) 拼接；密集文档仍按整页版面分析 (psm 3) 识别。
+ * 回退到可执行文件时不分块，每张图只启动一次进程、按整页识别，不给出文字块位置。
+ */
 class OCRManager : public QObject {
     Q_OBJECT
 public:
     static OCRManager& instance();
     void recognizeAsync(const QImage& image, int contextId = -1);
+    // 不经 recognitionFinished 广播，结果直接通过 QFuture 交给调用方 (批量调度见 OCRBatch)
+    QFuture<QString> recognize(const QImage& image);
+    // 图片在工作线程中解码，批量导入大量文件时不占用界面线程；无法解码时 success 为 false (不是 transient)
+    QFuture<OCRResult> recognizeFile(const QString& path);
+    // 同 recognize，另带各文字块在原图中的位置
+    QFuture<OCRResult> recognizeLayout(const QImage& image);
+    // 后台补全索引用：在工作线程中解码，识别期间把线程优先级降到最低
+    QFuture<OCRResult> recognizeInBackground(const QByteArray& encoded);
+    // 同时进行的识别数上限 (即识别线程数)
+    int maxConcurrency() const { return m_pool.maxThreadCount(); }
+    // 正在识别的任务数，后台任务据此避让前台识别
+    int activeCount() const { return m_pool.activeThreadCount(); }
+    // 可进行识别：进程内引擎已编译进来，或找到了 tesseract 可执行文件
+    static bool isAvailable();
+    // 进程内引擎已编译进来且没有初始化失败；否则每次识别都要启动 tesseract 进程
+    static bool hasInProcessEngine();
+    // 本次运行的缓存命中 / 未命中次数
+    int cacheHits() const { return m_cacheHits.load(); }
+    int cacheMisses() const { return m_cacheMisses.load(); }
     
     // 设置 OCR 识别语言（默认: "chi_sim+eng"）
     // 可用语言见 traineddata 文件，多语言用 + 连接
@@ -17,15 +74,49 @@ public:
     QString getLanguage() const;
 
 private:
+    // 一次探测的结果，之后所有识别共用
+    struct TessEnvironment {
+        QString dataPath;       // tessdata 目录
+        QString executable;     // 回退路径使用的 tesseract 可执行文件
+        QStringList languages;  // tessdata 中按优先级选出的语言
+    };
+    static const TessEnvironment& environment();
+    // psm 为 Tesseract 的页面分割模式编号；lines 非空时 (仅进程内引擎) 输出各文本行的位置
+    static QString runEngine(const QImage& processed, const QString& lang, int psm, QString* error,
+                             QList<OCRBlock>* lines = nullptr);
+    static QString runProcess(const QImage& processed, const QString& lang, int psm, QString* error);
+    static constexpr int kPsmAuto = 3;
+    static constexpr int kPsmSingleBlock = 6;
+
     void recognizeSync(const QImage& image, int contextId);
-    QImage preprocessImage(const QImage& original);
+    QString recognizeText(const QImage& image);
+    OCRResult recognizeResult(const QImage& image);
+    OCRResult recognizeRegions(const QImage& processed, const QString& lang, bool wholePage, QString* error);
+    static QString joinInReadingOrder(QList<OCRBlock>& blocks);
+    static QByteArray encodeBlocks(const QList<OCRBlock>& blocks);
+    static QList<OCRBlock> decodeBlocks(const QByteArray& data);
+    static ImagePreprocessor::Options preprocessOptions();
+    static QByteArray cacheKey(const QImage& gray, const QString& lang, const ImagePreprocessor::Options& options);
+    void ensureCacheLoaded();
 
 signals:
     void recognitionFinished(const QString& text, int contextId);
 
 private:
     OCRManager(QObject* parent = nullptr);
+    // 模型常驻内存，每个引擎占用上百 MB，线程数不宜过多
+    static constexpr int kMaxEngines = 4;
+    static constexpr int kProcessTimeoutMs = 20000;
+    static constexpr int kCacheVersion = 2;   // 识别流程改变时递增，使旧的缓存条目不再命中
+
+    QThreadPool m_pool;
     QString m_language = "chi_sim+eng"; // 默认中文简体+英文
+
+    QMutex m_cacheMutex;
+    QCache<QByteArray, OCRResult> m_cache;   // text 为空表示图中没有文字
+    bool m_cacheLoaded = false;            // 仅在界面线程读写
+    std::atomic<int> m_cacheHits{0};
+    std::atomic<int> m_cacheMisses{0};
 };
 
 #endif // OCRMANAGER_H
\ No newline at end of file
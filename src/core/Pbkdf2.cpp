@@ -0,0 +1,261 @@
+#include "Pbkdf2.h"
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const uint32_t kInit[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t kRound[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline uint32_t load32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+inline void store32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+
+void wipe(void* p, size_t len) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    for (size_t i = 0; i < len; ++i) v[i] = 0;
+}
+
+void compress(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) w[i] = load32(block + 4 * i);
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRound[i] + w[i];
+        const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+// 流式 SHA-256，只用于长度不定的输入 (超长口令、HMAC 首轮的 盐 + 块序号)
+struct Sha256 {
+    uint32_t h[8];
+    uint8_t buffer[64];
+    size_t bufferLen = 0;
+    uint64_t totalLen = 0;
+
+    explicit Sha256(const uint32_t* state = kInit, uint64_t absorbed = 0) : totalLen(absorbed) {
+        memcpy(h, state, sizeof(h));
+    }
+    ~Sha256() { wipe(buffer, sizeof(buffer)); wipe(h, sizeof(h)); }
+
+    void update(const uint8_t* data, size_t len) {
+        totalLen += len;
+        while (len > 0) {
+            if (bufferLen == 0 && len >= 64) {
+                compress(h, data);
+                data += 64;
+                len -= 64;
+                continue;
+            }
+            const size_t n = std::min(64 - bufferLen, len);
+            memcpy(buffer + bufferLen, data, n);
+            bufferLen += n;
+            data += n;
+            len -= n;
+            if (bufferLen == 64) {
+                compress(h, buffer);
+                bufferLen = 0;
+            }
+        }
+    }
+
+    void final(uint8_t out[32]) {
+        const uint64_t bits = totalLen * 8;
+        buffer[bufferLen++] = 0x80;
+        if (bufferLen > 56) {
+            memset(buffer + bufferLen, 0, 64 - bufferLen);
+            compress(h, buffer);
+            bufferLen = 0;
+        }
+        memset(buffer + bufferLen, 0, 56 - bufferLen);
+        for (int i = 0; i < 8; ++i) buffer[56 + i] = uint8_t(bits >> (56 - 8 * i));
+        compress(h, buffer);
+        for (int i = 0; i < 8; ++i) store32(out + 4 * i, h[i]);
+    }
+};
+
+// 口令已吸收 ipad / opad 的内外层中间状态
+struct HmacKey {
+    uint32_t inner[8];
+    uint32_t outer[8];
+
+    HmacKey(const uint8_t* key, size_t keyLen) {
+        uint8_t k[64] = {0};
+        if (keyLen > 64) {
+            Sha256 hash;
+            hash.update(key, keyLen);
+            hash.final(k);
+        } else if (keyLen > 0) {
+            memcpy(k, key, keyLen);
+        }
+        uint8_t pad[64];
+        for (int i = 0; i < 64; ++i) pad[i] = k[i] ^ 0x36;
+        memcpy(inner, kInit, sizeof(inner));
+        compress(inner, pad);
+        for (int i = 0; i < 64; ++i) pad[i] = k[i] ^ 0x5c;
+        memcpy(outer, kInit, sizeof(outer));
+        compress(outer, pad);
+        wipe(k, sizeof(k));
+        wipe(pad, sizeof(pad));
+    }
+    ~HmacKey() { wipe(inner, sizeof(inner)); wipe(outer, sizeof(outer)); }
+
+    // block 前 32 字节为消息，后 32 字节为预先写好的填充与长度 (64 + 32 字节 = 768 位)；
+    // 结果写回 block 前 32 字节，可直接作为下一轮的消息
+    void digest32(uint8_t block[64]) const {
+        uint32_t s[8];
+        memcpy(s, inner, sizeof(s));
+        compress(s, block);
+        for (int i = 0; i < 8; ++i) store32(block + 4 * i, s[i]);
+        memcpy(s, outer, sizeof(s));
+        compress(s, block);
+        for (int i = 0; i < 8; ++i) store32(block + 4 * i, s[i]);
+    }
+};
+
+void initDigestBlock(uint8_t block[64]) {
+    memset(block, 0, 64);
+    block[32] = 0x80;
+    block[62] = 0x03;   // 768 位
+}
+
+} // namespace
+
+bool Pbkdf2::deriveHmacSha256(const uint8_t* password, size_t passwordLen,
+                              const uint8_t* salt, size_t saltLen, uint32_t iterations,
+                              uint8_t* out, size_t outLen, const ProgressCallback& progress) {
+    if (iterations == 0 || outLen == 0) return false;
+
+    const HmacKey key(password, passwordLen);
+    const uint32_t blocks = static_cast<uint32_t>((outLen + 31) / 32);
+    const uint64_t total = uint64_t(blocks) * iterations;
+    const uint32_t step = std::max<uint32_t>(1, iterations / 100);
+
+    uint8_t block[64];
+    uint8_t t[32];
+    uint64_t done = 0;
+    for (uint32_t index = 1; index <= blocks; ++index) {
+        // U1 = HMAC(P, S || INT(index))
+        initDigestBlock(block);
+        {
+            Sha256 inner(key.inner, 64);
+            uint8_t counter[4];
+            store32(counter, index);
+            inner.update(salt, saltLen);
+            inner.update(counter, 4);
+            inner.final(block);
+            uint32_t s[8];
+            memcpy(s, key.outer, sizeof(s));
+            compress(s, block);
+            for (int i = 0; i < 8; ++i) store32(block + 4 * i, s[i]);
+        }
+        memcpy(t, block, 32);
+
+        // U2..Uc，T = U1 ^ U2 ^ ... ^ Uc
+        for (uint32_t i = 1; i < iterations; ++i) {
+            key.digest32(block);
+            for (int j = 0; j < 32; ++j) t[j] ^= block[j];
+            if (progress && i % step == 0 && !progress(done + i, total)) {
+                wipe(block, sizeof(block));
+                wipe(t, sizeof(t));
+                return false;
+            }
+        }
+        done += iterations;
+
+        const size_t offset = size_t(index - 1) * 32;
+        memcpy(out + offset, t, std::min<size_t>(32, outLen - offset));
+    }
+    wipe(block, sizeof(block));
+    wipe(t, sizeof(t));
+    if (progress) progress(total, total);
+    return true;
+}
+
+uint32_t Pbkdf2::calibrate(int targetMs) {
+    const uint8_t password[] = "calibrate";
+    const uint8_t salt[16] = {0};
+    uint8_t out[32];
+
+    // 测量时间过短时误差大，逐步放大探测轮数直到耗时足够
+    uint32_t probe = 4096;
+    double elapsedMs = 0.0;
+    for (;;) {
+        const auto start = std::chrono::steady_clock::now();
+        deriveHmacSha256(password, sizeof(password) - 1, salt, sizeof(salt), probe, out, sizeof(out));
+        elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsedMs >= 40.0 || probe >= kMaxIterations / 4) break;
+        probe *= 4;
+    }
+
+    const double iterations = probe / std::max(elapsedMs, 0.001) * std::max(targetMs, 1);
+    const uint64_t rounded = static_cast<uint64_t>(iterations / 1000.0) * 1000;
+    return static_cast<uint32_t>(std::clamp<uint64_t>(rounded, kMinIterations, kMaxIterations));
+}
+
+bool Pbkdf2::selfTest() {
+    struct Vector {
+        const char* password;
+        const char* salt;
+        uint32_t iterations;
+        std::vector<uint8_t> expected;
+    };
+    const Vector vectors[] = {
+        // RFC 7914 第 11 节
+        { "passwd", "salt", 1, {
+            0x55, 0xac, 0x04, 0x6e, 0x56, 0xe3, 0x08, 0x9f, 0xec, 0x16, 0x91, 0xc2, 0x25, 0x44, 0xb6, 0x05,
+            0xf9, 0x41, 0x85, 0x21, 0x6d, 0xde, 0x04, 0x65, 0xe6, 0x8b, 0x9d, 0x57, 0xc2, 0x0d, 0xac, 0xbc,
+            0x49, 0xca, 0x9c, 0xcc, 0xf1, 0x79, 0xb6, 0x45, 0x99, 0x16, 0x64, 0xb3, 0x9d, 0x77, 0xef, 0x31,
+            0x7c, 0x71, 0xb8, 0x45, 0xb1, 0xe3, 0x0b, 0xd5, 0x09, 0x11, 0x20, 0x41, 0xd3, 0xa1, 0x97, 0x83 } },
+        // RFC 6070 的输入换用 SHA-256
+        { "password", "salt", 4096, {
+            0xc5, 0xe4, 0x78, 0xd5, 0x92, 0x88, 0xc8, 0x41, 0xaa, 0x53, 0x0d, 0xb6, 0x84, 0x5c, 0x4c, 0x8d,
+            0x96, 0x28, 0x93, 0xa0, 0x01, 0xce, 0x4e, 0x11, 0xa4, 0x96, 0x38, 0x73, 0xaa, 0x98, 0x13, 0x4a } },
+        { "passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, {
+            0x34, 0x8c, 0x89, 0xdb, 0xcb, 0xd3, 0x2b, 0x2f, 0x32, 0xd8, 0x14, 0xb8, 0x11, 0x6e, 0x84, 0xcf,
+            0x2b, 0x17, 0x34, 0x7e, 0xbc, 0x18, 0x00, 0x18, 0x1c, 0x4e, 0x2a, 0x1f, 0xb8, 0xdd, 0x53, 0xe1,
+            0xc6, 0x35, 0x51, 0x8c, 0x7d, 0xac, 0x47, 0xe9 } },
+    };
+
+    for (const Vector& v : vectors) {
+        std::vector<uint8_t> out(v.expected.size());
+        if (!deriveHmacSha256(reinterpret_cast<const uint8_t*>(v.password), strlen(v.password),
+                              reinterpret_cast<const uint8_t*>(v.salt), strlen(v.salt),
+                              v.iterations, out.data(), out.size())) {
+            return false;
+        }
+        if (out != v.expected) return false;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef PBKDF2_H
+#define PBKDF2_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief PBKDF2-HMAC-SHA256 密钥派生 (RFC 8018)
+ *
+ * HMAC 的内外层在口令吸收完 ipad/opad 后各保存一份 SHA-256 中间状态，
+ * 此后每轮迭代只需两次固定格式的单块压缩，循环内没有任何内存分配与哈希对象构造。
+ * 迭代次数由 calibrate() 按本机速度测定，写入文件头随密文保存。
+ */
+class Pbkdf2 {
+public:
+    // 进度回调：done/total 为已完成/总迭代次数，返回 false 取消
+    using ProgressCallback = std::function<bool(uint64_t done, uint64_t total)>;
+
+    static constexpr uint32_t kMinIterations = 100000;
+    static constexpr uint32_t kMaxIterations = 50000000;   // 解密时拒绝更大的值，防止恶意文件头卡死进程
+
+    // 取消时返回 false，out 内容无意义
+    static bool deriveHmacSha256(const uint8_t* password, size_t passwordLen,
+                                 const uint8_t* salt, size_t saltLen, uint32_t iterations,
+                                 uint8_t* out, size_t outLen, const ProgressCallback& progress = nullptr);
+
+    // 测量本机速度，返回派生一次约耗时 targetMs 的迭代次数 (不低于 kMinIterations)
+    static uint32_t calibrate(int targetMs);
+
+    // RFC 7914 第 11 节测试向量
+    static bool selfTest();
+};
+
+#endif // PBKDF2_H
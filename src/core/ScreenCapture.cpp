@@ -0,0 +1,50 @@
+#include "ScreenCapture.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QPixmap>
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QDebug>
+
+QRect ScreenCapture::Frame::toPixels(const QRectF& logical) const {
+    return QRectF(logical.topLeft() * dpr, logical.size() * dpr).toAlignedRect().intersected(image.rect());
+}
+
+ScreenCapture::Frame ScreenCapture::grabAllScreens() {
+    QElapsedTimer timer;
+    timer.start();
+    Frame frame;
+    const QList<QScreen*> screens = QGuiApplication::screens();
+    if (screens.isEmpty()) return frame;
+
+    for (QScreen* screen : screens) {
+        frame.geometry |= screen->geometry();
+        frame.dpr = qMax(frame.dpr, screen->devicePixelRatio());
+    }
+
+    if (screens.size() == 1) {
+        // 单屏：抓取结果本身就是共享缓冲，不再拼合
+        frame.dpr = screens.first()->devicePixelRatio();
+        frame.image = screens.first()->grabWindow(0).toImage();
+    } else {
+        const QSize size = (QSizeF(frame.geometry.size()) * frame.dpr).toSize();
+        frame.image = QImage(size, QImage::Format_RGB32);
+        frame.image.fill(Qt::black);   // 屏幕排布不成矩形时的空隙
+        QPainter painter(&frame.image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        for (QScreen* screen : screens) {
+            const QRect g = screen->geometry();
+            const QRect target = QRectF(QPointF(g.topLeft() - frame.geometry.topLeft()) * frame.dpr,
+                                        QSizeF(g.size()) * frame.dpr).toAlignedRect();
+            // 缩放比例低于最大值的屏幕在此放大到统一比例，其余按原像素拷贝
+            painter.drawPixmap(target, screen->grabWindow(0));
+        }
+    }
+    frame.image.setDevicePixelRatio(frame.dpr);
+
+    qDebug().noquote() << QString("[ScreenCapture] %1 个屏幕，%2x%3 (缩放 %4)，%5 MB，耗时 %6 ms")
+                              .arg(screens.size()).arg(frame.image.width()).arg(frame.image.height())
+                              .arg(frame.dpr).arg(frame.image.sizeInBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                              .arg(timer.elapsed());
+    return frame;
+}
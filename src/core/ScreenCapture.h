@@ -0,0 +1,27 @@
+#ifndef SCREENCAPTURE_H
+#define SCREENCAPTURE_H
+
+#include <QImage>
+#include <QRect>
+
+/**
+ * @brief 截取整个虚拟桌面 (所有屏幕)
+ *
+ * 各屏幕的抓取结果按逻辑坐标拼入一张共享的 QImage (物理像素，缩放比例取所有屏幕中最大的)，
+ * 截屏界面的绘制、选区导出与马赛克都直接读这一块缓冲，不再另外转换或复制整屏。单屏时直接使用抓取结果。
+ */
+class ScreenCapture {
+public:
+    struct Frame {
+        QImage image;       // 已设置 devicePixelRatio
+        QRect geometry;     // 虚拟桌面的逻辑坐标范围
+        qreal dpr = 1.0;
+        bool isNull() const { return image.isNull(); }
+        // 逻辑坐标 (相对虚拟桌面左上角) 对应的像素范围
+        QRect toPixels(const QRectF& logical) const;
+    };
+
+    static Frame grabAllScreens();
+};
+
+#endif // SCREENCAPTURE_H
@@ -0,0 +1,66 @@
+#include "ScreenshotPipeline.h"
+#include "DatabaseManager.h"
+#include "OCRManager.h"
+#include "OCRBatch.h"
+#include <QtConcurrent>
+#include <QBuffer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+struct EncodedImage {
+    QByteArray data;   // PNG
+    QByteArray key;    // 去重键
+};
+
+EncodedImage encodePng(const QImage& image) {
+    EncodedImage encoded;
+    QBuffer buffer(&encoded.data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "PNG")) return {};
+    encoded.key = DatabaseManager::computeContentKey(encoded.data);
+    return encoded;
+}
+} // namespace
+
+ScreenshotPipeline::ScreenshotPipeline(QObject* parent) : QObject(parent), m_ocr(new OCRBatch(this)) {
+    // 常驻队列：每批识别完后清空，已完成任务的记录不随运行时间累积
+    connect(m_ocr, &OCRBatch::finished, m_ocr, &OCRBatch::cancel);
+    connect(m_ocr, &OCRBatch::itemFinished, this, [](int, const OCRResult& result, const QVariant& tag) {
+        const int noteId = tag.toInt();
+        // 引擎出错时交给后台索引按退避重试，不写入错误提示
+        if (result.transient) {
+            DatabaseManager::instance().markNoteOcrFailed(noteId);
+            return;
+        }
+        DatabaseManager::instance().setNoteOcrText(noteId, result.success ? result.text : QString(),
+                                                   result.success ? DatabaseManager::kOcrDone : DatabaseManager::kOcrNoText);
+    });
+}
+
+void ScreenshotPipeline::submit(const QImage& image) {
+    if (image.isNull()) return;
+    QElapsedTimer timer;
+    timer.start();
+
+    const QString title = "[截屏] " + QDateTime::currentDateTime().toString("MMdd_HHmm");
+    const int noteId = DatabaseManager::instance().addPendingImageNote(title, "[截屏]", QStringList() << "截屏");
+    if (noteId <= 0) return;
+
+    QtConcurrent::run(encodePng, image).then(this, [noteId, timer](const EncodedImage& encoded) {
+        DatabaseManager& db = DatabaseManager::instance();
+        // 图片没能写入时删掉占位，不留下一条没有图片、永远不会被补全的笔记
+        if (encoded.data.isEmpty() || !db.attachNoteImage(noteId, encoded.data, encoded.key)) {
+            qWarning().noquote() << QString("[ScreenshotPipeline] 笔记 %1 的截屏%2失败，已删除占位笔记")
+                                        .arg(noteId).arg(encoded.data.isEmpty() ? "编码" : "保存");
+            db.deleteNote(noteId);
+            return;
+        }
+        qDebug().noquote() << QString("[ScreenshotPipeline] 笔记 %1 已保存截屏：%2 KB，耗时 %3 ms")
+                                  .arg(noteId).arg(encoded.data.size() / 1024).arg(timer.elapsed());
+    });
+
+    // 识别直接用内存中的图像，不等编码完成
+    m_ocr->add(image, noteId);
+}
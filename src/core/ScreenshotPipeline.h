@@ -0,0 +1,28 @@
+#ifndef SCREENSHOTPIPELINE_H
+#define SCREENSHOTPIPELINE_H
+
+#include <QObject>
+#include <QImage>
+
+class OCRBatch;
+
+/**
+ * @brief 截屏保存为笔记
+ *
+ * submit() 在界面线程中只插入一条不带图片的占位笔记 (列表中立即可见) 即返回，截屏界面随即关闭；
+ * PNG 编码与内容哈希在线程池中进行，完成后回到界面线程补上图片。文字识别与编码同时开始，经常驻的
+ * OCRBatch 排队 (连续截屏时同时进行的识别数有上限)，结果写入笔记的 ocr_text (纳入全文索引)；
+ * 未识别出文字时只标记状态，引擎出错时标记为待重试交给后台索引，都不写入错误提示。
+ * 编码或写入图片失败时删除占位笔记；占位删除后才到达的识别结果因笔记不存在而被忽略。
+ */
+class ScreenshotPipeline : public QObject {
+    Q_OBJECT
+public:
+    explicit ScreenshotPipeline(QObject* parent = nullptr);
+    void submit(const QImage& image);
+
+private:
+    OCRBatch* m_ocr = nullptr;
+};
+
+#endif // SCREENSHOTPIPELINE_H
@@ -0,0 +1,114 @@
+#include "TextFileClassifier.h"
+#include <QFile>
+#include <QStringEncoder>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TFC_HAVE_SSE2 1
+#endif
+
+TextFileClassifier::Kind TextFileClassifier::classify(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return Kind::Binary;
+    return classifyHead(file.read(kSniffSize));
+}
+
+TextFileClassifier::Kind TextFileClassifier::classifyHead(const QByteArray& head) {
+    if (head.isEmpty()) return Kind::Utf8;
+
+    // BOM 优先：UTF-16 文本本身就含大量 NUL，必须在 NUL 检测之前识别
+    if (head.startsWith("\xEF\xBB\xBF")) return Kind::Utf8Bom;
+    if (head.startsWith("\xFF\xFE")) return Kind::Utf16LE;
+    if (head.startsWith("\xFE\xFF")) return Kind::Utf16BE;
+
+    if (containsNul(head.constData(), head.size())) return Kind::Binary;
+
+    // 块可能截断在多字节字符中间，末尾残缺不算非法
+    if (isValidUtf8(head.constData(), head.size(), true)) return Kind::Utf8;
+    return systemIsGbk() && looksLikeGbk(head.constData(), head.size()) ? Kind::Gbk : Kind::Legacy;
+}
+
+bool TextFileClassifier::containsNul(const char* data, qsizetype len) {
+    qsizetype i = 0;
+#ifdef TFC_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))) return true;
+    }
+#endif
+    return std::memchr(data + i, 0, static_cast<size_t>(len - i)) != nullptr;
+}
+
+bool TextFileClassifier::isValidUtf8(const char* data, qsizetype len, bool allowTruncatedTail) {
+    Utf8Validator validator;
+    return validator.feed(data, len) && (allowTruncatedTail || validator.finish());
+}
+
+bool TextFileClassifier::Utf8Validator::feed(const char* data, qsizetype len) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+    qsizetype i = 0;
+    while (i < len) {
+        if (m_need > 0) {
+            const unsigned char cc = s[i++];
+            if (cc < m_lo || cc > m_hi) return false;
+            m_lo = 0x80; m_hi = 0xBF;
+            --m_need;
+            continue;
+        }
+#ifdef TFC_HAVE_SSE2
+        // ASCII 段：16 字节的最高位全为 0 时整块跳过
+        while (i + 16 <= len &&
+               _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))) == 0) {
+            i += 16;
+        }
+        if (i >= len) break;
+#endif
+        const unsigned char c = s[i++];
+        if (c < 0x80) continue;
+
+        // 第二字节的合法范围 (排除过长编码与代理区)
+        if (c >= 0xC2 && c <= 0xDF) {
+            m_need = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            m_need = 2;
+            if (c == 0xE0) m_lo = 0xA0;
+            else if (c == 0xED) m_hi = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            m_need = 3;
+            if (c == 0xF0) m_lo = 0x90;
+            else if (c == 0xF4) m_hi = 0x8F;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextFileClassifier::looksLikeGbk(const char* data, qsizetype len) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+    qsizetype i = 0;
+    while (i < len) {
+        const unsigned char c = s[i];
+        if (c < 0x80) { ++i; continue; }
+        if (c == 0x80 || c == 0xFF) return false;
+        if (i + 1 >= len) return true;
+        const unsigned char c2 = s[i + 1];
+        if (c2 >= 0x30 && c2 <= 0x39) {
+            // GB18030 四字节：lead 0x30-0x39 lead 0x30-0x39
+            if (i + 3 >= len) return true;
+            if (s[i + 2] < 0x81 || s[i + 2] == 0xFF || s[i + 3] < 0x30 || s[i + 3] > 0x39) return false;
+            i += 4;
+        } else {
+            if (c2 < 0x40 || c2 == 0x7F || c2 == 0xFF) return false;
+            i += 2;
+        }
+    }
+    return true;
+}
+
+bool TextFileClassifier::systemIsGbk() {
+    static const bool gbk = QStringEncoder(QStringConverter::System).encode(QStringLiteral("\u4E2D")) == QByteArray("\xD6\xD0");
+    return gbk;
+}
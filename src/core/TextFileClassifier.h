@@ -0,0 +1,54 @@
+#ifndef TEXTFILECLASSIFIER_H
+#define TEXTFILECLASSIFIER_H
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @brief 文本/二进制判别与编码嗅探
+ *
+ * 只读取文件头部一个块 (kSniffSize)，依次判断 BOM、NUL 字节与 UTF-8 合法性。
+ * NUL 检测使用 SSE2 每次处理 16 字节；UTF-8 校验只有纯 ASCII 段用 SSE2 整块跳过，
+ * 遇到非 ASCII 字节仍逐字节做标量校验。不支持 SSE2 时全部退回标量实现。
+ *
+ * 头部不是合法 UTF-8 时：系统本地编码为 GBK 且字节结构符合 GBK/GB18030 才判为 Gbk，
+ * 其余 (Latin-1、Windows-1252、Shift-JIS 等) 判为 Legacy，由调用方按系统本地编码整体解码处理。
+ * 嗅探只覆盖头部，判为 Utf8 的文件在后续流式读取时应继续用 Utf8Validator 校验。
+ */
+class TextFileClassifier {
+public:
+    enum class Kind { Binary, Utf8, Utf8Bom, Utf16LE, Utf16BE, Gbk, Legacy };
+
+    static constexpr qint64 kSniffSize = 4096;
+
+    static Kind classify(const QString& filePath);
+    static Kind classifyHead(const QByteArray& head);
+
+    static bool isText(Kind kind) { return kind != Kind::Binary; }
+
+    // 检查是否含 NUL 字节
+    static bool containsNul(const char* data, qsizetype len);
+    // 校验 UTF-8 合法性；allowTruncatedTail 为 true 时容忍末尾被截断的多字节序列 (块边界)
+    static bool isValidUtf8(const char* data, qsizetype len, bool allowTruncatedTail = false);
+    // 字节结构符合 GBK/GB18030 (末尾截断的多字节字符不算错)
+    static bool looksLikeGbk(const char* data, qsizetype len);
+    // 系统本地编码是否为 GBK 系 (简体中文 Windows 的 CP936)
+    static bool systemIsGbk();
+
+    /**
+     * @brief 分块增量校验 UTF-8
+     *
+     * 多字节序列可以跨越 feed() 的调用边界；feed 返回 false 表示遇到非法序列，之后不应再使用。
+     * 全部数据送完后 finish() 为 false 表示文件末尾有残缺的序列。
+     */
+    class Utf8Validator {
+    public:
+        bool feed(const char* data, qsizetype len);
+        bool finish() const { return m_need == 0; }
+    private:
+        int m_need = 0;                          // 当前序列还差的后续字节数
+        unsigned char m_lo = 0x80, m_hi = 0xBF;  // 下一个后续字节的合法范围
+    };
+};
+
+#endif // TEXTFILECLASSIFIER_H
@@ -0,0 +1,91 @@
+#include "TextRegionDetector.h"
+#include <vector>
+
+QList<QRect> TextRegionDetector::detect(const QImage& processed) {
+    if (processed.isNull()) return {};
+    const QImage gray = processed.convertToFormat(QImage::Format_Grayscale8);
+    const int w = gray.width();
+    const int h = gray.height();
+    const int gw = (w + kCell - 1) / kCell;
+    const int gh = (h + kCell - 1) / kCell;
+
+    // 1. 墨迹格子：格内任一像素足够暗即标记
+    std::vector<uchar> mask(static_cast<size_t>(gw) * gh, 0);
+    for (int y = 0; y < h; ++y) {
+        const uchar* line = gray.constScanLine(y);
+        uchar* cells = mask.data() + static_cast<size_t>(y / kCell) * gw;
+        for (int x = 0; x < w; ++x) {
+            if (line[x] < kInkThreshold) cells[x / kCell] = 1;
+        }
+    }
+
+    // 2. 游程平滑：两侧都有墨迹且间隔不超过阈值的空白格填平，字连成行、行连成段
+    auto smear = [&mask](int count, int length, size_t stride, size_t step, int gap) {
+        for (int i = 0; i < count; ++i) {
+            uchar* base = mask.data() + static_cast<size_t>(i) * stride;
+            int last = -1;
+            for (int j = 0; j < length; ++j) {
+                if (!base[j * step]) continue;
+                if (last >= 0 && j - last - 1 <= gap) {
+                    for (int k = last + 1; k < j; ++k) base[k * step] = 1;
+                }
+                last = j;
+            }
+        }
+    };
+    smear(gh, gw, gw, 1, kHorizontalGap);
+    smear(gw, gh, 1, gw, kVerticalGap);
+
+    // 3. 四连通分量的外接矩形
+    QList<QRect> regions;
+    std::vector<int> stack;
+    for (int gy = 0; gy < gh; ++gy) {
+        for (int gx = 0; gx < gw; ++gx) {
+            if (mask[static_cast<size_t>(gy) * gw + gx] != 1) continue;
+            int x0 = gx, x1 = gx, y0 = gy, y1 = gy;
+            mask[static_cast<size_t>(gy) * gw + gx] = 2;
+            stack.push_back(gy * gw + gx);
+            while (!stack.empty()) {
+                const int index = stack.back();
+                stack.pop_back();
+                const int cx = index % gw;
+                const int cy = index / gw;
+                x0 = qMin(x0, cx); x1 = qMax(x1, cx);
+                y0 = qMin(y0, cy); y1 = qMax(y1, cy);
+                auto visit = [&](int nx, int ny) {
+                    if (nx < 0 || ny < 0 || nx >= gw || ny >= gh) return;
+                    uchar& cell = mask[static_cast<size_t>(ny) * gw + nx];
+                    if (cell != 1) return;
+                    cell = 2;
+                    stack.push_back(ny * gw + nx);
+                };
+                visit(cx - 1, cy); visit(cx + 1, cy); visit(cx, cy - 1); visit(cx, cy + 1);
+            }
+            const QRect box(x0 * kCell, y0 * kCell, (x1 - x0 + 1) * kCell, (y1 - y0 + 1) * kCell);
+            if (box.width() < kMinSide || box.height() < kMinSide) continue;
+            regions << box.adjusted(-kPadding, -kPadding, kPadding, kPadding).intersected(gray.rect());
+        }
+    }
+
+    // 4. 外扩后重叠的块合并，直到没有重叠
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (int i = 0; i < regions.size() && !merged; ++i) {
+            for (int j = i + 1; j < regions.size(); ++j) {
+                if (regions[i].intersects(regions[j])) {
+                    regions[i] = regions[i].united(regions[j]);
+                    regions.removeAt(j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    qint64 covered = 0;
+    for (const QRect& r : std::as_const(regions)) covered += qint64(r.width()) * r.height();
+    if (regions.size() > kMaxRegions || covered > qint64(w) * h * kMaxCoverage) {
+        return { gray.rect() };
+    }
+    return regions;
+}
@@ -0,0 +1,33 @@
+#ifndef TEXTREGIONDETECTOR_H
+#define TEXTREGIONDETECTOR_H
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+
+/**
+ * @brief OCR 前的文字区域检测
+ *
+ * 在预处理后的灰度图 (白底深色字) 上按 4x4 像素格子标记墨迹，水平方向填平字间空隙、竖直方向填平行距，
+ * 再求四连通分量得到候选文字块 (外扩少量边距，重叠的合并)。整屏截图中只有零星文字时，只把这些块交给
+ * Tesseract，不必识别大片空白。
+ *
+ * 返回空列表表示图中没有墨迹；文字块过多或覆盖面积过大 (密集文档) 时返回整图一个矩形，
+ * 由调用方按整页版面分析识别。
+ */
+class TextRegionDetector {
+public:
+    static QList<QRect> detect(const QImage& processed);
+
+private:
+    static constexpr int kCell = 4;              // 格子边长 (像素)
+    static constexpr int kInkThreshold = 128;    // 低于该灰度视为墨迹
+    static constexpr int kHorizontalGap = 6;     // 水平方向填平的空隙 (格)，约为放大后文字的词间距
+    static constexpr int kVerticalGap = 2;       // 竖直方向填平的空隙 (格)，合并同一段落的相邻行
+    static constexpr int kPadding = 8;           // 文字块外扩 (像素)，避免裁掉笔画边缘
+    static constexpr int kMinSide = 8;           // 宽或高小于该值的分量视为噪点
+    static constexpr int kMaxRegions = 64;
+    static constexpr double kMaxCoverage = 0.5;  // 文字块总面积超过该比例时按整页识别
+};
+
+#endif // TEXTREGIONDETECTOR_H
@@ -0,0 +1,207 @@
+#include "WindowDetector.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <dwmapi.h>
+#include <tchar.h>
+#endif
+
+#ifdef RAPIDNOTES_HAVE_X11
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#endif
+
+void WindowRectIndex::clear() {
+    m_bounds = QRect();
+    m_columns = m_rows = 0;
+    m_rects.clear();
+    m_cells.clear();
+}
+
+void WindowRectIndex::build(const QList<QRect>& rects, const QRect& bounds) {
+    clear();
+    if (bounds.isEmpty()) return;
+    m_bounds = bounds;
+    m_columns = (bounds.width() + kCell - 1) / kCell;
+    m_rows = (bounds.height() + kCell - 1) / kCell;
+    m_cells.resize(static_cast<size_t>(m_columns) * m_rows);
+
+    for (const QRect& r : rects) {
+        if (r.intersects(bounds)) m_rects << r;
+    }
+    // 稳定排序：面积相同时保留枚举顺序 (即窗口的叠放顺序)
+    std::stable_sort(m_rects.begin(), m_rects.end(), [](const QRect& a, const QRect& b) {
+        return qint64(a.width()) * a.height() < qint64(b.width()) * b.height();
+    });
+
+    for (int i = 0; i < m_rects.size(); ++i) {
+        const QRect r = m_rects[i].intersected(bounds).translated(-bounds.topLeft());
+        const int c1 = r.right() / kCell;
+        const int r1 = r.bottom() / kCell;
+        for (int row = r.top() / kCell; row <= r1; ++row) {
+            for (int col = r.left() / kCell; col <= c1; ++col) {
+                m_cells[static_cast<size_t>(row) * m_columns + col].push_back(i);
+            }
+        }
+    }
+}
+
+QRect WindowRectIndex::smallestAt(const QPoint& pos) const {
+    if (!m_bounds.contains(pos)) return QRect();
+    const QPoint local = pos - m_bounds.topLeft();
+    const std::vector<int>& cell = m_cells[static_cast<size_t>(local.y() / kCell) * m_columns + local.x() / kCell];
+    for (int index : cell) {
+        if (m_rects[index].contains(pos)) return m_rects[index];
+    }
+    return QRect();
+}
+
+#ifdef Q_OS_WIN
+namespace {
+struct EnumContext {
+    QList<QRect>* rects;
+    const QSet<quintptr>* exclude;
+};
+
+QRect actualWindowRect(HWND hwnd) {
+    RECT rect;
+    if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(rect)))) {
+        return QRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
+    }
+    GetWindowRect(hwnd, &rect);
+    return QRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
+}
+
+BOOL CALLBACK enumChildProc(HWND hwnd, LPARAM lParam) {
+    auto* context = reinterpret_cast<EnumContext*>(lParam);
+    if (IsWindowVisible(hwnd)) {
+        QRect qr = actualWindowRect(hwnd); if (qr.width() > 5 && qr.height() > 5) context->rects->append(qr);
+    }
+    return TRUE;
+}
+
+BOOL CALLBACK enumWindowsProc(HWND hwnd, LPARAM lParam) {
+    auto* context = reinterpret_cast<EnumContext*>(lParam);
+    if (context->exclude->contains(reinterpret_cast<quintptr>(hwnd))) return TRUE;
+    if (IsWindowVisible(hwnd) && !IsIconic(hwnd)) {
+        TCHAR className[256]; GetClassName(hwnd, className, 256);
+        if (_tcscmp(className, _T("Qt662QWindowIcon")) == 0) return TRUE;
+        int cloaked = 0; DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked));
+        if (cloaked) return TRUE;
+        QRect qr = actualWindowRect(hwnd); if (qr.width() > 10 && qr.height() > 10) { context->rects->append(qr); EnumChildWindows(hwnd, enumChildProc, lParam); }
+    }
+    return TRUE;
+}
+
+QList<QRect> enumerateWin32(const QSet<quintptr>& exclude) {
+    QList<QRect> rects;
+    EnumContext context{&rects, &exclude};
+    EnumWindows(enumWindowsProc, reinterpret_cast<LPARAM>(&context));
+    return rects;
+}
+} // namespace
+#endif
+
+#ifdef RAPIDNOTES_HAVE_X11
+namespace {
+// 工作线程中单独打开一个连接，不与 Qt 的 xcb 连接共用
+QList<QRect> enumerateX11(const QSet<quintptr>& exclude) {
+    QList<QRect> rects;
+    Display* display = XOpenDisplay(nullptr);
+    if (!display) return rects;
+    const Window root = DefaultRootWindow(display);
+    const Atom property = XInternAtom(display, "_NET_CLIENT_LIST_STACKING", True);
+    Atom type = None; int format = 0; unsigned long count = 0, remaining = 0; unsigned char* data = nullptr;
+    if (property != None
+        && XGetWindowProperty(display, root, property, 0, 4096, False, XA_WINDOW, &type, &format, &count, &remaining, &data) == Success
+        && data) {
+        const Window* windows = reinterpret_cast<const Window*>(data);
+        // 列表自底向上，倒序使面积相同的矩形中上层窗口在前
+        for (long i = static_cast<long>(count) - 1; i >= 0; --i) {
+            const Window window = windows[i];
+            if (exclude.contains(static_cast<quintptr>(window))) continue;
+            XWindowAttributes attributes;
+            if (!XGetWindowAttributes(display, window, &attributes) || attributes.map_state != IsViewable) continue;
+            int x = 0, y = 0; Window child = None;
+            XTranslateCoordinates(display, window, root, 0, 0, &x, &y, &child);
+            if (attributes.width > 10 && attributes.height > 10) rects << QRect(x, y, attributes.width, attributes.height);
+        }
+        XFree(data);
+    }
+    XCloseDisplay(display);
+    return rects;
+}
+} // namespace
+#endif
+
+QList<WindowDetector::ScreenScale> WindowDetector::screenScales() {
+    QList<ScreenScale> scales;
+    for (QScreen* screen : QGuiApplication::screens()) {
+        // Qt 的屏幕几何保留原生左上角、只按缩放比例缩小尺寸，由此得到该屏在原生坐标中的范围
+        const QRect logical = screen->geometry();
+        const qreal dpr = screen->devicePixelRatio();
+        const QRect native(logical.topLeft(), (QSizeF(logical.size()) * dpr).toSize());
+        scales.append({native, logical, dpr});
+    }
+    return scales;
+}
+
+QList<QRect> WindowDetector::toLogical(const QList<QRect>& nativeRects, const QList<ScreenScale>& scales) {
+    QList<QRect> rects;
+    rects.reserve(nativeRects.size());
+    for (const QRect& r : nativeRects) {
+        // 跨屏窗口按中心点 (不在任何屏上时按重叠面积最大者) 所在屏的比例换算
+        const ScreenScale* best = nullptr;
+        qint64 bestArea = 0;
+        for (const ScreenScale& scale : scales) {
+            if (scale.native.contains(r.center())) { best = &scale; break; }
+            const QRect overlap = scale.native.intersected(r);
+            const qint64 area = qint64(overlap.width()) * overlap.height();
+            if (area > bestArea) { bestArea = area; best = &scale; }
+        }
+        if (!best) continue;
+        const QPointF topLeft = QPointF(best->logical.topLeft()) + QPointF(r.topLeft() - best->native.topLeft()) / best->dpr;
+        rects << QRectF(topLeft, QSizeF(r.size()) / best->dpr).toAlignedRect();
+    }
+    return rects;
+}
+
+WindowDetector::Backend& WindowDetector::customBackend() {
+    static Backend backend;
+    return backend;
+}
+
+void WindowDetector::setBackend(Backend backend) {
+    customBackend() = std::move(backend);
+}
+
+WindowDetector::Backend WindowDetector::defaultBackend() {
+#ifdef Q_OS_WIN
+    return enumerateWin32;
+#else
+#ifdef RAPIDNOTES_HAVE_X11
+    if (QGuiApplication::platformName() == QLatin1String("xcb")) return enumerateX11;
+#endif
+    return {};
+#endif
+}
+
+QFuture<QList<QRect>> WindowDetector::detectAsync(const QSet<quintptr>& exclude) {
+    Backend backend = customBackend() ? customBackend() : defaultBackend();
+    if (!backend) return QtFuture::makeReadyValueFuture(QList<QRect>());
+    // 屏幕信息只能在界面线程读取，先取快照再交给工作线程换算
+    return QtConcurrent::run([backend = std::move(backend), exclude, scales = screenScales()]() {
+        QElapsedTimer timer;
+        timer.start();
+        QList<QRect> rects = toLogical(backend(exclude), scales);
+        qDebug().noquote() << QString("[WindowDetector] 枚举到 %1 个窗口/控件矩形，耗时 %2 ms")
+                                  .arg(rects.size()).arg(timer.elapsed());
+        return rects;
+    });
+}
@@ -0,0 +1,70 @@
+#ifndef WINDOWDETECTOR_H
+#define WINDOWDETECTOR_H
+
+#include <QFuture>
+#include <QList>
+#include <QRect>
+#include <QSet>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief 窗口矩形的均匀网格索引
+ *
+ * 把覆盖范围划分为 kCell 像素见方的格子，每个矩形登记到它覆盖的所有格子中，格内按面积从小到大排列。
+ * 悬停命中只检查鼠标所在的一个格子，取第一个包含该点的矩形即为最小的那个，与窗口总数无关。
+ */
+class WindowRectIndex {
+public:
+    // rects 与 bounds 使用同一坐标系；超出 bounds 的部分不参与命中
+    void build(const QList<QRect>& rects, const QRect& bounds);
+    void clear();
+    // 包含 pos 的最小矩形，没有则返回空矩形
+    QRect smallestAt(const QPoint& pos) const;
+    int size() const { return m_rects.size(); }
+    bool isEmpty() const { return m_rects.isEmpty(); }
+
+private:
+    static constexpr int kCell = 128;
+
+    QRect m_bounds;
+    int m_columns = 0;
+    int m_rows = 0;
+    QList<QRect> m_rects;                 // 按面积升序
+    std::vector<std::vector<int>> m_cells;  // 每格中的矩形下标，同样按面积升序
+};
+
+/**
+ * @brief 截屏时的窗口与控件矩形探测
+ *
+ * 枚举在工作线程中进行，截屏界面先显示并可操作，结果就绪后再启用窗口吸附。
+ * 后端返回系统原生 (物理像素) 坐标，detectAsync 再按各矩形所在屏幕的缩放比例、相对该屏原生左上角
+ * 换算为 Qt 的逻辑全局坐标，与 mapFromGlobal 等命中计算一致；混合 DPI 的多屏环境下各屏分别换算。
+ *
+ * 平台后端：Windows 用 EnumWindows / EnumChildWindows (含子控件)；Linux 在构建时找到 libX11
+ * (定义 RAPIDNOTES_HAVE_X11) 且运行于 xcb 平台时读取窗口管理器的 _NET_CLIENT_LIST_STACKING。
+ * Wayland 不允许枚举其他程序的窗口，默认不返回任何矩形；可用 setBackend 换成其他实现 (如桌面门户)。
+ */
+class WindowDetector {
+public:
+    // exclude 为需要忽略的本程序窗口 (WId)；在工作线程中调用，返回原生 (物理像素) 全局坐标
+    using Backend = std::function<QList<QRect>(const QSet<quintptr>& exclude)>;
+
+    // 替换当前平台的默认后端，传入空函数恢复默认；仅在界面线程调用
+    static void setBackend(Backend backend);
+    // 须在界面线程调用：后端与需要忽略的窗口在此确定，枚举本身在工作线程中进行
+    static QFuture<QList<QRect>> detectAsync(const QSet<quintptr>& exclude = {});
+
+private:
+    struct ScreenScale {
+        QRect native;    // 屏幕在原生坐标中的范围
+        QRect logical;   // QScreen::geometry()
+        qreal dpr;
+    };
+    static QList<ScreenScale> screenScales();
+    static QList<QRect> toLogical(const QList<QRect>& nativeRects, const QList<ScreenScale>& scales);
+    static Backend defaultBackend();
+    static Backend& customBackend();
+};
+
+#endif // WINDOWDETECTOR_H
@@ -0,0 +1,324 @@
+#include "Xxh3.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define XXH3_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t kPrime32_1 = 0x9E3779B1U;
+constexpr uint32_t kPrime32_2 = 0x85EBCA77U;
+constexpr uint32_t kPrime32_3 = 0xC2B2AE3DU;
+constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t kPrimeMx1 = 0x165667919E3779F9ULL;
+constexpr uint64_t kPrimeMx2 = 0x9FB21C651E98DF25ULL;
+
+constexpr size_t kSecretSize = 192;
+constexpr size_t kStripeLen = 64;
+constexpr size_t kSecretConsumeRate = 8;
+constexpr size_t kStripesPerBlock = (kSecretSize - kStripeLen) / kSecretConsumeRate;
+constexpr size_t kBlockLen = kStripeLen * kStripesPerBlock;
+constexpr size_t kSecretLastAccStart = 7;
+constexpr size_t kSecretMergeAccsStart = 11;
+constexpr size_t kMidSizeStartOffset = 3;
+constexpr size_t kMidSizeLastOffset = 17;
+constexpr size_t kSecretSizeMin = 136;
+
+alignas(64) const uint8_t kSecret[kSecretSize] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// 以下按小端读取，与参考实现一致 (x86 / ARM 小端平台上 memcpy 即编译为单条 load)
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t swap32(uint32_t x) {
+    return ((x << 24) & 0xff000000U) | ((x << 8) & 0x00ff0000U) | ((x >> 8) & 0x0000ff00U) | ((x >> 24) & 0x000000ffU);
+}
+
+inline uint64_t swap64(uint64_t x) {
+    return (uint64_t(swap32(uint32_t(x))) << 32) | swap32(uint32_t(x >> 32));
+}
+
+inline uint32_t rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+inline Xxh3::Hash128 mult64to128(uint64_t a, uint64_t b) {
+    Xxh3::Hash128 r;
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    r.low64 = static_cast<uint64_t>(product);
+    r.high64 = static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    r.low64 = _umul128(a, b, &r.high64);
+#else
+    const uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    const uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    const uint64_t hi_hi = (a >> 32) * (b >> 32);
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    r.high64 = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    r.low64 = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+#endif
+    return r;
+}
+
+inline uint64_t mul128Fold64(uint64_t a, uint64_t b) {
+    const Xxh3::Hash128 p = mult64to128(a, b);
+    return p.low64 ^ p.high64;
+}
+
+inline uint64_t xxh64Avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= kPrime64_2;
+    h ^= h >> 29;
+    h *= kPrime64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= kPrimeMx1;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint64_t mix16B(const uint8_t* in, const uint8_t* secret, uint64_t seed) {
+    return mul128Fold64(read64(in) ^ (read64(secret) + seed), read64(in + 8) ^ (read64(secret + 8) - seed));
+}
+
+inline void mix32B(Xxh3::Hash128& acc, const uint8_t* in1, const uint8_t* in2, const uint8_t* secret, uint64_t seed) {
+    acc.low64 += mix16B(in1, secret, seed);
+    acc.low64 ^= read64(in2) + read64(in2 + 8);
+    acc.high64 += mix16B(in2, secret + 16, seed);
+    acc.high64 ^= read64(in1) + read64(in1 + 8);
+}
+
+Xxh3::Hash128 len1to3(const uint8_t* in, size_t len, uint64_t seed) {
+    const uint8_t c1 = in[0];
+    const uint8_t c2 = in[len >> 1];
+    const uint8_t c3 = in[len - 1];
+    const uint32_t combinedl = (uint32_t(c1) << 16) | (uint32_t(c2) << 24) | uint32_t(c3) | (uint32_t(len) << 8);
+    const uint32_t combinedh = rotl32(swap32(combinedl), 13);
+    const uint64_t bitflipl = (read32(kSecret) ^ read32(kSecret + 4)) + seed;
+    const uint64_t bitfliph = (read32(kSecret + 8) ^ read32(kSecret + 12)) - seed;
+    Xxh3::Hash128 h;
+    h.low64 = xxh64Avalanche(uint64_t(combinedl) ^ bitflipl);
+    h.high64 = xxh64Avalanche(uint64_t(combinedh) ^ bitfliph);
+    return h;
+}
+
+Xxh3::Hash128 len4to8(const uint8_t* in, size_t len, uint64_t seed) {
+    seed ^= uint64_t(swap32(uint32_t(seed))) << 32;
+    const uint64_t input64 = read32(in) + (uint64_t(read32(in + len - 4)) << 32);
+    const uint64_t bitflip = (read64(kSecret + 16) ^ read64(kSecret + 24)) + seed;
+    Xxh3::Hash128 m = mult64to128(input64 ^ bitflip, kPrime64_1 + (uint64_t(len) << 2));
+    m.high64 += m.low64 << 1;
+    m.low64 ^= m.high64 >> 3;
+    m.low64 ^= m.low64 >> 35;
+    m.low64 *= kPrimeMx2;
+    m.low64 ^= m.low64 >> 28;
+    m.high64 = avalanche(m.high64);
+    return m;
+}
+
+Xxh3::Hash128 len9to16(const uint8_t* in, size_t len, uint64_t seed) {
+    const uint64_t bitflipl = (read64(kSecret + 32) ^ read64(kSecret + 40)) - seed;
+    const uint64_t bitfliph = (read64(kSecret + 48) ^ read64(kSecret + 56)) + seed;
+    const uint64_t inputLo = read64(in);
+    uint64_t inputHi = read64(in + len - 8);
+    Xxh3::Hash128 m = mult64to128(inputLo ^ inputHi ^ bitflipl, kPrime64_1);
+    m.low64 += uint64_t(len - 1) << 54;
+    inputHi ^= bitfliph;
+    m.high64 += inputHi + uint64_t(uint32_t(inputHi)) * (kPrime32_2 - 1);
+    m.low64 ^= swap64(m.high64);
+    Xxh3::Hash128 h = mult64to128(m.low64, kPrime64_2);
+    h.high64 += m.high64 * kPrime64_2;
+    h.low64 = avalanche(h.low64);
+    h.high64 = avalanche(h.high64);
+    return h;
+}
+
+Xxh3::Hash128 len0to16(const uint8_t* in, size_t len, uint64_t seed) {
+    if (len > 8) return len9to16(in, len, seed);
+    if (len >= 4) return len4to8(in, len, seed);
+    if (len > 0) return len1to3(in, len, seed);
+    Xxh3::Hash128 h;
+    h.low64 = xxh64Avalanche(seed ^ read64(kSecret + 64) ^ read64(kSecret + 72));
+    h.high64 = xxh64Avalanche(seed ^ read64(kSecret + 80) ^ read64(kSecret + 88));
+    return h;
+}
+
+Xxh3::Hash128 finishMid(const Xxh3::Hash128& acc, size_t len, uint64_t seed) {
+    Xxh3::Hash128 h;
+    h.low64 = avalanche(acc.low64 + acc.high64);
+    h.high64 = 0 - avalanche(acc.low64 * kPrime64_1 + acc.high64 * kPrime64_4 + (uint64_t(len) - seed) * kPrime64_2);
+    return h;
+}
+
+Xxh3::Hash128 len17to128(const uint8_t* in, size_t len, uint64_t seed) {
+    Xxh3::Hash128 acc;
+    acc.low64 = uint64_t(len) * kPrime64_1;
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96) mix32B(acc, in + 48, in + len - 64, kSecret + 96, seed);
+            mix32B(acc, in + 32, in + len - 48, kSecret + 64, seed);
+        }
+        mix32B(acc, in + 16, in + len - 32, kSecret + 32, seed);
+    }
+    mix32B(acc, in, in + len - 16, kSecret, seed);
+    return finishMid(acc, len, seed);
+}
+
+Xxh3::Hash128 len129to240(const uint8_t* in, size_t len, uint64_t seed) {
+    const size_t rounds = len / 32;
+    Xxh3::Hash128 acc;
+    acc.low64 = uint64_t(len) * kPrime64_1;
+    for (size_t i = 0; i < 4; ++i) mix32B(acc, in + 32 * i, in + 32 * i + 16, kSecret + 32 * i, seed);
+    acc.low64 = avalanche(acc.low64);
+    acc.high64 = avalanche(acc.high64);
+    for (size_t i = 4; i < rounds; ++i) {
+        mix32B(acc, in + 32 * i, in + 32 * i + 16, kSecret + kMidSizeStartOffset + 32 * (i - 4), seed);
+    }
+    mix32B(acc, in + len - 16, in + len - 32, kSecret + kSecretSizeMin - kMidSizeLastOffset - 16, 0 - seed);
+    return finishMid(acc, len, seed);
+}
+
+// ---- 长输入：8 路 64 位累加器，每 1KB 块后扰乱一次 ----
+
+#ifdef XXH3_SSE2
+inline void accumulate512(uint64_t* acc, const uint8_t* in, const uint8_t* secret) {
+    __m128i* xacc = reinterpret_cast<__m128i*>(acc);
+    for (int i = 0; i < 4; ++i) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+        const __m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+        const __m128i dataKey = _mm_xor_si128(data, key);
+        const __m128i dataKeyLo = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i product = _mm_mul_epu32(dataKey, dataKeyLo);
+        const __m128i dataSwap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        xacc[i] = _mm_add_epi64(product, _mm_add_epi64(xacc[i], dataSwap));
+    }
+}
+
+inline void scrambleAcc(uint64_t* acc, const uint8_t* secret) {
+    __m128i* xacc = reinterpret_cast<__m128i*>(acc);
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+    for (int i = 0; i < 4; ++i) {
+        const __m128i a = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+        const __m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+        const __m128i dataKey = _mm_xor_si128(a, key);
+        const __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i prodLo = _mm_mul_epu32(dataKey, prime);
+        const __m128i prodHi = _mm_mul_epu32(dataKeyHi, prime);
+        xacc[i] = _mm_add_epi64(prodLo, _mm_slli_epi64(prodHi, 32));
+    }
+}
+#else
+inline void accumulate512(uint64_t* acc, const uint8_t* in, const uint8_t* secret) {
+    for (int i = 0; i < 8; ++i) {
+        const uint64_t data = read64(in + 8 * i);
+        const uint64_t dataKey = data ^ read64(secret + 8 * i);
+        acc[i ^ 1] += data;
+        acc[i] += uint64_t(uint32_t(dataKey)) * (dataKey >> 32);
+    }
+}
+
+inline void scrambleAcc(uint64_t* acc, const uint8_t* secret) {
+    for (int i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= read64(secret + 8 * i);
+        a *= kPrime32_1;
+        acc[i] = a;
+    }
+}
+#endif
+
+inline void accumulate(uint64_t* acc, const uint8_t* in, size_t stripes) {
+    for (size_t n = 0; n < stripes; ++n) {
+        accumulate512(acc, in + n * kStripeLen, kSecret + n * kSecretConsumeRate);
+    }
+}
+
+uint64_t mergeAccs(const uint64_t* acc, const uint8_t* secret, uint64_t start) {
+    uint64_t result = start;
+    for (int i = 0; i < 4; ++i) {
+        result += mul128Fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+    }
+    return avalanche(result);
+}
+
+Xxh3::Hash128 hashLong(const uint8_t* in, size_t len) {
+    alignas(16) uint64_t acc[8] = {
+        kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1
+    };
+    const size_t blocks = (len - 1) / kBlockLen;
+    for (size_t n = 0; n < blocks; ++n) {
+        accumulate(acc, in + n * kBlockLen, kStripesPerBlock);
+        scrambleAcc(acc, kSecret + kSecretSize - kStripeLen);
+    }
+    const size_t stripes = ((len - 1) - kBlockLen * blocks) / kStripeLen;
+    accumulate(acc, in + blocks * kBlockLen, stripes);
+    accumulate512(acc, in + len - kStripeLen, kSecret + kSecretSize - kStripeLen - kSecretLastAccStart);
+
+    Xxh3::Hash128 h;
+    h.low64 = mergeAccs(acc, kSecret + kSecretMergeAccsStart, uint64_t(len) * kPrime64_1);
+    h.high64 = mergeAccs(acc, kSecret + kSecretSize - sizeof(acc) - kSecretMergeAccsStart, ~(uint64_t(len) * kPrime64_2));
+    return h;
+}
+
+} // namespace
+
+void Xxh3::Hash128::toBytes(uint8_t out[16]) const {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = uint8_t(high64 >> (56 - 8 * i));
+        out[8 + i] = uint8_t(low64 >> (56 - 8 * i));
+    }
+}
+
+Xxh3::Hash128 Xxh3::Hash128::fromBytes(const uint8_t in[16]) {
+    Hash128 h;
+    for (int i = 0; i < 8; ++i) {
+        h.high64 = (h.high64 << 8) | in[i];
+        h.low64 = (h.low64 << 8) | in[8 + i];
+    }
+    return h;
+}
+
+Xxh3::Hash128 Xxh3::hash128(const void* data, size_t len) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    if (len <= 16) return len0to16(in, len, 0);
+    if (len <= 128) return len17to128(in, len, 0);
+    if (len <= 240) return len129to240(in, len, 0);
+    return hashLong(in, len);
+}
@@ -0,0 +1,36 @@
+#ifndef XXH3_H
+#define XXH3_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief XXH3-128 非加密哈希 (默认密钥、种子 0，与 xxHash 0.8 的 XXH3_128bits 输出一致)
+ *
+ * 用作捕获内容的去重键：每字节开销远低于 SHA-256，长输入在 x86-64 上走 SSE2 累加。
+ * 不具备抗碰撞的密码学强度，不得用于校验或签名。
+ */
+class Xxh3 {
+public:
+    struct Hash128 {
+        uint64_t low64 = 0;
+        uint64_t high64 = 0;
+
+        bool operator==(const Hash128& other) const { return low64 == other.low64 && high64 == other.high64; }
+        bool operator!=(const Hash128& other) const { return !(*this == other); }
+        bool isNull() const { return low64 == 0 && high64 == 0; }
+
+        // 规范字节序 (大端，高 64 位在前)，与官方 hexdigest 一致
+        void toBytes(uint8_t out[16]) const;
+        static Hash128 fromBytes(const uint8_t in[16]);
+    };
+
+    // 供 std::unordered_set 等容器使用：低 64 位本身已充分混合
+    struct Hasher {
+        size_t operator()(const Hash128& h) const { return static_cast<size_t>(h.low64); }
+    };
+
+    static Hash128 hash128(const void* data, size_t len);
+};
+
+#endif // XXH3_H
@@ -8,7 +8,6 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QFileInfo>
-#include <QBuffer>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QLocalServer>
@@ -16,7 +15,9 @@
 #include "core/DatabaseManager.h"
 #include "core/HotkeyManager.h"
 #include "core/ClipboardMonitor.h"
-#include "core/OCRManager.h"
+#include "core/ScreenshotPipeline.h"
+#include "core/OCRIndexer.h"
+#include "core/EncryptedDatabase.h"
 #include "ui/MainWindow.h"
 #include "ui/FloatingBall.h"
 #include "ui/QuickWindow.h"
@@ -34,6 +35,7 @@
 #include "ui/FireworksOverlay.h"
 #include "ui/ScreenshotTool.h"
 #include "ui/SettingsWindow.h"
+#include "ui/DatabaseLockDialog.h"
 #include "core/KeyboardHook.h"
 
 // 日志文件输出
@@ -99,13 +101,24 @@ int main(int argc, char *argv[]) {
 
     // 1. 初始化数据库
     QString dbPath = QCoreApplication::applicationDirPath() + "/notes.db";
+    bool encrypted = EncryptedDatabase::isEnabled();
+    if (encrypted) {
+        // 加密模式：先输入主密码解密出工作副本，明文库只存在于仅当前用户可访问的工作目录 (Linux 为内存盘)
+        DatabaseLockDialog lockDlg(DatabaseLockDialog::Login);
+        if (lockDlg.exec() != QDialog::Accepted) return 0;
+        dbPath = EncryptedDatabase::instance().workingPath();
+    }
     qDebug() << "[Main] 数据库路径:" << dbPath;
 
-    if (!DatabaseManager::instance().init(dbPath)) {
+    // 工作副本每次启动都由容器重新生成，不做自动备份
+    if (!DatabaseManager::instance().init(dbPath, !encrypted)) {
         QMessageBox::critical(nullptr, "启动失败", 
             "无法初始化数据库！\n请检查是否有写入权限，或缺少 SQLite 驱动。");
         return -1;
     }
+    if (encrypted) EncryptedDatabase::instance().startAutoSave();
+    // 退出前把工作副本的改动写回容器并删除工作副本
+    QObject::connect(&a, &QCoreApplication::aboutToQuit, []() { EncryptedDatabase::instance().shutdown(); });
 
     // 2. 初始化主界面
     MainWindow* mainWin = new MainWindow();
@@ -202,6 +215,13 @@ int main(int argc, char *argv[]) {
 
     // 6. 注册全局热键 (从配置加载)
     HotkeyManager::instance().reapplyHotkeys();
+
+    // 截屏存为笔记：编码与识别都在后台进行，截屏界面确认后立即关闭
+    auto* screenshotPipeline = new ScreenshotPipeline(&a);
+
+    // 空闲时为尚未识别的图片笔记 (含剪贴板图片) 补全 OCR 文字，供全文搜索
+    auto* ocrIndexer = new OCRIndexer(&a);
+    ocrIndexer->start();
     
     QObject::connect(&HotkeyManager::instance(), &HotkeyManager::hotkeyPressed, [&](int id){
         if (id == 1) {
@@ -226,30 +246,13 @@ int main(int argc, char *argv[]) {
                 // 1. 保存到剪贴板
                 QApplication::clipboard()->setImage(img);
 
-                // 2. 保存到数据库
-                QByteArray ba;
-                QBuffer buffer(&ba);
-                buffer.open(QIODevice::WriteOnly);
-                img.save(&buffer, "PNG");
-                
-                QString title = "[截屏] " + QDateTime::currentDateTime().toString("MMdd_HHmm");
-                int noteId = DatabaseManager::instance().addNote(title, "[正在进行文字识别...]", QStringList() << "截屏", "", -1, "image", ba);
-                
-                // 3. 触发 OCR
-                OCRManager::instance().recognizeAsync(img, noteId);
+                // 2. 保存到数据库并识别文字 (后台进行)
+                screenshotPipeline->submit(img);
             });
             tool->show();
         }
     });
 
-    // 监听 OCR 完成信号并更新笔记内容 (排除工具箱特有的 ID 9999)
-    // 必须指定 context 对象 (&DatabaseManager::instance()) 确保回调在正确的线程执行
-    QObject::connect(&OCRManager::instance(), &OCRManager::recognitionFinished, &DatabaseManager::instance(), [](const QString& text, int noteId){
-        if (noteId > 0 && noteId != 9999) {
-            DatabaseManager::instance().updateNoteState(noteId, "content", text);
-        }
-    });
-
     // 7. 系统托盘
     QObject::connect(&server, &QLocalServer::newConnection, [&](){
         QLocalSocket* conn = server.nextPendingConnection();
@@ -292,7 +295,7 @@ int main(int argc, char *argv[]) {
 
     QObject::connect(&ClipboardMonitor::instance(), &ClipboardMonitor::newContentDetected, 
         [=](const QString& content, const QString& type, const QByteArray& data,
-            const QString& sourceApp, const QString& sourceTitle){
+            const QString& sourceApp, const QString& sourceTitle, const QByteArray& contentKey){
         qDebug() << "[Main] 接收到剪贴板信号:" << type << "来自:" << sourceApp;
         
         QString title;
@@ -308,8 +311,8 @@ int main(int argc, char *argv[]) {
                 title = "[未知文件]";
             }
         } else {
-            // 文本：取第一行
-            QString firstLine = content.section('\n', 0, 0).trimmed();
+            // 文本：取第一行 (只看开头一段，超大文本不做整段拷贝)
+            QString firstLine = content.left(256).section('\n', 0, 0).trimmed();
             if (firstLine.isEmpty()) title = "无标题灵感";
             else {
                 title = firstLine.left(40);
@@ -328,7 +331,7 @@ int main(int argc, char *argv[]) {
         if (type == "image") tags << "图片";
         else if (type == "file") tags << "文件";
         else {
-            QString trimmed = content.trimmed();
+            QString trimmed = content.left(256).trimmed();
             if (trimmed.startsWith("http://") || trimmed.startsWith("https://") || trimmed.startsWith("www.")) {
                 tags << "链接";
             } else {
@@ -336,7 +339,7 @@ int main(int argc, char *argv[]) {
             }
         }
         
-        DatabaseManager::instance().addNoteAsync(title, content, tags, "", catId, type, data, sourceApp, sourceTitle);
+        DatabaseManager::instance().addNoteAsync(title, content, tags, "", catId, type, data, sourceApp, sourceTitle, contentKey);
     });
 
     return a.exec();
@@ -48,7 +48,7 @@ QVariant NoteModel::data(const QModelIndex& index, int role) const {
                 if (m_thumbnailCache.contains(id)) return m_thumbnailCache[id];
                 
                 QImage img;
-                img.loadFromData(note.value("data_blob").toByteArray());
+                img.loadFromData(DatabaseManager::instance().getNoteImage(note));
                 if (!img.isNull()) {
                     QIcon thumb(QPixmap::fromImage(img.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation)));
                     m_thumbnailCache[id] = thumb;
@@ -134,7 +134,7 @@ QVariant NoteModel::data(const QModelIndex& index, int role) const {
 
             QString preview;
             if (note.value("item_type").toString() == "image") {
-                QByteArray ba = note.value("data_blob").toByteArray();
+                QByteArray ba = DatabaseManager::instance().getNoteImage(note);
                 preview = QString("<img src='data:image/png;base64,%1' width='300'>").arg(QString(ba.toBase64()));
             } else {
                 preview = content.left(400).toHtmlEscaped().replace("\n", "<br>").trimmed();
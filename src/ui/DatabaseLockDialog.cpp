@@ -3,6 +3,10 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
+#include <QCoreApplication>
+#include <QtConcurrent>
+#include "../core/EncryptedDatabase.h"
+#include "../core/DatabaseManager.h"
 
 DatabaseLockDialog::DatabaseLockDialog(Mode mode, QWidget* parent) 
     : FramelessDialog(mode == Login ? "数据库已锁定" : "设置数据库主密码", parent), m_mode(mode) 
@@ -18,7 +22,8 @@ DatabaseLockDialog::DatabaseLockDialog(Mode mode, QWidget* parent)
     iconLabel->setAlignment(Qt::AlignCenter);
     mainLayout->addWidget(iconLabel);
 
-    m_tipLabel = new QLabel(mode == Login ? "请输入主密码以解密并加载数据：" : "请设置一个主密码，该密码将用于加密整个数据库文件：");
+    m_defaultTip = mode == Login ? "请输入主密码以解密并加载数据：" : "请设置一个主密码，该密码将用于加密整个数据库文件：";
+    m_tipLabel = new QLabel(m_defaultTip);
     m_tipLabel->setWordWrap(true);
     m_tipLabel->setStyleSheet("color: #bbb; font-size: 12px;");
     m_tipLabel->setAlignment(Qt::AlignCenter);
@@ -43,14 +48,15 @@ DatabaseLockDialog::DatabaseLockDialog(Mode mode, QWidget* parent)
     }
 
     auto* btnLayout = new QHBoxLayout();
-    auto* btnConfirm = new QPushButton("确认");
-    btnConfirm->setAutoDefault(false);
-    btnConfirm->setFixedHeight(35);
-    btnConfirm->setStyleSheet("QPushButton { background: #007acc; color: white; border: none; border-radius: 4px; font-weight: bold; } QPushButton:hover { background: #0062a3; }");
-    connect(btnConfirm, &QPushButton::clicked, this, &DatabaseLockDialog::onConfirm);
-    btnLayout->addWidget(btnConfirm);
-
-    auto* btnCancel = new QPushButton("退出");
+    m_btnConfirm = new QPushButton("确认");
+    m_btnConfirm->setAutoDefault(false);
+    m_btnConfirm->setFixedHeight(35);
+    m_btnConfirm->setStyleSheet("QPushButton { background: #007acc; color: white; border: none; border-radius: 4px; font-weight: bold; } QPushButton:hover { background: #0062a3; } QPushButton:disabled { background: #3e3e42; color: #888; }");
+    connect(m_btnConfirm, &QPushButton::clicked, this, &DatabaseLockDialog::onConfirm);
+    connect(m_pwdEdit, &QLineEdit::returnPressed, this, &DatabaseLockDialog::onConfirm);
+    btnLayout->addWidget(m_btnConfirm);
+
+    auto* btnCancel = new QPushButton(mode == Login ? "退出" : "取消");
     btnCancel->setAutoDefault(false);
     btnCancel->setFixedHeight(35);
     btnCancel->setStyleSheet("QPushButton { background: #3e3e42; color: #ccc; border: none; border-radius: 4px; } QPushButton:hover { background: #4e4e52; }");
@@ -63,6 +69,8 @@ DatabaseLockDialog::DatabaseLockDialog(Mode mode, QWidget* parent)
 }
 
 void DatabaseLockDialog::onConfirm() {
+    if (m_future.isRunning()) return;
+
     QString pwd = m_pwdEdit->text();
     if (pwd.isEmpty()) {
         QMessageBox::warning(this, "错误", "密码不能为空");
@@ -76,5 +84,77 @@ void DatabaseLockDialog::onConfirm() {
         }
     }
 
+    setBusy(true);
+    m_cancel = std::make_shared<std::atomic<bool>>(false);
+    auto cancel = m_cancel;
+
+    // 回调在工作线程中执行，文字更新转回主线程；返回 false 即取消
+    auto keyProgress = [this, cancel](qint64 done, qint64 total) {
+        const int percent = total > 0 ? int(done * 100 / total) : 0;
+        QMetaObject::invokeMethod(this, [this, percent]() {
+            m_tipLabel->setText(QString("正在派生密钥... %1%").arg(percent));
+        });
+        return !cancel->load();
+    };
+    const QString action = m_mode == Login ? "正在解密数据库" : "正在加密数据库";
+    auto progress = [this, cancel, action](qint64 done, qint64 total) {
+        const int percent = total > 0 ? int(done * 100 / total) : 100;
+        QMetaObject::invokeMethod(this, [this, action, percent]() {
+            m_tipLabel->setText(QString("%1... %2%").arg(action).arg(percent));
+        });
+        return !cancel->load();
+    };
+
+    const Mode mode = m_mode;
+    const QString plainPath = DatabaseManager::instance().databasePath();
+    m_future = QtConcurrent::run([this, mode, pwd, plainPath, keyProgress, progress, cancel]() {
+        EncryptedDatabase& enc = EncryptedDatabase::instance();
+        bool wrongPassword = false;
+        const bool ok = mode == Login ? enc.unlock(pwd, keyProgress, progress, &wrongPassword)
+                                      : enc.prepareEnable(plainPath, pwd, keyProgress, progress);
+        // 最后一次回调之后才点的取消：已经完成的结果也要撤销
+        if (ok && cancel->load()) enc.discard();
+        QMetaObject::invokeMethod(this, [this, ok, wrongPassword]() { onFinished(ok, wrongPassword); });
+    });
+}
+
+void DatabaseLockDialog::onFinished(bool ok, bool wrongPassword) {
+    setBusy(false);
+    if (m_cancel && m_cancel->load()) return;   // 已由 reject() 处理
+
+    if (!ok) {
+        m_tipLabel->setText(m_defaultTip);
+        if (wrongPassword) {
+            QMessageBox::warning(this, "错误", "主密码错误，请重试");
+            m_pwdEdit->selectAll();
+            m_pwdEdit->setFocus();
+        } else {
+            QMessageBox::critical(this, "错误", m_mode == Login ? "数据库容器读取失败，文件可能已损坏" : "数据库加密失败，已保持明文存储");
+        }
+        return;
+    }
+
+    if (m_mode == SetPassword && !EncryptedDatabase::instance().finishEnable()) {
+        m_tipLabel->setText(m_defaultTip);
+        QMessageBox::critical(this, "错误", "切换到加密数据库失败，已保持明文存储");
+        return;
+    }
     accept();
 }
+
+void DatabaseLockDialog::setBusy(bool busy) {
+    m_btnConfirm->setEnabled(!busy);
+    m_pwdEdit->setEnabled(!busy);
+    if (m_confirmEdit) m_confirmEdit->setEnabled(!busy);
+}
+
+void DatabaseLockDialog::reject() {
+    // 后台任务持有 this，先取消并等它退出
+    if (m_future.isRunning()) {
+        m_cancel->store(true);
+        m_tipLabel->setText("正在取消...");
+        m_future.waitForFinished();
+        QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+    }
+    FramelessDialog::reject();
+}
@@ -5,7 +5,16 @@
 #include <QLineEdit>
 #include <QLabel>
 #include <QPushButton>
+#include <QFuture>
+#include <atomic>
+#include <memory>
 
+/**
+ * @brief 数据库主密码对话框
+ *
+ * Login 模式解锁 EncryptedDatabase，SetPassword 模式把当前明文库转为加密容器。
+ * 密钥派生与整库加解密都在后台线程进行，对话框显示进度，期间可随时取消。
+ */
 class DatabaseLockDialog : public FramelessDialog {
     Q_OBJECT
 public:
@@ -15,14 +24,25 @@ public:
 
     QString password() const { return m_pwdEdit->text(); }
 
+public slots:
+    void reject() override;
+
 private slots:
     void onConfirm();
 
 private:
+    void setBusy(bool busy);
+    void onFinished(bool ok, bool wrongPassword);
+
     Mode m_mode;
     QLineEdit* m_pwdEdit;
     QLineEdit* m_confirmEdit;
     QLabel* m_tipLabel;
+    QPushButton* m_btnConfirm;
+    QString m_defaultTip;
+
+    QFuture<void> m_future;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
 };
 
 #endif // DATABASELOCKDIALOG_H
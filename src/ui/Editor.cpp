@@ -1,4 +1,8 @@
 #include "Editor.h"
+#include "../core/DatabaseManager.h"
+#include <QApplication>
+#include <QPointer>
+#include <QtConcurrent>
 #include <QMimeData>
 #include <QFileInfo>
 #include <utility>
@@ -80,6 +84,7 @@ void MarkdownHighlighter::highlightBlock(const QString& text) {
 }
 
 #include <QVBoxLayout>
+#include <QHBoxLayout>
 #include <QFrame>
 #include <QMimeData>
 #include <QUrl>
@@ -147,26 +152,57 @@ Editor::Editor(QWidget* parent) : QWidget(parent) {
 
     m_stack->addWidget(m_edit);
     m_stack->addWidget(m_preview);
-    
+
+    // 超大文本提示条，默认隐藏
+    m_truncatedBar = new QWidget(this);
+    m_truncatedBar->setStyleSheet("background: #2A2A2A; border-bottom: 1px solid #333;");
+    auto* barLayout = new QHBoxLayout(m_truncatedBar);
+    barLayout->setContentsMargins(15, 6, 15, 6);
+    m_truncatedLabel = new QLabel(m_truncatedBar);
+    m_truncatedLabel->setStyleSheet("color: #E5C07B; font-size: 12px; border: none;");
+    m_loadFullBtn = new QPushButton("加载全文", m_truncatedBar);
+    m_loadFullBtn->setCursor(Qt::PointingHandCursor);
+    m_loadFullBtn->setStyleSheet("QPushButton { background: #333; color: #ddd; border: 1px solid #444; border-radius: 4px; padding: 2px 10px; }"
+                                 "QPushButton:hover { background: #444; }");
+    barLayout->addWidget(m_truncatedLabel, 1);
+    barLayout->addWidget(m_loadFullBtn);
+    m_truncatedBar->hide();
+    connect(m_loadFullBtn, &QPushButton::clicked, this, &Editor::loadFullText);
+
+    layout->addWidget(m_truncatedBar);
     layout->addWidget(m_stack);
 }
 
 void Editor::setNote(const QVariantMap& note, bool isPreview) {
     m_currentNote = note;
+    m_showTitle = isPreview;
+    ++m_loadSerial;
     QString title = note.value("title").toString();
     QString content = note.value("content").toString();
     QString type = note.value("item_type").toString();
     QByteArray blob = note.value("data_blob").toByteArray();
 
     m_edit->clear();
+
+    // 超大文本：content 只是预览，全文在用户点击时再加载；未加载全文前不允许编辑
+    const qint64 largeSize = note.value("large_size").toLongLong();
+    m_truncated = largeSize > 0;
+    m_truncatedBar->setVisible(m_truncated);
+    m_edit->setReadOnly(m_readOnly || m_truncated);
+    if (m_truncated) {
+        m_truncatedLabel->setText(QString("超大文本 (%1 MB)：仅显示前 %2 字")
+                                      .arg(largeSize / (1024.0 * 1024.0), 0, 'f', 1)
+                                      .arg(DatabaseManager::kLargeTextPreviewChars));
+        m_loadFullBtn->setEnabled(true);
+    }
     
     // 增强 HTML 检测：采用更严谨的启发式算法，识别 Qt 生成的 HTML 模式
     // Qt 生成的 HTML 通常以 <!DOCTYPE HTML 开始，或者包含大量的 <style>
     QString trimmed = content.trimmed();
-    m_isRichText = trimmed.startsWith("<!DOCTYPE", Qt::CaseInsensitive) || 
+    m_isRichText = !m_truncated && (trimmed.startsWith("<!DOCTYPE", Qt::CaseInsensitive) || 
                    trimmed.startsWith("<html", Qt::CaseInsensitive) || 
                    trimmed.contains("<style", Qt::CaseInsensitive) ||
-                   Qt::mightBeRichText(content);
+                   Qt::mightBeRichText(content));
 
     if (m_isRichText) {
         // 如果是 HTML 内容，加载为 HTML
@@ -227,9 +263,34 @@ void Editor::setNote(const QVariantMap& note, bool isPreview) {
 
 void Editor::setPlainText(const QString& text) {
     m_currentNote.clear();
+    ++m_loadSerial;
+    m_truncated = false;
+    m_truncatedBar->hide();
+    m_edit->setReadOnly(m_readOnly);
     m_edit->setPlainText(text);
 }
 
+void Editor::loadFullText() {
+    const int serial = m_loadSerial;
+    m_loadFullBtn->setEnabled(false);
+    m_truncatedLabel->setText("正在加载全文...");
+
+    // 压缩块在界面线程读出 (数据库连接不跨线程)，解压与解码放到线程池
+    const QList<QByteArray> chunks = DatabaseManager::instance().getLargeTextChunks(m_currentNote.value("id").toInt());
+    QPointer<Editor> self(this);
+    (void)QtConcurrent::run([self, serial, chunks]() {
+        const QString text = DatabaseManager::decodeLargeText(chunks);
+        QMetaObject::invokeMethod(qApp, [self, serial, text]() {
+            if (!self || self->m_loadSerial != serial) return;   // 期间已切换笔记
+            // 按普通笔记重新载入，此后编辑保存的就是全文
+            QVariantMap note = self->m_currentNote;
+            note["content"] = text;
+            note["large_size"] = 0;
+            self->setNote(note, self->m_showTitle);
+        });
+    });
+}
+
 QString Editor::toPlainText() const {
     return m_edit->toPlainText();
 }
@@ -369,5 +430,6 @@ void Editor::togglePreview(bool preview) {
 }
 
 void Editor::setReadOnly(bool ro) {
-    m_edit->setReadOnly(ro);
+    m_readOnly = ro;
+    m_edit->setReadOnly(ro || m_truncated);
 }
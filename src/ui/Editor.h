@@ -20,6 +20,8 @@ private:
 };
 
 #include <QStackedWidget>
+#include <QLabel>
+#include <QPushButton>
 
 class InternalEditor : public QTextEdit {
     Q_OBJECT
@@ -54,13 +56,27 @@ public:
     // 搜索功能
     bool findText(const QString& text, bool backward = false);
 
+    // 超大文本笔记只显示了预览，全文尚未载入 (此时编辑器只读)
+    bool isTruncated() const { return m_truncated; }
+
 private:
+    void loadFullText();
+
     QStackedWidget* m_stack;
     InternalEditor* m_edit;
     QTextEdit* m_preview;
     MarkdownHighlighter* m_highlighter;
     QVariantMap m_currentNote;
     bool m_isRichText = false;
+
+    // 超大文本：提示条 + 按需在后台解压全文
+    QWidget* m_truncatedBar;
+    QLabel* m_truncatedLabel;
+    QPushButton* m_loadFullBtn;
+    bool m_truncated = false;
+    bool m_readOnly = false;
+    bool m_showTitle = false;
+    int m_loadSerial = 0;   // 每次切换笔记递增，丢弃过期的全文加载结果
 };
 
 #endif // EDITOR_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "FileSearchWindow.h"
 #include "IconHelper.h"
+#include "../core/IgnoreMatcher.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFileDialog>
@@ -24,7 +25,6 @@
 #include <QGraphicsDropShadowEffect>
 #include <QPropertyAnimation>
 #include <QScrollArea>
-#include <functional>
 
 // ----------------------------------------------------------------------------
 // PathHistory 相关辅助类 (复刻 SearchHistoryPopup 逻辑)
@@ -262,32 +262,14 @@ void ScannerThread::run() {
         return;
     }
 
-    QStringList ignored = {".git", ".idea", "__pycache__", "node_modules", "$RECYCLE.BIN", "System Volume Information"};
-    
-    // 使用 std::function 实现递归扫描，支持目录剪枝
-    std::function<void(const QString&)> scanDir = [&](const QString& currentPath) {
-        if (!m_isRunning) return;
-
-        QDir dir(currentPath);
-        // 1. 获取当前目录下所有文件
-        QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden);
-        for (const auto& fi : files) {
-            if (!m_isRunning) return;
-            emit fileFound(fi.fileName(), fi.absoluteFilePath());
-            count++;
-        }
-
-        // 2. 获取子目录并递归 (排除忽略列表)
-        QFileInfoList subDirs = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden);
-        for (const auto& di : subDirs) {
-            if (!m_isRunning) return;
-            if (!ignored.contains(di.fileName())) {
-                scanDir(di.absoluteFilePath());
-            }
-        }
-    };
-
-    scanDir(m_folderPath);
+    // 共享的忽略规则：内置依赖/构建目录 + 沿途的 .gitignore / .ignore，被忽略的目录不会进入
+    IgnoreMatcher matcher;
+    matcher.walk(m_folderPath, [&](const QFileInfo& fi) {
+        if (!m_isRunning) return false;
+        emit fileFound(fi.fileName(), fi.absoluteFilePath());
+        count++;
+        return true;
+    }, IgnoreMatcher::Files | IgnoreMatcher::Hidden);
     emit finished(count);
 }
 
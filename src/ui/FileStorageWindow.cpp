@@ -1,6 +1,7 @@
 #include "FileStorageWindow.h"
 #include "IconHelper.h"
 #include "../core/DatabaseManager.h"
+#include "../core/BlobStore.h"
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
 #include <QDropEvent>
@@ -26,6 +27,19 @@ FileStorageWindow::FileStorageWindow(QWidget* parent) : FramelessDialog("存储
     setAcceptDrops(true);
     resize(450, 430);
 
+    m_copyEngine = new FileCopyEngine(this);
+    // 不支持 reflink 时块加物化副本要写两份，关闭块存储按原方式只复制一份
+    m_copyEngine->setBlobStoreEnabled(BlobStore::isSupported());
+    connect(m_copyEngine, &FileCopyEngine::progress, this, &FileStorageWindow::onCopyProgress);
+    connect(m_copyEngine, &FileCopyEngine::finished, this, [this](const QList<bool>& taskOk, bool cancelled) {
+        m_progressBar->hide();
+        m_cancelBtn->hide();
+        m_dropHint->setEnabled(true);
+        CopyCallback onDone = std::move(m_onCopyDone);
+        m_onCopyDone = nullptr;
+        if (onDone) onDone(taskOk, cancelled);
+    });
+
     initUI();
 }
 
@@ -51,6 +65,27 @@ void FileStorageWindow::initUI() {
                                 "QListWidget::item { padding: 4px; border-bottom: 1px solid #2d2d2d; }");
     contentLayout->addWidget(m_statusList);
 
+    // 复制进度与取消
+    auto* progressLayout = new QHBoxLayout();
+    m_progressBar = new QProgressBar();
+    m_progressBar->setRange(0, 1000);
+    m_progressBar->setTextVisible(false);
+    m_progressBar->setFixedHeight(6);
+    m_progressBar->setStyleSheet("QProgressBar { background: #252526; border: none; border-radius: 3px; } QProgressBar::chunk { background: #f1c40f; border-radius: 3px; }");
+    m_progressBar->hide();
+    m_cancelBtn = new QPushButton("取消");
+    m_cancelBtn->setCursor(Qt::PointingHandCursor);
+    m_cancelBtn->setStyleSheet("QPushButton { background: #333; color: #ccc; border: none; border-radius: 4px; padding: 3px 10px; font-size: 11px; } QPushButton:hover { background: #444; }");
+    m_cancelBtn->hide();
+    connect(m_cancelBtn, &QPushButton::clicked, m_copyEngine, &FileCopyEngine::cancel);
+    progressLayout->addWidget(m_progressBar, 1);
+    progressLayout->addWidget(m_cancelBtn);
+    contentLayout->addLayout(progressLayout);
+
+    m_progressLabel = new QLabel();
+    m_progressLabel->setStyleSheet("color: #888; font-size: 10px;");
+    contentLayout->addWidget(m_progressLabel);
+
     auto* tipLabel = new QLabel("文件将直接复制到 attachments 文件夹");
     tipLabel->setStyleSheet("color: #666; font-size: 10px;");
     tipLabel->setAlignment(Qt::AlignCenter);
@@ -62,12 +97,7 @@ void FileStorageWindow::initUI() {
 // ==========================================
 
 QString FileStorageWindow::getStorageRoot() {
-    QString path = QCoreApplication::applicationDirPath() + "/attachments";
-    QDir dir(path);
-    if (!dir.exists()) {
-        dir.mkpath(".");
-    }
-    return path;
+    return BlobStore::storageRoot();
 }
 
 QString FileStorageWindow::getUniqueFilePath(const QString& dirPath, const QString& fileName) {
@@ -86,33 +116,41 @@ QString FileStorageWindow::getUniqueFilePath(const QString& dirPath, const QStri
     return dir.filePath(finalName);
 }
 
-bool FileStorageWindow::copyRecursively(const QString& srcStr, const QString& dstStr) {
-    QDir srcDir(srcStr);
-    if (!srcDir.exists()) return false;
+static QString formatSize(qint64 bytes) {
+    if (bytes >= 1024LL * 1024 * 1024) return QString::number(bytes / (1024.0 * 1024 * 1024), 'f', 2) + " GB";
+    if (bytes >= 1024 * 1024) return QString::number(bytes / (1024.0 * 1024), 'f', 1) + " MB";
+    return QString::number(bytes / 1024.0, 'f', 0) + " KB";
+}
 
-    QDir dstDir(dstStr);
-    if (!dstDir.exists()) {
-        dstDir.mkpath(".");
-    }
+void FileStorageWindow::runCopy(const QList<FileCopyEngine::Task>& tasks, const CopyCallback& onDone) {
+    m_onCopyDone = onDone;
+    m_progressBar->setValue(0);
+    m_progressBar->show();
+    m_cancelBtn->show();
+    m_progressLabel->setText("正在统计文件...");
+    m_dropHint->setEnabled(false);
+    m_copyEngine->start(tasks);
+}
 
-    // 1. 复制所有文件
-    for (const QString& file : srcDir.entryList(QDir::Files)) {
-        QString srcFile = srcDir.filePath(file);
-        QString dstFile = dstDir.filePath(file);
-        if (!QFile::copy(srcFile, dstFile)) {
-            return false;
-        }
-    }
+void FileStorageWindow::onCopyProgress(qint64 bytesDone, qint64 bytesTotal, int filesDone, int filesTotal) {
+    m_progressBar->setValue(bytesTotal > 0 ? static_cast<int>(bytesDone * 1000 / bytesTotal) : 0);
+    m_progressLabel->setText(QString("%1 / %2  (%3/%4 个文件)")
+                                 .arg(formatSize(bytesDone), formatSize(bytesTotal))
+                                 .arg(filesDone).arg(filesTotal));
+}
 
-    // 2. 递归复制子文件夹
-    for (const QString& dir : srcDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-        QString srcSub = srcDir.filePath(dir);
-        QString dstSub = dstDir.filePath(dir);
-        if (!copyRecursively(srcSub, dstSub)) {
-            return false;
-        }
+void FileStorageWindow::discardStoredBlobs() {
+    // 放弃本批结果：本批新建的块可能已被并行的另一次归档引用，由数据库在锁内确认无引用后再删除
+    QStringList created;
+    for (const QVariantMap& blob : m_copyEngine->storedBlobs()) {
+        if (blob.value("created").toBool()) created << blob.value("hash").toString();
     }
-    return true;
+    DatabaseManager::instance().removeUnreferencedBlobs(created);
+}
+
+QString FileStorageWindow::dedupSummary() const {
+    const qint64 saved = m_copyEngine->deduplicatedBytes();
+    return saved > 0 ? QString(" (去重节省 %1)").arg(formatSize(saved)) : QString();
 }
 
 // ==========================================
@@ -147,8 +185,12 @@ void FileStorageWindow::dropEvent(QDropEvent* event) {
 }
 
 void FileStorageWindow::processStorage(const QStringList& paths) {
-    m_statusList->clear();
     if (paths.isEmpty()) return;
+    if (m_copyEngine->isRunning()) {
+        m_statusList->addItem("⏳ 上一批文件仍在复制，请稍候");
+        return;
+    }
+    m_statusList->clear();
 
     if (paths.size() == 1) {
         QFileInfo info(paths.first());
@@ -166,67 +208,91 @@ void FileStorageWindow::storeFile(const QString& path) {
     QFileInfo info(path);
     QString storageDir = getStorageRoot();
     QString destPath = getUniqueFilePath(storageDir, info.fileName());
-    
-    if (QFile::copy(path, destPath)) {
+
+    runCopy({{path, destPath}}, [this, info, destPath](const QList<bool>& taskOk, bool cancelled) {
+        if (cancelled) {
+            QFile::remove(destPath);
+            discardStoredBlobs();
+            m_statusList->addItem("⛔ 已取消: " + info.fileName());
+            return;
+        }
+        if (!taskOk.value(0)) {
+            QFile::remove(destPath);
+            discardStoredBlobs();
+            m_statusList->addItem("❌ 复制失败: 权限不足或文件被占用");
+            return;
+        }
+
         QFileInfo destInfo(destPath);
         QString relativePath = "attachments/" + destInfo.fileName();
 
-        bool ok = DatabaseManager::instance().addNote(
+        bool ok = DatabaseManager::instance().addStoredFileNote(
             info.fileName(),
             relativePath,
             {"文件链接"},
             "#2c3e50",
             m_categoryId,
             "local_file",
-            QByteArray(),
             "FileStorage",
-            info.absoluteFilePath()
+            info.absoluteFilePath(),
+            m_copyEngine->storedBlobs()
         );
 
         if (ok) {
-            m_statusList->addItem("✅ 已归档: " + info.fileName());
+            m_statusList->addItem("✅ 已归档: " + info.fileName() + dedupSummary());
         } else {
             m_statusList->addItem("❌ 数据库错误: " + info.fileName());
             QFile::remove(destPath);
+            discardStoredBlobs();
         }
-    } else {
-        m_statusList->addItem("❌ 复制失败: 权限不足或文件被占用");
-    }
+    });
 }
 
 void FileStorageWindow::storeFolder(const QString& path) {
     QFileInfo info(path);
     QString storageDir = getStorageRoot();
     QString destDir = getUniqueFilePath(storageDir, info.fileName());
-    
+
     m_statusList->addItem("📂 正在导入文件夹: " + info.fileName() + "...");
-    QApplication::processEvents();
 
-    if (copyRecursively(path, destDir)) {
+    runCopy({{path, destDir}}, [this, info, destDir](const QList<bool>& taskOk, bool cancelled) {
+        // 取消或失败时整体回滚，不留下半个文件夹
+        if (cancelled) {
+            QDir(destDir).removeRecursively();
+            discardStoredBlobs();
+            m_statusList->addItem("⛔ 已取消导入");
+            return;
+        }
+        if (!taskOk.value(0)) {
+            QDir(destDir).removeRecursively();
+            discardStoredBlobs();
+            m_statusList->addItem("❌ 文件夹复制失败");
+            return;
+        }
+
         QDir d(destDir);
         QString relativePath = "attachments/" + d.dirName();
 
-        bool ok = DatabaseManager::instance().addNote(
+        bool ok = DatabaseManager::instance().addStoredFileNote(
             info.fileName(),
             relativePath,
             {"文件夹链接"},
             "#8e44ad",
             m_categoryId,
             "local_folder",
-            QByteArray(),
             "FileStorage",
-            info.absoluteFilePath()
+            info.absoluteFilePath(),
+            m_copyEngine->storedBlobs()
         );
 
         if (ok) {
-            m_statusList->addItem("✅ 文件夹归档成功");
+            m_statusList->addItem("✅ 文件夹归档成功" + dedupSummary());
         } else {
             m_statusList->addItem("❌ 数据库错误");
             QDir(destDir).removeRecursively();
+            discardStoredBlobs();
         }
-    } else {
-        m_statusList->addItem("❌ 文件夹复制失败");
-    }
+    });
 }
 
 void FileStorageWindow::storeArchive(const QStringList& paths) {
@@ -241,25 +307,29 @@ void FileStorageWindow::storeArchive(const QStringList& paths) {
         return;
     }
 
-    int successCount = 0;
     m_statusList->addItem("📦 正在处理 " + QString::number(paths.size()) + " 个项目...");
-    QApplication::processEvents();
 
+    QList<FileCopyEngine::Task> tasks;
     for (const QString& srcPath : std::as_const(paths)) {
-        QFileInfo srcInfo(srcPath);
-        QString destPath = destDir + "/" + srcInfo.fileName();
+        tasks.append(FileCopyEngine::Task{srcPath, destDir + "/" + QFileInfo(srcPath).fileName()});
+    }
 
-        bool copyOk = false;
-        if (srcInfo.isDir()) {
-            copyOk = copyRecursively(srcPath, destPath);
-        } else {
-            copyOk = QFile::copy(srcPath, destPath);
+    runCopy(tasks, [this, paths, folderName, destDir](const QList<bool>& taskOk, bool cancelled) {
+        if (cancelled) {
+            QDir(destDir).removeRecursively();
+            discardStoredBlobs();
+            m_statusList->addItem("⛔ 已取消导入");
+            return;
         }
 
-        if (copyOk) successCount++;
-    }
+        const int successCount = static_cast<int>(taskOk.count(true));
+        if (successCount == 0) {
+            m_statusList->addItem("❌ 所有项目导入失败");
+            QDir(destDir).removeRecursively();
+            discardStoredBlobs();
+            return;
+        }
 
-    if (successCount > 0) {
         QString relativePath = "attachments/" + folderName;
         
         // 构建描述性标题：[数量个项目] 文件1, 文件2...
@@ -272,27 +342,26 @@ void FileStorageWindow::storeArchive(const QStringList& paths) {
             descriptiveTitle = descriptiveTitle.left(117) + "...";
         }
 
-        bool ok = DatabaseManager::instance().addNote(
+        bool ok = DatabaseManager::instance().addStoredFileNote(
             descriptiveTitle,
             relativePath,
             {"批量导入"},
             "#34495e",
             m_categoryId,
             "local_batch",
-            QByteArray(),
             "FileStorage",
-            ""
+            "",
+            m_copyEngine->storedBlobs()
         );
 
         if (ok) {
-            m_statusList->addItem(QString("✅ 成功归档 %1/%2 个项目").arg(successCount).arg(paths.size()));
+            m_statusList->addItem(QString("✅ 成功归档 %1/%2 个项目").arg(successCount).arg(paths.size()) + dedupSummary());
         } else {
             m_statusList->addItem("❌ 数据库写入失败");
+            QDir(destDir).removeRecursively();
+            discardStoredBlobs();
         }
-    } else {
-        m_statusList->addItem("❌ 所有项目导入失败");
-        QDir(destDir).removeRecursively();
-    }
+    });
 }
 
 
@@ -6,6 +6,9 @@
 #include <QListWidget>
 #include <QVBoxLayout>
 #include <QPoint>
+#include <QProgressBar>
+#include <functional>
+#include "../core/FileCopyEngine.h"
 
 class QDragEnterEvent;
 class QDragLeaveEvent;
@@ -36,10 +39,21 @@ private:
 
     QString getStorageRoot(); // 获取存储根目录
     QString getUniqueFilePath(const QString& dirPath, const QString& fileName); // 获取不重复的文件名
-    bool copyRecursively(const QString& srcStr, const QString& dstStr); // 递归复制文件夹
+
+    // 启动后台复制；全部结束后在 GUI 线程回调 onDone，由调用方完成唯一一次数据库写入
+    using CopyCallback = std::function<void(const QList<bool>& taskOk, bool cancelled)>;
+    void runCopy(const QList<FileCopyEngine::Task>& tasks, const CopyCallback& onDone);
+    void onCopyProgress(qint64 bytesDone, qint64 bytesTotal, int filesDone, int filesTotal);
+    void discardStoredBlobs();      // 放弃本批时删除本批新建的内容块
+    QString dedupSummary() const;
 
     QPushButton* m_dropHint;
     QListWidget* m_statusList;
+    QProgressBar* m_progressBar;
+    QLabel* m_progressLabel;
+    QPushButton* m_cancelBtn;
+    FileCopyEngine* m_copyEngine;
+    CopyCallback m_onCopyDone;
     QPoint m_dragPos;
     int m_categoryId = -1;
 };
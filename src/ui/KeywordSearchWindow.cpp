@@ -1,10 +1,10 @@
 #include "KeywordSearchWindow.h"
 #include "IconHelper.h"
+#include "../core/FileReplaceEngine.h"
+#include "../core/IgnoreMatcher.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFileDialog>
-#include <QDirIterator>
-#include <QTextStream>
 #include <QRegularExpression>
 #include <QDateTime>
 #include <QProcess>
@@ -18,6 +18,8 @@
 #include <QGraphicsDropShadowEffect>
 #include <QPropertyAnimation>
 #include <QScrollArea>
+#include <QMutex>
+#include <atomic>
 
 // ----------------------------------------------------------------------------
 // KeywordSearchHistory 相关辅助类 (复刻 FileSearchHistoryPopup 逻辑)
@@ -221,7 +223,6 @@ private:
 
 KeywordSearchWindow::KeywordSearchWindow(QWidget* parent) : FramelessDialog("查找关键字", parent) {
     resize(900, 700);
-    m_ignoreDirs = {".git", ".svn", ".idea", ".vscode", "__pycache__", "node_modules", "dist", "build", "venv"};
     initUI();
 }
 
@@ -374,19 +375,6 @@ void KeywordSearchWindow::onBrowseFolder() {
     }
 }
 
-bool KeywordSearchWindow::isTextFile(const QString& filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) return false;
-    
-    QByteArray chunk = file.read(1024);
-    file.close();
-
-    if (chunk.isEmpty()) return true;
-    if (chunk.contains('\0')) return false;
-
-    return true;
-}
-
 void KeywordSearchWindow::log(const QString& msg, const QString& type) {
     QString color = "#D4D4D4";
     if (type == "success") color = "#6A9955";
@@ -404,6 +392,30 @@ void KeywordSearchWindow::log(const QString& msg, const QString& type) {
     m_logDisplay->append(html);
 }
 
+// 文件名过滤：通配符只编译一次，遍历时逐个匹配
+static QList<QRegularExpression> compileNameFilters(const QString& filter) {
+    QList<QRegularExpression> result;
+    for (const QString& f : filter.split(QRegularExpression("[,\\s;]+"), Qt::SkipEmptyParts)) {
+        result << QRegularExpression(QRegularExpression::wildcardToRegularExpression(f));
+    }
+    return result;
+}
+
+static bool matchNameFilters(const QList<QRegularExpression>& filters, const QString& fileName) {
+    if (filters.isEmpty()) return true;
+    for (const QRegularExpression& re : filters) {
+        if (re.match(fileName).hasMatch()) return true;
+    }
+    return false;
+}
+
+// 查找与替换共用的遍历器：内置忽略目录 + .gitignore / .ignore，外加本工具生成的备份目录
+static IgnoreMatcher makeSearchMatcher() {
+    IgnoreMatcher matcher;
+    matcher.addRules(QString(), {"_backup_*/"});
+    return matcher;
+}
+
 void KeywordSearchWindow::onSearch() {
     QString rootDir = m_pathEdit->text().trimmed();
     QString keyword = m_searchEdit->text().trimmed();
@@ -428,59 +440,31 @@ void KeywordSearchWindow::onSearch() {
         int foundFiles = 0;
         int scannedFiles = 0;
 
-        QStringList filters;
-        if (!filter.isEmpty()) {
-            filters = filter.split(QRegularExpression("[,\\s;]+"), Qt::SkipEmptyParts);
-        }
+        const QList<QRegularExpression> filters = compileNameFilters(filter);
 
-        QDirIterator it(rootDir, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            QString filePath = it.next();
-            
-            // 过滤目录
-            bool skip = false;
-            for (const QString& ignore : m_ignoreDirs) {
-                if (filePath.contains("/" + ignore + "/") || filePath.contains("\\" + ignore + "\\")) {
-                    skip = true;
-                    break;
-                }
-            }
-            if (skip) continue;
-
-            // 过滤文件名
-            if (!filters.isEmpty()) {
-                bool matchFilter = false;
-                QString fileName = QFileInfo(filePath).fileName();
-                for (const QString& f : filters) {
-                    QRegularExpression re(QRegularExpression::wildcardToRegularExpression(f));
-                    if (re.match(fileName).hasMatch()) {
-                        matchFilter = true;
-                        break;
-                    }
-                }
-                if (!matchFilter) continue;
-            }
+        IgnoreMatcher matcher = makeSearchMatcher();
+        matcher.walk(rootDir, [&](const QFileInfo& info) {
+            if (!matchNameFilters(filters, info.fileName())) return true;
 
-            if (!isTextFile(filePath)) continue;
+            // 编码嗅探只读文件头一个块，随后按检测到的编码直接在原始字节上流式计数
+            const QString filePath = info.absoluteFilePath();
+            bool isText = false;
+            QString notReplaceable;
+            int count = FileReplaceEngine::countMatches(filePath, keyword, caseSensitive, &isText, &notReplaceable);
+            if (!isText) return true;
 
             scannedFiles++;
-            QFile file(filePath);
-            if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                QTextStream in(&file);
-                QString content = in.readAll();
-                file.close();
-
-                Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
-                if (content.contains(keyword, cs)) {
-                    foundFiles++;
-                    int count = content.count(keyword, cs);
-                    QMetaObject::invokeMethod(this, [this, filePath, count]() {
-                        log(filePath, "file");
-                        log(QString("   匹配次数: %1\n").arg(count));
-                    });
-                }
+            if (count > 0) {
+                foundFiles++;
+                QMetaObject::invokeMethod(this, [this, filePath, count, notReplaceable]() {
+                    log(filePath, "file");
+                    log(QString("   匹配次数: %1\n").arg(count));
+                    // 编码无法无损还原的文件只能查找，提前说明替换时会被跳过
+                    if (!notReplaceable.isEmpty()) log("   无法替换: " + notReplaceable + "\n", "error");
+                });
             }
-        }
+            return true;
+        });
 
         QMetaObject::invokeMethod(this, [this, scannedFiles, foundFiles, keyword, caseSensitive]() {
             log(QString("\n搜索完成! 扫描 %1 个文件，找到 %2 个匹配\n").arg(scannedFiles).arg(foundFiles), "success");
@@ -518,112 +502,81 @@ void KeywordSearchWindow::onReplace() {
     bool caseSensitive = m_caseCheck->isChecked();
 
     (void)QtConcurrent::run([this, rootDir, keyword, replaceText, filter, caseSensitive]() {
-        int modifiedFiles = 0;
         QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
         QString backupDirName = "_backup_" + timestamp;
         QDir root(rootDir);
         root.mkdir(backupDirName);
-        m_lastBackupPath = root.absoluteFilePath(backupDirName);
+        QString backupPath = root.absoluteFilePath(backupDirName);
 
-        QStringList filters;
-        if (!filter.isEmpty()) {
-            filters = filter.split(QRegularExpression("[,\\s;]+"), Qt::SkipEmptyParts);
-        }
+        const QList<QRegularExpression> filters = compileNameFilters(filter);
 
-        QDirIterator it(rootDir, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            QString filePath = it.next();
-            if (filePath.contains(backupDirName)) continue;
-
-            // 过滤目录和文件名（逻辑同搜索）
-            bool skip = false;
-            for (const QString& ignore : m_ignoreDirs) {
-                if (filePath.contains("/" + ignore + "/") || filePath.contains("\\" + ignore + "\\")) {
-                    skip = true;
-                    break;
-                }
+        // 1. 收集候选文件 (备份目录以 _backup_ 开头，已被遍历器排除)
+        QStringList candidates;
+        IgnoreMatcher matcher = makeSearchMatcher();
+        matcher.walk(rootDir, [&](const QFileInfo& info) {
+            if (matchNameFilters(filters, info.fileName())) {
+                candidates << info.absoluteFilePath(); // 二进制文件由替换引擎嗅探后跳过
             }
-            if (skip) continue;
-
-            if (!filters.isEmpty()) {
-                bool matchFilter = false;
-                QString fileName = QFileInfo(filePath).fileName();
-                for (const QString& f : filters) {
-                    QRegularExpression re(QRegularExpression::wildcardToRegularExpression(f));
-                    if (re.match(fileName).hasMatch()) {
-                        matchFilter = true;
-                        break;
-                    }
-                }
-                if (!matchFilter) continue;
+            return true;
+        });
+
+        // 2. 并行替换：每个文件独立流式读写，备份按相对路径镜像，互不冲突
+        QMutex manifestMutex;
+        QList<FileReplaceEngine::ManifestEntry> manifest;
+        std::atomic<int> skippedFiles{0};
+        QtConcurrent::blockingMap(candidates, [&](const QString& filePath) {
+            QString relPath = root.relativeFilePath(filePath);
+            auto result = FileReplaceEngine::replaceInFile(filePath, keyword, replaceText, caseSensitive,
+                                                           backupPath + "/" + relPath);
+            if (!result.ok) {
+                skippedFiles++;
+                QMetaObject::invokeMethod(this, [this, relPath, error = result.error]() {
+                    log("替换失败: " + relPath + " (" + error + ")", "error");
+                });
+                return;
             }
+            if (result.replacements == 0) return;
 
-            if (!isTextFile(filePath)) continue;
-
-            QFile file(filePath);
-            if (file.open(QIODevice::ReadWrite | QIODevice::Text)) {
-                QTextStream in(&file);
-                QString content = in.readAll();
-                
-                Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
-                if (content.contains(keyword, cs)) {
-                    // 备份
-                    QString fileName = QFileInfo(filePath).fileName();
-                    QFile::copy(filePath, m_lastBackupPath + "/" + fileName + ".bak");
-
-                    // 替换
-                    QString newContent;
-                    if (caseSensitive) {
-                        newContent = content.replace(keyword, replaceText);
-                    } else {
-                        newContent = content.replace(QRegularExpression(QRegularExpression::escape(keyword), QRegularExpression::CaseInsensitiveOption), replaceText);
-                    }
-
-                    file.resize(0);
-                    in << newContent;
-                    modifiedFiles++;
-                    QMetaObject::invokeMethod(this, [this, fileName]() {
-                        log("已修改: " + fileName, "success");
-                    });
-                }
-                file.close();
+            {
+                QMutexLocker locker(&manifestMutex);
+                manifest.append({filePath, relPath, result.replacements});
             }
+            QMetaObject::invokeMethod(this, [this, relPath]() {
+                log("已修改: " + relPath, "success");
+            });
+        });
+
+        // 3. 写入备份清单 (以完整路径为键)，供撤销精确还原
+        int modifiedFiles = manifest.size();
+        if (modifiedFiles > 0) {
+            FileReplaceEngine::writeManifest(backupPath, rootDir, manifest);
+        } else {
+            QDir(backupPath).removeRecursively();
         }
 
-        QMetaObject::invokeMethod(this, [this, modifiedFiles]() {
-            log(QString("\n替换完成! 修改了 %1 个文件").arg(modifiedFiles), "success");
-            m_statusLabel->setText(QString("完成: 修改了 %1 个文件").arg(modifiedFiles));
+        QMetaObject::invokeMethod(this, [this, modifiedFiles, skipped = skippedFiles.load(), backupPath]() {
+            if (modifiedFiles > 0) m_lastBackupPath = backupPath;
+            QString summary = QString("修改了 %1 个文件").arg(modifiedFiles);
+            if (skipped > 0) summary += QString("，%1 个文件未修改 (原因见日志)").arg(skipped);
+            log("\n替换完成! " + summary, skipped > 0 ? "error" : "success");
+            m_statusLabel->setText("完成: " + summary);
             m_progressBar->hide();
-            QMessageBox::information(this, "完成", QString("已修改 %1 个文件\n备份于: %2").arg(modifiedFiles).arg(QFileInfo(m_lastBackupPath).fileName()));
+            QMessageBox::information(this, "完成", QString("%1\n备份于: %2").arg(summary, QFileInfo(backupPath).fileName()));
         });
     });
 }
 
 void KeywordSearchWindow::onUndo() {
-    if (m_lastBackupPath.isEmpty() || !QDir(m_lastBackupPath).exists()) {
+    if (m_lastBackupPath.isEmpty() || !QFile::exists(m_lastBackupPath + "/manifest.json")) {
         QMessageBox::warning(this, "提示", "未找到有效的备份目录！");
         return;
     }
 
-    int restored = 0;
-    QDir backupDir(m_lastBackupPath);
-    QStringList baks = backupDir.entryList({"*.bak"});
-    
-    QString rootDir = m_pathEdit->text();
-
-    for (const QString& bak : baks) {
-        QString origName = bak.left(bak.length() - 4);
-        
-        // 在根目录下寻找原始文件（简化策略：找同名文件）
-        QDirIterator it(rootDir, {origName}, QDir::Files, QDirIterator::Subdirectories);
-        if (it.hasNext()) {
-            QString targetPath = it.next();
-            if (QFile::remove(targetPath)) {
-                if (QFile::copy(backupDir.absoluteFilePath(bak), targetPath)) {
-                    restored++;
-                }
-            }
-        }
+    // 按清单中的完整路径逐一原子还原，不再按文件名在目录树中猜测
+    QStringList failed;
+    int restored = FileReplaceEngine::restoreFromManifest(m_lastBackupPath, &failed);
+    for (const QString& path : std::as_const(failed)) {
+        log("恢复失败: " + path, "error");
     }
 
     log(QString("↶ 撤销完成，已恢复 %1 个文件\n").arg(restored), "success");
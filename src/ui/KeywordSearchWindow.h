@@ -35,7 +35,6 @@ private:
     // 历史记录管理
     enum HistoryType { Path, Keyword };
     void addHistoryEntry(HistoryType type, const QString& text);
-    bool isTextFile(const QString& filePath);
     void log(const QString& msg, const QString& type = "info");
     void highlightResult(const QString& keyword);
 
@@ -49,7 +48,6 @@ private:
     QLabel* m_statusLabel;
 
     QString m_lastBackupPath;
-    QStringList m_ignoreDirs;
 };
 
 #endif // KEYWORDSEARCHWINDOW_H
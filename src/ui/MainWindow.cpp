@@ -1601,7 +1601,7 @@ void MainWindow::doExtractContent() {
         QVariantMap note = DatabaseManager::instance().getNoteById(id);
         QString type = note.value("item_type").toString();
         if (type == "text" || type.isEmpty()) {
-            QString content = note.value("content").toString();
+            QString content = DatabaseManager::instance().getFullContent(note);
             texts << StringUtils::htmlToPlainText(content);
         }
     }
@@ -1645,13 +1645,19 @@ void MainWindow::saveCurrentNote() {
     QModelIndex index = m_noteList->currentIndex();
     if (!index.isValid()) return;
     int id = index.data(NoteModel::IdRole).toInt();
+
+    // 超大文本未加载全文时编辑器里只有预览，不能写回覆盖库中的全文
+    if (m_editor->isTruncated()) {
+        m_editLockBtn->setChecked(false);
+        return;
+    }
     
     QString content = m_editor->toHtml();
     
-    // 保存前锁定剪贴板监控，防止自触发 (虽然 updateNoteState 不直接操作剪贴板，但为了严谨性)
-    // 实际上 updateNoteState 会触发 noteUpdated，不会引起剪贴板变化。
+    // 保存前锁定剪贴板监控，防止自触发 (虽然 updateNoteContent 不直接操作剪贴板，但为了严谨性)
+    // 实际上 updateNoteContent 会触发 noteUpdated，不会引起剪贴板变化。
     
-    DatabaseManager::instance().updateNoteState(id, "content", content);
+    DatabaseManager::instance().updateNoteContent(id, content);
     
     // 退出编辑模式
     m_editLockBtn->setChecked(false);
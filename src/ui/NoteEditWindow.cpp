@@ -461,7 +461,8 @@ void NoteEditWindow::toggleMaximize() {
 void NoteEditWindow::saveNote() {
     QString title = m_titleEdit->text();
     if(title.isEmpty()) title = "未命名灵感";
-    QString content = m_contentEdit->toHtml();
+    // 超大文本只载入了预览，未加载全文时传空串保留库中正文
+    QString content = m_contentEdit->isTruncated() ? QString() : m_contentEdit->toHtml();
     QString tags = m_tagEdit->text();
     int catId = m_catId;
     QString color = m_colorGroup->checkedButton() ? m_colorGroup->checkedButton()->property("color").toString() : "";
@@ -6,6 +6,94 @@
 #include <QSettings>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QToolTip>
+
+// 版面视图：原图压暗后铺满可用区域，各文字块在原位置画出边框与文字，点击复制该块
+class OCRLayoutView : public QWidget {
+public:
+    explicit OCRLayoutView(const QImage& image, QWidget* parent = nullptr) : QWidget(parent), m_image(image) {
+        setMouseTracking(true);
+    }
+
+    void setBlocks(const QList<OCRBlock>& blocks) {
+        m_blocks = blocks;
+        m_hovered = -1;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent*) override {
+        QPainter p(this);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setRenderHint(QPainter::SmoothPixmapTransform);
+        p.fillRect(rect(), QColor("#1E1E1E"));
+        if (m_image.isNull()) return;
+
+        p.drawImage(imageRect(), m_image);
+        p.fillRect(imageRect(), QColor(0, 0, 0, 150));
+        for (int i = 0; i < m_blocks.size(); ++i) {
+            const QRectF r = mapRect(m_blocks[i].rect);
+            p.setPen(QPen(i == m_hovered ? QColor("#4a90e2") : QColor("#007ACC"), 1));
+            p.setBrush(i == m_hovered ? QColor(74, 144, 226, 70) : QColor(0, 122, 204, 35));
+            p.drawRoundedRect(r, 2, 2);
+
+            // 字号按块高度与行数估算，过长时由 elide 截断
+            const QStringList lines = m_blocks[i].text.split('\n');
+            QFont font("Microsoft YaHei");
+            font.setPixelSize(qBound(9, int(r.height() / qMax(1, int(lines.size())) * 0.75), 18));
+            p.setFont(font);
+            p.setPen(QColor("#EEEEEE"));
+            const QFontMetrics fm(font);
+            qreal y = r.top() + (r.height() - fm.height() * lines.size()) / 2;
+            for (const QString& line : lines) {
+                p.drawText(QRectF(r.left() + 2, y, r.width() - 4, fm.height()), Qt::AlignLeft | Qt::AlignVCenter,
+                           fm.elidedText(line, Qt::ElideRight, int(r.width()) - 4));
+                y += fm.height();
+            }
+        }
+    }
+
+    void mouseMoveEvent(QMouseEvent* event) override {
+        const int index = blockAt(event->position());
+        if (index != m_hovered) {
+            m_hovered = index;
+            setCursor(index >= 0 ? Qt::PointingHandCursor : Qt::ArrowCursor);
+            update();
+        }
+    }
+
+    void mousePressEvent(QMouseEvent* event) override {
+        const int index = blockAt(event->position());
+        if (index < 0) return;
+        QApplication::clipboard()->setText(m_blocks[index].text);
+        QToolTip::showText(event->globalPosition().toPoint(), "已复制该块文字", this);
+    }
+
+private:
+    QRectF imageRect() const {
+        const QSizeF size = QSizeF(m_image.size()).scaled(QSizeF(this->size()), Qt::KeepAspectRatio);
+        return QRectF(QPointF((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+    }
+
+    QRectF mapRect(const QRect& r) const {
+        const QRectF target = imageRect();
+        const qreal s = target.width() / m_image.width();
+        return QRectF(target.left() + r.x() * s, target.top() + r.y() * s, r.width() * s, r.height() * s);
+    }
+
+    int blockAt(const QPointF& pos) const {
+        for (int i = 0; i < m_blocks.size(); ++i) {
+            if (mapRect(m_blocks[i].rect).contains(pos)) return i;
+        }
+        return -1;
+    }
+
+    QImage m_image;
+    QList<OCRBlock> m_blocks;
+    int m_hovered = -1;
+};
 
 OCRResultWindow::OCRResultWindow(const QImage& image, QWidget* parent)
     : FramelessDialog("识别文本", parent), m_image(image)
@@ -59,7 +147,11 @@ OCRResultWindow::OCRResultWindow(const QImage& image, QWidget* parent)
             height: 0px;
         }
     )");
-    layout->addWidget(m_textEdit);
+    m_layoutView = new OCRLayoutView(m_image);
+    m_stack = new QStackedWidget();
+    m_stack->addWidget(m_textEdit);
+    m_stack->addWidget(m_layoutView);
+    layout->addWidget(m_stack);
 
     auto* bottomLayout = new QHBoxLayout();
     bottomLayout->setSpacing(10);
@@ -72,6 +164,17 @@ OCRResultWindow::OCRResultWindow(const QImage& image, QWidget* parent)
 
     bottomLayout->addStretch(1);
 
+    m_layoutBtn = new QPushButton("版面");
+    m_layoutBtn->setFlat(true);
+    m_layoutBtn->setCheckable(true);
+    m_layoutBtn->setEnabled(false);
+    m_layoutBtn->setToolTip("在原图位置查看各文字块，点击复制该块");
+    m_layoutBtn->setStyleSheet("QPushButton { color: #9b59b6; border: none; font-size: 13px; } QPushButton:hover { color: #be90d4; } "
+                               "QPushButton:checked { color: #be90d4; font-weight: bold; } QPushButton:disabled { color: #555; }");
+    m_layoutBtn->setCursor(Qt::PointingHandCursor);
+    connect(m_layoutBtn, &QPushButton::toggled, this, &OCRResultWindow::onLayoutToggled);
+    bottomLayout->addWidget(m_layoutBtn);
+
     QPushButton* toSimplifiedBtn = new QPushButton("转简体");
     toSimplifiedBtn->setFlat(true);
     toSimplifiedBtn->setStyleSheet("QPushButton { color: #1abc9c; border: none; font-size: 13px; } QPushButton:hover { color: #2ecc71; }");
@@ -131,6 +234,21 @@ void OCRResultWindow::setRecognizedText(const QString& text, int contextId) {
     }
 }
 
+void OCRResultWindow::setRecognizedResult(const OCRResult& result) {
+    m_layoutView->setBlocks(result.blocks);
+    m_layoutBtn->setEnabled(!result.blocks.isEmpty());
+    if (result.blocks.isEmpty()) m_layoutBtn->setChecked(false);
+
+    m_textEdit->setPlainText(result.text);
+    if (m_autoCopyCheck->isChecked()) {
+        onCopyClicked();
+    }
+}
+
+void OCRResultWindow::onLayoutToggled(bool checked) {
+    m_stack->setCurrentWidget(checked ? static_cast<QWidget*>(m_layoutView) : m_textEdit);
+}
+
 void OCRResultWindow::onCopyClicked() {
     QString text = m_textEdit->toPlainText();
     if (!text.isEmpty()) {
@@ -7,19 +7,29 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QStackedWidget>
+#include "../core/OCRManager.h"
+
+class OCRLayoutView;
 
 class OCRResultWindow : public FramelessDialog {
     Q_OBJECT
 public:
     explicit OCRResultWindow(const QImage& image, QWidget* parent = nullptr);
     void setRecognizedText(const QString& text, int contextId);
+    // 带文字块位置的结果：可切换到版面视图，在原图对应位置查看与复制各块文字
+    void setRecognizedResult(const OCRResult& result);
 
 private slots:
     void onCopyClicked();
     void onTypesettingClicked();
+    void onLayoutToggled(bool checked);
 
 private:
+    QStackedWidget* m_stack;
     QPlainTextEdit* m_textEdit;
+    OCRLayoutView* m_layoutView;
+    QPushButton* m_layoutBtn;
     QCheckBox* m_autoCopyCheck;
     QImage m_image;
 };
@@ -1,6 +1,7 @@
 #include "OCRWindow.h"
 #include "IconHelper.h"
 #include "../core/OCRManager.h"
+#include "../core/OCRBatch.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QMimeData>
@@ -11,24 +12,32 @@
 #include <QFileInfo>
 #include <QDateTime>
 #include <QThread>
+#include <QImageReader>
 
 OCRWindow::OCRWindow(QWidget* parent) : FramelessDialog("文字识别", parent) {
     setFixedSize(800, 500);
     setAcceptDrops(true);
 
+    m_batch = new OCRBatch(this);
+    connect(m_batch, &OCRBatch::itemFinished, this, &OCRWindow::onItemRecognized);
+    connect(m_batch, &OCRBatch::progress, this, [this](int finished, int total) {
+        m_progressBar->setMaximum(total);
+        m_progressBar->setValue(finished);
+    });
+    connect(m_batch, &OCRBatch::finished, this, [this]() {
+        qDebug() << "[OCR] 所有任务处理完成";
+        QTimer::singleShot(1000, m_progressBar, &QProgressBar::hide); // 完成1秒后隐藏
+        updateRightDisplay();
+    });
+
     initUI();
     onClearResults();
     
-    qDebug() << "[OCR] OCRWindow 初始化完成，使用顺序处理模式";
-    
-    connect(&OCRManager::instance(), &OCRManager::recognitionFinished, 
-            this, &OCRWindow::onRecognitionFinished, 
-            static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
+    qDebug() << "[OCR] OCRWindow 初始化完成，并行识别上限:" << OCRManager::instance().maxConcurrency();
 }
 
 OCRWindow::~OCRWindow() {
-    m_processingQueue.clear();
-    m_isProcessing = false;
+    m_batch->cancel();
 }
 
 void OCRWindow::initUI() {
@@ -65,6 +74,13 @@ void OCRWindow::initUI() {
     connect(btnClear, &QPushButton::clicked, this, &OCRWindow::onClearResults);
     leftLayout->addWidget(btnClear);
 
+    auto* btnStop = new QPushButton(" 停止识别");
+    btnStop->setIcon(IconHelper::getIcon("close", "#ddbbbb"));
+    btnStop->setFixedHeight(36);
+    btnStop->setStyleSheet("QPushButton { background: #333; color: #ccc; border: 1px solid #444; border-radius: 4px; padding: 0 10px; text-align: left; } QPushButton:hover { background: #444; color: #fff; }");
+    connect(btnStop, &QPushButton::clicked, this, &OCRWindow::onStopRecognition);
+    leftLayout->addWidget(btnStop);
+
     leftLayout->addStretch();
 
     auto* btnCopy = new QPushButton(" 复制文字");
@@ -139,55 +155,33 @@ void OCRWindow::onPasteAndRecognize() {
     
     const QClipboard* clipboard = QApplication::clipboard();
     const QMimeData* mimeData = clipboard->mimeData();
-
-    QList<QPair<QImage, QString>> imageData;
-
     if (!mimeData) return;
 
+    int count = 0;
     if (mimeData->hasImage()) {
         QImage img = qvariant_cast<QImage>(mimeData->imageData());
         if (!img.isNull()) {
-            imageData.append({img, "粘贴的图片"});
+            addItem("粘贴的图片", img);
+            count++;
         }
     } else if (mimeData->hasUrls()) {
         for (const QUrl& url : mimeData->urls()) {
+            if (count >= kMaxImages) {
+                qDebug() << "[OCR] 粘贴识别: 图片数量超过限制，仅处理前" << kMaxImages << "张";
+                break;
+            }
             QString path = url.toLocalFile();
-            if (!path.isEmpty()) {
-                QImage img(path);
-                if (!img.isNull()) {
-                    imageData.append({img, QFileInfo(path).fileName()});
-                }
+            // 只读文件头判断能否解码，真正的解码放到识别线程
+            if (!path.isEmpty() && QImageReader(path).canRead()) {
+                addItem(QFileInfo(path).fileName(), QImage(), path);
+                count++;
             }
         }
     }
 
-    if (!imageData.isEmpty()) {
-        // 限制最多 10 张图片
-        if (imageData.size() > 10) {
-            qDebug() << "[OCR] 粘贴识别: 图片数量超过限制，仅处理前 10 张";
-            imageData = imageData.mid(0, 10);
-        }
-        
-        qDebug() << "[OCR] 粘贴识别: 开始处理" << imageData.size() << "张图片";
-        QList<QImage> imgs;
-        for (auto& p : imageData) {
-            OCRItem item;
-            item.image = p.first;
-            item.name = p.second;
-            item.id = ++m_lastUsedId;
-            item.sessionVersion = m_sessionVersion;
-            m_items.append(item);
-            imgs << p.first;
-            qDebug() << "[OCR] 添加任务 ID:" << item.id << "名称:" << item.name;
-
-            auto* listItem = new QListWidgetItem(item.name, m_itemList);
-            listItem->setData(Qt::UserRole, item.id);
-            listItem->setIcon(IconHelper::getIcon("image", "#888"));
-        }
-        processImages(imgs);
-        
-        // 自动选中第一个新加入的项目
-        m_itemList->setCurrentRow(m_itemList->count() - imageData.size());
+    if (count > 0) {
+        qDebug() << "[OCR] 粘贴识别: 开始处理" << count << "张图片";
+        startBatch(count);
     }
 }
 
@@ -200,43 +194,27 @@ void OCRWindow::onBrowseAndRecognize() {
 
     qDebug() << "[OCR] 浏览识别: 选择了" << files.size() << "个文件";
     
-    // 限制最多 10 张图片
-    if (files.size() > 10) {
-        qDebug() << "[OCR] 浏览识别: 文件数量超过限制，仅处理前 10 个";
-        files = files.mid(0, 10);
+    if (files.size() > kMaxImages) {
+        qDebug() << "[OCR] 浏览识别: 文件数量超过限制，仅处理前" << kMaxImages << "个";
+        files = files.mid(0, kMaxImages);
     }
     
-    QList<QImage> imgs;
+    int count = 0;
     for (const QString& file : std::as_const(files)) {
-        QImage img(file);
-        if (!img.isNull()) {
-            OCRItem item;
-            item.image = img;
-            item.name = QFileInfo(file).fileName();
-            item.id = ++m_lastUsedId;
-            item.sessionVersion = m_sessionVersion;
-            m_items.append(item);
-            imgs << img;
-            qDebug() << "[OCR] 添加任务 ID:" << item.id << "文件:" << file;
-
-            auto* listItem = new QListWidgetItem(item.name, m_itemList);
-            listItem->setData(Qt::UserRole, item.id);
-            listItem->setIcon(IconHelper::getIcon("image", "#888"));
+        if (QImageReader(file).canRead()) {
+            addItem(QFileInfo(file).fileName(), QImage(), file);
+            count++;
         }
     }
 
-    if (!imgs.isEmpty()) {
-        processImages(imgs);
-        m_itemList->setCurrentRow(m_itemList->count() - imgs.size());
-    }
+    if (count > 0) startBatch(count);
 }
 
 void OCRWindow::onClearResults() {
     qDebug() << "[OCR] 清空结果";
     
-    m_isProcessing = false;
-    m_processingQueue.clear();
-    m_sessionVersion++; // 递增版本号，使旧的回调失效
+    // 取消后旧任务迟到的结果会被 OCRBatch 丢弃
+    m_batch->cancel();
     
     m_itemList->clear();
     m_items.clear();
@@ -256,6 +234,21 @@ void OCRWindow::onClearResults() {
     m_itemList->setCurrentItem(summaryItem);
 }
 
+void OCRWindow::onStopRecognition() {
+    if (!m_batch->isRunning()) return;
+    m_batch->cancel();
+
+    // 保留已完成的结果，其余标记为已取消
+    for (auto& item : m_items) {
+        if (!item.isFinished) {
+            item.result = "已取消";
+            item.isFinished = true;
+        }
+    }
+    m_progressBar->hide();
+    updateRightDisplay();
+}
+
 void OCRWindow::dragEnterEvent(QDragEnterEvent* event) {
     if (event->mimeData()->hasImage() || event->mimeData()->hasUrls()) {
         event->acceptProposedAction();
@@ -269,127 +262,56 @@ void OCRWindow::dropEvent(QDropEvent* event) {
     onClearResults();
     
     const QMimeData* mime = event->mimeData();
-    QList<QImage> imgsToProcess;
-
-    // 限制最多 10 张图片
     int imageCount = 0;
-    const int MAX_IMAGES = 10;
 
     if (mime->hasImage()) {
         QImage img = qvariant_cast<QImage>(mime->imageData());
-        if (!img.isNull() && imageCount < MAX_IMAGES) {
-            OCRItem item;
-            item.image = img;
-            item.name = "拖入的图片";
-            item.id = ++m_lastUsedId;
-            item.sessionVersion = m_sessionVersion;
-            m_items.append(item);
-            imgsToProcess << img;
+        if (!img.isNull()) {
+            addItem("拖入的图片", img);
             imageCount++;
-
-            auto* listItem = new QListWidgetItem(item.name, m_itemList);
-            listItem->setData(Qt::UserRole, item.id);
-            listItem->setIcon(IconHelper::getIcon("image", "#888"));
         }
     }
 
     if (mime->hasUrls()) {
         for (const QUrl& url : mime->urls()) {
-            if (imageCount >= MAX_IMAGES) {
-                qDebug() << "[OCR] 拖入识别: 已达到最大图片数量限制 (10 张)";
+            if (imageCount >= kMaxImages) {
+                qDebug() << "[OCR] 拖入识别: 已达到最大图片数量限制" << kMaxImages;
                 break;
             }
             
             QString path = url.toLocalFile();
-            if (!path.isEmpty()) {
-                QImage img(path);
-                if (!img.isNull()) {
-                    OCRItem item;
-                    item.image = img;
-                    item.name = QFileInfo(path).fileName();
-                    item.id = ++m_lastUsedId;
-                    item.sessionVersion = m_sessionVersion;
-                    m_items.append(item);
-                    imgsToProcess << img;
-                    imageCount++;
-
-                    auto* listItem = new QListWidgetItem(item.name, m_itemList);
-                    listItem->setData(Qt::UserRole, item.id);
-                    listItem->setIcon(IconHelper::getIcon("image", "#888"));
-                }
+            if (!path.isEmpty() && QImageReader(path).canRead()) {
+                addItem(QFileInfo(path).fileName(), QImage(), path);
+                imageCount++;
             }
         }
     }
 
-    if (!imgsToProcess.isEmpty()) {
-        processImages(imgsToProcess);
-        m_itemList->setCurrentRow(m_itemList->count() - imgsToProcess.size());
+    if (imageCount > 0) {
+        startBatch(imageCount);
         event->acceptProposedAction();
     }
 }
 
-void OCRWindow::processImages(const QList<QImage>& images) {
-    qDebug() << "[OCR] processImages: 添加" << images.size() << "张图片到队列";
-    
-    m_processingQueue.clear(); // 清空旧队列
-    
-    // 将所有图片添加到队列
-    int startIdx = m_items.size() - images.size();
-    for (int i = 0; i < images.size(); ++i) {
-        int taskId = m_items[startIdx + i].id;
-        m_processingQueue.enqueue(taskId);
-        qDebug() << "[OCR] 添加到队列 ID:" << taskId;
-    }
-    
-    // 显示并初始化进度条
-    if (m_progressBar && !images.isEmpty()) {
-        m_progressBar->setMaximum(images.size()); // 仅当前批次
-        m_progressBar->setValue(0);
-        m_progressBar->show();
-    }
-    
-    // 如果当前没有在处理，立即开始处理
-    if (!m_isProcessing) {
-        qDebug() << "[OCR] 开始顺序处理";
-        processNextImage();
-    }
+void OCRWindow::addItem(const QString& name, const QImage& image, const QString& path) {
+    OCRItem item;
+    item.name = name;
+    item.id = ++m_lastUsedId;
+    m_items.append(item);
+    qDebug() << "[OCR] 添加任务 ID:" << item.id << "名称:" << item.name;
+
+    auto* listItem = new QListWidgetItem(item.name, m_itemList);
+    listItem->setData(Qt::UserRole, item.id);
+    listItem->setIcon(IconHelper::getIcon("image", "#888"));
+
+    if (path.isEmpty()) m_batch->add(image, item.id);
+    else m_batch->addFile(path, item.id);
 }
 
-void OCRWindow::processNextImage() {
-    // 检查队列是否为空
-    if (m_processingQueue.isEmpty()) {
-        qDebug() << "[OCR] 所有任务处理完成";
-        m_isProcessing = false;
-        updateRightDisplay();
-        return;
-    }
-    
-    m_isProcessing = true;
-    int taskId = m_processingQueue.dequeue();
-    
-    qDebug() << "[OCR] 开始处理 ID:" << taskId << "剩余:" << m_processingQueue.size();
-    
-    // 找到对应的图片
-    OCRItem* item = nullptr;
-    for (auto& it : m_items) {
-        if (it.id == taskId) {
-            item = &it;
-            break;
-        }
-    }
-    
-    if (!item) {
-        qDebug() << "[OCR] 错误: 未找到任务 ID:" << taskId;
-        // 继续处理下一个
-        QMetaObject::invokeMethod(this, &OCRWindow::processNextImage, Qt::QueuedConnection);
-        return;
-    }
-    
-    // 启动异步识别
-    // 注意：这里我们使用 recognizeAsync，它会在后台线程运行
-    // 识别完成后会发射 recognitionFinished 信号，我们在槽函数中触发下一个任务
-    qDebug() << "[OCR] 调用 recognizeAsync ID:" << taskId;
-    OCRManager::instance().recognizeAsync(item->image, taskId);
+void OCRWindow::startBatch(int count) {
+    if (m_progressBar) m_progressBar->show();
+    // 自动选中第一个新加入的项目
+    m_itemList->setCurrentRow(m_itemList->count() - count);
 }
 
 
@@ -397,58 +319,32 @@ void OCRWindow::onItemSelectionChanged() {
     updateRightDisplay();
 }
 
-void OCRWindow::onRecognitionFinished(const QString& text, int contextId) {
-    qDebug() << "[OCR] onRecognitionFinished: 收到识别结果 ID:" << contextId 
-             << "线程:" << QThread::currentThread() << "文本长度:" << text.length();
-    
-    bool found = false;
+void OCRWindow::onItemRecognized(int index, const OCRResult& result, const QVariant& tag) {
+    const int id = tag.toInt();
+    qDebug() << "[OCR] 收到识别结果 序号:" << index << "ID:" << id << "文本长度:" << result.text.length();
+
     for (auto& item : m_items) {
-        if (item.id == contextId) {
-            // 检查会话版本号
-            if (item.sessionVersion != m_sessionVersion) {
-                qDebug() << "[OCR] 忽略过期回调 ID:" << contextId 
-                         << "任务会话:" << item.sessionVersion 
-                         << "当前会话:" << m_sessionVersion;
-                // 注意：旧任务的回调不应该触发下一个新任务的处理
-                // 因为新任务的处理循环是由新的 processImages 启动的
-                return; 
-            }
-            
-            item.result = text.trimmed();
+        if (item.id == id) {
+            // 出错或无字时 text 为提示信息，照常显示给用户
+            item.result = result.text.trimmed();
             item.isFinished = true;
-            found = true;
-            qDebug() << "[OCR] 更新任务状态 ID:" << contextId << "名称:" << item.name;
             break;
         }
     }
-    
-    if (!found) {
-        // 如果未找到任务（可能已被清空），也不要触发下一个
-        qDebug() << "[OCR] 警告: 未找到对应的任务 ID:" << contextId;
-        return;
-    }
-    
-    // 统计完成进度
-    int finished = 0;
-    for (const auto& item : std::as_const(m_items)) {
-        if (item.isFinished) finished++;
-    }
-    qDebug() << "[OCR] 识别进度:" << finished << "/" << m_items.size();
-    
-    // 更新进度条
-    if (m_progressBar) {
-        m_progressBar->setValue(finished);
-        if (finished >= m_items.size()) {
-            QTimer::singleShot(1000, m_progressBar, &QProgressBar::hide); // 完成1秒后隐藏
+
+    // 逐项进度：完成的项目图标变为绿色
+    for (int row = 0; row < m_itemList->count(); ++row) {
+        QListWidgetItem* listItem = m_itemList->item(row);
+        if (listItem->data(Qt::UserRole).toInt() == id) {
+            listItem->setIcon(IconHelper::getIcon("image", "#2ecc71"));
+            break;
         }
     }
-    
-    // 延迟到主线程更新UI
-    QMetaObject::invokeMethod(this, &OCRWindow::updateRightDisplay, Qt::QueuedConnection);
-    
-    // 延迟到下一个事件循环处理任务，避免栈溢出
-    qDebug() << "[OCR] 当前任务完成，准备处理下一个";
-    QMetaObject::invokeMethod(this, &OCRWindow::processNextImage, Qt::QueuedConnection);
+
+    // 只有正在查看的项目 (或汇总) 受影响时才刷新右侧
+    auto* current = m_itemList->currentItem();
+    const int currentId = current ? current->data(Qt::UserRole).toInt() : -1;
+    if (currentId == 0 || currentId == id) updateRightDisplay();
 }
 
 void OCRWindow::updateRightDisplay() {
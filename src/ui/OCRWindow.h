@@ -10,8 +10,11 @@
 #include <QMap>
 #include <QListWidget>
 #include <QTimer>
-#include <QQueue>
 #include <QProgressBar>
+#include <QVariant>
+#include "../core/OCRManager.h"
+
+class OCRBatch;
 
 class OCRWindow : public FramelessDialog {
     Q_OBJECT
@@ -23,10 +26,10 @@ private slots:
     void onPasteAndRecognize();
     void onBrowseAndRecognize();
     void onClearResults();
+    void onStopRecognition();
     void onCopyResult();
     void onItemSelectionChanged();
-    void processNextImage();  // 处理队列中的下一张图片
-    void onRecognitionFinished(const QString& text, int contextId);
+    void onItemRecognized(int index, const OCRResult& result, const QVariant& tag);
 
 protected:
     void dragEnterEvent(QDragEnterEvent* event) override;
@@ -34,16 +37,19 @@ protected:
 
 private:
     void initUI();
-    void processImages(const QList<QImage>& images);
+    // 单次导入的图片数上限 (识别已并行，不再限制为 10 张)
+    static constexpr int kMaxImages = 200;
+
+    // 新建列表项；图片与文件路径二选一，文件交给识别线程解码
+    void addItem(const QString& name, const QImage& image, const QString& path = QString());
+    void startBatch(int count);
     void updateRightDisplay();
 
     struct OCRItem {
-        QImage image;
         QString name;
         QString result;
         bool isFinished = false;
         int id = -1;
-        int sessionVersion = 0;
     };
 
     QListWidget* m_itemList = nullptr;
@@ -52,11 +58,9 @@ private:
     
     QList<OCRItem> m_items;
     int m_lastUsedId = 0;
-    int m_sessionVersion = 0;
-    
-    // 顺序处理队列
-    QQueue<int> m_processingQueue;  // 待处理的任务 ID 队列
-    bool m_isProcessing = false;  // 是否正在处理
+
+    // 并行识别调度：tag 为 OCRItem::id
+    OCRBatch* m_batch = nullptr;
 };
 
 #endif // OCRWINDOW_H
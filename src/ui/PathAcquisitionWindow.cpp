@@ -1,5 +1,6 @@
 #include "PathAcquisitionWindow.h"
 #include "IconHelper.h"
+#include "../core/IgnoreMatcher.h"
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QMimeData>
@@ -8,7 +9,6 @@
 #include <QGraphicsDropShadowEffect>
 #include <QHBoxLayout>
 #include <QToolTip>
-#include <QDirIterator>
 #include <QDir>
 #include <QFileInfo>
 #include <QCheckBox>
@@ -17,6 +17,74 @@
 #include <QProcess>
 #include <QDesktopServices>
 #include <QFileDialog>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+
+// ----------------------------------------------------------------------------
+// PathExpandThread 实现
+// ----------------------------------------------------------------------------
+PathExpandThread::PathExpandThread(const QList<QUrl>& urls, const Options& options, QObject* parent)
+    : QThread(parent), m_urls(urls), m_options(options) {}
+
+void PathExpandThread::stop() {
+    m_isRunning = false;
+    wait();
+}
+
+void PathExpandThread::run() {
+    int count = 0;
+    QStringList batch;
+    QElapsedTimer timer;
+    timer.start();
+
+    // 攒够一批或间隔到期才回传，避免逐条跨线程投递把 GUI 事件队列塞满
+    auto flush = [&]() {
+        if (batch.isEmpty()) return;
+        emit batchReady(batch);
+        emit progress(count);
+        batch.clear();
+        timer.restart();
+    };
+    auto push = [&](const QString& path) {
+        batch << path;
+        count++;
+        if (batch.size() >= kBatchSize || timer.elapsed() >= kBatchIntervalMs) flush();
+    };
+
+    // 设置了扩展名过滤时只列文件，目录本身不再列出
+    const IgnoreMatcher::WalkFlags flags = m_options.extensions.isEmpty()
+        ? (IgnoreMatcher::Files | IgnoreMatcher::Dirs)
+        : IgnoreMatcher::WalkFlags(IgnoreMatcher::Files);
+
+    for (const QUrl& url : std::as_const(m_urls)) {
+        if (!m_isRunning) break;
+        QString path = url.toLocalFile();
+        if (path.isEmpty()) continue;
+
+        if (m_options.recursive && QFileInfo(path).isDir()) {
+            // 与文件查找共用忽略规则，node_modules / .git 等目录整棵跳过
+            IgnoreMatcher matcher;
+            matcher.walk(path, [&](const QFileInfo& info) {
+                if (!m_isRunning) return false;
+                if (!m_options.extensions.isEmpty() && !m_options.extensions.contains(info.suffix().toLower())) {
+                    return true;
+                }
+                push(QDir::fromNativeSeparators(info.absoluteFilePath()));
+                return true;
+            }, flags, m_options.maxDepth);
+        } else {
+            // 默认行为：只添加该路径本身 (统一路径分隔符)
+            push(QDir::fromNativeSeparators(path));
+        }
+    }
+
+    flush();
+    emit finished(count, !m_isRunning);
+}
+
+// ----------------------------------------------------------------------------
+// PathAcquisitionWindow 实现
+// ----------------------------------------------------------------------------
 
 PathAcquisitionWindow::PathAcquisitionWindow(QWidget* parent) : FramelessDialog("路径提取", parent) {
     setAcceptDrops(true);
@@ -26,6 +94,7 @@ PathAcquisitionWindow::PathAcquisitionWindow(QWidget* parent) : FramelessDialog(
 }
 
 PathAcquisitionWindow::~PathAcquisitionWindow() {
+    stopExpansion();
 }
 
 void PathAcquisitionWindow::initUI() {
@@ -78,6 +147,30 @@ void PathAcquisitionWindow::initUI() {
     });
     leftLayout->addWidget(m_recursiveCheck);
 
+    // 递归深度与扩展名过滤在遍历过程中生效，被排除的子树不会被展开
+    m_depthSpin = new QSpinBox();
+    m_depthSpin->setRange(0, 64);
+    m_depthSpin->setPrefix("深度: ");
+    m_depthSpin->setSpecialValueText("深度: 不限");
+    m_depthSpin->setEnabled(false);
+    m_depthSpin->setStyleSheet("QSpinBox { background: #252526; border: 1px solid #333; border-radius: 4px; color: #ccc; padding: 3px; font-size: 12px; }");
+    connect(m_depthSpin, &QSpinBox::valueChanged, this, [this](int){
+        if (!m_currentUrls.isEmpty()) processStoredUrls();
+    });
+    leftLayout->addWidget(m_depthSpin);
+
+    m_extFilterEdit = new QLineEdit();
+    m_extFilterEdit->setPlaceholderText("扩展名过滤，如 cpp;h");
+    m_extFilterEdit->setEnabled(false);
+    m_extFilterEdit->setStyleSheet("QLineEdit { background: #252526; border: 1px solid #333; border-radius: 4px; color: #ccc; padding: 4px; font-size: 12px; }");
+    connect(m_extFilterEdit, &QLineEdit::editingFinished, this, [this](){
+        if (!m_currentUrls.isEmpty()) processStoredUrls();
+    });
+    leftLayout->addWidget(m_extFilterEdit);
+
+    connect(m_recursiveCheck, &QCheckBox::toggled, m_depthSpin, &QSpinBox::setEnabled);
+    connect(m_recursiveCheck, &QCheckBox::toggled, m_extFilterEdit, &QLineEdit::setEnabled);
+
     auto* tipLabel = new QLabel("提示：切换选项会自动刷新\n无需重新拖入");
     tipLabel->setStyleSheet("color: #666; font-size: 11px;");
     tipLabel->setAlignment(Qt::AlignLeft);
@@ -114,6 +207,21 @@ void PathAcquisitionWindow::initUI() {
     });
     rightLayout->addWidget(m_pathList);
 
+    // 遍历进度与取消
+    auto* statusLayout = new QHBoxLayout();
+    m_statusLabel = new QLabel();
+    m_statusLabel->setStyleSheet("color: #666; font-size: 11px;");
+    m_cancelBtn = new QPushButton("取消");
+    m_cancelBtn->setCursor(Qt::PointingHandCursor);
+    m_cancelBtn->setStyleSheet("QPushButton { background: #333; color: #ccc; border: none; border-radius: 4px; padding: 3px 10px; font-size: 11px; } QPushButton:hover { background: #444; }");
+    m_cancelBtn->hide();
+    connect(m_cancelBtn, &QPushButton::clicked, this, [this](){
+        if (m_expandThread) m_expandThread->stop();
+    });
+    statusLayout->addWidget(m_statusLabel, 1);
+    statusLayout->addWidget(m_cancelBtn);
+    rightLayout->addLayout(statusLayout);
+
     mainLayout->addWidget(rightPanel);
 }
 
@@ -156,41 +264,57 @@ void PathAcquisitionWindow::dropEvent(QDropEvent* event) {
 }
 
 void PathAcquisitionWindow::hideEvent(QHideEvent* event) {
+    stopExpansion();
+    m_statusLabel->clear();
     m_currentUrls.clear();
     m_pathList->clear();
     FramelessDialog::hideEvent(event);
 }
 
+void PathAcquisitionWindow::stopExpansion() {
+    ++m_expandGeneration;
+    if (m_expandThread) {
+        m_expandThread->stop();
+        m_expandThread->deleteLater();
+        m_expandThread = nullptr;
+    }
+    m_cancelBtn->hide();
+}
+
 void PathAcquisitionWindow::processStoredUrls() {
+    stopExpansion();
     m_pathList->clear();
-    
-    QStringList paths;
-    for (const QUrl& url : std::as_const(m_currentUrls)) {
-        QString path = url.toLocalFile();
-        if (!path.isEmpty()) {
-            QFileInfo fileInfo(path);
-            
-            // 如果选中递归且是目录，则遍历
-            if (m_recursiveCheck->isChecked() && fileInfo.isDir()) {
-                QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-                while (it.hasNext()) {
-                    QString subPath = it.next();
-                    // 统一路径分隔符
-                    subPath.replace("\\", "/");
-                    m_pathList->addItem(subPath);
-                    paths << subPath;
-                }
-            } else {
-                // 默认行为：只添加该路径本身
-                // 统一路径分隔符
-                path.replace("\\", "/");
-                m_pathList->addItem(path);
-                paths << path;
-            }
-        }
+
+    PathExpandThread::Options options;
+    options.recursive = m_recursiveCheck->isChecked();
+    options.maxDepth = m_depthSpin->value();
+    for (QString ext : m_extFilterEdit->text().split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts)) {
+        ext = ext.toLower();
+        while (ext.startsWith('*') || ext.startsWith('.')) ext.remove(0, 1);
+        if (!ext.isEmpty()) options.extensions << ext;
     }
-    
-    m_pathList->scrollToBottom();
+
+    // 目录遍历放到后台线程，结果分批追加到列表
+    const int generation = m_expandGeneration;
+    m_expandThread = new PathExpandThread(m_currentUrls, options, this);
+    connect(m_expandThread, &PathExpandThread::batchReady, this, [this, generation](const QStringList& paths) {
+        if (generation != m_expandGeneration) return;
+        m_pathList->addItems(paths);
+        m_pathList->scrollToBottom();
+    });
+    connect(m_expandThread, &PathExpandThread::progress, this, [this, generation](int count) {
+        if (generation != m_expandGeneration) return;
+        m_statusLabel->setText(QString("正在遍历... 已找到 %1 项").arg(count));
+    });
+    connect(m_expandThread, &PathExpandThread::finished, this, [this, generation](int count, bool cancelled) {
+        if (generation != m_expandGeneration) return;
+        m_statusLabel->setText(cancelled ? QString("已取消，共 %1 项").arg(count) : QString("共 %1 项").arg(count));
+        m_cancelBtn->hide();
+    });
+
+    m_statusLabel->setText("正在遍历...");
+    m_cancelBtn->setVisible(options.recursive);
+    m_expandThread->start();
 }
 
 void PathAcquisitionWindow::onShowContextMenu(const QPoint& pos) {
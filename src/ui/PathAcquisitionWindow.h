@@ -10,6 +10,42 @@
 #include <QUrl>
 #include <QCheckBox>
 #include <QToolButton>
+#include <QSpinBox>
+#include <QLineEdit>
+#include <QThread>
+#include <atomic>
+
+/**
+ * @brief 路径展开线程：在后台递归遍历拖入的目录，分批回传结果
+ */
+class PathExpandThread : public QThread {
+    Q_OBJECT
+public:
+    struct Options {
+        bool recursive = false;
+        int maxDepth = 0;           // <= 0 表示不限深度
+        QStringList extensions;     // 小写、不带点；为空表示不过滤
+    };
+
+    PathExpandThread(const QList<QUrl>& urls, const Options& options, QObject* parent = nullptr);
+    void stop();
+
+    static constexpr int kBatchSize = 256;      // 每批最多条数
+    static constexpr int kBatchIntervalMs = 50; // 或距上次回传超过该时间
+
+signals:
+    void batchReady(const QStringList& paths);
+    void progress(int count);
+    void finished(int count, bool cancelled);
+
+protected:
+    void run() override;
+
+private:
+    QList<QUrl> m_urls;
+    Options m_options;
+    std::atomic<bool> m_isRunning{true};
+};
 
 class PathAcquisitionWindow : public FramelessDialog {
     Q_OBJECT
@@ -26,13 +62,21 @@ protected:
 private:
     void initUI();
     void updateDropHintStyle(bool dragging);
+    void stopExpansion();
 
     QListWidget* m_pathList;
     QToolButton* m_dropHint;
     QLabel* m_dropIconLabel;
     QLabel* m_dropTextLabel;
     QCheckBox* m_recursiveCheck;
+    QSpinBox* m_depthSpin;
+    QLineEdit* m_extFilterEdit;
+    QLabel* m_statusLabel;
+    QPushButton* m_cancelBtn;
     QPoint m_dragPos;
+
+    PathExpandThread* m_expandThread = nullptr;
+    int m_expandGeneration = 0;     // 丢弃已取消线程残留在事件队列中的批次
     
     QList<QUrl> m_currentUrls;  // 缓存当前拖入的 URL，用于自动刷新
     void processStoredUrls();   // 处理缓存的 URL
@@ -1016,7 +1016,8 @@ void QuickWindow::activateNote(const QModelIndex& index) {
             }
         }
     } else {
-        StringUtils::copyNoteToClipboard(content);
+        // 超大文本的 content 只是预览，复制时还原全文
+        StringUtils::copyNoteToClipboard(DatabaseManager::instance().getFullContent(note));
     }
 
     // hide(); // 用户要求不隐藏窗口
@@ -1175,7 +1176,7 @@ void QuickWindow::doExtractContent() {
         QVariantMap note = DatabaseManager::instance().getNoteById(id);
         QString type = note.value("item_type").toString();
         if (type == "text" || type.isEmpty()) {
-            QString content = note.value("content").toString();
+            QString content = DatabaseManager::instance().getFullContent(note);
             texts << StringUtils::htmlToPlainText(content);
         }
     }
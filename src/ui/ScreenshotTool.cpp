@@ -12,24 +12,10 @@
 #include <QStyleOption>
 #include <QColorDialog>
 #include <QSettings>
+#include <QCursor>
+#include <QDebug>
 #include <cmath>
 
-#ifdef Q_OS_WIN
-#include <windows.h>
-#include <dwmapi.h>
-#include <tchar.h>
-#pragma comment(lib, "dwmapi.lib")
-
-QRect getActualWindowRect(HWND hwnd) {
-    RECT rect;
-    if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(rect)))) {
-        return QRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
-    }
-    GetWindowRect(hwnd, &rect);
-    return QRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
-}
-#endif
-
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -306,12 +292,11 @@ ScreenshotTool::ScreenshotTool(QWidget* parent)
     setAttribute(Qt::WA_TranslucentBackground);
     setAttribute(Qt::WA_QuitOnClose, false);
     setAttribute(Qt::WA_DeleteOnClose);
-    setWindowState(Qt::WindowFullScreen);
     setMouseTracking(true);
-    m_screenPixmap = QGuiApplication::primaryScreen()->grabWindow(0);
-    QImage img = m_screenPixmap.toImage();
-    QImage small = img.scaled(img.width()/15, img.height()/15, Qt::IgnoreAspectRatio, Qt::FastTransformation);
-    m_mosaicPixmap = QPixmap::fromImage(small.scaled(img.size(), Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    m_openTimer.start();
+    // 覆盖所有屏幕：窗口坐标即相对虚拟桌面左上角的逻辑坐标
+    m_capture = ScreenCapture::grabAllScreens();
+    setGeometry(m_capture.geometry);
 
     QSettings settings("RapidNotes", "Screenshot");
     m_currentColor = settings.value("color", QColor(255, 50, 50)).value<QColor>();
@@ -376,6 +361,8 @@ void ScreenshotTool::drawArrow(QPainter& p, const QPointF& start, const QPointF&
 void ScreenshotTool::drawAnnotation(QPainter& p, const DrawingAnnotation& ann) {
     if (ann.points.size() < 2 && ann.type != ScreenshotToolType::Text && ann.type != ScreenshotToolType::Marker) return;
     p.setPen(QPen(ann.color, ann.strokeWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    // 缓存层的画笔在多条标注之间共用：不清掉画刷时，序号标记留下的填充色会把之后的画笔路径、矩形填满
+    p.setBrush(Qt::NoBrush);
     if (ann.type == ScreenshotToolType::Rect) p.drawRect(QRectF(ann.points[0], ann.points[1]).normalized());
     else if (ann.type == ScreenshotToolType::Ellipse) p.drawEllipse(QRectF(ann.points[0], ann.points[1]).normalized());
     else if (ann.type == ScreenshotToolType::Line) p.drawLine(ann.points[0], ann.points[1]);
@@ -397,7 +384,7 @@ void ScreenshotTool::drawAnnotation(QPainter& p, const DrawingAnnotation& ann) {
             QPainterPathStroker s; s.setWidth(ann.strokeWidth * 6);
             p.setClipPath(s.createStroke(path));
         }
-        p.drawPixmap(0, 0, m_mosaicPixmap); p.restore();
+        drawMosaic(p, p.clipBoundingRect()); p.restore();
     } else if (ann.type == ScreenshotToolType::Text && !ann.text.isEmpty()) {
         p.setPen(ann.color); p.setFont(QFont("Microsoft YaHei", 12 + ann.strokeWidth*2, QFont::Bold));
         p.drawText(ann.points[0], ann.text);
@@ -415,6 +402,7 @@ void ScreenshotTool::mousePressEvent(QMouseEvent* e) {
         if (selectionRect().contains(e->pos()) && m_currentTool != ScreenshotToolType::None && handle == -1) {
             if (m_currentTool == ScreenshotToolType::Text) { showTextInput(e->pos()); return; }
             m_isDrawing = true; m_currentAnnotation = {m_currentTool, {e->pos()}, m_currentColor, "", m_currentStrokeWidth, LineStyle::Solid, m_currentArrowStyle};
+            m_currentPath = QPainterPath(e->pos());
             if(m_currentTool == ScreenshotToolType::Marker) {
                 int c = 1; for(auto& a: m_annotations) if(a.type == ScreenshotToolType::Marker) c++;
                 m_currentAnnotation.text = QString::number(c);
@@ -432,13 +420,7 @@ void ScreenshotTool::mousePressEvent(QMouseEvent* e) {
 
 void ScreenshotTool::mouseMoveEvent(QMouseEvent* e) {
     if (m_state == ScreenshotState::Selecting && !m_isDragging) {
-        QRect smallest; long long minArea = -1;
-        for (const QRect& r : m_detectedRects) {
-            if (r.contains(e->pos())) {
-                long long area = (long long)r.width() * r.height();
-                if (minArea == -1 || area < minArea) { minArea = area; smallest = r; }
-            }
-        }
+        QRect smallest = m_windowIndex.smallestAt(e->pos());
         if (m_highlightedRect != smallest) { m_highlightedRect = smallest; update(); }
     }
     if (m_isDragging) {
@@ -452,7 +434,7 @@ void ScreenshotTool::mouseMoveEvent(QMouseEvent* e) {
                 }
                 if (hit) { m_redoStack.append(m_annotations.takeAt(i)); changed = true; }
             }
-            if (changed) update();
+            if (changed) { invalidateAnnotationLayer(); update(); }
             return;
         }
 
@@ -471,15 +453,27 @@ void ScreenshotTool::mouseMoveEvent(QMouseEvent* e) {
         }
     } else if (m_isDrawing) {
         updateToolbarPosition();
+        const QRect before = currentDirtyRect();
         if (m_currentTool == ScreenshotToolType::Arrow || m_currentTool == ScreenshotToolType::Line || m_currentTool == ScreenshotToolType::Rect || m_currentTool == ScreenshotToolType::Ellipse) {
             if (m_currentAnnotation.points.size() > 1) m_currentAnnotation.points[1] = e->pos(); else m_currentAnnotation.points.append(e->pos());
-        } else m_currentAnnotation.points.append(e->pos());
+        } else {
+            m_currentAnnotation.points.append(e->pos());
+            m_currentPath.lineTo(e->pos());
+            if (m_currentTool == ScreenshotToolType::Mosaic) {
+                // 马赛克叠画结果不变，新线段直接画进缓存层，不必每次为整条路径重新描边
+                ensureAnnotationLayer();
+                const QList<QPointF>& pts = m_currentAnnotation.points;
+                commitToLayer({ScreenshotToolType::Mosaic, {pts[pts.size() - 2], pts.last()}, m_currentColor, "", m_currentStrokeWidth, LineStyle::Solid, m_currentArrowStyle});
+            }
+        }
+        update(before.united(currentDirtyRect()));
+        return;
     } else updateCursor(e->pos());
     update();
 }
 
 void ScreenshotTool::mouseReleaseEvent(QMouseEvent* e) {
-    if (m_isDrawing) { m_isDrawing = false; m_annotations.append(m_currentAnnotation); m_redoStack.clear(); }
+    if (m_isDrawing) { m_isDrawing = false; m_annotations.append(m_currentAnnotation); m_redoStack.clear(); commitToLayer(m_currentAnnotation); }
     else if (m_isDragging) {
         m_isDragging = false;
         if (m_state == ScreenshotState::Selecting) {
@@ -504,9 +498,11 @@ void ScreenshotTool::updateToolbarPosition() {
     if (m_toolbar->isVisible()) m_toolbar->raise();
 }
 
-void ScreenshotTool::paintEvent(QPaintEvent*) {
+void ScreenshotTool::paintEvent(QPaintEvent* e) {
+    if (!m_firstFrameLogged) { m_firstFrameLogged = true; qDebug().noquote() << QString("[Screenshot] 打开到可操作：%1 ms").arg(m_openTimer.elapsed()); }
     QPainter p(this); p.setRenderHint(QPainter::Antialiasing);
-    p.drawPixmap(0,0,m_screenPixmap);
+    // 只绘制需要刷新的部分，直接读共享缓冲
+    p.drawImage(QRectF(e->rect()), m_capture.image, QRectF(m_capture.toPixels(e->rect())));
     QRect r = selectionRect(); QPainterPath path; path.addRect(rect());
     if(r.isValid()) path.addRect(r); p.fillPath(path, QColor(0,0,0,120));
 
@@ -516,8 +512,8 @@ void ScreenshotTool::paintEvent(QPaintEvent*) {
     if(r.isValid()) {
         p.setPen(QPen(QColor(0, 120, 255), 2)); p.drawRect(r);
         auto h = getHandleRects(); p.setBrush(Qt::white); for(auto& hr : h) p.drawEllipse(hr);
-        p.setClipRect(r); for(auto& a : m_annotations) drawAnnotation(p, a);
-        if(m_isDrawing) drawAnnotation(p, m_currentAnnotation);
+        p.setClipRect(r); ensureAnnotationLayer(); p.drawImage(r.topLeft(), m_annotationLayer);
+        if(m_isDrawing) drawCurrentAnnotation(p);
     }
 }
 
@@ -526,12 +522,12 @@ void ScreenshotTool::setDrawColor(const QColor& c) { m_currentColor = c; QSettin
 void ScreenshotTool::setDrawWidth(int w) { m_currentStrokeWidth = w; QSettings("RapidNotes", "Screenshot").setValue("strokeWidth", w); }
 void ScreenshotTool::setArrowStyle(ArrowStyle s) { m_currentArrowStyle = s; QSettings("RapidNotes", "Screenshot").setValue("arrowStyle", static_cast<int>(s)); }
 
-void ScreenshotTool::undo() { if(!m_annotations.isEmpty()) { m_redoStack.append(m_annotations.takeLast()); update(); } }
-void ScreenshotTool::redo() { if(!m_redoStack.isEmpty()) { m_annotations.append(m_redoStack.takeLast()); update(); } }
+void ScreenshotTool::undo() { if(!m_annotations.isEmpty()) { m_redoStack.append(m_annotations.takeLast()); invalidateAnnotationLayer(); update(); } }
+void ScreenshotTool::redo() { if(!m_redoStack.isEmpty()) { m_annotations.append(m_redoStack.takeLast()); commitToLayer(m_annotations.last()); update(); } }
 void ScreenshotTool::copyToClipboard() { QApplication::clipboard()->setImage(generateFinalImage()); cancel(); }
 void ScreenshotTool::save() { QString f = QFileDialog::getSaveFileName(this, "Save", "cap.png", "PNG(*.png)"); if(!f.isEmpty()) generateFinalImage().save(f); cancel(); }
 void ScreenshotTool::confirm() { emit screenshotCaptured(generateFinalImage()); cancel(); }
-void ScreenshotTool::pin() { QImage img = generateFinalImage(); if (img.isNull()) return; auto* widget = new PinnedScreenshotWidget(QPixmap::fromImage(img), selectionRect()); widget->show(); cancel(); }
+void ScreenshotTool::pin() { QImage img = generateFinalImage(); if (img.isNull()) return; auto* widget = new PinnedScreenshotWidget(QPixmap::fromImage(img), selectionRect().translated(geometry().topLeft())); widget->show(); cancel(); }
 
 QRect ScreenshotTool::selectionRect() const { return QRect(m_startPoint, m_endPoint).normalized(); }
 QList<QRect> ScreenshotTool::getHandleRects() const {
@@ -554,33 +550,20 @@ void ScreenshotTool::updateCursor(const QPoint& p) {
     setCursor(Qt::ArrowCursor);
 }
 void ScreenshotTool::showTextInput(const QPoint& p) { m_textInput->move(p); m_textInput->resize(100, 30); m_textInput->show(); m_textInput->setFocus(); }
-void ScreenshotTool::commitTextInput() { if(m_textInput->text().isEmpty()) { m_textInput->hide(); return; } m_annotations.append({ScreenshotToolType::Text, {m_textInput->pos()}, m_currentColor, m_textInput->text(), m_currentStrokeWidth}); m_textInput->hide(); m_textInput->clear(); update(); }
-
-#ifdef Q_OS_WIN
-BOOL CALLBACK EnumChildProc(HWND hwnd, LPARAM lParam) {
-    QList<QRect>* rects = reinterpret_cast<QList<QRect>*>(lParam);
-    if (IsWindowVisible(hwnd)) {
-        QRect qr = getActualWindowRect(hwnd); if (qr.width() > 5 && qr.height() > 5) rects->append(qr);
-    }
-    return TRUE;
-}
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-    QList<QRect>* rects = reinterpret_cast<QList<QRect>*>(lParam);
-    if (IsWindowVisible(hwnd) && !IsIconic(hwnd)) {
-        TCHAR className[256]; GetClassName(hwnd, className, 256);
-        if (_tcscmp(className, _T("Qt662QWindowIcon")) == 0) return TRUE;
-        int cloaked = 0; DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked));
-        if (cloaked) return TRUE;
-        QRect qr = getActualWindowRect(hwnd); if (qr.width() > 10 && qr.height() > 10) { rects->append(qr); EnumChildWindows(hwnd, EnumChildProc, lParam); }
-    }
-    return TRUE;
-}
-#endif
-void ScreenshotTool::detectWindows() { m_detectedRects.clear();
-#ifdef Q_OS_WIN
-    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&m_detectedRects));
-    QPoint offset = mapToGlobal(QPoint(0,0)); for(QRect& r : m_detectedRects) r.translate(-offset);
-#endif
+void ScreenshotTool::commitTextInput() { if(m_textInput->text().isEmpty()) { m_textInput->hide(); return; } m_annotations.append({ScreenshotToolType::Text, {m_textInput->pos()}, m_currentColor, m_textInput->text(), m_currentStrokeWidth}); commitToLayer(m_annotations.last()); m_textInput->hide(); m_textInput->clear(); update(); }
+
+void ScreenshotTool::detectWindows() {
+    // 本程序自己的窗口 (含截屏界面) 不参与吸附
+    QSet<quintptr> exclude;
+    for (QWidget* widget : QApplication::topLevelWidgets()) { if (widget->isVisible()) exclude.insert(static_cast<quintptr>(widget->winId())); }
+    const QPoint origin = m_capture.geometry.topLeft();
+    WindowDetector::detectAsync(exclude).then(this, [this, origin](QList<QRect> rects) {
+        for (QRect& r : rects) r.translate(-origin);  // 已是逻辑全局坐标，转为本窗口坐标
+        m_windowIndex.build(rects, rect());
+        qDebug().noquote() << QString("[Screenshot] 窗口吸附就绪：%1 ms (%2 个矩形)").arg(m_openTimer.elapsed()).arg(m_windowIndex.size());
+        // 结果到达前鼠标可能已停在某个窗口上，不等下一次移动
+        if (m_state == ScreenshotState::Selecting && !m_isDragging) { m_highlightedRect = m_windowIndex.smallestAt(mapFromGlobal(QCursor::pos())); update(); }
+    });
 }
 #include "OCRResultWindow.h"
 #include "../core/OCRManager.h"
@@ -588,14 +571,95 @@ void ScreenshotTool::executeOCR() {
     QImage img = generateFinalImage();
     for (QWidget* widget : QApplication::topLevelWidgets()) { if (widget->objectName() == "OCRResultWindow") widget->close(); }
     OCRResultWindow* resWin = new OCRResultWindow(img, nullptr); resWin->setObjectName("OCRResultWindow"); resWin->show();
-    connect(&OCRManager::instance(), &OCRManager::recognitionFinished, resWin, &OCRResultWindow::setRecognizedText);
-    OCRManager::instance().recognizeAsync(img, 9999); cancel();
+    // 结果窗口关闭 (析构) 后续延自动取消
+    OCRManager::instance().recognizeLayout(img).then(resWin, [resWin](const OCRResult& result) { resWin->setRecognizedResult(result); });
+    cancel();
 }
 
 QImage ScreenshotTool::generateFinalImage() {
-    QRect r = selectionRect(); QPixmap p = m_screenPixmap.copy(r); QPainter painter(&p); painter.translate(-r.topLeft());
+    // 按物理像素导出选区，高 DPI 屏幕上不丢分辨率；标注仍按逻辑坐标绘制
+    QRect r = selectionRect(); QImage img = m_capture.image.copy(m_capture.toPixels(r)); img.setDevicePixelRatio(m_capture.dpr);
+    ensureAnnotationLayer();
+    QPainter painter(&img); painter.drawImage(QPointF(0, 0), m_annotationLayer);
+    painter.end();
+    return img;
+}
+
+void ScreenshotTool::ensureAnnotationLayer() {
+    const QRect r = selectionRect();
+    if (m_layerValid && r == m_layerRect) return;
+    m_layerRect = r;
+    m_layerValid = true;
+    m_annotationLayer = QImage((QSizeF(r.size()) * m_capture.dpr).toSize(), QImage::Format_ARGB32_Premultiplied);
+    m_annotationLayer.setDevicePixelRatio(m_capture.dpr);
+    m_annotationLayer.fill(Qt::transparent);
+    if (m_annotationLayer.isNull()) return;
+    QPainter painter(&m_annotationLayer); painter.setRenderHint(QPainter::Antialiasing); painter.translate(-r.topLeft());
     for(auto& a : m_annotations) drawAnnotation(painter, a);
-    return p.toImage();
+}
+
+void ScreenshotTool::commitToLayer(const DrawingAnnotation& ann) {
+    // 缓存层失效 (或选区已变) 时等下次绘制整体重建，否则只把这一条叠加上去
+    if (!m_layerValid || m_layerRect != selectionRect() || m_annotationLayer.isNull()) { invalidateAnnotationLayer(); return; }
+    QPainter painter(&m_annotationLayer); painter.setRenderHint(QPainter::Antialiasing); painter.translate(-m_layerRect.topLeft());
+    drawAnnotation(painter, ann);
+}
+
+void ScreenshotTool::drawCurrentAnnotation(QPainter& p) {
+    const DrawingAnnotation& ann = m_currentAnnotation;
+    if (ann.type == ScreenshotToolType::Mosaic) return;   // 已随鼠标移动画进缓存层
+    if (ann.type == ScreenshotToolType::Pen) {
+        if (ann.points.size() < 2) return;
+        p.setPen(QPen(ann.color, ann.strokeWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin)); p.setBrush(Qt::NoBrush);
+        p.drawPath(m_currentPath);
+        return;
+    }
+    drawAnnotation(p, ann);
+}
+
+QRect ScreenshotTool::currentDirtyRect() const {
+    const QList<QPointF>& pts = m_currentAnnotation.points;
+    if (pts.isEmpty()) return QRect();
+    // 余量覆盖箭头头部、标号圆与马赛克笔宽
+    const int margin = 30 + m_currentAnnotation.strokeWidth * 4;
+    QRectF bounds(pts.last(), QSizeF(0, 0));
+    if (m_currentAnnotation.type == ScreenshotToolType::Pen || m_currentAnnotation.type == ScreenshotToolType::Mosaic) {
+        if (pts.size() > 1) bounds = QRectF(pts[pts.size() - 2], pts.last()).normalized();
+    } else {
+        for (const QPointF& pt : pts) bounds = bounds.united(QRectF(pt, QSizeF(0, 0)));
+    }
+    return bounds.toAlignedRect().adjusted(-margin, -margin, margin, margin);
+}
+
+void ScreenshotTool::drawMosaic(QPainter& painter, const QRectF& area) {
+    const QRect pixels = m_capture.toPixels(area);
+    if (pixels.isEmpty()) return;
+    for (int ty = pixels.top() / kMosaicTile; ty <= pixels.bottom() / kMosaicTile; ++ty) {
+        for (int tx = pixels.left() / kMosaicTile; tx <= pixels.right() / kMosaicTile; ++tx) {
+            painter.drawImage(QPointF(tx * kMosaicTile, ty * kMosaicTile) / m_capture.dpr, mosaicTile(tx, ty));
+        }
+    }
+}
+
+const QImage& ScreenshotTool::mosaicTile(int tx, int ty) {
+    const quint64 key = (quint64(quint32(ty)) << 32) | quint32(tx);
+    auto it = m_mosaicTiles.find(key);
+    if (it != m_mosaicTiles.end()) return *it;
+
+    // 每个色块取中心像素的颜色
+    const QRect area = QRect(tx * kMosaicTile, ty * kMosaicTile, kMosaicTile, kMosaicTile).intersected(m_capture.image.rect());
+    QImage tile(area.size(), QImage::Format_RGB32);
+    QPainter painter(&tile);
+    for (int y = 0; y < area.height(); y += kMosaicBlock) {
+        for (int x = 0; x < area.width(); x += kMosaicBlock) {
+            const int sx = qMin(area.left() + x + kMosaicBlock / 2, area.right());
+            const int sy = qMin(area.top() + y + kMosaicBlock / 2, area.bottom());
+            painter.fillRect(x, y, kMosaicBlock, kMosaicBlock, QColor::fromRgb(m_capture.image.pixel(sx, sy)));
+        }
+    }
+    painter.end();
+    tile.setDevicePixelRatio(m_capture.dpr);
+    return *m_mosaicTiles.insert(key, tile);
 }
 void ScreenshotTool::keyPressEvent(QKeyEvent* e) { 
     if(e->key() == Qt::Key_Escape) cancel(); 
@@ -17,7 +17,12 @@
 #include <QMenu>
 #include <QColorDialog>
 #include <QList>
+#include <QHash>
+#include <QImage>
+#include <QElapsedTimer>
 #include <functional>
+#include "../core/ScreenCapture.h"
+#include "../core/WindowDetector.h"
 
 enum class ScreenshotState { Selecting, Editing };
 enum class ScreenshotToolType { None, Rect, Ellipse, Arrow, Line, Pen, Marker, Text, Mosaic, MosaicRect, Eraser };
@@ -122,7 +127,7 @@ signals:
     void screenshotCanceled();
 
 protected:
-    void paintEvent(QPaintEvent*) override;
+    void paintEvent(QPaintEvent* event) override;
     void showEvent(QShowEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
@@ -144,15 +149,36 @@ private:
     void showTextInput(const QPoint& pos);
     void commitTextInput();
     QImage generateFinalImage();
+    // 后台枚举窗口，完成后建立命中索引；界面不等待枚举结果
     void detectWindows();
-
-    QPixmap m_screenPixmap;
-    QPixmap m_mosaicPixmap;
+    // 已提交的标注合成到与选区等大的缓存层；绘制过程中只重绘当前标注所在的脏矩形
+    void ensureAnnotationLayer();
+    void invalidateAnnotationLayer() { m_layerValid = false; }
+    void commitToLayer(const DrawingAnnotation& ann);
+    void drawCurrentAnnotation(QPainter& painter);
+    QRect currentDirtyRect() const;
+
+    // 马赛克按需生成：只计算笔画覆盖到的图块，结果缓存到关闭截屏界面
+    void drawMosaic(QPainter& painter, const QRectF& area);
+    const QImage& mosaicTile(int tx, int ty);
+
+    static constexpr int kMosaicBlock = 15;                  // 马赛克色块边长 (物理像素)
+    static constexpr int kMosaicTile = kMosaicBlock * 16;    // 缓存图块边长，按色块对齐保证相邻图块无接缝
+
+    ScreenCapture::Frame m_capture;          // 所有屏幕共享的一块像素缓冲
+    QHash<quint64, QImage> m_mosaicTiles;
+
+    QImage m_annotationLayer;
+    QRect m_layerRect;              // 缓存层对应的选区 (逻辑坐标)
+    bool m_layerValid = false;
+    QPainterPath m_currentPath;     // 正在绘制的画笔路径，随鼠标移动增量追加
     
     ScreenshotState m_state = ScreenshotState::Selecting;
     ScreenshotToolType m_currentTool = ScreenshotToolType::None;
     
-    QList<QRect> m_detectedRects;
+    WindowRectIndex m_windowIndex;          // 窗口坐标，后台枚举完成前为空
+    QElapsedTimer m_openTimer;              // 打开截屏到首帧 / 窗口吸附就绪的耗时
+    bool m_firstFrameLogged = false;
     QRect m_highlightedRect;
 
     QPoint m_startPoint, m_endPoint;
@@ -1,6 +1,7 @@
 #include "SettingsWindow.h"
 #include "IconHelper.h"
 #include "CategoryPasswordDialog.h"
+#include "DatabaseLockDialog.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -12,6 +13,7 @@
 
 #include <QKeyEvent>
 #include "../core/HotkeyManager.h"
+#include "../core/EncryptedDatabase.h"
 
 // --- HotkeyEdit 辅助类 ---
 HotkeyEdit::HotkeyEdit(QWidget* parent) : QLineEdit(parent) {
@@ -103,6 +105,17 @@ void SettingsWindow::initSettingsUI() {
     pwdLayout->addWidget(btnSet);
     pwdLayout->addWidget(btnModify);
     pwdLayout->addWidget(btnRemove);
+
+    // 数据库文件加密 (开启后不可在此关闭)
+    auto* btnEncrypt = new QPushButton(IconHelper::getIcon("lock", "#aaa"), " 加密数据库文件");
+    btnEncrypt->setStyleSheet(btnStyle);
+    btnEncrypt->setAutoDefault(false);
+    if (EncryptedDatabase::isEnabled()) {
+        btnEncrypt->setText(" 数据库文件已加密");
+        btnEncrypt->setEnabled(false);
+    }
+    connect(btnEncrypt, &QPushButton::clicked, this, &SettingsWindow::handleEncryptDatabase);
+    pwdLayout->addWidget(btnEncrypt);
     layout->addWidget(pwdGroup);
 
     // 2. 快捷键设置部分
@@ -197,6 +210,17 @@ void SettingsWindow::handleSetPassword() {
     dlg->deleteLater();
 }
 
+void SettingsWindow::handleEncryptDatabase() {
+    auto* dlg = new DatabaseLockDialog(DatabaseLockDialog::SetPassword, this);
+    if (dlg->exec() == QDialog::Accepted) {
+        QMessageBox::information(this, "成功",
+            "数据库文件已加密，下次启动时需要输入主密码。\n"
+            "请牢记主密码，遗忘后数据无法恢复。backups 目录中此前的明文备份不会自动删除，请自行处理。");
+        accept();
+    }
+    dlg->deleteLater();
+}
+
 void SettingsWindow::handleModifyPassword() {
     QSettings s("RapidNotes", "QuickWindow");
     auto* verifyDlg = new FramelessInputDialog("身份验证", "请输入当前启动密码:", "", this);
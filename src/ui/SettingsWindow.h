@@ -37,6 +37,7 @@ private slots:
     void handleSetPassword();
     void handleModifyPassword();
     void handleRemovePassword();
+    void handleEncryptDatabase();
     void saveHotkeys();
     void handleRestoreDefaults();
 
@@ -0,0 +1,26 @@
+#include "Benchmarks.h"
+#include <QGuiApplication>
+#include <QStringList>
+
+// 用法：RapidNotesBenchmark [crypto] [images] [encrypted] [ocr]，不带参数时运行全部
+int main(int argc, char *argv[]) {
+    // 合成截屏需要字体渲染：Linux 下没有显示环境 (CI、SSH) 时改用 offscreen 平台
+#ifdef Q_OS_LINUX
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty("DISPLAY") &&
+        qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+#endif
+    QGuiApplication a(argc, argv);
+    a.setApplicationName("RapidNotesBenchmark");
+
+    const QStringList names = a.arguments().mid(1);
+    auto wanted = [&names](const QString& name) { return names.isEmpty() || names.contains(name); };
+
+    bool ok = true;
+    if (wanted("crypto")) benchmarkFileCrypto();
+    if (wanted("images")) benchmarkImageStorage();
+    if (wanted("encrypted")) ok = benchmarkEncryptedDatabase() && ok;
+    if (wanted("ocr")) ok = benchmarkImagePreprocessor() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QtGlobal>
+
+/**
+ * @brief RapidNotesBenchmark 的各项性能基准
+ *
+ * 每项在内存或临时目录中运行，耗时与吞吐输出到日志。
+ */
+
+// 各 AES 后端与模式 (CBC / CTR / GCM / 并行 GCM) 的吞吐，返回最佳后端并行 GCM 的 MB/s
+double benchmarkFileCrypto(qint64 totalBytes = 64 * 1024 * 1024);
+// 对比图片内嵌在 notes 表与独立存放 (image_blobs) 两种布局下的列表查询耗时
+void benchmarkImageStorage(int imageCount = 20000, int imageBytes = 32 * 1024);
+// 约 1 GB 的加密数据库：开启加密、三种改动规模的检查点、退出与重新解锁的耗时。
+// 容器写在程序目录，工作副本在 EncryptedDatabase 的工作目录，RapidNotes 运行时跳过
+bool benchmarkEncryptedDatabase(qint64 databaseBytes = Q_INT64_C(1024) * 1024 * 1024);
+// 以 4K 合成截屏及小尺寸裁剪对比逐像素的原始实现与 ImagePreprocessor 的耗时，返回输出是否逐字节一致
+bool benchmarkImagePreprocessor(int runs = 5);
+
+#endif // BENCHMARKS_H
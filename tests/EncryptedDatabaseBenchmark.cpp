@@ -0,0 +1,144 @@
+#include "Benchmarks.h"
+#include "core/EncryptedDatabase.h"
+#include "core/DatabaseManager.h"
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDebug>
+#include <functional>
+
+static constexpr int kRowBytes = 64 * 1024;
+static constexpr int kNewNotes = 20;
+static constexpr int kScatteredRows = 64;
+
+// 在独立连接上执行 fn，用完移除连接
+static bool withConnection(const QString& path, const QString& name, const std::function<bool(QSqlDatabase&)>& fn) {
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(path);
+        ok = db.open() && fn(db);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    return ok;
+}
+
+static void fillRandom(QByteArray& data) {
+    QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(data.data()), data.size() / 4);
+}
+
+bool benchmarkEncryptedDatabase(qint64 databaseBytes) {
+    // 工作目录与正式程序共用 (Linux 下为 XDG_RUNTIME_DIR/rapidnotes)，建立工作副本时会清理其中的残留文件
+    QLocalSocket socket;
+    socket.connectToServer("RapidNotes_SingleInstance_Server");
+    if (socket.waitForConnected(500)) {
+        qWarning() << "[Benchmark] RapidNotes 正在运行，跳过加密数据库基准";
+        return false;
+    }
+    if (EncryptedDatabase::isEnabled()) {
+        qWarning() << "[Benchmark] 已存在容器文件，跳过加密数据库基准:" << EncryptedDatabase::containerPath();
+        return false;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) return false;
+    const QString plainPath = dir.filePath("plain.db");
+
+    // 1. 明文库：随机内容 (不可压缩) 的定长行，总量约 databaseBytes
+    const int rows = static_cast<int>(databaseBytes / kRowBytes);
+    const bool filled = withConnection(plainPath, "benchmark_fill", [rows](QSqlDatabase& db) {
+        QSqlQuery q(db);
+        if (!q.exec("CREATE TABLE benchmark_filler (id INTEGER PRIMARY KEY, data BLOB)")) return false;
+        db.transaction();
+        q.prepare("INSERT INTO benchmark_filler (id, data) VALUES (?, ?)");
+        QByteArray row(kRowBytes, Qt::Uninitialized);
+        for (int i = 1; i <= rows; ++i) {
+            fillRandom(row);
+            q.addBindValue(i);
+            q.addBindValue(row);
+            if (!q.exec()) {
+                db.rollback();
+                return false;
+            }
+        }
+        return db.commit();
+    });
+    DatabaseManager& manager = DatabaseManager::instance();
+    if (!filled || !manager.init(plainPath, false)) {
+        qWarning() << "[Benchmark] 无法生成明文库:" << plainPath;
+        return false;
+    }
+
+    EncryptedDatabase& encrypted = EncryptedDatabase::instance();
+    const QString password = "RapidNotes benchmark";
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = encrypted.prepareEnable(plainPath, password) && manager.init(encrypted.workingPath(), false);
+    const qint64 enableMs = timer.elapsed();
+
+    // 2. 检查点：无改动 (只读文件头)、新增少量笔记 (尾部几块)、分散改写 (多块各自重新加密)
+    qint64 idleMs = 0, notesMs = 0, scatteredMs = 0, shutdownMs = 0, unlockMs = 0;
+    if (ok) {
+        timer.restart();
+        ok = encrypted.checkpoint();
+        idleMs = timer.elapsed();
+    }
+    if (ok) {
+        for (int i = 0; i < kNewNotes; ++i) manager.addNote(QString("基准笔记 %1").arg(i), "检查点基准");
+        timer.restart();
+        ok = encrypted.checkpoint();
+        notesMs = timer.elapsed();
+    }
+    if (ok) {
+        ok = withConnection(encrypted.workingPath(), "benchmark_scatter", [rows](QSqlDatabase& db) {
+            QSqlQuery q(db);
+            q.prepare("UPDATE benchmark_filler SET data = ? WHERE id = ?");
+            QByteArray row(kRowBytes, Qt::Uninitialized);
+            db.transaction();
+            for (int k = 0; k < kScatteredRows; ++k) {
+                fillRandom(row);
+                q.addBindValue(row);
+                q.addBindValue(1 + static_cast<int>(qint64(k) * rows / kScatteredRows));
+                if (!q.exec()) {
+                    db.rollback();
+                    return false;
+                }
+            }
+            return db.commit();
+        });
+        timer.restart();
+        ok = ok && encrypted.checkpoint();
+        scatteredMs = timer.elapsed();
+    }
+
+    // 3. 退出 (最后一次检查点 + 删除工作副本) 与重新解锁 (密钥派生 + 并行解密全部块)
+    if (ok) {
+        timer.restart();
+        encrypted.shutdown();
+        shutdownMs = timer.elapsed();
+        timer.restart();
+        ok = encrypted.unlock(password);
+        unlockMs = timer.elapsed();
+    }
+
+    if (ok) {
+        qDebug().noquote() << QString("[Benchmark] 加密数据库 %1 MB: 开启 %2 ms | 检查点 无改动 %3 ms / 新增 %4 条笔记 %5 ms / "
+                                      "分散改写 %6 行 %7 ms | 退出 %8 ms | 解锁 %9 ms (持锁时间见检查点日志)")
+                                  .arg(databaseBytes / (1024 * 1024)).arg(enableMs).arg(idleMs)
+                                  .arg(kNewNotes).arg(notesMs).arg(kScatteredRows).arg(scatteredMs)
+                                  .arg(shutdownMs).arg(unlockMs);
+    } else {
+        qWarning() << "[Benchmark] 加密数据库基准失败 (工作目录或程序目录空间不足？)";
+    }
+
+    // 开启加密的结果从未交给正式流程：discard 删除工作副本与容器
+    manager.close();
+    encrypted.discard();
+    QFile::remove(EncryptedDatabase::containerPath());
+    return ok;
+}
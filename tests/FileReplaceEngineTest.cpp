@@ -0,0 +1,72 @@
+#include "SelfTests.h"
+#include "core/FileReplaceEngine.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QStringEncoder>
+#include <QDebug>
+
+bool testFileReplaceEngine() {
+    using Engine = FileReplaceEngine;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) return false;
+    QStringList failures;
+    auto writeFile = [&dir](const QString& name, const QByteArray& data) {
+        QFile file(dir.filePath(name));
+        if (file.open(QIODevice::WriteOnly)) file.write(data);
+        return file.fileName();
+    };
+    auto readFile = [](const QString& path) {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    auto expect = [&failures](bool ok, const QString& what) { if (!ok) failures << what; };
+
+    // 非 ASCII 关键字忽略大小写：德语变音、西里尔与希腊字母 (UTF-8 与 UTF-16 各一份)
+    const QString text = QString::fromUtf8("Äpfel, äpfel; ПРИВЕТ привет; ΣΟΦΙΑ σοφια\r\n");
+    const QString utf8 = writeFile("umlaut.txt", text.toUtf8());
+    expect(Engine::countMatches(utf8, QString::fromUtf8("äPFEL"), false) == 2, "UTF-8 忽略大小写匹配 Ä/ä");
+    expect(Engine::countMatches(utf8, QString::fromUtf8("привет"), false) == 2, "UTF-8 忽略大小写匹配西里尔字母");
+    expect(Engine::countMatches(utf8, QString::fromUtf8("σοφια"), false) == 2, "UTF-8 忽略大小写匹配希腊字母");
+    expect(Engine::countMatches(utf8, QString::fromUtf8("äpfel"), true) == 1, "UTF-8 区分大小写只匹配原样");
+    const Engine::FileResult replaced = Engine::replaceInFile(utf8, QString::fromUtf8("ÄPFEL"), "Birnen", false, QString());
+    expect(replaced.ok && replaced.replacements == 2, "UTF-8 忽略大小写替换次数");
+    expect(readFile(utf8) == QString::fromUtf8("Birnen, Birnen; ПРИВЕТ привет; ΣΟΦΙΑ σοφια\r\n").toUtf8(),
+           "UTF-8 替换结果 (换行符保持 \\r\\n)");
+
+    QByteArray utf16("\xFF\xFE");
+    utf16 += QStringEncoder(QStringConverter::Utf16LE).encode(text);
+    const QString utf16Path = writeFile("umlaut16.txt", utf16);
+    expect(Engine::countMatches(utf16Path, QString::fromUtf8("ПРИВЕТ"), false) == 2, "UTF-16 忽略大小写匹配西里尔字母");
+    const Engine::FileResult replaced16 = Engine::replaceInFile(utf16Path, QString::fromUtf8("привет"), "hi", false, QString());
+    const QByteArray after16 = readFile(utf16Path);
+    expect(replaced16.ok && replaced16.replacements == 2 && after16.startsWith("\xFF\xFE"), "UTF-16 替换次数并保留 BOM");
+
+    // 解码路径按块读取：关键字跨越块边界，且边界正好切开一个多字节字符
+    QByteArray straddle(Engine::kChunkSize - 5, 'x');
+    const QString straddlePath = writeFile("straddle.txt", straddle + QString::fromUtf8("привет!").toUtf8());
+    expect(Engine::countMatches(straddlePath, QString::fromUtf8("ПРИВЕТ"), false) == 1, "解码路径跨块边界计数");
+    const Engine::FileResult replacedStraddle =
+        Engine::replaceInFile(straddlePath, QString::fromUtf8("ПРИВЕТ"), "hi", false, QString());
+    expect(replacedStraddle.ok && replacedStraddle.replacements == 1 && readFile(straddlePath) == straddle + "hi!",
+           "解码路径跨块边界替换");
+
+    // 头部是合法 UTF-8、超过嗅探范围之后才出现 Latin-1 字节：应发现并改走解码路径，不按 UTF-8 字节匹配漏算
+    QByteArray mixed(TextFileClassifier::kSniffSize * 2, 'x');
+    mixed += " caf\xE9 keyword KEYWORD";
+    const QString mixedPath = writeFile("latin1_tail.txt", mixed);
+    QString notReplaceable;
+    expect(Engine::countMatches(mixedPath, "keyword", false, nullptr, &notReplaceable) == 2, "头部合法、尾部非法 UTF-8 时仍能计数");
+    // 系统本地编码是 UTF-8 时无法还原，应报告原因且不改动文件；否则按本地编码替换
+    const Engine::FileResult replacedMixed = Engine::replaceInFile(mixedPath, "keyword", "kw", false, QString());
+    if (notReplaceable.isEmpty()) {
+        expect(replacedMixed.ok && replacedMixed.replacements == 2, "非 UTF-8 文件按本地编码替换");
+    } else {
+        expect(!replacedMixed.ok && replacedMixed.error == notReplaceable && readFile(mixedPath) == mixed,
+               "无法还原的非 UTF-8 文件报告原因且不修改");
+    }
+
+    for (const QString& failure : std::as_const(failures)) qWarning().noquote() << "[SelfTest] 查找替换:" << failure;
+    qDebug().noquote() << QString("[SelfTest] 查找替换：%1").arg(failures.isEmpty() ? "通过" : "失败");
+    return failures.isEmpty();
+}
@@ -0,0 +1,137 @@
+#include "Benchmarks.h"
+#include "core/ImagePreprocessor.h"
+#include <QImage>
+#include <QPainter>
+#include <QFont>
+#include <QColor>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+#include <functional>
+
+// 原始的逐像素实现，用于校验当前实现的输出逐字节一致
+static QImage legacyPrepare(const QImage& original) {
+    QImage processed = original.convertToFormat(QImage::Format_Grayscale8);
+    int scale = 3;
+    if (processed.width() > 2000 || processed.height() > 2000) {
+        scale = 1;
+    } else if (processed.width() > 1000 || processed.height() > 1000) {
+        scale = 2;
+    }
+    if (scale > 1) {
+        processed = processed.scaled(processed.width() * scale, processed.height() * scale,
+                                     Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    int cornerSum = 0;
+    cornerSum += qGray(processed.pixel(0, 0));
+    cornerSum += qGray(processed.pixel(processed.width()-1, 0));
+    cornerSum += qGray(processed.pixel(0, processed.height()-1));
+    cornerSum += qGray(processed.pixel(processed.width()-1, processed.height()-1));
+    if (cornerSum / 4 < 128) {
+        processed.invertPixels();
+    }
+
+    int histogram[256] = {0};
+    for (int y = 0; y < processed.height(); ++y) {
+        const uchar* line = processed.constScanLine(y);
+        for (int x = 0; x < processed.width(); ++x) histogram[line[x]]++;
+    }
+    int totalPixels = processed.width() * processed.height();
+    int minGray = 0, maxGray = 255;
+    int count = 0;
+    for (int i = 0; i < 256; ++i) {
+        count += histogram[i];
+        if (count > totalPixels * 0.005) { minGray = i; break; }
+    }
+    count = 0;
+    for (int i = 255; i >= 0; --i) {
+        count += histogram[i];
+        if (count > totalPixels * 0.005) { maxGray = i; break; }
+    }
+    if (maxGray > minGray) {
+        for (int y = 0; y < processed.height(); ++y) {
+            uchar* line = processed.scanLine(y);
+            for (int x = 0; x < processed.width(); ++x) {
+                int val = (line[x] - minGray) * 255 / (maxGray - minGray);
+                line[x] = static_cast<uchar>(qBound(0, val, 255));
+            }
+        }
+    }
+
+    QImage sharpened = processed;
+    for (int y = 1; y < processed.height() - 1; ++y) {
+        const uchar* prevLine = processed.constScanLine(y - 1);
+        const uchar* currLine = processed.constScanLine(y);
+        const uchar* nextLine = processed.constScanLine(y + 1);
+        uchar* destLine = sharpened.scanLine(y);
+        for (int x = 1; x < processed.width() - 1; ++x) {
+            int sum = currLine[x] * 5 - prevLine[x] - nextLine[x] - currLine[x-1] - currLine[x+1];
+            destLine[x] = static_cast<uchar>(qBound(0, sum, 255));
+        }
+    }
+    return sharpened;
+}
+
+static bool sameGrayPixels(const QImage& a, const QImage& b) {
+    if (a.size() != b.size() || a.format() != b.format()) return false;
+    for (int y = 0; y < a.height(); ++y) {
+        if (std::memcmp(a.constScanLine(y), b.constScanLine(y), static_cast<size_t>(a.width())) != 0) return false;
+    }
+    return true;
+}
+
+// 深色背景、多种字号与颜色的合成截屏，覆盖反色与拉伸路径
+static QImage syntheticScreenshot(int width, int height) {
+    QImage image(width, height, QImage::Format_ARGB32);
+    image.fill(QColor("#1e1e1e"));
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    const QColor colors[] = { QColor("#d4d4d4"), QColor("#569cd6"), QColor("#ce9178"), QColor("#6a9955") };
+    int y = 40;
+    for (int line = 0; y < height - 20; ++line) {
+        QFont font("Consolas");
+        font.setPixelSize(14 + (line % 4) * 4);
+        painter.setFont(font);
+        painter.setPen(colors[line % 4]);
+        painter.drawText(20 + (line % 7) * 12, y,
+                         QString("%1  RapidNotes 预处理基准 The quick brown fox jumps over the lazy dog 0123456789").arg(line));
+        if (line % 9 == 0) painter.fillRect(width / 2, y - 12, width / 3, 24, QColor("#2d2d30"));
+        y += font.pixelSize() + 10;
+    }
+    return image;
+}
+
+bool benchmarkImagePreprocessor(int runs) {
+    const QImage screenshot = syntheticScreenshot(3840, 2160);
+    // 4K 原尺寸 (不放大)、1280x720 (放大 2 倍)、640x360 (放大 3 倍)
+    const QList<QImage> inputs = { screenshot, screenshot.copy(0, 0, 1280, 720), screenshot.copy(0, 0, 640, 360) };
+
+    bool allIdentical = true;
+    for (const QImage& input : inputs) {
+        auto best = [&](const std::function<QImage()>& fn, QImage* out) {
+            qint64 result = std::numeric_limits<qint64>::max();
+            for (int run = 0; run < qMax(1, runs); ++run) {
+                QElapsedTimer timer;
+                timer.start();
+                *out = fn();
+                result = qMin(result, timer.nsecsElapsed() / 1000);
+            }
+            return result;
+        };
+        QImage legacy, current;
+        const qint64 legacyUs = best([&] { return legacyPrepare(input); }, &legacy);
+        const qint64 currentUs = best([&] { return ImagePreprocessor::prepareForOcr(input); }, &current);
+        const bool identical = sameGrayPixels(legacy, current);
+        allIdentical = allIdentical && identical;
+
+        qDebug().noquote() << QString("[Benchmark] OCR 预处理 %1x%2 -> %3x%4: 原始实现 %5 ms | 当前实现 %6 ms (%7x) | 输出%8")
+                                  .arg(input.width()).arg(input.height())
+                                  .arg(current.width()).arg(current.height())
+                                  .arg(legacyUs / 1000.0, 0, 'f', 1).arg(currentUs / 1000.0, 0, 'f', 1)
+                                  .arg(double(legacyUs) / qMax<qint64>(currentUs, 1), 0, 'f', 2)
+                                  .arg(identical ? "一致" : "不一致");
+    }
+    return allIdentical;
+}
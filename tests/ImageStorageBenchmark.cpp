@@ -0,0 +1,90 @@
+#include "Benchmarks.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QTemporaryDir>
+#include <QRandomGenerator>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QDebug>
+#include <limits>
+
+// 与 DatabaseManager 打开主库时设置的 mmap_size 相同
+static constexpr qint64 kMmapSize = 256 * 1024 * 1024;
+
+void benchmarkImageStorage(int imageCount, int imageBytes) {
+    QTemporaryDir dir;
+    if (!dir.isValid()) return;
+
+    // 两个独立库：inline 把图片写在 notes.data_blob，separate 写入 image_blobs 只在 notes 中保留哈希
+    for (const bool separate : {false, true}) {
+        const QString connName = separate ? "benchmark_separate" : "benchmark_inline";
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
+            db.setDatabaseName(dir.filePath(connName + ".db"));
+            if (!db.open()) return;
+            QSqlQuery q(db);
+            q.exec(QString("PRAGMA mmap_size = %1").arg(kMmapSize));
+            q.exec("CREATE TABLE notes (id INTEGER PRIMARY KEY AUTOINCREMENT, title TEXT, content TEXT, tags TEXT, "
+                   "item_type TEXT, data_blob BLOB, image_hash TEXT, is_deleted INTEGER DEFAULT 0, "
+                   "is_pinned INTEGER DEFAULT 0, updated_at DATETIME)");
+            q.exec("CREATE TABLE image_blobs (hash TEXT PRIMARY KEY, size INTEGER, data BLOB)");
+
+            QByteArray image(imageBytes, Qt::Uninitialized);
+            db.transaction();
+            QSqlQuery insertNote(db);
+            insertNote.prepare("INSERT INTO notes (title, content, tags, item_type, data_blob, image_hash, updated_at) "
+                               "VALUES (?, '', '', 'image', ?, ?, ?)");
+            QSqlQuery insertImage(db);
+            insertImage.prepare("INSERT INTO image_blobs (hash, size, data) VALUES (?, ?, ?)");
+            for (int i = 0; i < imageCount; ++i) {
+                // 随机内容，模拟已压缩的 PNG
+                QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(image.data()), imageBytes / 4);
+                const QString hash = QCryptographicHash::hash(image, QCryptographicHash::Sha256).toHex();
+                insertNote.addBindValue(QString("[截图] %1").arg(i));
+                insertNote.addBindValue(separate ? QVariant(QMetaType::fromType<QByteArray>()) : QVariant(image));
+                insertNote.addBindValue(separate ? QVariant(hash) : QVariant(QMetaType::fromType<QString>()));
+                insertNote.addBindValue(QDateTime::currentDateTime().addSecs(i).toString("yyyy-MM-dd HH:mm:ss"));
+                insertNote.exec();
+                if (separate) {
+                    insertImage.addBindValue(hash);
+                    insertImage.addBindValue(imageBytes);
+                    insertImage.addBindValue(image);
+                    insertImage.exec();
+                }
+            }
+            db.commit();
+
+            auto timeQuery = [&db](const QString& sql) {
+                QElapsedTimer timer;
+                timer.start();
+                QSqlQuery query(db);
+                query.setForwardOnly(true);
+                query.exec(sql);
+                int rows = 0;
+                while (query.next()) {
+                    for (int c = 0; c < query.record().count(); ++c) query.value(c);
+                    ++rows;
+                }
+                return timer.nsecsElapsed() / 1000;
+            };
+            // 各取三次中的最好成绩，排除首次读盘的干扰
+            auto best = [&](const QString& sql) {
+                qint64 result = std::numeric_limits<qint64>::max();
+                for (int run = 0; run < 3; ++run) result = qMin(result, timeQuery(sql));
+                return result;
+            };
+            const qint64 page = best("SELECT * FROM notes WHERE is_deleted = 0 ORDER BY is_pinned DESC, updated_at DESC LIMIT 100");
+            const qint64 all = best("SELECT * FROM notes WHERE is_deleted = 0");
+            const qint64 count = best("SELECT COUNT(*) FROM notes");
+            const qint64 search = best("SELECT id FROM notes WHERE title LIKE '%9999%'");
+            qDebug().noquote() << QString("[Benchmark] %1 (%2 张 %3 KB 图片): 首页 %4 ms, 全表 %5 ms, COUNT %6 ms, 标题搜索 %7 ms")
+                                      .arg(separate ? "独立存放" : "内嵌 data_blob").arg(imageCount).arg(imageBytes / 1024)
+                                      .arg(page / 1000.0, 0, 'f', 2).arg(all / 1000.0, 0, 'f', 2)
+                                      .arg(count / 1000.0, 0, 'f', 2).arg(search / 1000.0, 0, 'f', 2);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connName);
+    }
+}
@@ -0,0 +1,45 @@
+#include "SelfTests.h"
+#include "core/DatabaseManager.h"
+#include <QTemporaryDir>
+#include <QDebug>
+
+// 占用单例连接：在临时库中验证超大文本 加载全文 → 编辑 → 保存 → getFullContent 的往返
+bool testLargeText() {
+    QTemporaryDir dir;
+    if (!dir.isValid()) return false;
+    DatabaseManager& db = DatabaseManager::instance();
+    if (!db.init(dir.filePath("selftest.db"), false)) return false;
+
+    QStringList failures;
+    auto check = [&failures](bool ok, const QString& what) { if (!ok) failures << what; };
+
+    // 超过阈值的正文入库后只保留预览
+    const QString original = QString("RapidNotes 超大文本自检 ").repeated(DatabaseManager::largeTextThreshold() / 16 + 1);
+    db.addNote("selftest", original);
+    int id = 0;
+    const QList<QVariantMap> notes = db.getAllNotes();
+    for (const QVariantMap& row : notes) id = qMax(id, row.value("id").toInt());
+    QVariantMap note = db.getNoteById(id);
+    check(note.value("large_size").toLongLong() > 0, "入库后 large_size 应大于 0");
+
+    // 加载全文 → 编辑 → 保存 (主窗口保存走 updateNoteContent)
+    const QString full = db.getFullContent(note);
+    check(full == original, "加载全文应与原文一致");
+    const QString edited = full + "\n已编辑";
+    check(db.updateNoteContent(id, edited), "保存编辑后的全文失败");
+    note = db.getNoteById(id);
+    check(note.value("large_size").toLongLong() > 0, "编辑后仍超阈值，应重新分块");
+    check(db.getFullContent(note) == edited, "保存后 getFullContent 应返回编辑后的全文");
+
+    // 缩短到阈值以下：清掉旧分块，large_size 复位 (经 updateNoteState 的旧调用方式同样分块)
+    check(db.updateNoteState(id, "content", "短正文"), "保存短正文失败");
+    note = db.getNoteById(id);
+    check(note.value("large_size").toLongLong() == 0, "缩短后 large_size 应复位为 0");
+    check(db.getFullContent(note) == "短正文", "缩短后 getFullContent 应返回新正文");
+    check(db.getLargeTextChunks(id).isEmpty(), "缩短后旧分块应被清除");
+
+    db.close();
+    for (const QString& failure : std::as_const(failures)) qWarning().noquote() << "[SelfTest] 超大文本:" << failure;
+    qDebug().noquote() << QString("[SelfTest] 超大文本往返：%1").arg(failures.isEmpty() ? "通过" : "失败");
+    return failures.isEmpty();
+}
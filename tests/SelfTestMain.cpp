@@ -0,0 +1,16 @@
+#include "SelfTests.h"
+#include <QCoreApplication>
+#include <QDebug>
+
+// 由 ctest 调用：任意一项失败时返回码非 0
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("RapidNotesSelfTest");
+
+    bool ok = testFileReplaceEngine();
+    ok = testLargeText() && ok;
+    ok = testXxh3() && ok;
+
+    qDebug().noquote() << QString("[SelfTest] 全部自检：%1").arg(ok ? "通过" : "失败");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#ifndef SELFTESTS_H
+#define SELFTESTS_H
+
+/**
+ * @brief RapidNotesSelfTest 的各项自检
+ *
+ * 每项在临时目录 / 临时库上运行，失败项输出到日志，返回是否全部通过。
+ */
+bool testFileReplaceEngine();
+bool testLargeText();
+bool testXxh3();
+
+#endif // SELFTESTS_H